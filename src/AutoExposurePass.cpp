@@ -0,0 +1,331 @@
+#include "pch.h"
+#include "AutoExposurePass.h"
+#include "ColorKernels.h"
+#include <random>
+
+// 和 shaders/LuminanceHistogram_CS.hlsl 一致，每个线程负责一个桶
+static constexpr uint32_t THREAD_GROUP_SIZE = 16;
+static_assert(THREAD_GROUP_SIZE * THREAD_GROUP_SIZE == LuminanceHistogram::BIN_COUNT);
+
+static constexpr uint64_t HISTOGRAM_SIZE = sizeof(LuminanceHistogram::Bins);
+
+HRESULT AutoExposurePass::Initialize(D3D12Context& d3d12Context) noexcept {
+	// 使用 wave 指令
+	if (!d3d12Context.IsSM6Supported()) {
+		return DXGI_ERROR_UNSUPPORTED;
+	}
+
+	const uint32_t frameCount = d3d12Context.GetMaxInFlightFrameCount();
+	assert(frameCount <= 32);
+
+	HRESULT hr = _CreatePipeline(d3d12Context);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	{
+		const CD3DX12_RESOURCE_DESC bufferDesc =
+			CD3DX12_RESOURCE_DESC::Buffer(HISTOGRAM_SIZE, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+		hr = d3d12Context.CreateResource(D3D12_HEAP_TYPE_DEFAULT, bufferDesc,
+			D3D12_RESOURCE_STATE_COMMON, nullptr, _histogramBuffer, _histogramBufferAllocation);
+		if (FAILED(hr)) {
+			return hr;
+		}
+	}
+
+	{
+		const CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(HISTOGRAM_SIZE * frameCount);
+		hr = d3d12Context.CreateResource(D3D12_HEAP_TYPE_READBACK, bufferDesc,
+			D3D12_RESOURCE_STATE_COPY_DEST, nullptr, _readbackBuffer, _readbackBufferAllocation);
+		if (FAILED(hr)) {
+			return hr;
+		}
+	}
+
+	return d3d12Context.AllocateCpuDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1, _cpuDescriptor);
+}
+
+HRESULT AutoExposurePass::Prepare(D3D12Context& d3d12Context, uint32_t frameIndex, float headroom) noexcept {
+	if (_readbackMask & (1u << frameIndex)) {
+		LuminanceHistogram::Bins bins;
+		HRESULT hr = _ReadHistogram(frameIndex, bins);
+		if (FAILED(hr)) {
+			return hr;
+		}
+
+		LuminanceHistogram::Stats stats;
+		if (LuminanceHistogram::Analyze(bins, stats)) {
+			const float target = LuminanceHistogram::ComputeExposure(stats, headroom);
+			const auto now = std::chrono::steady_clock::now();
+
+			// 第一次直接使用目标曝光
+			if (_hasExposure) {
+				const std::chrono::duration<float> deltaTime = now - _lastUpdateTime;
+				_exposure = LuminanceHistogram::SmoothExposure(_exposure, target, deltaTime.count());
+			} else {
+				_exposure = target;
+				_hasExposure = true;
+			}
+
+			_lastUpdateTime = now;
+		}
+	}
+
+	// 直方图每帧从上传环复制零清空
+	HRESULT hr = d3d12Context.AllocateUpload(HISTOGRAM_SIZE, sizeof(uint32_t), _zeroUpload);
+	if (FAILED(hr)) {
+		return hr;
+	}
+	std::memset(_zeroUpload.cpuAddress, 0, HISTOGRAM_SIZE);
+
+	return S_OK;
+}
+
+void AutoExposurePass::AddPasses(
+	RenderGraph& renderGraph,
+	uint32_t commandListIndex,
+	RenderGraphResource scene,
+	uint32_t frameIndex,
+	Size size
+) noexcept {
+	const RenderGraphResource histogram = renderGraph.ImportBuffer(_histogramBuffer.get());
+
+	{
+		const uint32_t pass = renderGraph.AddPass("ClearLuminanceHistogram", commandListIndex,
+			[this](ID3D12GraphicsCommandList* commandList) {
+				commandList->CopyBufferRegion(_histogramBuffer.get(), 0,
+					_zeroUpload.resource, _zeroUpload.offset, HISTOGRAM_SIZE);
+			});
+		renderGraph.WriteResource(pass, histogram, D3D12_RESOURCE_STATE_COPY_DEST);
+	}
+
+	{
+		const uint32_t pass = renderGraph.AddPass("LuminanceHistogram", commandListIndex,
+			[this, size](ID3D12GraphicsCommandList* commandList) {
+				_Record(commandList, size);
+			});
+		renderGraph.ReadResource(pass, scene, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+		renderGraph.WriteResource(pass, histogram, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	}
+
+	{
+		// 回读缓冲始终处于 COPY_DEST 状态，无需渲染图跟踪
+		const uint32_t pass = renderGraph.AddPass("ReadbackLuminanceHistogram", commandListIndex,
+			[this, frameIndex](ID3D12GraphicsCommandList* commandList) {
+				commandList->CopyBufferRegion(_readbackBuffer.get(), HISTOGRAM_SIZE * frameIndex,
+					_histogramBuffer.get(), 0, HISTOGRAM_SIZE);
+			}, true);
+		renderGraph.ReadResource(pass, histogram, D3D12_RESOURCE_STATE_COPY_SOURCE);
+	}
+
+	_readbackMask |= 1u << frameIndex;
+}
+
+HRESULT AutoExposurePass::BindScene(D3D12Context& d3d12Context, ID3D12Resource* scene) noexcept {
+	// 瞬态资源可能每帧不同，着色器不可见的描述符在复制后即可覆盖
+	d3d12Context.GetDevice()->CreateShaderResourceView(scene, nullptr, _cpuDescriptor.cpuHandle);
+
+	const D3D12_CPU_DESCRIPTOR_HANDLE srcStart = _cpuDescriptor.cpuHandle;
+	const UINT srcCount = 1;
+	return d3d12Context.CopyToFrameDescriptors({ &srcStart, 1 }, { &srcCount, 1 }, _frameDescriptor);
+}
+
+HRESULT AutoExposurePass::Validate(Size size, ValidationResult& result) noexcept {
+	const uint32_t pixelCount = size.width * size.height;
+	const uint64_t rowPitch = ((uint64_t)size.width * 8 + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) &
+		~(uint64_t)(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+
+	// 图像在一帧内上传
+	D3D12Context d3d12Context;
+	if (!d3d12Context.Initialize(1, false, rowPitch * size.height + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT)) {
+		return E_FAIL;
+	}
+
+	AutoExposurePass pass;
+	HRESULT hr = pass.Initialize(d3d12Context);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	// 亮度在直方图的范围内外对数均匀分布，包括 0 和负值。GPU 上使用 FP16 的值，因此 CPU 上
+	// 统计往返后的值。
+	std::vector<uint16_t> pixels((size_t)pixelCount * 4);
+	LuminanceHistogram::Bins expected{};
+	{
+		std::vector<float> channels((size_t)pixelCount * 3);
+		float* const rgb[3] = {
+			channels.data(), channels.data() + pixelCount, channels.data() + (size_t)pixelCount * 2 };
+
+		std::mt19937 random(42);
+		std::uniform_real_distribution<float> log2Distribution(
+			LuminanceHistogram::MIN_LOG2_LUMINANCE - 2.0f, LuminanceHistogram::MAX_LOG2_LUMINANCE + 2.0f);
+		std::uniform_real_distribution<float> chromaDistribution(-0.1f, 1.0f);
+		for (uint32_t i = 0; i < pixelCount; ++i) {
+			const float luminance = i % 64 == 0 ? 0.0f : std::exp2(log2Distribution(random));
+			for (uint32_t c = 0; c < 3; ++c) {
+				rgb[c][i] = luminance * chromaDistribution(random);
+			}
+		}
+
+		ColorKernels::PackHalf(rgb, pixels.data(), pixelCount);
+		ColorKernels::UnpackHalf(pixels.data(), rgb, pixelCount);
+		LuminanceHistogram::Build(rgb, pixelCount, expected);
+	}
+
+	winrt::com_ptr<ID3D12Resource> texture;
+	HeapAllocation textureAllocation;
+	hr = d3d12Context.CreateResource(D3D12_HEAP_TYPE_DEFAULT,
+		CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R16G16B16A16_FLOAT, size.width, size.height, 1, 1),
+		D3D12_RESOURCE_STATE_COPY_DEST, nullptr, texture, textureAllocation);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	uint32_t frameIndex;
+	hr = d3d12Context.BeginFrame(frameIndex);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	UploadAllocation upload;
+	hr = d3d12Context.AllocateUpload(rowPitch * size.height, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, upload);
+	if (FAILED(hr)) {
+		return hr;
+	}
+	for (uint32_t y = 0; y < size.height; ++y) {
+		std::memcpy((uint8_t*)upload.cpuAddress + rowPitch * y,
+			pixels.data() + (size_t)size.width * 4 * y, (size_t)size.width * 8);
+	}
+
+	hr = pass.Prepare(d3d12Context, frameIndex, 1.0f);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	RenderGraph renderGraph;
+	const RenderGraphResource scene = renderGraph.ImportResource(texture.get(),
+		D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+	{
+		const uint32_t uploadPass = renderGraph.AddPass("UploadScene", 0,
+			[&](ID3D12GraphicsCommandList* commandList) {
+				const D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {
+					.Offset = upload.offset,
+					.Footprint = {
+						.Format = DXGI_FORMAT_R16G16B16A16_FLOAT,
+						.Width = size.width,
+						.Height = size.height,
+						.Depth = 1,
+						.RowPitch = (UINT)rowPitch
+					}
+				};
+				const CD3DX12_TEXTURE_COPY_LOCATION dest(texture.get(), 0);
+				const CD3DX12_TEXTURE_COPY_LOCATION src(upload.resource, footprint);
+				commandList->CopyTextureRegion(&dest, 0, 0, 0, &src, nullptr);
+			});
+		renderGraph.WriteResource(uploadPass, scene, D3D12_RESOURCE_STATE_COPY_DEST);
+	}
+	pass.AddPasses(renderGraph, 0, scene, frameIndex, size);
+	renderGraph.Compile();
+
+	hr = pass.BindScene(d3d12Context, texture.get());
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	ID3D12GraphicsCommandList* commandList = d3d12Context.GetCommandList();
+	ID3D12DescriptorHeap* descriptorHeap = d3d12Context.GetShaderVisibleDescriptorHeap();
+	commandList->SetDescriptorHeaps(1, &descriptorHeap);
+	renderGraph.Execute(commandList, 0);
+
+	hr = commandList->Close();
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	ID3D12CommandList* commandLists[] = { commandList };
+	d3d12Context.GetCommandQueue()->ExecuteCommandLists(1, commandLists);
+
+	hr = d3d12Context.EndFrame();
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	hr = d3d12Context.WaitForGpu();
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	LuminanceHistogram::Bins actual;
+	hr = pass._ReadHistogram(frameIndex, actual);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	result = { .pixelCount = pixelCount };
+	uint64_t difference = 0;
+	for (uint32_t i = 0; i < LuminanceHistogram::BIN_COUNT; ++i) {
+		result.gpuPixelCount += actual[i];
+		difference += actual[i] > expected[i] ? actual[i] - expected[i] : expected[i] - actual[i];
+	}
+	result.mismatchCount = difference / 2;
+
+	return S_OK;
+}
+
+HRESULT AutoExposurePass::_CreatePipeline(D3D12Context& d3d12Context) noexcept {
+	{
+		// 布局见 shaders/LuminanceHistogram_CS.hlsl
+		const CD3DX12_DESCRIPTOR_RANGE1 srvRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
+
+		CD3DX12_ROOT_PARAMETER1 rootParams[3];
+		rootParams[0].InitAsConstants(2, 0);
+		rootParams[1].InitAsDescriptorTable(1, &srvRange);
+		rootParams[2].InitAsUnorderedAccessView(0);
+
+		CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc(
+			(UINT)std::size(rootParams), rootParams, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+		HRESULT hr = d3d12Context.CreateRootSignature(rootSignatureDesc, _rootSignature);
+		if (FAILED(hr)) {
+			return hr;
+		}
+	}
+
+	D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {
+		.pRootSignature = _rootSignature.get(),
+		.CS = d3d12Context.GetShaderByteCode(ShaderId::LuminanceHistogram_CS)
+	};
+	return d3d12Context.CreateComputePipelineState(psoDesc, _pipelineState);
+}
+
+void AutoExposurePass::_Record(ID3D12GraphicsCommandList* commandList, Size size) const noexcept {
+	commandList->SetComputeRootSignature(_rootSignature.get());
+	commandList->SetPipelineState(_pipelineState.get());
+
+	// 布局见 shaders/LuminanceHistogram_CS.hlsl
+	const uint32_t constants[] = { size.width, size.height };
+	commandList->SetComputeRoot32BitConstants(0, (UINT)std::size(constants), constants, 0);
+	commandList->SetComputeRootDescriptorTable(1, _frameDescriptor.gpuHandle);
+	commandList->SetComputeRootUnorderedAccessView(2, _histogramBuffer->GetGPUVirtualAddress());
+
+	commandList->Dispatch(
+		(size.width + THREAD_GROUP_SIZE - 1) / THREAD_GROUP_SIZE,
+		(size.height + THREAD_GROUP_SIZE - 1) / THREAD_GROUP_SIZE,
+		1
+	);
+}
+
+HRESULT AutoExposurePass::_ReadHistogram(uint32_t frameIndex, LuminanceHistogram::Bins& bins) const noexcept {
+	const D3D12_RANGE readRange = { HISTOGRAM_SIZE * frameIndex, HISTOGRAM_SIZE * (frameIndex + 1) };
+	void* data;
+	HRESULT hr = _readbackBuffer->Map(0, &readRange, &data);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	std::memcpy(bins.data(), (const uint8_t*)data + readRange.Begin, HISTOGRAM_SIZE);
+
+	const D3D12_RANGE writtenRange{};
+	_readbackBuffer->Unmap(0, &writtenRange);
+	return S_OK;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "D3D12Context.h"
+#include "LuminanceHistogram.h"
+#include "RenderGraph.h"
+#include <chrono>
+
+// 自动曝光。shaders/LuminanceHistogram_CS.hlsl 统计 scRGB 场景的亮度直方图，每帧复制到这一帧
+// 独占的回读缓冲。同一个帧索引下次开始时 GPU 已经完成，因此读取时无需等待，直方图的延迟为在途
+// 帧数。曝光由 ColorLutPass 在 LUT 之前应用。要求 SM6。
+class AutoExposurePass {
+public:
+	// 和 CPU 参考实现比较的结果
+	struct ValidationResult {
+		uint64_t pixelCount = 0;
+		uint64_t gpuPixelCount = 0;
+		// 两个直方图之差的绝对值之和的一半，即至少有这么多像素分到了不同的桶
+		uint64_t mismatchCount = 0;
+	};
+
+	AutoExposurePass() = default;
+	AutoExposurePass(const AutoExposurePass&) = delete;
+	AutoExposurePass(AutoExposurePass&&) = default;
+
+	HRESULT Initialize(D3D12Context& d3d12Context) noexcept;
+
+	// 在渲染线程调用，BeginFrame 之后。读取这个帧索引上次写入的直方图并更新曝光，headroom 为
+	// 显示器的最大亮度和 SDR 白的比值。
+	HRESULT Prepare(D3D12Context& d3d12Context, uint32_t frameIndex, float headroom) noexcept;
+
+	float GetExposure() const noexcept {
+		return _exposure;
+	}
+
+	// scene 是场景的 FP16 渲染目标。调用者负责在 commandListIndex 对应的命令列表中设置
+	// D3D12Context 的着色器可见描述符堆。
+	void AddPasses(
+		RenderGraph& renderGraph,
+		uint32_t commandListIndex,
+		RenderGraphResource scene,
+		uint32_t frameIndex,
+		Size size
+	) noexcept;
+
+	// 在渲染线程调用，瞬态资源绑定之后为 scene 创建 SRV
+	HRESULT BindScene(D3D12Context& d3d12Context, ID3D12Resource* scene) noexcept;
+
+	// 在默认显卡上统计随机生成的 FP16 图像，和 LuminanceHistogram::Build 比较。不创建窗口，
+	// 没有显卡时使用 WARP。用于测试。
+	static HRESULT Validate(Size size, ValidationResult& result) noexcept;
+
+private:
+	HRESULT _CreatePipeline(D3D12Context& d3d12Context) noexcept;
+
+	void _Record(ID3D12GraphicsCommandList* commandList, Size size) const noexcept;
+
+	HRESULT _ReadHistogram(uint32_t frameIndex, LuminanceHistogram::Bins& bins) const noexcept;
+
+	winrt::com_ptr<ID3D12RootSignature> _rootSignature;
+	winrt::com_ptr<ID3D12PipelineState> _pipelineState;
+
+	winrt::com_ptr<ID3D12Resource> _histogramBuffer;
+	HeapAllocation _histogramBufferAllocation;
+	// 每个帧索引一个直方图
+	winrt::com_ptr<ID3D12Resource> _readbackBuffer;
+	HeapAllocation _readbackBufferAllocation;
+	// 第 i 位表示第 i 个帧索引的直方图是否已写入
+	uint32_t _readbackMask = 0;
+
+	DescriptorAllocation _cpuDescriptor;
+	DescriptorAllocation _frameDescriptor;
+	// 这一帧用于清零直方图
+	UploadAllocation _zeroUpload{};
+
+	float _exposure = 1.0f;
+	bool _hasExposure = false;
+	std::chrono::steady_clock::time_point _lastUpdateTime;
+};
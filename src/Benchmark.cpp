@@ -0,0 +1,163 @@
+// 不依赖 D3D12，不使用预编译头，以便在其他平台测试
+#include "Benchmark.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+
+// 报告的格式改变时递增
+static constexpr uint32_t REPORT_VERSION = 2;
+
+static double ToMilliseconds(std::chrono::steady_clock::duration duration) noexcept {
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// 最近秩法，samples 已排序且不为空
+static double GetPercentile(const std::vector<double>& samples, double percentile) noexcept {
+	const size_t rank = (size_t)std::ceil(percentile * samples.size());
+	return samples[std::clamp(rank, (size_t)1, samples.size()) - 1];
+}
+
+static void AppendFormat(std::string& str, const char* format, auto... args) noexcept {
+	char buffer[128];
+	const int length = std::snprintf(buffer, sizeof(buffer), format, args...);
+	if (length > 0) {
+		str.append(buffer, std::min((size_t)length, sizeof(buffer) - 1));
+	}
+}
+
+static void AppendJsonString(std::string& json, std::string_view str) noexcept {
+	json += '"';
+	for (char c : str) {
+		if (c == '"' || c == '\\') {
+			json += '\\';
+			json += c;
+		} else if ((unsigned char)c < 0x20) {
+			AppendFormat(json, "\\u%04x", (unsigned int)c);
+		} else {
+			json += c;
+		}
+	}
+	json += '"';
+}
+
+static void AppendSummary(std::string& json, const char* name, const Benchmark::Summary& summary) noexcept {
+	AppendFormat(json, "\t\"%s\": {\n\t\t\"count\": %u,\n", name, summary.count);
+	AppendFormat(json, "\t\t\"min\": %.4f,\n\t\t\"mean\": %.4f,\n", summary.min, summary.mean);
+	AppendFormat(json, "\t\t\"p50\": %.4f,\n\t\t\"p95\": %.4f,\n", summary.p50, summary.p95);
+	AppendFormat(json, "\t\t\"p99\": %.4f,\n\t\t\"p99.9\": %.4f,\n", summary.p99, summary.p999);
+	AppendFormat(json, "\t\t\"max\": %.4f\n\t}", summary.max);
+}
+
+bool Benchmark::AddFrame(const FrameTiming& timing) noexcept {
+	const bool hasLastPresent = _frameCount > 0;
+	const std::chrono::steady_clock::time_point lastPresentTime =
+		std::exchange(_lastPresentTime, timing.presentTime);
+
+	if (++_frameCount <= _options.warmupFrameCount) {
+		return false;
+	}
+
+	if (_cpuTimes.empty()) {
+		_firstFrameNumber = timing.frameNumber;
+		_startTime = hasLastPresent ? lastPresentTime : timing.presentTime;
+	}
+
+	_cpuTimes.push_back(timing.cpuTime);
+	if (hasLastPresent) {
+		_presentIntervals.push_back(ToMilliseconds(timing.presentTime - lastPresentTime));
+	}
+	// 预热帧的 GPU 耗时可能在预热结束后才读取到
+	if (timing.gpuTime >= 0 && timing.gpuFrameNumber >= _firstFrameNumber) {
+		_gpuTimes.push_back(timing.gpuTime);
+	}
+
+	_duration = ToMilliseconds(timing.presentTime - _startTime) / 1000;
+
+	return (_options.frameCount > 0 && _cpuTimes.size() >= _options.frameCount) ||
+		(_options.duration > 0 && _duration >= _options.duration);
+}
+
+Benchmark::Summary Benchmark::Summarize(std::vector<double>& samples) noexcept {
+	if (samples.empty()) {
+		return {};
+	}
+
+	std::sort(samples.begin(), samples.end());
+
+	double sum = 0;
+	for (double sample : samples) {
+		sum += sample;
+	}
+
+	return {
+		.count = (uint32_t)samples.size(),
+		.min = samples.front(),
+		.mean = sum / samples.size(),
+		.p50 = GetPercentile(samples, 0.5),
+		.p95 = GetPercentile(samples, 0.95),
+		.p99 = GetPercentile(samples, 0.99),
+		.p999 = GetPercentile(samples, 0.999),
+		.max = samples.back()
+	};
+}
+
+std::string Benchmark::GenerateReport(const Environment& environment, const RendererStats& rendererStats) noexcept {
+	std::string json = "{\n";
+	AppendFormat(json, "\t\"version\": %u,\n", REPORT_VERSION);
+
+	json += "\t\"adapter\": {\n\t\t\"name\": ";
+	AppendJsonString(json, environment.adapterName);
+	AppendFormat(json, ",\n\t\t\"vendorId\": \"0x%04X\",\n\t\t\"deviceId\": \"0x%04X\",\n",
+		environment.vendorId, environment.deviceId);
+	AppendFormat(json, "\t\t\"driverVersion\": \"%u.%u.%u.%u\"\n\t},\n",
+		(uint32_t)(environment.driverVersion >> 48), (uint32_t)(environment.driverVersion >> 32) & 0xFFFF,
+		(uint32_t)(environment.driverVersion >> 16) & 0xFFFF, (uint32_t)environment.driverVersion & 0xFFFF);
+
+	json += "\t\"colorMode\": ";
+	AppendJsonString(json, environment.colorMode);
+	json += ",\n\t\"commandLine\": ";
+	AppendJsonString(json, environment.commandLine);
+	json += ",\n";
+
+	AppendFormat(json, "\t\"width\": %u,\n\t\"height\": %u,\n", _options.width, _options.height);
+	AppendFormat(json, "\t\"warmupFrameCount\": %u,\n", _options.warmupFrameCount);
+	AppendFormat(json, "\t\"frameCount\": %u,\n", (uint32_t)_cpuTimes.size());
+	AppendFormat(json, "\t\"duration\": %.4f,\n", _duration);
+
+	// 时间的单位都是毫秒
+	AppendSummary(json, "cpuFrameTime", Summarize(_cpuTimes));
+	json += ",\n";
+	AppendSummary(json, "gpuFrameTime", Summarize(_gpuTimes));
+	json += ",\n";
+	AppendSummary(json, "presentInterval", Summarize(_presentIntervals));
+	json += ",\n";
+
+	AppendFormat(json, "\t\"uploadRing\": {\n\t\t\"lastFrameBytes\": %llu,\n\t\t\"maxFrameBytes\": %llu,\n",
+		(unsigned long long)rendererStats.uploadLastFrameBytes, (unsigned long long)rendererStats.uploadMaxFrameBytes);
+	AppendFormat(json, "\t\t\"wrapCount\": %llu,\n\t\t\"stallCount\": %llu\n\t},\n",
+		(unsigned long long)rendererStats.uploadWrapCount, (unsigned long long)rendererStats.uploadStallCount);
+	AppendFormat(json, "\t\"commandAllocatorPool\": {\n\t\t\"count\": %u,\n\t\t\"inUseCount\": %u,\n",
+		rendererStats.commandAllocatorCount, rendererStats.commandAllocatorInUseCount);
+	AppendFormat(json, "\t\t\"maxCount\": %u,\n\t\t\"maxInUseCount\": %u\n\t},\n",
+		rendererStats.maxCommandAllocatorCount, rendererStats.maxCommandAllocatorInUseCount);
+
+	AppendFormat(json, "\t\"heapAllocator\": {\n\t\t\"heapCount\": %u,\n\t\t\"heapSize\": %llu,\n",
+		rendererStats.heapCount, (unsigned long long)rendererStats.heapSize);
+	AppendFormat(json, "\t\t\"usedSize\": %llu,\n\t\t\"requestedSize\": %llu,\n",
+		(unsigned long long)rendererStats.heapUsedSize, (unsigned long long)rendererStats.heapRequestedSize);
+	AppendFormat(json, "\t\t\"largestFreeBlockSize\": %llu,\n\t\t\"freeBlockCount\": %u,\n",
+		(unsigned long long)rendererStats.largestFreeBlockSize, rendererStats.freeBlockCount);
+	AppendFormat(json, "\t\t\"placedResourceCount\": %u,\n\t\t\"committedResourceCount\": %u\n\t},\n",
+		rendererStats.placedResourceCount, rendererStats.committedResourceCount);
+
+	AppendFormat(json, "\t\"pipelineCompilation\": {\n\t\t\"sdrCompileTime\": %.4f,\n",
+		rendererStats.sdrPipelineCompileTime);
+	AppendFormat(json, "\t\t\"advancedColorCompileTime\": %.4f,\n\t\t\"hdr10CompileTime\": %.4f,\n",
+		rendererStats.advancedColorPipelineCompileTime, rendererStats.hdr10PipelineCompileTime);
+	AppendFormat(json, "\t\t\"waitTime\": %.4f,\n\t\t\"deferredColorModeSwitchCount\": %u\n\t}",
+		rendererStats.pipelineWaitTime, rendererStats.deferredColorModeSwitchCount);
+	json += "\n}\n";
+
+	return json;
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// 基准测试模式的统计和报告。逐帧记录 CPU 耗时、GPU 耗时和 Present 间隔，结束后计算百分位数
+// 并生成 JSON，用于比较不同的构建和驱动。不依赖 D3D12 和窗口。
+class Benchmark {
+public:
+	struct Options {
+		// 预热之后统计的帧数和时间（秒），为 0 表示不限制，都设置时先达到的为准
+		uint32_t frameCount = 0;
+		double duration = 0;
+		// 不计入统计的帧数，用于排除管线编译和资源上传
+		uint32_t warmupFrameCount = 60;
+		// 客户区的尺寸，以像素为单位，不随 DPI 缩放
+		uint32_t width = 1280;
+		uint32_t height = 720;
+		std::filesystem::path outputPath;
+	};
+
+	// Renderer 每帧的计时，单位为毫秒
+	struct FrameTiming {
+		// 从 0 开始的帧序号
+		uint64_t frameNumber = 0;
+		// Renderer::Render 的耗时，包括提交和 Present
+		double cpuTime = 0;
+		std::chrono::steady_clock::time_point presentTime;
+		// GPU 耗时有几帧的延迟，这是第 gpuFrameNumber 帧的结果。gpuTime 为负表示没有新结果。
+		uint64_t gpuFrameNumber = 0;
+		double gpuTime = -1;
+	};
+
+	// 单位为毫秒。百分位数使用最近秩法，总是样本中的某个值，样本为空时全部为 0。
+	struct Summary {
+		uint32_t count = 0;
+		double min = 0;
+		double mean = 0;
+		double p50 = 0;
+		double p95 = 0;
+		double p99 = 0;
+		double p999 = 0;
+		double max = 0;
+	};
+
+	// 报告中的测试环境，字符串为 UTF-8
+	struct Environment {
+		std::string adapterName;
+		uint32_t vendorId = 0;
+		uint32_t deviceId = 0;
+		// 用户模式驱动的版本，四个 16 位的部分
+		uint64_t driverVersion = 0;
+		std::string colorMode;
+		std::string commandLine;
+	};
+
+	// 报告中 Renderer 的内部统计，测试结束时读取
+	struct RendererStats {
+		// 上传环形缓冲区上一帧和单帧最多使用的字节数，回绕和因空间不足等待 GPU 的次数
+		uint64_t uploadLastFrameBytes = 0;
+		uint64_t uploadMaxFrameBytes = 0;
+		uint64_t uploadWrapCount = 0;
+		uint64_t uploadStallCount = 0;
+		// 命令分配器池的大小和正在使用的数量，以及它们的峰值
+		uint32_t commandAllocatorCount = 0;
+		uint32_t commandAllocatorInUseCount = 0;
+		uint32_t maxCommandAllocatorCount = 0;
+		uint32_t maxCommandAllocatorInUseCount = 0;
+		// 放置资源所在的堆。usedSize 和 requestedSize 的差为内部碎片，最大空闲块和空闲空间的
+		// 比例反映外部碎片。
+		uint32_t heapCount = 0;
+		uint64_t heapSize = 0;
+		uint64_t heapUsedSize = 0;
+		uint64_t heapRequestedSize = 0;
+		uint64_t largestFreeBlockSize = 0;
+		uint32_t freeBlockCount = 0;
+		uint32_t placedResourceCount = 0;
+		uint32_t committedResourceCount = 0;
+		// 启动时后台编译管线的耗时，单位为毫秒。每种颜色模式从派发到全部完成，未编译的为 0。
+		double sdrPipelineCompileTime = 0;
+		double advancedColorPipelineCompileTime = 0;
+		double hdr10PipelineCompileTime = 0;
+		// 渲染线程等待编译完成的总时间，即编译造成的卡顿
+		double pipelineWaitTime = 0;
+		// 因管线未就绪而推迟的颜色模式切换次数
+		uint32_t deferredColorModeSwitchCount = 0;
+	};
+
+	explicit Benchmark(const Options& options) noexcept : _options(options) {}
+
+	// 每帧调用一次，返回 true 表示测试已结束
+	bool AddFrame(const FrameTiming& timing) noexcept;
+
+	// 会将 samples 排序
+	static Summary Summarize(std::vector<double>& samples) noexcept;
+
+	std::string GenerateReport(const Environment& environment, const RendererStats& rendererStats) noexcept;
+
+	const Options& GetOptions() const noexcept {
+		return _options;
+	}
+
+private:
+	Options _options;
+
+	uint32_t _frameCount = 0;
+	// 第一个统计的帧的序号，这之前的 GPU 耗时不计入
+	uint64_t _firstFrameNumber = 0;
+	// 预热结束的时刻，即最后一个预热帧 Present 返回的时刻
+	std::chrono::steady_clock::time_point _startTime;
+	std::chrono::steady_clock::time_point _lastPresentTime;
+	double _duration = 0;
+
+	std::vector<double> _cpuTimes;
+	std::vector<double> _gpuTimes;
+	std::vector<double> _presentIntervals;
+};
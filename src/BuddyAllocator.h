@@ -0,0 +1,154 @@
+#pragma once
+#include <set>
+
+// 伙伴分配算法，只管理偏移，不依赖 D3D12。容量为 minBlockSize << maxOrder，每个块的大小是
+// minBlockSize 的 2 的幂倍，并且按自身大小对齐。释放时和空闲的伙伴块合并。
+class BuddyAllocator {
+public:
+	struct Allocation {
+		uint64_t offset = 0;
+		// 请求的大小，块的大小为 minBlockSize << order
+		uint64_t size = 0;
+		uint32_t order = 0;
+	};
+
+	struct Stats {
+		uint64_t capacity = 0;
+		// 已分配的块的总大小
+		uint64_t usedSize = 0;
+		// 请求的总大小，和 usedSize 的差为内部碎片
+		uint64_t requestedSize = 0;
+		uint32_t allocationCount = 0;
+		uint32_t freeBlockCount = 0;
+		// 空闲空间都在一个块中时外部碎片为 0
+		uint64_t largestFreeBlockSize = 0;
+	};
+
+	BuddyAllocator() = default;
+	BuddyAllocator(const BuddyAllocator&) = delete;
+	BuddyAllocator(BuddyAllocator&&) = default;
+	BuddyAllocator& operator=(BuddyAllocator&&) = default;
+
+	// minBlockSize 必须是 2 的幂
+	BuddyAllocator(uint64_t minBlockSize, uint32_t maxOrder) noexcept
+		: _minBlockSize(minBlockSize), _freeBlocks(maxOrder + 1)
+	{
+		assert(minBlockSize > 0 && (minBlockSize & (minBlockSize - 1)) == 0);
+		_freeBlocks[maxOrder].insert(0);
+	}
+
+	uint64_t GetCapacity() const noexcept {
+		return _GetBlockSize(_GetMaxOrder());
+	}
+
+	bool IsEmpty() const noexcept {
+		return _allocationCount == 0;
+	}
+
+	// alignment 必须是 2 的幂。空间不足时返回 false。
+	bool Allocate(uint64_t size, uint64_t alignment, Allocation& allocation) noexcept {
+		assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+		// 块按自身大小对齐，因此块不小于 alignment 即可满足对齐要求
+		const uint64_t blockSize = std::max(size, alignment);
+		if (size == 0 || _freeBlocks.empty() || blockSize > GetCapacity()) {
+			return false;
+		}
+
+		const uint32_t order = _GetOrder(blockSize);
+
+		// 查找足够大的最小空闲块
+		uint32_t curOrder = order;
+		while (_freeBlocks[curOrder].empty()) {
+			if (++curOrder > _GetMaxOrder()) {
+				return false;
+			}
+		}
+
+		// 优先使用偏移最小的块，使空闲空间集中在末尾
+		const uint64_t offset = *_freeBlocks[curOrder].begin();
+		_freeBlocks[curOrder].erase(_freeBlocks[curOrder].begin());
+
+		// 拆分多余的部分，后一半成为空闲块
+		while (curOrder > order) {
+			--curOrder;
+			_freeBlocks[curOrder].insert(offset + _GetBlockSize(curOrder));
+		}
+
+		_usedSize += _GetBlockSize(order);
+		_requestedSize += size;
+		++_allocationCount;
+
+		allocation = { .offset = offset, .size = size, .order = order };
+		return true;
+	}
+
+	void Free(const Allocation& allocation) noexcept {
+		assert(_allocationCount > 0);
+
+		_usedSize -= _GetBlockSize(allocation.order);
+		_requestedSize -= allocation.size;
+		--_allocationCount;
+
+		uint64_t offset = allocation.offset;
+		uint32_t order = allocation.order;
+
+		// 伙伴块空闲则合并
+		while (order < _GetMaxOrder()) {
+			const uint64_t buddyOffset = offset ^ _GetBlockSize(order);
+			auto it = _freeBlocks[order].find(buddyOffset);
+			if (it == _freeBlocks[order].end()) {
+				break;
+			}
+
+			_freeBlocks[order].erase(it);
+			offset = std::min(offset, buddyOffset);
+			++order;
+		}
+
+		_freeBlocks[order].insert(offset);
+	}
+
+	Stats GetStats() const noexcept {
+		Stats stats = {
+			.capacity = GetCapacity(),
+			.usedSize = _usedSize,
+			.requestedSize = _requestedSize,
+			.allocationCount = _allocationCount
+		};
+
+		for (uint32_t order = 0; order < (uint32_t)_freeBlocks.size(); ++order) {
+			if (!_freeBlocks[order].empty()) {
+				stats.freeBlockCount += (uint32_t)_freeBlocks[order].size();
+				stats.largestFreeBlockSize = _GetBlockSize(order);
+			}
+		}
+
+		return stats;
+	}
+
+private:
+	uint32_t _GetMaxOrder() const noexcept {
+		return (uint32_t)_freeBlocks.size() - 1;
+	}
+
+	uint64_t _GetBlockSize(uint32_t order) const noexcept {
+		return _minBlockSize << order;
+	}
+
+	// 能容纳 size 的最小块
+	uint32_t _GetOrder(uint64_t size) const noexcept {
+		uint32_t order = 0;
+		while (_GetBlockSize(order) < size) {
+			++order;
+		}
+		return order;
+	}
+
+	uint64_t _minBlockSize = 0;
+	// 每个阶的空闲块的偏移
+	std::vector<std::set<uint64_t>> _freeBlocks;
+	uint64_t _usedSize = 0;
+	uint64_t _requestedSize = 0;
+	uint32_t _allocationCount = 0;
+};
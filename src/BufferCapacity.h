@@ -0,0 +1,26 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+// 按元素数增长的缓冲的容量策略，不依赖 D3D12 以便在其他平台测试
+namespace BufferCapacity {
+
+// 返回容纳 count 个元素所需的容量，current 足够时原样返回。容量从 minCapacity 开始按 2 的幂
+// 增长以减少重新创建的次数，元素数减少时不收缩。超出 UINT32_MAX 时返回 count，字节数由调用者
+// 检查。
+inline uint32_t Grow(uint32_t current, uint32_t count, uint32_t minCapacity) noexcept {
+	assert(minCapacity > 0);
+	if (count <= current) {
+		return current;
+	}
+
+	uint64_t capacity = std::max(current, minCapacity);
+	while (capacity < count) {
+		capacity *= 2;
+	}
+
+	return capacity > UINT32_MAX ? count : (uint32_t)capacity;
+}
+
+}
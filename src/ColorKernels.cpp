@@ -0,0 +1,423 @@
+// 不依赖 D3D12，不使用预编译头，以便在其他平台测试
+#include "ColorKernels.h"
+#include "ColorKernelsSimd.h"
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifdef COLOR_KERNELS_X64
+#ifdef _WIN32
+#include <Windows.h>
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace ColorKernels {
+
+using Detail::KernelTable;
+
+namespace {
+
+// 标量实现，也作为其他指令集的参考
+struct Scalar {
+	using D = double;
+	using M = bool;
+
+	static constexpr size_t LANES = 1;
+
+	static D Load(const float* src) noexcept { return *src; }
+	static void Store(float* dst, D value) noexcept { *dst = (float)value; }
+	static D Set(double value) noexcept { return value; }
+	static D Add(D a, D b) noexcept { return a + b; }
+	static D Sub(D a, D b) noexcept { return a - b; }
+	static D Mul(D a, D b) noexcept { return a * b; }
+	static D Div(D a, D b) noexcept { return a / b; }
+	static D MulAdd(D a, D b, D c) noexcept { return a * b + c; }
+	static D Min(D a, D b) noexcept { return a < b ? a : b; }
+	static D Max(D a, D b) noexcept { return a > b ? a : b; }
+	static D Abs(D a) noexcept { return std::abs(a); }
+	static D CopySign(D a, D b) noexcept { return std::copysign(a, b); }
+	static D Round(D a) noexcept { return std::nearbyint(a); }
+	static M Less(D a, D b) noexcept { return a < b; }
+	static M LessEqual(D a, D b) noexcept { return a <= b; }
+	static D Select(M m, D a, D b) noexcept { return m ? a : b; }
+
+	static D GetExponent(D x) noexcept {
+		return (double)(std::bit_cast<uint64_t>(x) >> 52);
+	}
+
+	static D GetMantissa(D x) noexcept {
+		return std::bit_cast<double>((std::bit_cast<uint64_t>(x) & 0x000FFFFFFFFFFFFFull) | 0x3FF0000000000000ull);
+	}
+
+	static D Pow2(D n) noexcept {
+		return std::bit_cast<double>((uint64_t)((int64_t)n + 1023) << 52);
+	}
+
+	static void PackHalf(const float* const src[3], uint16_t* dst, size_t count) noexcept {
+		Detail::PackHalfScalar(src, dst, count);
+	}
+
+	static void UnpackHalf(const uint16_t* src, float* const dst[3], size_t count) noexcept {
+		Detail::UnpackHalfScalar(src, dst, count);
+	}
+};
+
+}
+
+static constexpr KernelTable SCALAR_KERNELS = Detail::MakeKernelTable<Scalar>();
+
+#ifdef COLOR_KERNELS_X64
+// 依次为 EAX、EBX、ECX、EDX
+static void GetCpuid(uint32_t leaf, uint32_t (&info)[4]) noexcept {
+#ifdef _WIN32
+	__cpuidex((int*)info, (int)leaf, 0);
+#else
+	__cpuid_count(leaf, 0, info[0], info[1], info[2], info[3]);
+#endif
+}
+
+static bool IsSSE41Supported() noexcept {
+#ifdef _WIN32
+	return IsProcessorFeaturePresent(PF_SSE4_1_INSTRUCTIONS_AVAILABLE);
+#else
+	uint32_t info[4];
+	GetCpuid(1, info);
+	return (info[2] & (1 << 19)) != 0;
+#endif
+}
+
+static bool IsAVX2Supported() noexcept {
+	uint32_t info[4];
+	GetCpuid(1, info);
+
+#ifdef _WIN32
+	// 同时检查了操作系统是否保存 YMM 寄存器
+	if (!IsProcessorFeaturePresent(PF_AVX2_INSTRUCTIONS_AVAILABLE)) {
+		return false;
+	}
+#else
+	// 需要 OSXSAVE 和 AVX，并且操作系统在 XCR0 中启用了 XMM 和 YMM 的状态
+	if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28))) {
+		return false;
+	}
+
+	uint32_t xcr0Low, xcr0High;
+	__asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+	if ((xcr0Low & 6) != 6) {
+		return false;
+	}
+
+	uint32_t extendedInfo[4];
+	GetCpuid(7, extendedInfo);
+	if (!(extendedInfo[1] & (1 << 5))) {
+		return false;
+	}
+#endif
+
+	// IsProcessorFeaturePresent 不能检查 FMA 和 F16C，支持 AVX2 的 CPU 实际上都支持
+	return (info[2] & (1 << 12)) && (info[2] & (1 << 29));
+}
+#endif
+
+static const KernelTable* GetKernelTable(InstructionSet instructionSet) noexcept {
+	switch (instructionSet) {
+	case InstructionSet::Scalar:
+		return &SCALAR_KERNELS;
+#ifdef COLOR_KERNELS_X64
+	case InstructionSet::SSE4:
+		return IsSSE41Supported() ? Detail::SSE4_KERNELS : nullptr;
+	case InstructionSet::AVX2:
+		return IsAVX2Supported() ? Detail::AVX2_KERNELS : nullptr;
+#endif
+	case InstructionSet::NEON:
+		// ARM64 总是支持
+		return Detail::NEON_KERNELS;
+	default:
+		return nullptr;
+	}
+}
+
+static std::atomic<const KernelTable*> currentKernels = nullptr;
+static std::atomic<InstructionSet> currentInstructionSet = InstructionSet::Scalar;
+
+static const KernelTable& GetKernels() noexcept {
+	const KernelTable* kernels = currentKernels.load(std::memory_order_acquire);
+	if (kernels) {
+		return *kernels;
+	}
+
+	// 多个线程同时初始化时结果相同
+	for (InstructionSet instructionSet : { InstructionSet::AVX2, InstructionSet::SSE4, InstructionSet::NEON }) {
+		if (SetInstructionSet(instructionSet)) {
+			return *currentKernels.load(std::memory_order_acquire);
+		}
+	}
+
+	SetInstructionSet(InstructionSet::Scalar);
+	return SCALAR_KERNELS;
+}
+
+InstructionSet GetInstructionSet() noexcept {
+	GetKernels();
+	return currentInstructionSet.load(std::memory_order_relaxed);
+}
+
+const char* GetInstructionSetName(InstructionSet instructionSet) noexcept {
+	static constexpr const char* NAMES[] = { "Scalar", "SSE4", "AVX2", "NEON" };
+	return NAMES[(size_t)instructionSet];
+}
+
+bool IsInstructionSetSupported(InstructionSet instructionSet) noexcept {
+	return GetKernelTable(instructionSet) != nullptr;
+}
+
+bool SetInstructionSet(InstructionSet instructionSet) noexcept {
+	const KernelTable* kernels = GetKernelTable(instructionSet);
+	if (!kernels) {
+		return false;
+	}
+
+	currentInstructionSet.store(instructionSet, std::memory_order_relaxed);
+	currentKernels.store(kernels, std::memory_order_release);
+	return true;
+}
+
+void SRGBToLinear(const float* src, float* dst, size_t count) noexcept {
+	GetKernels().srgbToLinear(src, dst, count);
+}
+
+void LinearToSRGB(const float* src, float* dst, size_t count) noexcept {
+	GetKernels().linearToSRGB(src, dst, count);
+}
+
+void LinearToPQ(const float* src, float* dst, size_t count, float scale) noexcept {
+	GetKernels().linearToPQ(src, dst, count, scale);
+}
+
+void PQToLinear(const float* src, float* dst, size_t count, float scale) noexcept {
+	GetKernels().pqToLinear(src, dst, count, scale);
+}
+
+void Scale(const float* src, float* dst, size_t count, float scale) noexcept {
+	GetKernels().scale(src, dst, count, scale);
+}
+
+void TransformGamut(const float* const src[3], float* const dst[3], size_t count, const Matrix3x3& matrix) noexcept {
+	GetKernels().transformGamut(src, dst, count, matrix);
+}
+
+// 编码表以线性值的浮点表示为索引：指数不小于 -13，保留尾数的高 11 位，更小的值编码为 0。每个
+// 区间内编码最多变化一次，表中是区间起点的编码，再和下一个编码的起点比较得到精确结果。
+static constexpr uint32_t SRGB8_TABLE_MIN_BITS = (127 - 13) << 23;
+static constexpr uint32_t SRGB8_TABLE_SHIFT = 12;
+static constexpr uint32_t SRGB8_TABLE_SIZE = (((127 << 23) - SRGB8_TABLE_MIN_BITS) >> SRGB8_TABLE_SHIFT) + 1;
+
+struct SRGB8Table {
+	std::array<uint8_t, SRGB8_TABLE_SIZE> codes;
+	// thresholds[i] 是编码为 i + 1 的最小线性值
+	std::array<float, 256> thresholds;
+};
+
+// 不经过单精度舍入
+static uint32_t EncodeSRGB8Exact(float value) noexcept {
+	return (uint32_t)std::nearbyint(Detail::LinearToSRGB<Scalar>(value) * 255);
+}
+
+static const SRGB8Table& GetSRGB8Table() noexcept {
+	static const SRGB8Table table = [] {
+		SRGB8Table result;
+		for (uint32_t i = 0; i < SRGB8_TABLE_SIZE; ++i) {
+			const uint32_t bits = SRGB8_TABLE_MIN_BITS + (i << SRGB8_TABLE_SHIFT);
+			result.codes[i] = (uint8_t)EncodeSRGB8Exact(std::min(std::bit_cast<float>(bits), 1.0f));
+		}
+
+		// 正浮点数的表示和大小的顺序相同，二分查找每个编码的起点
+		for (uint32_t code = 0; code < 255; ++code) {
+			uint32_t low = 0;
+			uint32_t high = std::bit_cast<uint32_t>(1.0f);
+			while (low < high) {
+				const uint32_t mid = (low + high) / 2;
+				if (EncodeSRGB8Exact(std::bit_cast<float>(mid)) > code) {
+					high = mid;
+				} else {
+					low = mid + 1;
+				}
+			}
+			result.thresholds[code] = std::bit_cast<float>(low);
+		}
+		result.thresholds[255] = std::numeric_limits<float>::infinity();
+		return result;
+	}();
+	return table;
+}
+
+static uint32_t EncodeSRGB8(const SRGB8Table& table, float value) noexcept {
+	// 比较的顺序使 NaN 被视为 0
+	value = value > 0.0f ? value : 0.0f;
+	value = value < 1.0f ? value : 1.0f;
+	const uint32_t bits = std::max(std::bit_cast<uint32_t>(value), SRGB8_TABLE_MIN_BITS);
+	const uint32_t code = table.codes[(bits - SRGB8_TABLE_MIN_BITS) >> SRGB8_TABLE_SHIFT];
+	return code + (value >= table.thresholds[code]);
+}
+
+void PackSRGB8(const float* const src[3], uint32_t* dst, size_t count) noexcept {
+	const SRGB8Table& table = GetSRGB8Table();
+
+	for (size_t i = 0; i < count; ++i) {
+		dst[i] = EncodeSRGB8(table, src[0][i])
+			| (EncodeSRGB8(table, src[1][i]) << 8)
+			| (EncodeSRGB8(table, src[2][i]) << 16)
+			| 0xFF000000u;
+	}
+}
+
+void UnpackSRGB8(const uint32_t* src, float* const dst[3], size_t count) noexcept {
+	static const std::array<float, 256> table = [] {
+		std::array<float, 256> values;
+		for (uint32_t i = 0; i < 256; ++i) {
+			values[i] = i / 255.0f;
+		}
+		SCALAR_KERNELS.srgbToLinear(values.data(), values.data(), values.size());
+		return values;
+	}();
+
+	for (size_t i = 0; i < count; ++i) {
+		const uint32_t value = src[i];
+		dst[0][i] = table[value & 0xFF];
+		dst[1][i] = table[(value >> 8) & 0xFF];
+		dst[2][i] = table[(value >> 16) & 0xFF];
+	}
+}
+
+void PackHalf(const float* const src[3], uint16_t* dst, size_t count) noexcept {
+	GetKernels().packHalf(src, dst, count);
+}
+
+void UnpackHalf(const uint16_t* src, float* const dst[3], size_t count) noexcept {
+	GetKernels().unpackHalf(src, dst, count);
+}
+
+static uint32_t EncodeUNorm10(float value) noexcept {
+	// 比较的顺序使 NaN 被视为 0
+	value = value > 0.0f ? value : 0.0f;
+	value = value < 1.0f ? value : 1.0f;
+	return (uint32_t)std::nearbyint(value * 1023.0f);
+}
+
+void PackUNorm10(const float* const src[3], uint32_t* dst, size_t count) noexcept {
+	for (size_t i = 0; i < count; ++i) {
+		dst[i] = EncodeUNorm10(src[0][i])
+			| (EncodeUNorm10(src[1][i]) << 10)
+			| (EncodeUNorm10(src[2][i]) << 20)
+			| 0xC0000000u;
+	}
+}
+
+void UnpackUNorm10(const uint32_t* src, float* const dst[3], size_t count) noexcept {
+	for (size_t i = 0; i < count; ++i) {
+		const uint32_t value = src[i];
+		dst[0][i] = (value & 0x3FF) / 1023.0f;
+		dst[1][i] = ((value >> 10) & 0x3FF) / 1023.0f;
+		dst[2][i] = ((value >> 20) & 0x3FF) / 1023.0f;
+	}
+}
+
+const char* GetKernelName(Kernel kernel) noexcept {
+	static constexpr const char* NAMES[] = {
+		"SRGBToLinear",
+		"LinearToSRGB",
+		"LinearToPQ",
+		"PQToLinear",
+		"Scale",
+		"TransformGamut",
+		"PackHalf",
+		"UnpackHalf"
+	};
+	static_assert(std::size(NAMES) == (size_t)Kernel::COUNT);
+
+	return NAMES[(size_t)kernel];
+}
+
+std::vector<BenchmarkResult> Benchmark(uint32_t pixelCount, uint32_t iterationCount) noexcept {
+	// 覆盖所有分支：0 附近的线性段、[0, 1] 和 HDR 下超过 1 的值
+	std::vector<float> input((size_t)pixelCount * 3);
+	for (size_t i = 0; i < input.size(); ++i) {
+		input[i] = (float)(i % 1000) / 500.0f;
+	}
+
+	std::vector<float> output(input.size());
+	std::vector<uint16_t> packedHalf((size_t)pixelCount * 4);
+
+	const float* const src[3] = { input.data(), input.data() + pixelCount, input.data() + pixelCount * 2 };
+	float* const dst[3] = { output.data(), output.data() + pixelCount, output.data() + pixelCount * 2 };
+
+	const InstructionSet originalInstructionSet = GetInstructionSet();
+	const float pqScale = SCRGB_WHITE_NITS / PQ_MAX_NITS;
+
+	std::vector<BenchmarkResult> results;
+	for (InstructionSet instructionSet : {
+		InstructionSet::Scalar, InstructionSet::SSE4, InstructionSet::AVX2, InstructionSet::NEON
+	}) {
+		if (!SetInstructionSet(instructionSet)) {
+			continue;
+		}
+
+		BenchmarkResult& result = results.emplace_back();
+		result.instructionSet = instructionSet;
+
+		PackHalf(src, packedHalf.data(), pixelCount);
+
+		for (uint32_t i = 0; i < (uint32_t)Kernel::COUNT; ++i) {
+			const auto run = [&] {
+				switch ((Kernel)i) {
+				case Kernel::SRGBToLinear:
+					SRGBToLinear(input.data(), output.data(), input.size());
+					break;
+				case Kernel::LinearToSRGB:
+					LinearToSRGB(input.data(), output.data(), input.size());
+					break;
+				case Kernel::LinearToPQ:
+					LinearToPQ(input.data(), output.data(), input.size(), pqScale);
+					break;
+				case Kernel::PQToLinear:
+					PQToLinear(input.data(), output.data(), input.size(), pqScale);
+					break;
+				case Kernel::Scale:
+					Scale(input.data(), output.data(), input.size(), 2.5f);
+					break;
+				case Kernel::TransformGamut:
+					TransformGamut(src, dst, pixelCount, P3_TO_BT709);
+					break;
+				case Kernel::PackHalf:
+					PackHalf(src, packedHalf.data(), pixelCount);
+					break;
+				default:
+					UnpackHalf(packedHalf.data(), dst, pixelCount);
+					break;
+				}
+			};
+
+			// 预热
+			run();
+
+			const auto start = std::chrono::steady_clock::now();
+
+			for (uint32_t j = 0; j < iterationCount; ++j) {
+				run();
+			}
+
+			const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+			result.pixelsPerSecond[i] = (double)pixelCount * iterationCount / duration.count();
+		}
+	}
+
+	SetInstructionSet(originalInstructionSet);
+	return results;
+}
+
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 批量的颜色转换，用于截图导出、CPU 回落（SoftwareRenderer）和验证 GPU 的输出。有标量、SSE4.1、
+// AVX2 和 NEON 实现，第一次调用时根据 CPU 选择。非线性的转换在内部使用双精度计算，所有实现的
+// 结果和精确值相差不超过 1 ULP。RGB 数据按通道分开存储，源和目标可以相同。不依赖 D3D12。
+namespace ColorKernels {
+
+// scRGB 中 1.0 对应的亮度
+static constexpr float SCRGB_WHITE_NITS = 80.0f;
+// PQ 中 1.0 对应的亮度
+static constexpr float PQ_MAX_NITS = 10000.0f;
+
+// 行主序，作用于列向量
+struct Matrix3x3 {
+	float m[3][3];
+};
+
+// 线性 RGB 在不同色域间的转换，白点都是 D65。由三原色的色度坐标计算。
+static constexpr Matrix3x3 BT709_TO_P3 = { {
+	{ 0.822461969f, 0.177538031f, 0.0f },
+	{ 0.0331941989f, 0.966805801f, 0.0f },
+	{ 0.0170826307f, 0.0723974407f, 0.910519929f }
+} };
+// 每列是 P3 的一个原色在 scRGB 中的值，shaders/AdvancedColor_PS.hlsl 使用
+static constexpr Matrix3x3 P3_TO_BT709 = { {
+	{ 1.22494018f, -0.224940176f, 0.0f },
+	{ -0.0420569547f, 1.04205695f, 0.0f },
+	{ -0.0196375546f, -0.0786360456f, 1.0982736f }
+} };
+static constexpr Matrix3x3 BT709_TO_BT2020 = { {
+	{ 0.627403896f, 0.329283038f, 0.0433130657f },
+	{ 0.0690972894f, 0.919540395f, 0.0113623156f },
+	{ 0.0163914389f, 0.0880133079f, 0.895595253f }
+} };
+static constexpr Matrix3x3 BT2020_TO_BT709 = { {
+	{ 1.660491f, -0.587641139f, -0.0728498633f },
+	{ -0.124550475f, 1.1328999f, -0.0083494226f },
+	{ -0.0181507634f, -0.100578898f, 1.11872966f }
+} };
+static constexpr Matrix3x3 P3_TO_BT2020 = { {
+	{ 0.753833034f, 0.198597369f, 0.0475695966f },
+	{ 0.045743849f, 0.94177722f, 0.0124789312f },
+	{ -0.00121034035f, 0.0176017173f, 0.983608623f }
+} };
+static constexpr Matrix3x3 BT2020_TO_P3 = { {
+	{ 1.34357825f, -0.282179671f, -0.0613985821f },
+	{ -0.0652974528f, 1.07578792f, -0.0104904631f },
+	{ 0.00282178726f, -0.0195984945f, 1.01677671f }
+} };
+
+enum class InstructionSet {
+	Scalar,
+	SSE4,
+	// 也要求 FMA 和 F16C
+	AVX2,
+	NEON
+};
+
+InstructionSet GetInstructionSet() noexcept;
+
+const char* GetInstructionSetName(InstructionSet instructionSet) noexcept;
+
+bool IsInstructionSetSupported(InstructionSet instructionSet) noexcept;
+
+// 用于比较不同实现，CPU 不支持时返回 false。可以在任何线程调用，影响所有线程。
+bool SetInstructionSet(InstructionSet instructionSet) noexcept;
+
+// sRGB 的传递函数，负值按原点对称扩展，和 scRGB 的约定一致。输入应为有限值。
+void SRGBToLinear(const float* src, float* dst, size_t count) noexcept;
+void LinearToSRGB(const float* src, float* dst, size_t count) noexcept;
+
+// SMPTE ST 2084。线性值乘以 scale 后 1.0 对应 PQ_MAX_NITS，scRGB 使用
+// SCRGB_WHITE_NITS / PQ_MAX_NITS。超出 [0, 1] 的值被截断，NaN 视为 0。
+void LinearToPQ(const float* src, float* dst, size_t count, float scale) noexcept;
+void PQToLinear(const float* src, float* dst, size_t count, float scale) noexcept;
+
+// 乘以 scale，用于 SDR 内容亮度和 HDR 下的 boost
+void Scale(const float* src, float* dst, size_t count, float scale) noexcept;
+
+void TransformGamut(const float* const src[3], float* const dst[3], size_t count, const Matrix3x3& matrix) noexcept;
+
+// R8G8B8A8_UNORM_SRGB，和写入渲染目标相同：超出 [0, 1] 的值被截断，NaN 视为 0，alpha 为 255。
+// 两者都查表实现，和指令集无关，结果精确，比逐个计算传递函数更快。
+void PackSRGB8(const float* const src[3], uint32_t* dst, size_t count) noexcept;
+void UnpackSRGB8(const uint32_t* src, float* const dst[3], size_t count) noexcept;
+
+// R16G16B16A16_FLOAT，舍入到最近的偶数，alpha 为 1
+void PackHalf(const float* const src[3], uint16_t* dst, size_t count) noexcept;
+void UnpackHalf(const uint16_t* src, float* const dst[3], size_t count) noexcept;
+
+// R10G10B10A2_UNORM，用于 HDR10 的 PQ 编码值。超出 [0, 1] 的值被截断，NaN 视为 0，舍入到最近的
+// 偶数，alpha 为 3。不涉及传递函数，和指令集无关。
+void PackUNorm10(const float* const src[3], uint32_t* dst, size_t count) noexcept;
+void UnpackUNorm10(const uint32_t* src, float* const dst[3], size_t count) noexcept;
+
+// 参与基准测试的函数
+enum class Kernel {
+	SRGBToLinear,
+	LinearToSRGB,
+	LinearToPQ,
+	PQToLinear,
+	Scale,
+	TransformGamut,
+	PackHalf,
+	UnpackHalf,
+	COUNT
+};
+
+const char* GetKernelName(Kernel kernel) noexcept;
+
+struct BenchmarkResult {
+	InstructionSet instructionSet;
+	// 每秒处理的像素数，单通道的函数每个像素处理三个值
+	std::array<double, (size_t)Kernel::COUNT> pixelsPerSecond;
+};
+
+// 在单线程中测试每种支持的指令集的吞吐量，每个函数处理 pixelCount 个像素 iterationCount 次。
+// 结束后恢复原来的指令集。
+std::vector<BenchmarkResult> Benchmark(uint32_t pixelCount, uint32_t iterationCount) noexcept;
+
+}
@@ -0,0 +1,125 @@
+// 使用 AVX2、FMA 和 F16C 指令，以 /arch:AVX2 或 -mavx2 -mfma -mf16c 编译，不使用预编译头
+#include "ColorKernelsSimd.h"
+
+#ifdef COLOR_KERNELS_X64
+
+#include <immintrin.h>
+
+namespace ColorKernels::Detail {
+
+namespace {
+
+struct Avx2 {
+	using D = __m256d;
+	using M = __m256d;
+
+	static constexpr size_t LANES = 4;
+
+	static D Load(const float* src) noexcept { return _mm256_cvtps_pd(_mm_loadu_ps(src)); }
+	static void Store(float* dst, D value) noexcept { _mm_storeu_ps(dst, _mm256_cvtpd_ps(value)); }
+	static D Set(double value) noexcept { return _mm256_set1_pd(value); }
+	static D Add(D a, D b) noexcept { return _mm256_add_pd(a, b); }
+	static D Sub(D a, D b) noexcept { return _mm256_sub_pd(a, b); }
+	static D Mul(D a, D b) noexcept { return _mm256_mul_pd(a, b); }
+	static D Div(D a, D b) noexcept { return _mm256_div_pd(a, b); }
+	static D MulAdd(D a, D b, D c) noexcept { return _mm256_fmadd_pd(a, b, c); }
+	static D Min(D a, D b) noexcept { return _mm256_min_pd(a, b); }
+	// 任一操作数为 NaN 时返回 b
+	static D Max(D a, D b) noexcept { return _mm256_max_pd(a, b); }
+	static D Abs(D a) noexcept { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+
+	static D CopySign(D a, D b) noexcept {
+		const __m256d signMask = _mm256_set1_pd(-0.0);
+		return _mm256_or_pd(_mm256_andnot_pd(signMask, a), _mm256_and_pd(signMask, b));
+	}
+
+	static D Round(D a) noexcept { return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	static M Less(D a, D b) noexcept { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+	static M LessEqual(D a, D b) noexcept { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+	static D Select(M m, D a, D b) noexcept { return _mm256_blendv_pd(b, a, m); }
+
+	static D GetExponent(D x) noexcept {
+		// 指数域放入 2^52 的尾数再减去 2^52
+		const __m256d magic = _mm256_set1_pd(4503599627370496.0);
+		const __m256i exponent = _mm256_srli_epi64(_mm256_castpd_si256(x), 52);
+		return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(exponent, _mm256_castpd_si256(magic))), magic);
+	}
+
+	static D GetMantissa(D x) noexcept {
+		const __m256i mantissa = _mm256_and_si256(_mm256_castpd_si256(x), _mm256_set1_epi64x(0x000FFFFFFFFFFFFFll));
+		return _mm256_castsi256_pd(_mm256_or_si256(mantissa, _mm256_set1_epi64x(0x3FF0000000000000ll)));
+	}
+
+	static D Pow2(D n) noexcept {
+		// n + 1023 出现在 2^52 + n + 1023 的尾数的低位
+		const __m256d biased = _mm256_add_pd(n, _mm256_set1_pd(4503599627370496.0 + 1023));
+		return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(biased), 52));
+	}
+
+	static void PackHalf(const float* const src[3], uint16_t* dst, size_t count) noexcept {
+		constexpr int ROUNDING = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+
+		// 每次 8 个像素
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			const __m128i r = _mm256_cvtps_ph(_mm256_loadu_ps(src[0] + i), ROUNDING);
+			const __m128i g = _mm256_cvtps_ph(_mm256_loadu_ps(src[1] + i), ROUNDING);
+			const __m128i b = _mm256_cvtps_ph(_mm256_loadu_ps(src[2] + i), ROUNDING);
+			const __m128i a = _mm_set1_epi16(0x3C00);
+
+			const __m128i rgLo = _mm_unpacklo_epi16(r, g);
+			const __m128i rgHi = _mm_unpackhi_epi16(r, g);
+			const __m128i baLo = _mm_unpacklo_epi16(b, a);
+			const __m128i baHi = _mm_unpackhi_epi16(b, a);
+
+			__m128i* out = (__m128i*)(dst + i * 4);
+			_mm_storeu_si128(out, _mm_unpacklo_epi32(rgLo, baLo));
+			_mm_storeu_si128(out + 1, _mm_unpackhi_epi32(rgLo, baLo));
+			_mm_storeu_si128(out + 2, _mm_unpacklo_epi32(rgHi, baHi));
+			_mm_storeu_si128(out + 3, _mm_unpackhi_epi32(rgHi, baHi));
+		}
+
+		const float* const rest[3] = { src[0] + i, src[1] + i, src[2] + i };
+		PackHalfScalar(rest, dst + i * 4, count - i);
+	}
+
+	static void UnpackHalf(const uint16_t* src, float* const dst[3], size_t count) noexcept {
+		// 每次 4 个像素，和 SSE4 相同的方法分离通道
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			const __m128i p01 = _mm_loadu_si128((const __m128i*)(src + i * 4));
+			const __m128i p23 = _mm_loadu_si128((const __m128i*)(src + i * 4 + 8));
+
+			const __m128i lo = _mm_unpacklo_epi16(p01, p23);
+			const __m128i hi = _mm_unpackhi_epi16(p01, p23);
+			// r0 r1 r2 r3 g0 g1 g2 g3 和 b0 b1 b2 b3 a0 a1 a2 a3
+			const __m128i rg = _mm_unpacklo_epi16(lo, hi);
+			const __m128i ba = _mm_unpackhi_epi16(lo, hi);
+
+			_mm_storeu_ps(dst[0] + i, _mm_cvtph_ps(rg));
+			_mm_storeu_ps(dst[1] + i, _mm_cvtph_ps(_mm_srli_si128(rg, 8)));
+			_mm_storeu_ps(dst[2] + i, _mm_cvtph_ps(ba));
+		}
+
+		float* const rest[3] = { dst[0] + i, dst[1] + i, dst[2] + i };
+		UnpackHalfScalar(src + i * 4, rest, count - i);
+	}
+};
+
+constexpr KernelTable KERNELS = MakeKernelTable<Avx2>();
+
+}
+
+const KernelTable* const AVX2_KERNELS = &KERNELS;
+
+}
+
+#else
+
+namespace ColorKernels::Detail {
+
+const KernelTable* const AVX2_KERNELS = nullptr;
+
+}
+
+#endif
@@ -0,0 +1,100 @@
+// ARM64 的 NEON 实现，不使用预编译头
+#include "ColorKernelsSimd.h"
+
+#ifdef COLOR_KERNELS_ARM64
+
+#include <arm_neon.h>
+
+namespace ColorKernels::Detail {
+
+namespace {
+
+struct Neon {
+	using D = float64x2_t;
+	using M = uint64x2_t;
+
+	static constexpr size_t LANES = 2;
+
+	static D Load(const float* src) noexcept { return vcvt_f64_f32(vld1_f32(src)); }
+	static void Store(float* dst, D value) noexcept { vst1_f32(dst, vcvt_f32_f64(value)); }
+	static D Set(double value) noexcept { return vdupq_n_f64(value); }
+	static D Add(D a, D b) noexcept { return vaddq_f64(a, b); }
+	static D Sub(D a, D b) noexcept { return vsubq_f64(a, b); }
+	static D Mul(D a, D b) noexcept { return vmulq_f64(a, b); }
+	static D Div(D a, D b) noexcept { return vdivq_f64(a, b); }
+	static D MulAdd(D a, D b, D c) noexcept { return vfmaq_f64(c, a, b); }
+	static D Min(D a, D b) noexcept { return vminnmq_f64(a, b); }
+	// 一个操作数为 NaN 时返回另一个
+	static D Max(D a, D b) noexcept { return vmaxnmq_f64(a, b); }
+	static D Abs(D a) noexcept { return vabsq_f64(a); }
+
+	static D CopySign(D a, D b) noexcept {
+		return vbslq_f64(vdupq_n_u64(0x8000000000000000ull), b, a);
+	}
+
+	static D Round(D a) noexcept { return vrndnq_f64(a); }
+	static M Less(D a, D b) noexcept { return vcltq_f64(a, b); }
+	static M LessEqual(D a, D b) noexcept { return vcleq_f64(a, b); }
+	static D Select(M m, D a, D b) noexcept { return vbslq_f64(m, a, b); }
+
+	static D GetExponent(D x) noexcept {
+		return vcvtq_f64_u64(vshrq_n_u64(vreinterpretq_u64_f64(x), 52));
+	}
+
+	static D GetMantissa(D x) noexcept {
+		const uint64x2_t mantissa = vandq_u64(vreinterpretq_u64_f64(x), vdupq_n_u64(0x000FFFFFFFFFFFFFull));
+		return vreinterpretq_f64_u64(vorrq_u64(mantissa, vdupq_n_u64(0x3FF0000000000000ull)));
+	}
+
+	static D Pow2(D n) noexcept {
+		const int64x2_t biased = vaddq_s64(vcvtq_s64_f64(n), vdupq_n_s64(1023));
+		return vreinterpretq_f64_s64(vshlq_n_s64(biased, 52));
+	}
+
+	static void PackHalf(const float* const src[3], uint16_t* dst, size_t count) noexcept {
+		// 每次 4 个像素，交错写入
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			uint16x4x4_t pixels;
+			pixels.val[0] = vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src[0] + i)));
+			pixels.val[1] = vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src[1] + i)));
+			pixels.val[2] = vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src[2] + i)));
+			pixels.val[3] = vdup_n_u16(0x3C00);
+			vst4_u16(dst + i * 4, pixels);
+		}
+
+		const float* const rest[3] = { src[0] + i, src[1] + i, src[2] + i };
+		PackHalfScalar(rest, dst + i * 4, count - i);
+	}
+
+	static void UnpackHalf(const uint16_t* src, float* const dst[3], size_t count) noexcept {
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			const uint16x4x4_t pixels = vld4_u16(src + i * 4);
+			vst1q_f32(dst[0] + i, vcvt_f32_f16(vreinterpret_f16_u16(pixels.val[0])));
+			vst1q_f32(dst[1] + i, vcvt_f32_f16(vreinterpret_f16_u16(pixels.val[1])));
+			vst1q_f32(dst[2] + i, vcvt_f32_f16(vreinterpret_f16_u16(pixels.val[2])));
+		}
+
+		float* const rest[3] = { dst[0] + i, dst[1] + i, dst[2] + i };
+		UnpackHalfScalar(src + i * 4, rest, count - i);
+	}
+};
+
+constexpr KernelTable KERNELS = MakeKernelTable<Neon>();
+
+}
+
+const KernelTable* const NEON_KERNELS = &KERNELS;
+
+}
+
+#else
+
+namespace ColorKernels::Detail {
+
+const KernelTable* const NEON_KERNELS = nullptr;
+
+}
+
+#endif
@@ -0,0 +1,176 @@
+// 使用 SSE4.1 指令，不使用预编译头
+#include "ColorKernelsSimd.h"
+
+#ifdef COLOR_KERNELS_X64
+
+#include <smmintrin.h>
+
+namespace ColorKernels::Detail {
+
+namespace {
+
+struct Sse4 {
+	using D = __m128d;
+	using M = __m128d;
+
+	static constexpr size_t LANES = 2;
+
+	static D Load(const float* src) noexcept {
+		return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)src)));
+	}
+
+	static void Store(float* dst, D value) noexcept {
+		_mm_storel_epi64((__m128i*)dst, _mm_castps_si128(_mm_cvtpd_ps(value)));
+	}
+
+	static D Set(double value) noexcept { return _mm_set1_pd(value); }
+	static D Add(D a, D b) noexcept { return _mm_add_pd(a, b); }
+	static D Sub(D a, D b) noexcept { return _mm_sub_pd(a, b); }
+	static D Mul(D a, D b) noexcept { return _mm_mul_pd(a, b); }
+	static D Div(D a, D b) noexcept { return _mm_div_pd(a, b); }
+	static D MulAdd(D a, D b, D c) noexcept { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+	static D Min(D a, D b) noexcept { return _mm_min_pd(a, b); }
+	// 任一操作数为 NaN 时返回 b
+	static D Max(D a, D b) noexcept { return _mm_max_pd(a, b); }
+	static D Abs(D a) noexcept { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+
+	static D CopySign(D a, D b) noexcept {
+		const __m128d signMask = _mm_set1_pd(-0.0);
+		return _mm_or_pd(_mm_andnot_pd(signMask, a), _mm_and_pd(signMask, b));
+	}
+
+	static D Round(D a) noexcept { return _mm_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+	static M Less(D a, D b) noexcept { return _mm_cmplt_pd(a, b); }
+	static M LessEqual(D a, D b) noexcept { return _mm_cmple_pd(a, b); }
+	static D Select(M m, D a, D b) noexcept { return _mm_blendv_pd(b, a, m); }
+
+	static D GetExponent(D x) noexcept {
+		// 指数域放入 2^52 的尾数再减去 2^52
+		const __m128d magic = _mm_set1_pd(4503599627370496.0);
+		const __m128i exponent = _mm_srli_epi64(_mm_castpd_si128(x), 52);
+		return _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(exponent, _mm_castpd_si128(magic))), magic);
+	}
+
+	static D GetMantissa(D x) noexcept {
+		const __m128i mantissa = _mm_and_si128(_mm_castpd_si128(x), _mm_set1_epi64x(0x000FFFFFFFFFFFFFll));
+		return _mm_castsi128_pd(_mm_or_si128(mantissa, _mm_set1_epi64x(0x3FF0000000000000ll)));
+	}
+
+	static D Pow2(D n) noexcept {
+		// n + 1023 出现在 2^52 + n + 1023 的尾数的低位
+		const __m128d biased = _mm_add_pd(n, _mm_set1_pd(4503599627370496.0 + 1023));
+		return _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(biased), 52));
+	}
+
+	// 和 FloatToHalf 相同，结果在每个 32 位元素的低 16 位
+	static __m128i FloatToHalf(__m128 value) noexcept {
+		__m128i bits = _mm_castps_si128(value);
+		const __m128i sign = _mm_and_si128(bits, _mm_set1_epi32((int)0x80000000u));
+		bits = _mm_xor_si128(bits, sign);
+
+		const __m128i infOrNaN = _mm_blendv_epi8(
+			_mm_set1_epi32(0x7C00),
+			_mm_set1_epi32(0x7E00),
+			_mm_cmpgt_epi32(bits, _mm_set1_epi32(0x7F800000))
+		);
+
+		const __m128 magic = _mm_set1_ps(0.5f);
+		const __m128i denormal = _mm_sub_epi32(
+			_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(bits), magic)), _mm_castps_si128(magic));
+
+		const __m128i mantissaOdd = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1));
+		__m128i normal = _mm_add_epi32(bits, _mm_set1_epi32(((15 - 127) << 23) + 0xFFF));
+		normal = _mm_srli_epi32(_mm_add_epi32(normal, mantissaOdd), 13);
+
+		__m128i result = _mm_blendv_epi8(normal, denormal, _mm_cmplt_epi32(bits, _mm_set1_epi32(0x38800000)));
+		result = _mm_blendv_epi8(result, infOrNaN, _mm_cmpgt_epi32(bits, _mm_set1_epi32(0x477FFFFF)));
+		return _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+	}
+
+	// 和 HalfToFloat 相同，value 的每个 32 位元素的低 16 位是一个半精度数
+	static __m128 HalfToFloat(__m128i value) noexcept {
+		const __m128i exponentMask = _mm_set1_epi32(0x7C00 << 13);
+
+		__m128i bits = _mm_slli_epi32(_mm_and_si128(value, _mm_set1_epi32(0x7FFF)), 13);
+		const __m128i exponent = _mm_and_si128(bits, exponentMask);
+		bits = _mm_add_epi32(bits, _mm_set1_epi32((127 - 15) << 23));
+
+		// 无穷大和 NaN 的指数域全为 1
+		const __m128i isInfOrNaN = _mm_cmpeq_epi32(exponent, exponentMask);
+		bits = _mm_add_epi32(bits, _mm_and_si128(isInfOrNaN, _mm_set1_epi32((128 - 16) << 23)));
+
+		// 0 和非规格化数借助浮点减法归一化
+		const __m128i isDenormal = _mm_cmpeq_epi32(exponent, _mm_setzero_si128());
+		const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32(113 << 23));
+		const __m128i denormal = _mm_castps_si128(_mm_sub_ps(
+			_mm_castsi128_ps(_mm_add_epi32(bits, _mm_set1_epi32(1 << 23))), magic));
+		bits = _mm_blendv_epi8(bits, denormal, isDenormal);
+
+		const __m128i sign = _mm_slli_epi32(_mm_and_si128(value, _mm_set1_epi32(0x8000)), 16);
+		return _mm_castsi128_ps(_mm_or_si128(bits, sign));
+	}
+
+	static void PackHalf(const float* const src[3], uint16_t* dst, size_t count) noexcept {
+		// 每次 4 个像素
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			const __m128i r = FloatToHalf(_mm_loadu_ps(src[0] + i));
+			const __m128i g = FloatToHalf(_mm_loadu_ps(src[1] + i));
+			const __m128i b = FloatToHalf(_mm_loadu_ps(src[2] + i));
+			const __m128i a = _mm_set1_epi32(0x3C00);
+
+			// r0 r1 r2 r3 g0 g1 g2 g3 和 b0 b1 b2 b3 a a a a
+			const __m128i rg = _mm_packus_epi32(r, g);
+			const __m128i ba = _mm_packus_epi32(b, a);
+			// r0 g0 r1 g1 r2 g2 r3 g3 和 b0 a b1 a b2 a b3 a
+			const __m128i rgInterleaved = _mm_unpacklo_epi16(rg, _mm_srli_si128(rg, 8));
+			const __m128i baInterleaved = _mm_unpacklo_epi16(ba, _mm_srli_si128(ba, 8));
+
+			_mm_storeu_si128((__m128i*)(dst + i * 4), _mm_unpacklo_epi32(rgInterleaved, baInterleaved));
+			_mm_storeu_si128((__m128i*)(dst + i * 4 + 8), _mm_unpackhi_epi32(rgInterleaved, baInterleaved));
+		}
+
+		const float* const rest[3] = { src[0] + i, src[1] + i, src[2] + i };
+		PackHalfScalar(rest, dst + i * 4, count - i);
+	}
+
+	static void UnpackHalf(const uint16_t* src, float* const dst[3], size_t count) noexcept {
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			const __m128i p01 = _mm_loadu_si128((const __m128i*)(src + i * 4));
+			const __m128i p23 = _mm_loadu_si128((const __m128i*)(src + i * 4 + 8));
+
+			// r0 r2 g0 g2 b0 b2 a0 a2 和 r1 r3 g1 g3 b1 b3 a1 a3
+			const __m128i lo = _mm_unpacklo_epi16(p01, p23);
+			const __m128i hi = _mm_unpackhi_epi16(p01, p23);
+			// r0 r1 r2 r3 g0 g1 g2 g3 和 b0 b1 b2 b3 a0 a1 a2 a3
+			const __m128i rg = _mm_unpacklo_epi16(lo, hi);
+			const __m128i ba = _mm_unpackhi_epi16(lo, hi);
+
+			_mm_storeu_ps(dst[0] + i, HalfToFloat(_mm_cvtepu16_epi32(rg)));
+			_mm_storeu_ps(dst[1] + i, HalfToFloat(_mm_cvtepu16_epi32(_mm_srli_si128(rg, 8))));
+			_mm_storeu_ps(dst[2] + i, HalfToFloat(_mm_cvtepu16_epi32(ba)));
+		}
+
+		float* const rest[3] = { dst[0] + i, dst[1] + i, dst[2] + i };
+		UnpackHalfScalar(src + i * 4, rest, count - i);
+	}
+};
+
+constexpr KernelTable KERNELS = MakeKernelTable<Sse4>();
+
+}
+
+const KernelTable* const SSE4_KERNELS = &KERNELS;
+
+}
+
+#else
+
+namespace ColorKernels::Detail {
+
+const KernelTable* const SSE4_KERNELS = nullptr;
+
+}
+
+#endif
@@ -0,0 +1,317 @@
+#pragma once
+#include "ColorKernels.h"
+#include <bit>
+#include <cstring>
+
+// 目标架构，MSVC 和 GCC/Clang 的预定义宏不同
+#if defined(_M_X64) || defined(__x86_64__)
+#define COLOR_KERNELS_X64
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define COLOR_KERNELS_ARM64
+#endif
+
+// ColorKernels 各个指令集共用的实现。每个指令集的源文件定义一个封装双精度向量的类型 V，然后
+// 用 MakeKernelTable<V> 实例化所有函数。V 需要提供：
+//   D：双精度向量；M：比较的结果；LANES：D 的宽度
+//   Load/Store：读写 LANES 个 float
+//   Set、Add、Sub、Mul、Div、MulAdd(a, b, c) = a * b + c、Min、Max、Abs、CopySign、Round（最近偶数）
+//   Max(a, b) 中 a 为 NaN 时必须返回 b
+//   Less、LessEqual、Select(m, a, b)
+//   GetExponent：正数的指数域（含偏移）；GetMantissa：[1, 2) 内的尾数；Pow2：2^n，n 为整数
+//   PackHalf/UnpackHalf：完整实现 ColorKernels::PackHalf/UnpackHalf
+//
+// 这个文件在不同指令集的编译选项下被包含多次，其中的函数都是内部链接，也不能调用标准库中非内联
+// 的模板，否则链接器可能在所有翻译单元中选用 AVX2 版本的实例。
+namespace ColorKernels::Detail {
+
+struct KernelTable {
+	void (*srgbToLinear)(const float* src, float* dst, size_t count) noexcept;
+	void (*linearToSRGB)(const float* src, float* dst, size_t count) noexcept;
+	void (*linearToPQ)(const float* src, float* dst, size_t count, float scale) noexcept;
+	void (*pqToLinear)(const float* src, float* dst, size_t count, float scale) noexcept;
+	void (*scale)(const float* src, float* dst, size_t count, float scale) noexcept;
+	void (*transformGamut)(const float* const src[3], float* const dst[3], size_t count, const Matrix3x3& matrix) noexcept;
+	void (*packHalf)(const float* const src[3], uint16_t* dst, size_t count) noexcept;
+	void (*unpackHalf)(const uint16_t* src, float* const dst[3], size_t count) noexcept;
+};
+
+// 在各自的源文件中定义，当前平台不支持的指令集为 nullptr
+extern const KernelTable* const SSE4_KERNELS;
+extern const KernelTable* const AVX2_KERNELS;
+extern const KernelTable* const NEON_KERNELS;
+
+namespace {
+
+// 舍入到最近的偶数，溢出时为无穷大
+inline uint16_t FloatToHalf(float value) noexcept {
+	uint32_t bits = std::bit_cast<uint32_t>(value);
+	const uint32_t sign = bits & 0x80000000u;
+	bits ^= sign;
+
+	uint32_t result;
+	if (bits >= 0x47800000u) {
+		// 不小于 65536 时为无穷大，NaN 保持为 NaN
+		result = bits > 0x7F800000u ? 0x7E00 : 0x7C00;
+	} else if (bits < 0x38800000u) {
+		// 结果为非规格化数，借助浮点加法舍入
+		constexpr float MAGIC = 0.5f;
+		result = std::bit_cast<uint32_t>(std::bit_cast<float>(bits) + MAGIC) - std::bit_cast<uint32_t>(MAGIC);
+	} else {
+		const uint32_t mantissaOdd = (bits >> 13) & 1;
+		bits += ((uint32_t)(15 - 127) << 23) + 0xFFF + mantissaOdd;
+		result = bits >> 13;
+	}
+
+	return (uint16_t)(result | (sign >> 16));
+}
+
+inline float HalfToFloat(uint16_t value) noexcept {
+	const uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+	const uint32_t exponent = (value >> 10) & 0x1F;
+	const uint32_t mantissa = value & 0x3FF;
+
+	if (exponent == 0) {
+		// 0 和非规格化数都可以精确表示
+		const float magnitude = (float)mantissa * (1.0f / (1 << 24));
+		return std::bit_cast<float>(std::bit_cast<uint32_t>(magnitude) | sign);
+	}
+
+	const uint32_t bits = exponent == 0x1F
+		? 0x7F800000u | (mantissa << 13)
+		: ((exponent + 127 - 15) << 23) | (mantissa << 13);
+	return std::bit_cast<float>(bits | sign);
+}
+
+// 每次处理 V::LANES 个元素，不足的部分复制到临时缓冲，使每个元素的结果和位置无关
+template <typename V, typename F>
+inline void ForEachBlock(size_t count, const F& func) noexcept {
+	size_t i = 0;
+	for (; i + V::LANES <= count; i += V::LANES) {
+		func(i, V::LANES);
+	}
+	if (i < count) {
+		func(i, count - i);
+	}
+}
+
+template <typename V, typename F>
+inline void TransformChannel(const float* src, float* dst, size_t count, const F& func) noexcept {
+	ForEachBlock<V>(count, [&](size_t offset, size_t n) {
+		if (n == V::LANES) {
+			V::Store(dst + offset, func(V::Load(src + offset)));
+		} else {
+			float temp[V::LANES] = {};
+			std::memcpy(temp, src + offset, n * sizeof(float));
+			V::Store(temp, func(V::Load(temp)));
+			std::memcpy(dst + offset, temp, n * sizeof(float));
+		}
+	});
+}
+
+// x 为非负的有限值，log2(0) 返回 -1023
+template <typename V>
+inline typename V::D Log2(typename V::D x) noexcept {
+	// 1/ln(2) * 2/k
+	constexpr double INV_LN2 = 1.4426950408889634;
+	constexpr double C[] = {
+		2 * INV_LN2, 2 * INV_LN2 / 3, 2 * INV_LN2 / 5, 2 * INV_LN2 / 7,
+		2 * INV_LN2 / 9, 2 * INV_LN2 / 11, 2 * INV_LN2 / 13, 2 * INV_LN2 / 15
+	};
+
+	// 尾数归一化到 [sqrt(0.5), sqrt(2))
+	typename V::D e = V::Sub(V::GetExponent(x), V::Set(1023.0));
+	typename V::D m = V::GetMantissa(x);
+	const typename V::M isLarge = V::Less(V::Set(1.4142135623730951), m);
+	m = V::Select(isLarge, V::Mul(m, V::Set(0.5)), m);
+	e = V::Select(isLarge, V::Add(e, V::Set(1.0)), e);
+
+	// ln(m) = 2 * atanh(t)，|t| < 0.172，截断到 t^15 的误差小于 1e-14
+	const typename V::D t = V::Div(V::Sub(m, V::Set(1.0)), V::Add(m, V::Set(1.0)));
+	const typename V::D t2 = V::Mul(t, t);
+	typename V::D p = V::Set(C[7]);
+	for (int i = 6; i >= 0; --i) {
+		p = V::MulAdd(p, t2, V::Set(C[i]));
+	}
+	return V::MulAdd(p, t, e);
+}
+
+template <typename V>
+inline typename V::D Exp2(typename V::D x) noexcept {
+	// ln(2)^k / k!
+	constexpr double C[] = {
+		1.0, 0.69314718055994531, 0.24022650695910071, 0.055504108664821580,
+		9.6181291076284772e-3, 1.3333558146428443e-3, 1.5403530393381610e-4, 1.5252733804059841e-5,
+		1.3215486790144307e-6, 1.0178086009239699e-7, 7.0549116208011233e-9, 4.4455382718708114e-10,
+		2.5678435993488203e-11
+	};
+
+	// 2^x = 2^n * 2^f，|f| <= 0.5，泰勒级数截断到 f^12 的误差小于 1e-15
+	x = V::Min(V::Max(x, V::Set(-1022.0)), V::Set(1023.0));
+	const typename V::D n = V::Round(x);
+	const typename V::D f = V::Sub(x, n);
+	typename V::D p = V::Set(C[12]);
+	for (int i = 11; i >= 0; --i) {
+		p = V::MulAdd(p, f, V::Set(C[i]));
+	}
+	return V::Mul(p, V::Pow2(n));
+}
+
+// x 为非负的有限值
+template <typename V>
+inline typename V::D Pow(typename V::D x, double y) noexcept {
+	const typename V::D result = Exp2<V>(V::Mul(Log2<V>(x), V::Set(y)));
+	return V::Select(V::LessEqual(x, V::Set(0.0)), V::Set(0.0), result);
+}
+
+template <typename V>
+inline typename V::D SRGBToLinear(typename V::D x) noexcept {
+	const typename V::D a = V::Abs(x);
+	const typename V::D curve = Pow<V>(V::Div(V::Add(a, V::Set(0.055)), V::Set(1.055)), 2.4);
+	const typename V::D result = V::Select(V::LessEqual(a, V::Set(0.04045)), V::Div(a, V::Set(12.92)), curve);
+	return V::CopySign(result, x);
+}
+
+template <typename V>
+inline typename V::D LinearToSRGB(typename V::D x) noexcept {
+	const typename V::D a = V::Abs(x);
+	const typename V::D curve = V::MulAdd(Pow<V>(a, 1 / 2.4), V::Set(1.055), V::Set(-0.055));
+	const typename V::D result = V::Select(V::LessEqual(a, V::Set(0.0031308)), V::Mul(a, V::Set(12.92)), curve);
+	return V::CopySign(result, x);
+}
+
+// SMPTE ST 2084 的常量
+static constexpr double PQ_M1 = 2610.0 / 16384;
+static constexpr double PQ_M2 = 2523.0 / 4096 * 128;
+static constexpr double PQ_C1 = 3424.0 / 4096;
+static constexpr double PQ_C2 = 2413.0 / 4096 * 32;
+static constexpr double PQ_C3 = 2392.0 / 4096 * 32;
+
+template <typename V>
+inline typename V::D Saturate(typename V::D x) noexcept {
+	return V::Min(V::Max(x, V::Set(0.0)), V::Set(1.0));
+}
+
+template <typename V>
+inline typename V::D LinearToPQ(typename V::D x, double scale) noexcept {
+	const typename V::D y = Pow<V>(Saturate<V>(V::Mul(x, V::Set(scale))), PQ_M1);
+	const typename V::D numerator = V::MulAdd(y, V::Set(PQ_C2), V::Set(PQ_C1));
+	const typename V::D denominator = V::MulAdd(y, V::Set(PQ_C3), V::Set(1.0));
+	return Pow<V>(V::Div(numerator, denominator), PQ_M2);
+}
+
+template <typename V>
+inline typename V::D PQToLinear(typename V::D x, double scale) noexcept {
+	const typename V::D e = Pow<V>(Saturate<V>(x), 1 / PQ_M2);
+	const typename V::D numerator = V::Max(V::Sub(e, V::Set(PQ_C1)), V::Set(0.0));
+	const typename V::D denominator = V::Sub(V::Set(PQ_C2), V::Mul(e, V::Set(PQ_C3)));
+	return V::Div(Pow<V>(V::Div(numerator, denominator), 1 / PQ_M1), V::Set(scale));
+}
+
+template <typename V>
+void SRGBToLinearKernel(const float* src, float* dst, size_t count) noexcept {
+	TransformChannel<V>(src, dst, count, SRGBToLinear<V>);
+}
+
+template <typename V>
+void LinearToSRGBKernel(const float* src, float* dst, size_t count) noexcept {
+	TransformChannel<V>(src, dst, count, LinearToSRGB<V>);
+}
+
+template <typename V>
+void LinearToPQKernel(const float* src, float* dst, size_t count, float scale) noexcept {
+	TransformChannel<V>(src, dst, count, [scale](typename V::D x) {
+		return LinearToPQ<V>(x, scale);
+	});
+}
+
+template <typename V>
+void PQToLinearKernel(const float* src, float* dst, size_t count, float scale) noexcept {
+	TransformChannel<V>(src, dst, count, [scale](typename V::D x) {
+		return PQToLinear<V>(x, scale);
+	});
+}
+
+template <typename V>
+void ScaleKernel(const float* src, float* dst, size_t count, float scale) noexcept {
+	const typename V::D s = V::Set(scale);
+	TransformChannel<V>(src, dst, count, [s](typename V::D x) {
+		return V::Mul(x, s);
+	});
+}
+
+template <typename V>
+void TransformGamutKernel(const float* const src[3], float* const dst[3], size_t count, const Matrix3x3& matrix) noexcept {
+	typename V::D m[3][3];
+	for (int i = 0; i < 3; ++i) {
+		for (int j = 0; j < 3; ++j) {
+			m[i][j] = V::Set(matrix.m[i][j]);
+		}
+	}
+
+	ForEachBlock<V>(count, [&](size_t offset, size_t n) {
+		float temp[3][V::LANES] = {};
+		typename V::D in[3];
+		for (int c = 0; c < 3; ++c) {
+			if (n == V::LANES) {
+				in[c] = V::Load(src[c] + offset);
+			} else {
+				std::memcpy(temp[c], src[c] + offset, n * sizeof(float));
+				in[c] = V::Load(temp[c]);
+			}
+		}
+
+		// 先计算完所有通道再写入，允许就地转换
+		typename V::D out[3];
+		for (int c = 0; c < 3; ++c) {
+			out[c] = V::MulAdd(m[c][2], in[2], V::MulAdd(m[c][1], in[1], V::Mul(m[c][0], in[0])));
+		}
+
+		for (int c = 0; c < 3; ++c) {
+			if (n == V::LANES) {
+				V::Store(dst[c] + offset, out[c]);
+			} else {
+				V::Store(temp[c], out[c]);
+				std::memcpy(dst[c] + offset, temp[c], n * sizeof(float));
+			}
+		}
+	});
+}
+
+// 标量的 PackHalf，用于 SIMD 实现处理剩余的像素
+inline void PackHalfScalar(const float* const src[3], uint16_t* dst, size_t count) noexcept {
+	// 1.0
+	constexpr uint16_t ALPHA = 0x3C00;
+
+	for (size_t i = 0; i < count; ++i) {
+		dst[i * 4] = FloatToHalf(src[0][i]);
+		dst[i * 4 + 1] = FloatToHalf(src[1][i]);
+		dst[i * 4 + 2] = FloatToHalf(src[2][i]);
+		dst[i * 4 + 3] = ALPHA;
+	}
+}
+
+inline void UnpackHalfScalar(const uint16_t* src, float* const dst[3], size_t count) noexcept {
+	for (size_t i = 0; i < count; ++i) {
+		dst[0][i] = HalfToFloat(src[i * 4]);
+		dst[1][i] = HalfToFloat(src[i * 4 + 1]);
+		dst[2][i] = HalfToFloat(src[i * 4 + 2]);
+	}
+}
+
+template <typename V>
+constexpr KernelTable MakeKernelTable() noexcept {
+	return {
+		.srgbToLinear = SRGBToLinearKernel<V>,
+		.linearToSRGB = LinearToSRGBKernel<V>,
+		.linearToPQ = LinearToPQKernel<V>,
+		.pqToLinear = PQToLinearKernel<V>,
+		.scale = ScaleKernel<V>,
+		.transformGamut = TransformGamutKernel<V>,
+		.packHalf = V::PackHalf,
+		.unpackHalf = V::UnpackHalf
+	};
+}
+
+}
+
+}
@@ -0,0 +1,306 @@
+// 不依赖 D3D12，不使用预编译头，以便在其他平台测试
+#include "ColorLut.h"
+#include "IccProfile.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using ColorKernels::Matrix3x3;
+
+static constexpr uint32_t SLICE_ENTRY_COUNT = ColorLut::SIZE * ColorLut::SIZE;
+
+// 校准时每条 TRC 的采样数
+static constexpr uint32_t CURVE_SAMPLE_COUNT = 4096;
+
+// 原色的亮度，即 RGB 到 XYZ 的矩阵的第二行
+static constexpr std::array<float, 3> BT709_LUMINANCE = { 0.212639f, 0.715169f, 0.0721923f };
+static constexpr std::array<float, 3> BT2020_LUMINANCE = { 0.2627002f, 0.6779981f, 0.0593017f };
+
+// 白点为 D65
+static constexpr Matrix3x3 BT709_TO_XYZ = { {
+	{ 0.412390799f, 0.357584339f, 0.180480788f },
+	{ 0.212639006f, 0.715168679f, 0.0721923054f },
+	{ 0.0193308187f, 0.119194780f, 0.950532152f }
+} };
+
+// Bradford 色适应，ICC 的 PCS 的白点为 D50
+static constexpr Matrix3x3 D65_TO_D50 = { {
+	{ 1.0478112f, 0.0228866f, -0.050127f },
+	{ 0.0295424f, 0.9904844f, -0.0170491f },
+	{ -0.0092345f, 0.0150436f, 0.7521316f }
+} };
+
+static constexpr Matrix3x3 IDENTITY = { {
+	{ 1.0f, 0.0f, 0.0f },
+	{ 0.0f, 1.0f, 0.0f },
+	{ 0.0f, 0.0f, 1.0f }
+} };
+
+// 和 shaders/ColorLut_PS.hlsl 一致。SDR 中 1.0 编码为 PQ 的 2500nit，约为 0.9，负值占用 8 个
+// 格子。HDR 和 HDR10 的编码相同。
+static constexpr ColorLut::Grid SDR_GRID = {
+	.fromScRGB = IDENTITY,
+	.pqScale = 0.25f,
+	.zeroIndex = 8
+};
+static constexpr ColorLut::Grid HDR_GRID = {
+	.fromScRGB = ColorKernels::BT709_TO_BT2020,
+	.pqScale = ColorKernels::SCRGB_WHITE_NITS / ColorKernels::PQ_MAX_NITS,
+	.zeroIndex = 0
+};
+
+static Matrix3x3 Multiply(const Matrix3x3& a, const Matrix3x3& b) noexcept {
+	Matrix3x3 result;
+	for (uint32_t i = 0; i < 3; ++i) {
+		for (uint32_t j = 0; j < 3; ++j) {
+			double sum = 0;
+			for (uint32_t k = 0; k < 3; ++k) {
+				sum += (double)a.m[i][k] * b.m[k][j];
+			}
+			result.m[i][j] = (float)sum;
+		}
+	}
+	return result;
+}
+
+static bool Invert(const Matrix3x3& matrix, Matrix3x3& result) noexcept {
+	const auto& m = matrix.m;
+	// 余子式
+	double cofactors[3][3];
+	for (uint32_t i = 0; i < 3; ++i) {
+		for (uint32_t j = 0; j < 3; ++j) {
+			const uint32_t i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+			const uint32_t j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+			cofactors[i][j] = (double)m[i1][j1] * m[i2][j2] - (double)m[i1][j2] * m[i2][j1];
+		}
+	}
+
+	const double determinant = m[0][0] * cofactors[0][0] + m[0][1] * cofactors[0][1] + m[0][2] * cofactors[0][2];
+	if (!std::isfinite(determinant) || std::abs(determinant) < 1e-6) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < 3; ++i) {
+		for (uint32_t j = 0; j < 3; ++j) {
+			result.m[i][j] = (float)(cofactors[j][i] / determinant);
+		}
+	}
+	return true;
+}
+
+// 超出色域（有负分量）的颜色向相同亮度的灰色去饱和，直到最小的分量为 0。保持色相和亮度。
+static void MapToGamut(float* const rgb[3], size_t count, const std::array<float, 3>& luminance) noexcept {
+	for (size_t i = 0; i < count; ++i) {
+		const float minValue = std::min({ rgb[0][i], rgb[1][i], rgb[2][i] });
+		if (minValue >= 0) {
+			continue;
+		}
+
+		const float y = luminance[0] * rgb[0][i] + luminance[1] * rgb[1][i] + luminance[2] * rgb[2][i];
+		const float t = y > 0 ? y / (y - minValue) : 0.0f;
+		for (uint32_t c = 0; c < 3; ++c) {
+			rgb[c][i] = std::max(y + t * (rgb[c][i] - y), 0.0f);
+		}
+	}
+}
+
+// 每个分量单独压缩，knee 以下不变，之上渐近到 peak，在 knee 处斜率连续。按最大分量压缩可以保持
+// 色相，但在格子内不光滑，大的格子插值后灰阶不再单调；分别压缩时高光向白色去饱和。SDR 内容的亮度
+// 以下总是不压缩。SDR 和 WCG 下 peak 就是 SDR 白，超出的部分由渲染目标或显示器截断，在 LUT 中
+// 截断会使附近的格点插值出错。
+static void ToneMap(float* const rgb[3], size_t count, float peak, float sdrWhiteLevel) noexcept {
+	if (peak <= sdrWhiteLevel) {
+		return;
+	}
+
+	const float knee = std::max(0.75f * peak, sdrWhiteLevel);
+	const float range = peak - knee;
+
+	for (uint32_t c = 0; c < 3; ++c) {
+		for (size_t i = 0; i < count; ++i) {
+			const float value = rgb[c][i];
+			if (value > knee) {
+				const float x = (value - knee) / range;
+				rgb[c][i] = knee + range * x / (1 + x);
+			}
+		}
+	}
+}
+
+// TRC 的逆。curve 单调不减，在其中二分查找再线性插值。linear 超过 1 时沿最后一段外推，由渲染目标
+// 截断，在 LUT 中截断会使 1 附近的格点插值出错。
+static float InvertCurve(const std::vector<float>& curve, float linear) noexcept {
+	const size_t last = curve.size() - 1;
+	if (linear >= curve[last]) {
+		const float slope = (curve[last] - curve[last - 1]) * last;
+		return slope > 0 ? 1.0f + (linear - curve[last]) / slope : 1.0f;
+	}
+
+	const auto it = std::lower_bound(curve.begin(), curve.end(), linear);
+	if (it == curve.begin()) {
+		return 0.0f;
+	}
+
+	const float high = *it;
+	const float low = *(it - 1);
+	const float fraction = high > low ? (linear - low) / (high - low) : 0.0f;
+	return ((it - curve.begin() - 1) + fraction) / last;
+}
+
+const ColorLut::Grid& ColorLut::GetGrid(Output output) noexcept {
+	return output == Output::SDR ? SDR_GRID : HDR_GRID;
+}
+
+bool ColorLut::CreateCalibration(const IccProfile& profile, Calibration& calibration) noexcept {
+	Matrix3x3 xyzToDisplay;
+	if (!Invert(profile.rgbToXYZ, xyzToDisplay)) {
+		return false;
+	}
+
+	// 场景的白点为 D65，配置文件的原色已经适应到 D50
+	calibration.fromBT709 = Multiply(xyzToDisplay, Multiply(D65_TO_D50, BT709_TO_XYZ));
+
+	for (uint32_t c = 0; c < 3; ++c) {
+		calibration.luminance[c] = profile.rgbToXYZ.m[1][c];
+
+		std::vector<float>& curve = calibration.curves[c];
+		curve.resize(CURVE_SAMPLE_COUNT);
+
+		float prevValue = 0.0f;
+		for (uint32_t i = 0; i < CURVE_SAMPLE_COUNT; ++i) {
+			// 校准的表可能有微小的非单调，求逆要求单调不减
+			prevValue = std::max(prevValue, profile.curves[c].Evaluate((float)i / (CURVE_SAMPLE_COUNT - 1)));
+			curve[i] = prevValue;
+		}
+	}
+
+	return true;
+}
+
+void ColorLut::Build(JobSystem& jobSystem, const Params& params, uint16_t* data) noexcept {
+	jobSystem.ParallelFor(SIZE, [&](uint32_t slice) {
+		BuildSlice(params, slice, data);
+	});
+}
+
+void ColorLut::BuildSlice(const Params& params, uint32_t slice, uint16_t* data) noexcept {
+	const Grid& grid = GetGrid(params.output);
+
+	// 每个维度上格点解码后的值，0 两侧分别解码
+	float values[SIZE];
+	for (uint32_t i = 0; i < SIZE; ++i) {
+		values[i] = i >= grid.zeroIndex ?
+			float(i - grid.zeroIndex) / (SIZE - 1 - grid.zeroIndex) : float(grid.zeroIndex - i) / grid.zeroIndex;
+	}
+	ColorKernels::PQToLinear(values, values, SIZE, grid.pqScale);
+	for (uint32_t i = 0; i < grid.zeroIndex; ++i) {
+		values[i] = -values[i];
+	}
+
+	float channels[3][SLICE_ENTRY_COUNT];
+	float* const rgb[3] = { channels[0], channels[1], channels[2] };
+
+	for (uint32_t g = 0; g < SIZE; ++g) {
+		for (uint32_t r = 0; r < SIZE; ++r) {
+			const uint32_t i = g * SIZE + r;
+			rgb[0][i] = values[r];
+			rgb[1][i] = values[g];
+			rgb[2][i] = values[slice];
+		}
+	}
+
+	// 坐标空间就是目标色域：SDR 为 BT.709，HDR 显示器的色域不超过 BT.2020。校准时转换到显示器的
+	// 原色，SDR 的坐标空间是 scRGB。
+	const Calibration* calibration = params.output == Output::SDR ? params.calibration : nullptr;
+	std::array<float, 3> luminance = params.output == Output::SDR ? BT709_LUMINANCE : BT2020_LUMINANCE;
+	if (calibration) {
+		ColorKernels::TransformGamut(rgb, rgb, SLICE_ENTRY_COUNT, calibration->fromBT709);
+		luminance = calibration->luminance;
+	}
+
+	// 场景中 1.0 为 SDR 白，转换为 scRGB 的单位
+	for (uint32_t c = 0; c < 3; ++c) {
+		ColorKernels::Scale(rgb[c], rgb[c], SLICE_ENTRY_COUNT, params.sdrWhiteLevel);
+	}
+
+	MapToGamut(rgb, SLICE_ENTRY_COUNT, luminance);
+	ToneMap(rgb, SLICE_ENTRY_COUNT, params.maxLuminance, params.sdrWhiteLevel);
+
+	switch (params.output) {
+	case Output::SDR:
+		if (calibration) {
+			// 渲染目标编码为 sRGB，因此写入的是显示器编码值的 sRGB 解码
+			for (uint32_t c = 0; c < 3; ++c) {
+				for (uint32_t i = 0; i < SLICE_ENTRY_COUNT; ++i) {
+					rgb[c][i] = InvertCurve(calibration->curves[c], rgb[c][i]);
+				}
+				ColorKernels::SRGBToLinear(rgb[c], rgb[c], SLICE_ENTRY_COUNT);
+			}
+		}
+		break;
+	case Output::ScRGB:
+		ColorKernels::TransformGamut(rgb, rgb, SLICE_ENTRY_COUNT, ColorKernels::BT2020_TO_BT709);
+		break;
+	case Output::HDR10:
+		for (uint32_t c = 0; c < 3; ++c) {
+			ColorKernels::LinearToPQ(rgb[c], rgb[c], SLICE_ENTRY_COUNT, HDR_GRID.pqScale);
+		}
+		break;
+	}
+
+	ColorKernels::PackHalf(rgb, data + (size_t)slice * SLICE_ENTRY_COUNT * 4, SLICE_ENTRY_COUNT);
+}
+
+void ColorLut::Apply(
+	Output output,
+	const uint16_t* data,
+	const float* const src[3],
+	float* const dst[3],
+	size_t count
+) noexcept {
+	const Grid& grid = GetGrid(output);
+	const float zero = (float)grid.zeroIndex / (SIZE - 1);
+
+	ColorKernels::TransformGamut(src, dst, count, grid.fromScRGB);
+
+	for (uint32_t c = 0; c < 3; ++c) {
+		for (size_t i = 0; i < count; ++i) {
+			const float value = dst[c][i];
+			float pq = std::abs(value);
+			ColorKernels::LinearToPQ(&pq, &pq, 1, grid.pqScale);
+			dst[c][i] = value >= 0 ? zero + (1 - zero) * pq : zero * (1 - pq);
+		}
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		uint32_t base[3];
+		float weights[3];
+		for (uint32_t c = 0; c < 3; ++c) {
+			const float position = dst[c][i] * (SIZE - 1);
+			base[c] = std::min((uint32_t)position, SIZE - 2);
+			weights[c] = position - base[c];
+		}
+
+		// 立方体的 8 个顶点，第 j 个在每个维度上的偏移为 j 的对应位
+		uint16_t corners[8 * 4];
+		for (uint32_t j = 0; j < 8; ++j) {
+			const size_t index = ((size_t)(base[2] + (j >> 2)) * SIZE + base[1] + ((j >> 1) & 1)) * SIZE +
+				base[0] + (j & 1);
+			std::memcpy(corners + j * 4, data + index * 4, sizeof(uint16_t) * 4);
+		}
+
+		float values[3][8];
+		float* const unpacked[3] = { values[0], values[1], values[2] };
+		ColorKernels::UnpackHalf(corners, unpacked, 8);
+
+		for (uint32_t c = 0; c < 3; ++c) {
+			const float* v = values[c];
+			const float x00 = std::lerp(v[0], v[1], weights[0]);
+			const float x10 = std::lerp(v[2], v[3], weights[0]);
+			const float x01 = std::lerp(v[4], v[5], weights[0]);
+			const float x11 = std::lerp(v[6], v[7], weights[0]);
+			dst[c][i] = std::lerp(std::lerp(x00, x10, weights[1]), std::lerp(x01, x11, weights[1]), weights[2]);
+		}
+	}
+}
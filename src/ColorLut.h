@@ -0,0 +1,80 @@
+#pragma once
+#include "ColorKernels.h"
+#include <array>
+#include <vector>
+
+class JobSystem;
+struct IccProfile;
+
+// 颜色管理的 3D LUT，将整个输出变换烘焙为一次采样。场景以 scRGB 渲染到中间纹理，1.0 为 SDR
+// 白，shaders/ColorLut_PS.hlsl 将它转换为 LUT 的坐标，见 Grid。每个格点依次解码坐标、转换到目标
+// 色域、乘以 SDR 内容亮度、映射到目标色域内、按显示器的最大亮度色调映射、应用 ICC 校准，最后编码
+// 为交换链的格式。按切片生成，每个切片使用 ColorKernels 的批量函数。不依赖 D3D12。
+struct ColorLut {
+	// 和交换链的格式对应
+	enum class Output {
+		// R8G8B8A8_UNORM_SRGB，写入线性 BT.709，由渲染目标编码为 sRGB
+		SDR,
+		// R16G16B16A16_FLOAT，写入 scRGB
+		ScRGB,
+		// R10G10B10A2_UNORM，写入 BT.2020 的 PQ 编码值
+		HDR10
+	};
+
+	// LUT 的坐标空间。场景的颜色先乘以 fromScRGB，每个分量的绝对值乘以 pqScale 后编码为 PQ，
+	// 非负值映射到 [zero, 1]，负值映射到 [0, zero)，zero 是第 zeroIndex 个格点的坐标。目标色域的
+	// 边界因此落在格点上而不穿过格子，色域内的颜色插值时不受色域映射的影响。
+	struct Grid {
+		ColorKernels::Matrix3x3 fromScRGB;
+		float pqScale;
+		uint32_t zeroIndex;
+	};
+
+	// 由显示器的 ICC 配置文件得到，只用于 SDR
+	struct Calibration {
+		// BT.709 到显示器的线性 RGB
+		ColorKernels::Matrix3x3 fromBT709;
+		// 显示器每个原色的亮度，用于色域映射
+		std::array<float, 3> luminance;
+		// 每个通道的 TRC 在编码值上均匀采样，单调不减，用于求逆
+		std::array<std::vector<float>, 3> curves;
+	};
+
+	struct Params {
+		Output output = Output::SDR;
+		// 单位和 ColorInfo 相同，1.0 表示 80nit
+		float maxLuminance = 1.0f;
+		float sdrWhiteLevel = 1.0f;
+		// 可选，只用于 Output::SDR
+		const Calibration* calibration = nullptr;
+	};
+
+	// 每个维度的格点数
+	static constexpr uint32_t SIZE = 33;
+	// R16G16B16A16_FLOAT，格点 (r, g, b) 是第 (b * SIZE + g) * SIZE + r 项，和 3D 纹理的布局相同
+	static constexpr size_t ENTRY_COUNT = (size_t)SIZE * SIZE * SIZE;
+	// 半精度数的个数
+	static constexpr size_t DATA_SIZE = ENTRY_COUNT * 4;
+
+	// SDR 的坐标空间为 scRGB，超出 BT.709 的颜色占用 0 以下的格点，正值的范围只需覆盖 SDR。HDR 的
+	// 坐标空间为 BT.2020，和 HDR10 的编码相同。
+	static const Grid& GetGrid(Output output) noexcept;
+
+	// 配置文件的矩阵不可逆时返回 false
+	static bool CreateCalibration(const IccProfile& profile, Calibration& calibration) noexcept;
+
+	// 在工作线程并行生成所有切片，data 至少有 DATA_SIZE 项
+	static void Build(JobSystem& jobSystem, const Params& params, uint16_t* data) noexcept;
+
+	// 生成 b 为 slice 的切片，可以在多个线程同时调用
+	static void BuildSlice(const Params& params, uint32_t slice, uint16_t* data) noexcept;
+
+	// 和 shaders/ColorLut_PS.hlsl 相同：将 scRGB 转换为 LUT 的坐标再三线性插值。用于验证。
+	static void Apply(
+		Output output,
+		const uint16_t* data,
+		const float* const src[3],
+		float* const dst[3],
+		size_t count
+	) noexcept;
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include "ColorLut.h"
+#include "Hasher.h"
+#include <cassert>
+#include <cstring>
+#include <span>
+
+// 颜色管理 LUT 的缓存文件格式：文件头之后是 ColorLut::Build 生成的数据。键由调用者根据显示器、
+// ColorInfo 和 ICC 配置文件计算，不匹配时缓存失效。只处理字节，不依赖 D3D12。
+struct ColorLutFile {
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint64_t key;
+		uint32_t lutSize;
+		uint32_t reserved;
+		// 检测文件损坏
+		uint64_t dataHash;
+	};
+	// 没有填充字节，文件内容是确定的
+	static_assert(sizeof(Header) == 32);
+
+	// "CLT0"
+	static constexpr uint32_t MAGIC = 0x30544C43;
+	// 格式或 ColorLut 的算法改变时递增
+	static constexpr uint32_t VERSION = 1;
+	static constexpr size_t HEADER_SIZE = sizeof(Header);
+	static constexpr size_t DATA_BYTES = ColorLut::DATA_SIZE * sizeof(uint16_t);
+	static constexpr size_t FILE_SIZE = HEADER_SIZE + DATA_BYTES;
+
+	// 调用者在 data 的 HEADER_SIZE 之后写入 LUT 再调用 WriteHeader
+	static uint16_t* GetLut(std::span<uint8_t> data) noexcept {
+		assert(data.size() == FILE_SIZE);
+		return (uint16_t*)(data.data() + HEADER_SIZE);
+	}
+
+	static void WriteHeader(uint64_t key, std::span<uint8_t> data) noexcept {
+		assert(data.size() == FILE_SIZE);
+
+		const Header header = {
+			.magic = MAGIC,
+			.version = VERSION,
+			.key = key,
+			.lutSize = ColorLut::SIZE,
+			.reserved = 0,
+			.dataHash = Hasher::Hash(data.data() + HEADER_SIZE, DATA_BYTES)
+		};
+		std::memcpy(data.data(), &header, sizeof(header));
+	}
+
+	// 文件有效且键匹配时将 LUT 复制到 lut，它至少有 ColorLut::DATA_SIZE 项
+	static bool Read(std::span<const uint8_t> data, uint64_t key, uint16_t* lut) noexcept {
+		if (data.size() != FILE_SIZE) {
+			return false;
+		}
+
+		// 文件数据不一定对齐
+		Header header;
+		std::memcpy(&header, data.data(), sizeof(header));
+
+		if (header.magic != MAGIC || header.version != VERSION || header.key != key ||
+			header.lutSize != ColorLut::SIZE || header.reserved != 0) {
+			return false;
+		}
+
+		if (header.dataHash != Hasher::Hash(data.data() + HEADER_SIZE, DATA_BYTES)) {
+			return false;
+		}
+
+		std::memcpy(lut, data.data() + HEADER_SIZE, DATA_BYTES);
+		return true;
+	}
+};
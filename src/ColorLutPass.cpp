@@ -0,0 +1,307 @@
+#include "pch.h"
+#include "ColorLutPass.h"
+#include "ColorLutFile.h"
+#include "Hasher.h"
+#include "IccProfile.h"
+#include "JobSystem.h"
+#include "Win32Helper.h"
+
+// 显示器的 ICC 配置文件通常只有几 KB，含有 LUT 的配置文件也不会超过这个大小
+static constexpr uint64_t MAX_ICC_PROFILE_SIZE = 4 * 1024 * 1024;
+
+static ColorLut::Output GetOutput(ShaderPermutations::ColorMode colorMode) noexcept {
+	switch (colorMode) {
+	case ShaderPermutations::ColorMode::SDR:
+		return ColorLut::Output::SDR;
+	case ShaderPermutations::ColorMode::HDR10:
+		return ColorLut::Output::HDR10;
+	default:
+		return ColorLut::Output::ScRGB;
+	}
+}
+
+// 设备接口名在重启和重新排列显示器后不变，GDI 设备名如 \\.\DISPLAY1 则可能改变
+static std::wstring GetMonitorId(const MONITORINFOEX& monitorInfo) noexcept {
+	DISPLAY_DEVICE device{ .cb = sizeof(device) };
+	if (EnumDisplayDevices(monitorInfo.szDevice, 0, &device, EDD_GET_DEVICE_INTERFACE_NAME)) {
+		return device.DeviceID;
+	}
+	return monitorInfo.szDevice;
+}
+
+// 读取颜色管理设置中显示器的默认配置文件
+static bool ReadIccProfile(const wchar_t* deviceName, std::vector<uint8_t>& data) noexcept {
+	wil::unique_hdc hdc(CreateDC(L"DISPLAY", deviceName, nullptr, nullptr));
+	if (!hdc) {
+		return false;
+	}
+
+	wchar_t path[MAX_PATH];
+	DWORD size = (DWORD)std::size(path);
+	if (!GetICMProfile(hdc.get(), &size, path)) {
+		return false;
+	}
+
+	return Win32Helper::ReadFileData(path, MAX_ICC_PROFILE_SIZE, data);
+}
+
+// 每个显示器的每种输出一个缓存文件，名字为它们的哈希的十六进制表示。亮度或配置文件改变后覆盖
+// 原来的文件，因此文件数不会随设置的改变而增长。
+static std::filesystem::path GetCachePath(uint64_t slot) noexcept {
+	wchar_t name[32];
+	swprintf_s(name, L"%016llX.bin", slot);
+	return Win32Helper::GetExePath().parent_path() / L"ColorLutCache" / name;
+}
+
+HRESULT ColorLutPass::Initialize(D3D12Context& d3d12Context, JobSystem& jobSystem) noexcept {
+	_jobSystem = &jobSystem;
+	_lut.resize(ColorLut::DATA_SIZE);
+
+	HRESULT hr = _CreateRootSignature(d3d12Context);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	const CD3DX12_RESOURCE_DESC textureDesc = CD3DX12_RESOURCE_DESC::Tex3D(
+		DXGI_FORMAT_R16G16B16A16_FLOAT, ColorLut::SIZE, ColorLut::SIZE, ColorLut::SIZE, 1);
+	hr = d3d12Context.CreateResource(D3D12_HEAP_TYPE_DEFAULT, textureDesc,
+		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, nullptr, _lutTexture, _lutTextureAllocation);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	hr = d3d12Context.AllocateCpuDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 2, _cpuDescriptors);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	// LUT 的 SRV 之后不再改变，场景的 SRV 每帧创建
+	const uint32_t descriptorSize = d3d12Context.GetDescriptorSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	d3d12Context.GetDevice()->CreateShaderResourceView(
+		_lutTexture.get(), nullptr, _cpuDescriptors.GetCpuHandle(1, descriptorSize));
+
+	return S_OK;
+}
+
+HRESULT ColorLutPass::CreatePipelineState(
+	D3D12Context& d3d12Context,
+	ShaderPermutations::ColorMode colorMode,
+	winrt::com_ptr<ID3D12PipelineState>& pipelineState
+) const noexcept {
+	// SDR 的 LUT 坐标空间不同，见 ColorLut::GetGrid
+	const ShaderId ps = colorMode == ShaderPermutations::ColorMode::SDR ?
+		ShaderId::ColorLutSDR_PS : ShaderId::ColorLut_PS;
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {
+		.pRootSignature = _rootSignature.get(),
+		.VS = d3d12Context.GetShaderByteCode(ShaderId::FullscreenVS),
+		.PS = d3d12Context.GetShaderByteCode(ps),
+		.BlendState = {
+			.RenderTarget = {{ .RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL }}
+		},
+		.SampleMask = UINT_MAX,
+		.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT),
+		.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE,
+		.NumRenderTargets = 1,
+		.RTVFormats = { ShaderPermutations::GetRtvFormat(colorMode) },
+		.SampleDesc = { .Count = 1 }
+	};
+	return d3d12Context.CreateGraphicsPipelineState(psoDesc, pipelineState);
+}
+
+HRESULT ColorLutPass::Update(
+	HMONITOR hMonitor,
+	ShaderPermutations::ColorMode colorMode,
+	const ColorInfo& colorInfo
+) noexcept {
+	MONITORINFOEX monitorInfo{};
+	monitorInfo.cbSize = sizeof(monitorInfo);
+	if (!GetMonitorInfo(hMonitor, &monitorInfo)) {
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	ColorLut::Params params = {
+		.output = GetOutput(colorMode),
+		.maxLuminance = colorInfo.maxLuminance,
+		.sdrWhiteLevel = colorInfo.sdrWhiteLevel
+	};
+
+	// HDR 下系统不应用显示器的配置文件，因此只在 SDR 下校准。不支持的配置文件视为没有。
+	std::vector<uint8_t> iccProfileData;
+	ColorLut::Calibration calibration;
+	if (params.output == ColorLut::Output::SDR && ReadIccProfile(monitorInfo.szDevice, iccProfileData)) {
+		IccProfile profile;
+		if (IccProfile::Parse(iccProfileData, profile) && ColorLut::CreateCalibration(profile, calibration)) {
+			params.calibration = &calibration;
+		} else {
+			iccProfileData.clear();
+		}
+	}
+
+	// slot 决定缓存文件，key 还包含 LUT 的其他输入，存储在文件头中
+	uint64_t slot;
+	uint64_t key;
+	{
+		const std::wstring monitorId = GetMonitorId(monitorInfo);
+
+		Hasher hasher;
+		hasher.Add((uint64_t)monitorId.size());
+		hasher.AddBytes(monitorId.data(), monitorId.size() * sizeof(wchar_t));
+		hasher.Add(params.output);
+		slot = hasher.GetHash();
+
+		hasher.Add(params.maxLuminance);
+		hasher.Add(params.sdrWhiteLevel);
+		hasher.Add(Hasher::Hash(iccProfileData.data(), iccProfileData.size()));
+		key = hasher.GetHash();
+	}
+
+	if (key == _key) {
+		return S_OK;
+	}
+	_key = key;
+	_isUploadPending = true;
+
+	const std::filesystem::path cachePath = GetCachePath(slot);
+
+	std::vector<uint8_t> fileData;
+	if (Win32Helper::ReadFileData(cachePath, ColorLutFile::FILE_SIZE, fileData) &&
+		ColorLutFile::Read(fileData, key, _lut.data())) {
+		return S_OK;
+	}
+
+	fileData.resize(ColorLutFile::FILE_SIZE);
+	uint16_t* lut = ColorLutFile::GetLut(fileData);
+	ColorLut::Build(*_jobSystem, params, lut);
+	ColorLutFile::WriteHeader(key, fileData);
+	std::memcpy(_lut.data(), lut, ColorLutFile::DATA_BYTES);
+
+	// 写入失败不影响渲染，下次重新生成
+	CreateDirectory(cachePath.parent_path().c_str(), nullptr);
+	Win32Helper::WriteFileData(cachePath, fileData);
+
+	return S_OK;
+}
+
+HRESULT ColorLutPass::Prepare(D3D12Context& d3d12Context) noexcept {
+	_uploadBuffer = nullptr;
+
+	if (!_isUploadPending) {
+		return S_OK;
+	}
+
+	const D3D12_RESOURCE_DESC textureDesc = _lutTexture->GetDesc();
+	uint64_t uploadSize;
+	d3d12Context.GetDevice()->GetCopyableFootprints(
+		&textureDesc, 0, 1, 0, &_uploadFootprint, nullptr, nullptr, &uploadSize);
+
+	// 上传环中的数据只在这一帧有效
+	UploadAllocation uploadAllocation;
+	HRESULT hr = d3d12Context.AllocateUpload(
+		uploadSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, uploadAllocation);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	// 每行按 D3D12_TEXTURE_DATA_PITCH_ALIGNMENT 对齐
+	const D3D12_SUBRESOURCE_FOOTPRINT& footprint = _uploadFootprint.Footprint;
+	const size_t rowSize = sizeof(uint16_t) * 4 * ColorLut::SIZE;
+	for (uint32_t z = 0; z < ColorLut::SIZE; ++z) {
+		for (uint32_t y = 0; y < ColorLut::SIZE; ++y) {
+			uint8_t* row = (uint8_t*)uploadAllocation.cpuAddress +
+				(size_t)footprint.RowPitch * (footprint.Height * z + y);
+			std::memcpy(row, _lut.data() + ((size_t)z * ColorLut::SIZE + y) * ColorLut::SIZE * 4, rowSize);
+		}
+	}
+
+	_uploadFootprint.Offset = uploadAllocation.offset;
+	_uploadBuffer = uploadAllocation.resource;
+	_isUploadPending = false;
+	return S_OK;
+}
+
+void ColorLutPass::AddPasses(
+	RenderGraph& renderGraph,
+	uint32_t commandListIndex,
+	RenderGraphResource scene,
+	RenderGraphResource backBuffer,
+	const CD3DX12_CPU_DESCRIPTOR_HANDLE& rtvHandle,
+	Size size
+) noexcept {
+	const RenderGraphResource lut = renderGraph.ImportResource(_lutTexture.get(),
+		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+	if (_uploadBuffer) {
+		const uint32_t pass = renderGraph.AddPass("UploadColorLut", commandListIndex,
+			[this](ID3D12GraphicsCommandList* commandList) {
+				const CD3DX12_TEXTURE_COPY_LOCATION dest(_lutTexture.get(), 0);
+				const CD3DX12_TEXTURE_COPY_LOCATION src(_uploadBuffer, _uploadFootprint);
+				commandList->CopyTextureRegion(&dest, 0, 0, 0, &src, nullptr);
+			});
+		renderGraph.WriteResource(pass, lut, D3D12_RESOURCE_STATE_COPY_DEST);
+	}
+
+	const uint32_t pass = renderGraph.AddPass("ColorLut", commandListIndex,
+		[this, rtvHandle, size](ID3D12GraphicsCommandList* commandList) {
+			_Record(commandList, rtvHandle, size);
+		});
+	renderGraph.ReadResource(pass, scene, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	renderGraph.ReadResource(pass, lut, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	renderGraph.WriteResource(pass, backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+}
+
+HRESULT ColorLutPass::BindScene(D3D12Context& d3d12Context, ID3D12Resource* scene) noexcept {
+	// 瞬态资源可能每帧不同，着色器不可见的描述符在复制后即可覆盖
+	d3d12Context.GetDevice()->CreateShaderResourceView(scene, nullptr, _cpuDescriptors.cpuHandle);
+
+	const D3D12_CPU_DESCRIPTOR_HANDLE srcStart = _cpuDescriptors.cpuHandle;
+	const UINT srcCount = 2;
+	return d3d12Context.CopyToFrameDescriptors({ &srcStart, 1 }, { &srcCount, 1 }, _frameDescriptors);
+}
+
+HRESULT ColorLutPass::_CreateRootSignature(D3D12Context& d3d12Context) noexcept {
+	// 布局见 shaders/ColorLut_PS.hlsl
+	const CD3DX12_DESCRIPTOR_RANGE1 srvRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 2, 0);
+
+	CD3DX12_ROOT_PARAMETER1 rootParams[2];
+	rootParams[0].InitAsDescriptorTable(1, &srvRange, D3D12_SHADER_VISIBILITY_PIXEL);
+	rootParams[1].InitAsConstants(1, 0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+
+	const CD3DX12_STATIC_SAMPLER_DESC samplerDesc(
+		0,
+		D3D12_FILTER_MIN_MAG_MIP_LINEAR,
+		D3D12_TEXTURE_ADDRESS_MODE_CLAMP,
+		D3D12_TEXTURE_ADDRESS_MODE_CLAMP,
+		D3D12_TEXTURE_ADDRESS_MODE_CLAMP
+	);
+
+	// 全屏三角形在顶点着色器中生成，没有输入布局
+	CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc(
+		(UINT)std::size(rootParams), rootParams, 1, &samplerDesc, D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+	return d3d12Context.CreateRootSignature(rootSignatureDesc, _rootSignature);
+}
+
+void ColorLutPass::_Record(
+	ID3D12GraphicsCommandList* commandList,
+	const CD3DX12_CPU_DESCRIPTOR_HANDLE& rtvHandle,
+	Size size
+) const noexcept {
+	commandList->SetGraphicsRootSignature(_rootSignature.get());
+	commandList->SetPipelineState(_pipelineState.get());
+	commandList->SetGraphicsRootDescriptorTable(0, _frameDescriptors.gpuHandle);
+	commandList->SetGraphicsRoot32BitConstants(1, 1, &_exposure, 0);
+
+	{
+		CD3DX12_VIEWPORT viewport(0.0f, 0.0f, (float)size.width, (float)size.height);
+		commandList->RSSetViewports(1, &viewport);
+	}
+	{
+		CD3DX12_RECT scissorRect(0, 0, (LONG)size.width, (LONG)size.height);
+		commandList->RSSetScissorRects(1, &scissorRect);
+	}
+
+	commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
+	commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	commandList->DrawInstanced(3, 1, 0, 0);
+}
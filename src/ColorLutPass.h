@@ -0,0 +1,87 @@
+#pragma once
+#include "ColorLut.h"
+#include "D3D12Context.h"
+#include "RenderGraph.h"
+
+class JobSystem;
+
+// 颜色管理的后处理。场景以 scRGB 渲染到 FP16 的瞬态纹理，1.0 为 SDR 白，这里用 ColorLut 生成的
+// 3D LUT 采样一次，写入交换链的格式。LUT 取决于显示器、ColorInfo、交换链格式和 SDR 下显示器的
+// ICC 配置文件，生成后缓存在 exe 所在目录，这些都不变时不重新生成。每个显示器的每种输出只保留
+// 最近的一个 LUT。
+class ColorLutPass {
+public:
+	ColorLutPass() = default;
+	ColorLutPass(const ColorLutPass&) = delete;
+	ColorLutPass(ColorLutPass&&) = default;
+
+	HRESULT Initialize(D3D12Context& d3d12Context, JobSystem& jobSystem) noexcept;
+
+	// 每种交换链格式一个 PSO，可以在工作线程并行调用
+	HRESULT CreatePipelineState(
+		D3D12Context& d3d12Context,
+		ShaderPermutations::ColorMode colorMode,
+		winrt::com_ptr<ID3D12PipelineState>& pipelineState
+	) const noexcept;
+
+	void SetPipelineState(ID3D12PipelineState* pipelineState) noexcept {
+		_pipelineState.copy_from(pipelineState);
+	}
+
+	// 在渲染线程调用，显示器或颜色模式改变后调用。先读取缓存，失败或键不匹配时生成 LUT 并覆盖
+	// 缓存，写入失败不影响渲染。新的 LUT 在下一帧上传。
+	HRESULT Update(HMONITOR hMonitor, ShaderPermutations::ColorMode colorMode, const ColorInfo& colorInfo) noexcept;
+
+	// 在 LUT 之前乘以场景的颜色，用于自动曝光
+	void SetExposure(float exposure) noexcept {
+		_exposure = exposure;
+	}
+
+	// 在渲染线程调用，LUT 改变后将它复制到上传环
+	HRESULT Prepare(D3D12Context& d3d12Context) noexcept;
+
+	// scene 是场景的 FP16 渲染目标，结果写入 backBuffer。上传 LUT 的 pass 也录制到
+	// commandListIndex 对应的命令列表，调用者负责在这个命令列表中设置 D3D12Context 的着色器
+	// 可见描述符堆。
+	void AddPasses(
+		RenderGraph& renderGraph,
+		uint32_t commandListIndex,
+		RenderGraphResource scene,
+		RenderGraphResource backBuffer,
+		const CD3DX12_CPU_DESCRIPTOR_HANDLE& rtvHandle,
+		Size size
+	) noexcept;
+
+	// 在渲染线程调用，瞬态资源绑定之后为 scene 创建 SRV
+	HRESULT BindScene(D3D12Context& d3d12Context, ID3D12Resource* scene) noexcept;
+
+private:
+	HRESULT _CreateRootSignature(D3D12Context& d3d12Context) noexcept;
+
+	void _Record(
+		ID3D12GraphicsCommandList* commandList,
+		const CD3DX12_CPU_DESCRIPTOR_HANDLE& rtvHandle,
+		Size size
+	) const noexcept;
+
+	JobSystem* _jobSystem = nullptr;
+
+	winrt::com_ptr<ID3D12RootSignature> _rootSignature;
+	winrt::com_ptr<ID3D12PipelineState> _pipelineState;
+
+	winrt::com_ptr<ID3D12Resource> _lutTexture;
+	HeapAllocation _lutTextureAllocation;
+	// 第一个是场景的 SRV，第二个是 LUT 的 SRV，每帧复制到着色器可见的描述符堆
+	DescriptorAllocation _cpuDescriptors;
+	DescriptorAllocation _frameDescriptors;
+
+	float _exposure = 1.0f;
+
+	// 当前 LUT 的键，见 Update
+	uint64_t _key = 0;
+	std::vector<uint16_t> _lut;
+	bool _isUploadPending = false;
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT _uploadFootprint{};
+	// 这一帧需要上传时不为空
+	ID3D12Resource* _uploadBuffer = nullptr;
+};
@@ -3,12 +3,17 @@
 #include "DirectXHelper.h"
 #include "Win32Helper.h"
 
-bool D3D12Context::Initialize(uint32_t maxInFlightFrameCount) noexcept {
+bool D3D12Context::Initialize(
+	uint32_t maxInFlightFrameCount,
+	bool forceWarp,
+	uint64_t uploadRingSize,
+	uint64_t heapSize
+) noexcept {
 	if (FAILED(_CreateDXGIFactory())) {
 		return false;
 	}
 
-	if (!_CreateD3DDevice()) {
+	if (!_CreateD3DDevice(forceWarp)) {
 		return false;
 	}
 
@@ -49,14 +54,35 @@ bool D3D12Context::Initialize(uint32_t maxInFlightFrameCount) noexcept {
 		}
 	}
 
-	// 检查 shader model 6.0 支持
+	// 检查支持的最高 shader model。运行时不认识查询的版本时返回 E_INVALIDARG，应降低版本重试
 	{
-		D3D12_FEATURE_DATA_SHADER_MODEL data = { .HighestShaderModel = D3D_SHADER_MODEL_6_0 };
-		if (SUCCEEDED(_device->CheckFeatureSupport(D3D12_FEATURE_SHADER_MODEL, &data, sizeof(data)))) {
-			_isSM6Supported = data.HighestShaderModel == D3D_SHADER_MODEL_6_0;
+		D3D12_FEATURE_DATA_SHADER_MODEL data{};
+		for (D3D_SHADER_MODEL shaderModel = D3D_SHADER_MODEL_6_6; shaderModel >= D3D_SHADER_MODEL_6_0;
+			shaderModel = D3D_SHADER_MODEL(shaderModel - 1)) {
+			data.HighestShaderModel = shaderModel;
+			HRESULT hr = _device->CheckFeatureSupport(D3D12_FEATURE_SHADER_MODEL, &data, sizeof(data));
+			if (SUCCEEDED(hr)) {
+				_shaderModel = data.HighestShaderModel;
+				break;
+			}
+			if (hr != E_INVALIDARG) {
+				break;
+			}
 		}
 	}
 
+	// 检查 bindless 支持，需要 SM 6.6 的 ResourceDescriptorHeap 和 Resource Binding Tier 3
+	if (_shaderModel >= D3D_SHADER_MODEL_6_6) {
+		D3D12_FEATURE_DATA_D3D12_OPTIONS data{};
+		if (SUCCEEDED(_device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &data, sizeof(data)))) {
+			_isBindlessSupported = data.ResourceBindingTier >= D3D12_RESOURCE_BINDING_TIER_3;
+		}
+	}
+
+	if (FAILED(_shaderArchive.Initialize(Win32Helper::GetExePath().parent_path() / L"Shaders.bin"))) {
+		return false;
+	}
+
 	{
 		D3D12_COMMAND_QUEUE_DESC queueDesc = {
 			.Type = D3D12_COMMAND_LIST_TYPE_DIRECT,
@@ -67,24 +93,36 @@ bool D3D12Context::Initialize(uint32_t maxInFlightFrameCount) noexcept {
 		}
 	}
 
-	if (FAILED(_device->CreateCommandList1(0, D3D12_COMMAND_LIST_TYPE_DIRECT,
-		D3D12_COMMAND_LIST_FLAG_NONE, IID_PPV_ARGS(&_commandList)))) {
+	if (FAILED(_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&_fence)))) {
 		return false;
 	}
 
-	_commandAllocators.resize(maxInFlightFrameCount);
-	for (winrt::com_ptr<ID3D12CommandAllocator>& commandAllocator : _commandAllocators) {
-		if (FAILED(_device->CreateCommandAllocator(
-			D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator)))) {
-			return false;
-		}
+	if (FAILED(_fenceEvent.create(wil::EventOptions::None))) {
+		return false;
 	}
 
-	if (FAILED(_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&_fence)))) {
+	_frameFenceValues.resize(maxInFlightFrameCount);
+
+	if (FAILED(_gpuProfiler.Initialize(_device.get(), maxInFlightFrameCount))) {
 		return false;
 	}
 
-	_frameFenceValues.resize(maxInFlightFrameCount);
+	_heapAllocator.Initialize(_device.get(), _isHeapFlagCreateNotZeroedSupported, heapSize);
+
+	if (FAILED(_CreateUploadRingBuffer(uploadRingSize))) {
+		return false;
+	}
+
+	if (FAILED(_CreateDescriptorHeaps())) {
+		return false;
+	}
+
+	_QueryAdapterInfo();
+	_InitializePipelineCache();
+
+	if (_isBindlessSupported && FAILED(_CreateBindlessRootSignature())) {
+		return false;
+	}
 
 	return true;
 }
@@ -119,21 +157,43 @@ HRESULT D3D12Context::WaitForGpu() noexcept {
 		return hr;
 	}
 
-	return WaitForFenceValue(_curFenceValue);
+	hr = WaitForFenceValue(_curFenceValue);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	// GPU 已空闲
+	_ReleaseCompleted(_curFenceValue);
+	return S_OK;
+}
+
+HANDLE D3D12Context::GetFrameWaitHandle() noexcept {
+	const uint64_t fenceValue = _frameFenceValues[_curFrameIndex];
+	if (_fence->GetCompletedValue() >= fenceValue) {
+		return NULL;
+	}
+
+	// 失败则由 BeginFrame 阻塞等待
+	if (FAILED(_fence->SetEventOnCompletion(fenceValue, _fenceEvent.get()))) {
+		return NULL;
+	}
+
+	return _fenceEvent.get();
 }
 
 HRESULT D3D12Context::BeginFrame(uint32_t& curFrameIndex, ID3D12PipelineState* initialState) noexcept {
+	// 限制在途帧数。命令分配器来自对象池，这里的等待与它们无关。
 	HRESULT hr = WaitForFenceValue(_frameFenceValues[_curFrameIndex]);
 	if (FAILED(hr)) {
 		return hr;
 	}
 
-	hr = _commandAllocators[_curFrameIndex]->Reset();
-	if (FAILED(hr)) {
-		return hr;
-	}
+	_ReleaseCompleted(_fence->GetCompletedValue());
 
-	hr = _commandList->Reset(_commandAllocators[_curFrameIndex].get(), initialState);
+	// 这个帧索引上次的时间戳已经可以读取
+	_gpuProfiler.BeginFrame(_curFrameIndex, _frameCount);
+
+	hr = _AcquireCommandList(initialState, &_commandList);
 	if (FAILED(hr)) {
 		return hr;
 	}
@@ -142,13 +202,112 @@ HRESULT D3D12Context::BeginFrame(uint32_t& curFrameIndex, ID3D12PipelineState* i
 	return S_OK;
 }
 
+HRESULT D3D12Context::AcquireCommandList(
+	ID3D12PipelineState* initialState,
+	ID3D12GraphicsCommandList** commandList
+) noexcept {
+	assert(_commandList);
+	return _AcquireCommandList(initialState, commandList);
+}
+
 HRESULT D3D12Context::EndFrame() noexcept {
+	// 必须在这一帧的围栏之前提交
+	if (_gpuProfiler.HasScopes()) {
+		HRESULT hr = _ResolveGpuProfiler();
+		if (FAILED(hr)) {
+			return hr;
+		}
+	}
+
 	HRESULT hr = Signal(_frameFenceValues[_curFrameIndex]);
 	if (FAILED(hr)) {
 		return hr;
 	}
 
-	_curFrameIndex = (_curFrameIndex + 1) % (uint32_t)_commandAllocators.size();
+	// 这一帧使用的命令分配器在围栏值完成后可以复用，命令列表已提交可以立即复用
+	const uint64_t fenceValue = _frameFenceValues[_curFrameIndex];
+	_uploadRingAllocator.FinishFrame(fenceValue);
+	_shaderVisibleDescriptorHeap.GetRingAllocator().FinishFrame(fenceValue);
+
+	for (winrt::com_ptr<ID3D12CommandAllocator>& commandAllocator : _frameCommandAllocators) {
+		_commandAllocatorPool.Release(std::move(commandAllocator), fenceValue, _frameCount);
+	}
+	_frameCommandAllocators.clear();
+
+	for (winrt::com_ptr<ID3D12GraphicsCommandList>& commandList : _frameCommandLists) {
+		_freeCommandLists.push_back(std::move(commandList));
+	}
+	_frameCommandLists.clear();
+	_commandList = nullptr;
+
+	_curFrameIndex = (_curFrameIndex + 1) % (uint32_t)_frameFenceValues.size();
+	++_frameCount;
+
+	const uint64_t completedFenceValue = _fence->GetCompletedValue();
+	_ReleaseCompleted(completedFenceValue);
+
+	// 释放长时间不用的命令分配器和堆，比如调整窗口大小或录制多个命令列表时临时增加的
+	static constexpr uint64_t MAX_IDLE_FRAMES = 300;
+	_commandAllocatorPool.Trim(completedFenceValue, _frameCount, MAX_IDLE_FRAMES, GetMaxInFlightFrameCount());
+	_heapAllocator.Trim(_frameCount, MAX_IDLE_FRAMES);
+
+	return S_OK;
+}
+
+HRESULT D3D12Context::AllocateUpload(uint64_t size, uint64_t alignment, UploadAllocation& allocation) noexcept {
+	uint64_t offset;
+	HRESULT hr = _AllocateFromRing(_uploadRingAllocator, size, alignment, offset);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	allocation = {
+		.cpuAddress = _uploadRingBufferData + offset,
+		.gpuAddress = _uploadRingBuffer->GetGPUVirtualAddress() + offset,
+		.resource = _uploadRingBuffer.get(),
+		.offset = offset
+	};
+	return S_OK;
+}
+
+HRESULT D3D12Context::AllocateFrameDescriptors(uint32_t count, DescriptorAllocation& allocation) noexcept {
+	// 环中的偏移以描述符为单位，描述符无需对齐
+	uint64_t offset;
+	HRESULT hr = _AllocateFromRing(_shaderVisibleDescriptorHeap.GetRingAllocator(), count, 1, offset);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	allocation = _shaderVisibleDescriptorHeap.GetRingAllocation((uint32_t)offset, count);
+	return S_OK;
+}
+
+HRESULT D3D12Context::CopyToFrameDescriptors(
+	std::span<const D3D12_CPU_DESCRIPTOR_HANDLE> srcStarts,
+	std::span<const UINT> srcCounts,
+	DescriptorAllocation& allocation
+) noexcept {
+	assert(srcStarts.size() == srcCounts.size());
+
+	UINT count = 0;
+	for (UINT srcCount : srcCounts) {
+		count += srcCount;
+	}
+
+	HRESULT hr = AllocateFrameDescriptors(count, allocation);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	_device->CopyDescriptors(
+		1,
+		&allocation.cpuHandle,
+		&count,
+		(UINT)srcStarts.size(),
+		srcStarts.data(),
+		srcCounts.data(),
+		D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV
+	);
 	return S_OK;
 }
 
@@ -197,6 +356,137 @@ HRESULT D3D12Context::_CreateDXGIFactory() noexcept {
 	return CreateDXGIFactory2(dxgiFactoryFlags, IID_PPV_ARGS(&_dxgiFactory));
 }
 
+HRESULT D3D12Context::_CreateUploadRingBuffer(uint64_t size) noexcept {
+	CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+
+	// 支持 Resizable BAR 时 CPU 直接写入显存
+	HRESULT hr = _heapAllocator.CreateResource(
+		_isGPUUploadHeapSupported ? D3D12_HEAP_TYPE_GPU_UPLOAD : D3D12_HEAP_TYPE_UPLOAD,
+		bufferDesc,
+		_isGPUUploadHeapSupported ? D3D12_RESOURCE_STATE_COMMON : D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		_uploadRingBuffer,
+		_uploadRingBufferAllocation
+	);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	// 持久映射，无需解除映射
+	D3D12_RANGE readRange{};
+	hr = _uploadRingBuffer->Map(0, &readRange, (void**)&_uploadRingBufferData);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	_uploadRingAllocator = LinearRingAllocator(size);
+	return S_OK;
+}
+
+HRESULT D3D12Context::_CreateDescriptorHeaps() noexcept {
+	// 着色器不可见的描述符堆按页增长，页的大小只影响创建次数
+	static constexpr uint32_t CPU_PAGE_SIZES[] = {
+		256,	// CBV_SRV_UAV
+		64,		// SAMPLER
+		64,		// RTV
+		64		// DSV
+	};
+	static_assert(std::size(CPU_PAGE_SIZES) == D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES);
+
+	for (uint32_t type = 0; type < D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES; ++type) {
+		_cpuDescriptorHeaps[type].Initialize(_device.get(), (D3D12_DESCRIPTOR_HEAP_TYPE)type, CPU_PAGE_SIZES[type]);
+	}
+
+	// 远小于 Resource Binding Tier 1 的上限
+	static constexpr uint32_t PERSISTENT_DESCRIPTOR_COUNT = 4096;
+	static constexpr uint32_t RING_DESCRIPTOR_COUNT = 16384;
+	return _shaderVisibleDescriptorHeap.Initialize(_device.get(), PERSISTENT_DESCRIPTOR_COUNT, RING_DESCRIPTOR_COUNT);
+}
+
+void D3D12Context::_QueryAdapterInfo() noexcept {
+	winrt::com_ptr<IDXGIAdapter1> adapter;
+	if (FAILED(_dxgiFactory->EnumAdapterByLuid(_device->GetAdapterLuid(), IID_PPV_ARGS(&adapter)))) {
+		return;
+	}
+
+	DXGI_ADAPTER_DESC1 desc;
+	if (SUCCEEDED(adapter->GetDesc1(&desc))) {
+		_adapterName = desc.Description;
+		_adapterIdentity.vendorId = desc.VendorId;
+		_adapterIdentity.deviceId = desc.DeviceId;
+		_adapterIdentity.subSysId = desc.SubSysId;
+		_adapterIdentity.revision = desc.Revision;
+	}
+
+	// 虽然接口名为 IDXGIDevice，实际返回用户模式驱动的版本
+	LARGE_INTEGER driverVersion;
+	if (SUCCEEDED(adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driverVersion))) {
+		_adapterIdentity.driverVersion = (uint64_t)driverVersion.QuadPart;
+	}
+}
+
+void D3D12Context::_InitializePipelineCache() noexcept {
+	// 显卡或驱动改变时缓存失效
+	_pipelineCache.Initialize(_device.get(), _rootSignatureVersion, _adapterIdentity,
+		Win32Helper::GetExePath().parent_path() / L"PipelineCache.bin");
+}
+
+HRESULT D3D12Context::_CreateBindlessRootSignature() noexcept {
+	// 所有着色器共享根常量，资源通过描述符堆中的索引访问，因此根签名和着色器无关
+	CD3DX12_ROOT_PARAMETER1 rootParam;
+	rootParam.InitAsConstants(BINDLESS_ROOT_CONSTANT_COUNT, 0);
+
+	const CD3DX12_STATIC_SAMPLER_DESC samplerDesc(
+		0,
+		D3D12_FILTER_MIN_MAG_MIP_LINEAR,
+		D3D12_TEXTURE_ADDRESS_MODE_CLAMP,
+		D3D12_TEXTURE_ADDRESS_MODE_CLAMP,
+		D3D12_TEXTURE_ADDRESS_MODE_CLAMP
+	);
+
+	CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc(1, &rootParam, 1, &samplerDesc,
+		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT |
+		D3D12_ROOT_SIGNATURE_FLAG_CBV_SRV_UAV_HEAP_DIRECTLY_INDEXED);
+
+	return _pipelineCache.CreateRootSignature(rootSignatureDesc, _bindlessRootSignature);
+}
+
+HRESULT D3D12Context::_AllocateFromRing(
+	LinearRingAllocator& ringAllocator,
+	uint64_t size,
+	uint64_t alignment,
+	uint64_t& offset
+) noexcept {
+	offset = ringAllocator.Allocate(size, alignment);
+
+	while (offset == LinearRingAllocator::INVALID_OFFSET) {
+		// 先回收已完成的帧
+		ringAllocator.ReleaseCompleted(_fence->GetCompletedValue());
+		offset = ringAllocator.Allocate(size, alignment);
+		if (offset != LinearRingAllocator::INVALID_OFFSET) {
+			break;
+		}
+
+		// 当前帧的分配已经超过容量
+		const uint64_t fenceValue = ringAllocator.GetOldestFenceValue();
+		if (fenceValue == 0) {
+			return E_OUTOFMEMORY;
+		}
+
+		ringAllocator.OnStall();
+
+		HRESULT hr = WaitForFenceValue(fenceValue);
+		if (FAILED(hr)) {
+			return hr;
+		}
+
+		ringAllocator.ReleaseCompleted(fenceValue);
+		offset = ringAllocator.Allocate(size, alignment);
+	}
+
+	return S_OK;
+}
+
 // 和 D3D12SDKLayers.dll 不同，OS 加载 d3d10warp.dll 时不遵循 D3D12SDKPath。
 // 这个函数确保加载匹配的 d3d10warp.dll。
 static void FixD3D10WarpDll(IDXGIAdapter1* warpAdapter) noexcept {
@@ -225,11 +515,106 @@ static void FixD3D10WarpDll(IDXGIAdapter1* warpAdapter) noexcept {
 	}
 }
 
-bool D3D12Context::_CreateD3DDevice() noexcept {
+HRESULT D3D12Context::_AcquireCommandList(
+	ID3D12PipelineState* initialState,
+	ID3D12GraphicsCommandList** commandList
+) noexcept {
+	winrt::com_ptr<ID3D12CommandAllocator> commandAllocator;
+	if (_commandAllocatorPool.TryAcquire(_fence->GetCompletedValue(), commandAllocator)) {
+		HRESULT hr = commandAllocator->Reset();
+		if (FAILED(hr)) {
+			return hr;
+		}
+	} else {
+		// 没有空闲的命令分配器则创建新的
+		HRESULT hr = _device->CreateCommandAllocator(
+			D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator));
+		if (FAILED(hr)) {
+			return hr;
+		}
+
+		_commandAllocatorPool.OnCreated();
+	}
+
+	winrt::com_ptr<ID3D12GraphicsCommandList> list;
+	if (_freeCommandLists.empty()) {
+		HRESULT hr = _device->CreateCommandList1(0, D3D12_COMMAND_LIST_TYPE_DIRECT,
+			D3D12_COMMAND_LIST_FLAG_NONE, IID_PPV_ARGS(&list));
+		if (FAILED(hr)) {
+			// 在 EndFrame 中归还
+			_frameCommandAllocators.push_back(std::move(commandAllocator));
+			return hr;
+		}
+
+		++_commandListCount;
+	} else {
+		list = std::move(_freeCommandLists.back());
+		_freeCommandLists.pop_back();
+	}
+
+	HRESULT hr = list->Reset(commandAllocator.get(), initialState);
+
+	_frameCommandAllocators.push_back(std::move(commandAllocator));
+	_frameCommandLists.push_back(std::move(list));
+
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	*commandList = _frameCommandLists.back().get();
+	return S_OK;
+}
+
+HRESULT D3D12Context::_ResolveGpuProfiler() noexcept {
+	// 获取失败时这一帧没有结果，不影响渲染
+	GpuProfiler::Calibration calibration;
+	if (FAILED(_commandQueue->GetTimestampFrequency(&calibration.gpuFrequency))) {
+		calibration.gpuFrequency = 0;
+	}
+	if (FAILED(_commandQueue->GetClockCalibration(&calibration.gpuTimestamp, &calibration.cpuTimestamp))) {
+		calibration.gpuTimestamp = 0;
+		calibration.cpuTimestamp = 0;
+	}
+	LARGE_INTEGER cpuFrequency;
+	QueryPerformanceFrequency(&cpuFrequency);
+	calibration.cpuFrequency = (uint64_t)cpuFrequency.QuadPart;
+
+	// 计时范围可能分布在多个命令列表中，由调用者提交，因此使用单独的命令列表解析
+	ID3D12GraphicsCommandList* commandList;
+	HRESULT hr = _AcquireCommandList(nullptr, &commandList);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	_gpuProfiler.Resolve(commandList, calibration);
+
+	hr = commandList->Close();
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	ID3D12CommandList* commandLists[] = { commandList };
+	_commandQueue->ExecuteCommandLists(1, commandLists);
+	return S_OK;
+}
+
+void D3D12Context::_ReleaseCompleted(uint64_t completedFenceValue) noexcept {
+	_deferredReleaseQueue.ReleaseCompleted(completedFenceValue);
+	_deferredHeapFreeQueue.ReleaseCompleted(completedFenceValue, [&](const HeapAllocation& allocation) {
+		_heapAllocator.Free(allocation);
+	});
+	_uploadRingAllocator.ReleaseCompleted(completedFenceValue);
+	_shaderVisibleDescriptorHeap.GetRingAllocator().ReleaseCompleted(completedFenceValue);
+	_deferredDescriptorFreeQueue.ReleaseCompleted(completedFenceValue, [&](const DescriptorAllocation& allocation) {
+		_shaderVisibleDescriptorHeap.FreePersistent(allocation);
+	});
+}
+
+bool D3D12Context::_CreateD3DDevice(bool forceWarp) noexcept {
 	// 枚举查找第一个支持 D3D12 的显卡
 	winrt::com_ptr<IDXGIAdapter1> adapter;
 	for (UINT adapterIdx = 0;
-		SUCCEEDED(_dxgiFactory->EnumAdapters1(adapterIdx, adapter.put()));
+		!forceWarp && SUCCEEDED(_dxgiFactory->EnumAdapters1(adapterIdx, adapter.put()));
 		++adapterIdx
 	) {
 		DXGI_ADAPTER_DESC1 desc;
@@ -1,4 +1,20 @@
 #pragma once
+#include "DeferredReleaseQueue.h"
+#include "DescriptorHeap.h"
+#include "FencedObjectPool.h"
+#include "GpuProfiler.h"
+#include "HeapAllocator.h"
+#include "LinearRingAllocator.h"
+#include "PipelineCache.h"
+#include "ShaderArchive.h"
+#include <span>
+
+struct UploadAllocation {
+	void* cpuAddress;
+	D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;
+	ID3D12Resource* resource;
+	uint64_t offset;
+};
 
 class D3D12Context {
 public:
@@ -6,7 +22,13 @@ public:
 	D3D12Context(const D3D12Context&) = delete;
 	D3D12Context(D3D12Context&&) = default;
 
-	bool Initialize(uint32_t maxInFlightFrameCount) noexcept;
+	// forceWarp 为 true 时即使有显卡也使用 WARP
+	bool Initialize(
+		uint32_t maxInFlightFrameCount,
+		bool forceWarp = false,
+		uint64_t uploadRingSize = 4 * 1024 * 1024,
+		uint64_t heapSize = 16 * 1024 * 1024
+	) noexcept;
 
 	IDXGIFactory7* GetDXGIFactory() const noexcept {
 		return _dxgiFactory.get();
@@ -22,14 +44,30 @@ public:
 		return _commandQueue.get();
 	}
 
+	// 当前帧的主命令列表，BeginFrame 中重置
 	ID3D12GraphicsCommandList* GetCommandList() const noexcept {
-		return _commandList.get();
+		return _commandList;
 	}
 
 	D3D_ROOT_SIGNATURE_VERSION GetRootSignatureVersion() const noexcept {
 		return _rootSignatureVersion;
 	}
 
+	// 没有支持 D3D12 的显卡时回落到 WARP，在 CPU 上渲染
+	bool IsWarp() const noexcept {
+		return _isWarp;
+	}
+
+	// DXGI_ADAPTER_DESC1::Description
+	const std::wstring& GetAdapterName() const noexcept {
+		return _adapterName;
+	}
+
+	// 包括用户模式驱动的版本
+	const PipelineCacheFile::AdapterIdentity& GetAdapterIdentity() const noexcept {
+		return _adapterIdentity;
+	}
+
 	bool IsUMA() const noexcept {
 		return _isUMA;
 	}
@@ -43,11 +81,29 @@ public:
 	}
 
 	bool IsSM6Supported() const noexcept {
-		return _isSM6Supported;
+		return _shaderModel >= D3D_SHADER_MODEL_6_0;
 	}
 
+	// 支持的最高 shader model，最高检测到 6.6，不支持 SM6 时为 5.1
+	D3D_SHADER_MODEL GetShaderModel() const noexcept {
+		return _shaderModel;
+	}
+
+	// 支持 SM 6.6 和 Resource Binding Tier 3 时着色器可以直接索引 ResourceDescriptorHeap
+	bool IsBindlessSupported() const noexcept {
+		return _isBindlessSupported;
+	}
+
+	// 支持 bindless 时所有着色器共用的根签名，b0 处有 BINDLESS_ROOT_CONSTANT_COUNT 个根常量，
+	// s0 处为线性采样器。使用前必须先调用 SetDescriptorHeaps。
+	ID3D12RootSignature* GetBindlessRootSignature() const noexcept {
+		return _bindlessRootSignature.get();
+	}
+
+	static constexpr uint32_t BINDLESS_ROOT_CONSTANT_COUNT = 4;
+
 	uint32_t GetMaxInFlightFrameCount() const noexcept {
-		return (uint32_t)_commandAllocators.size();
+		return (uint32_t)_frameFenceValues.size();
 	}
 
 	HRESULT Signal(uint64_t& fenceValue) noexcept;
@@ -56,35 +112,260 @@ public:
 
 	HRESULT WaitForGpu() noexcept;
 
+	// 返回 BeginFrame 需要等待的事件，返回 NULL 表示无需等待
+	HANDLE GetFrameWaitHandle() noexcept;
+
 	HRESULT BeginFrame(uint32_t& curFrameIndex, ID3D12PipelineState* initialState = nullptr) noexcept;
 
+	// 为当前帧额外获取一个已重置的命令列表，它使用独立的命令分配器，EndFrame 后归还。
+	// 调用者负责关闭和提交。
+	HRESULT AcquireCommandList(
+		ID3D12PipelineState* initialState,
+		ID3D12GraphicsCommandList** commandList
+	) noexcept;
+
+	// 提交这一帧。有 GPU 计时范围时先提交一个解析时间戳的命令列表。
 	HRESULT EndFrame() noexcept;
 
+	// 已结束的帧数，也是当前帧的序号
+	uint64_t GetFrameCount() const noexcept {
+		return _frameCount;
+	}
+
+	// 范围在命令列表中录制，结果在 BeginFrame 中读取，见 GpuProfiler
+	GpuProfiler& GetGpuProfiler() noexcept {
+		return _gpuProfiler;
+	}
+
+	// 从持久映射的上传环中分配，数据只在当前帧有效，帧的围栏值完成后自动回收。空间不足时
+	// 等待最早的帧完成。
+	HRESULT AllocateUpload(uint64_t size, uint64_t alignment, UploadAllocation& allocation) noexcept;
+
+	const LinearRingAllocator::Stats& GetUploadRingStats() const noexcept {
+		return _uploadRingAllocator.GetStats();
+	}
+
+	// 着色器不可见的描述符，在 Initialize 以外的地方创建描述符时应避开每帧的热路径
+	HRESULT AllocateCpuDescriptors(
+		D3D12_DESCRIPTOR_HEAP_TYPE type,
+		uint32_t count,
+		DescriptorAllocation& allocation
+	) noexcept {
+		return _cpuDescriptorHeaps[type].Allocate(count, allocation);
+	}
+
+	// 使用这些描述符的命令录制完成后即可释放
+	void FreeCpuDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE type, DescriptorAllocation& allocation) noexcept {
+		_cpuDescriptorHeaps[type].Free(allocation);
+	}
+
+	uint32_t GetDescriptorSize(D3D12_DESCRIPTOR_HEAP_TYPE type) const noexcept {
+		return _cpuDescriptorHeaps[type].GetDescriptorSize();
+	}
+
+	DescriptorFreeList::Stats GetCpuDescriptorStats(D3D12_DESCRIPTOR_HEAP_TYPE type) const noexcept {
+		return _cpuDescriptorHeaps[type].GetStats();
+	}
+
+	// 所有命令列表共用的着色器可见描述符堆
+	ID3D12DescriptorHeap* GetShaderVisibleDescriptorHeap() const noexcept {
+		return _shaderVisibleDescriptorHeap.GetHeap();
+	}
+
+	// 着色器可见的持久描述符，不再使用时应调用 ReleasePersistentDescriptors
+	HRESULT AllocatePersistentDescriptors(uint32_t count, DescriptorAllocation& allocation) noexcept {
+		return _shaderVisibleDescriptorHeap.AllocatePersistent(count, allocation);
+	}
+
+	// 延迟到 GPU 不再使用时释放
+	void ReleasePersistentDescriptors(DescriptorAllocation& allocation) noexcept {
+		if (allocation.IsValid()) {
+			_deferredDescriptorFreeQueue.Push(_curFenceValue + 1, std::move(allocation));
+			allocation = {};
+		}
+	}
+
+	// 从着色器可见描述符堆的环中分配，只在当前帧有效。空间不足时等待最早的帧完成。
+	HRESULT AllocateFrameDescriptors(uint32_t count, DescriptorAllocation& allocation) noexcept;
+
+	// 将多段不连续的 CPU 描述符复制到环中连续的位置，只调用一次 CopyDescriptors
+	HRESULT CopyToFrameDescriptors(
+		std::span<const D3D12_CPU_DESCRIPTOR_HANDLE> srcStarts,
+		std::span<const UINT> srcCounts,
+		DescriptorAllocation& allocation
+	) noexcept;
+
+	DescriptorFreeList::Stats GetPersistentDescriptorStats() const noexcept {
+		return _shaderVisibleDescriptorHeap.GetPersistentStats();
+	}
+
+	const LinearRingAllocator::Stats& GetFrameDescriptorRingStats() const noexcept {
+		return _shaderVisibleDescriptorHeap.GetRingStats();
+	}
+
+	// 从 exe 所在目录的着色器包读取设备支持的版本，失败时返回空。可以在工作线程调用。
+	D3D12_SHADER_BYTECODE GetShaderByteCode(ShaderId shader) const noexcept {
+		return _shaderArchive.GetByteCode(shader, ShaderPermutations::GetShaderTier(IsSM6Supported()));
+	}
+
+	// 下面四个函数使用管线缓存，描述相同时返回同一个对象，可以在工作线程调用
+	HRESULT CreateRootSignature(
+		const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc,
+		winrt::com_ptr<ID3D12RootSignature>& rootSignature
+	) noexcept {
+		return _pipelineCache.CreateRootSignature(desc, rootSignature);
+	}
+
+	// desc.pRootSignature 应由 CreateRootSignature 创建，否则无法缓存
+	HRESULT CreateGraphicsPipelineState(
+		const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+		winrt::com_ptr<ID3D12PipelineState>& pipelineState
+	) noexcept {
+		return _pipelineCache.CreateGraphicsPipelineState(desc, pipelineState);
+	}
+
+	HRESULT CreateComputePipelineState(
+		const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc,
+		winrt::com_ptr<ID3D12PipelineState>& pipelineState
+	) noexcept {
+		return _pipelineCache.CreateComputePipelineState(desc, pipelineState);
+	}
+
+	// 将新创建的 PSO 写入 exe 所在目录的缓存文件，应在创建一批 PSO 之后调用
+	HRESULT SavePipelineCache() noexcept {
+		return _pipelineCache.Save();
+	}
+
+	PipelineCache::Stats GetPipelineCacheStats() const noexcept {
+		return _pipelineCache.GetStats();
+	}
+
+	// 从大的堆中分配并创建放置资源，不再使用时应调用 ReleaseResource
+	HRESULT CreateResource(
+		D3D12_HEAP_TYPE heapType,
+		const D3D12_RESOURCE_DESC& desc,
+		D3D12_RESOURCE_STATES initialState,
+		const D3D12_CLEAR_VALUE* clearValue,
+		winrt::com_ptr<ID3D12Resource>& resource,
+		HeapAllocation& allocation
+	) noexcept {
+		return _heapAllocator.CreateResource(heapType, desc, initialState, clearValue, resource, allocation);
+	}
+
+	// 和 DeferRelease 一样延迟到 GPU 不再使用时释放资源和它占用的堆空间
+	void ReleaseResource(winrt::com_ptr<ID3D12Resource>&& resource, const HeapAllocation& allocation) noexcept {
+		if (resource) {
+			DeferRelease(std::move(resource));
+			_deferredHeapFreeQueue.Push(_curFenceValue + 1, HeapAllocation(allocation));
+		}
+	}
+
+	HeapAllocator::Stats GetHeapAllocatorStats() const noexcept {
+		return _heapAllocator.GetStats();
+	}
+
+	const FencedObjectPool<winrt::com_ptr<ID3D12CommandAllocator>>::Stats& GetCommandAllocatorPoolStats() const noexcept {
+		return _commandAllocatorPool.GetStats();
+	}
+
+	uint32_t GetCommandListCount() const noexcept {
+		return _commandListCount;
+	}
+
+	// 延迟释放 obj，直到已提交和正在录制的命令都执行完毕，替换 GPU 可能仍在使用的对象
+	// 时无需等待 GPU。
+	template <typename T>
+	void DeferRelease(winrt::com_ptr<T>&& obj) noexcept {
+		if (obj) {
+			winrt::com_ptr<IUnknown> unknown;
+			unknown.attach(obj.detach());
+			_deferredReleaseQueue.Push(_curFenceValue + 1, std::move(unknown));
+		}
+	}
+
 	bool CheckForBetterAdapter() noexcept;
 
 private:
 	HRESULT _CreateDXGIFactory() noexcept;
 
-	bool _CreateD3DDevice() noexcept;
+	bool _CreateD3DDevice(bool forceWarp) noexcept;
+
+	HRESULT _CreateUploadRingBuffer(uint64_t size) noexcept;
+
+	HRESULT _CreateDescriptorHeaps() noexcept;
+
+	void _QueryAdapterInfo() noexcept;
+
+	void _InitializePipelineCache() noexcept;
+
+	HRESULT _CreateBindlessRootSignature() noexcept;
+
+	// 从环中分配，空间不足时等待最早的帧完成
+	HRESULT _AllocateFromRing(
+		LinearRingAllocator& ringAllocator,
+		uint64_t size,
+		uint64_t alignment,
+		uint64_t& offset
+	) noexcept;
+
+	HRESULT _AcquireCommandList(ID3D12PipelineState* initialState, ID3D12GraphicsCommandList** commandList) noexcept;
+
+	HRESULT _ResolveGpuProfiler() noexcept;
+
+	void _ReleaseCompleted(uint64_t completedFenceValue) noexcept;
 
 	winrt::com_ptr<IDXGIFactory7> _dxgiFactory;
 	winrt::com_ptr<ID3D12Device5> _device;
 	winrt::com_ptr<ID3D12CommandQueue> _commandQueue;
 
-	std::vector<winrt::com_ptr<ID3D12CommandAllocator>> _commandAllocators;
-	winrt::com_ptr<ID3D12GraphicsCommandList> _commandList;
+	// 任何围栏值已完成的命令分配器都可以复用，不必等待特定的帧
+	FencedObjectPool<winrt::com_ptr<ID3D12CommandAllocator>> _commandAllocatorPool;
+	// 命令列表提交后即可重置，无需等待 GPU
+	std::vector<winrt::com_ptr<ID3D12GraphicsCommandList>> _freeCommandLists;
+	uint32_t _commandListCount = 0;
+	// 当前帧取出的命令分配器和命令列表，EndFrame 时归还
+	std::vector<winrt::com_ptr<ID3D12CommandAllocator>> _frameCommandAllocators;
+	std::vector<winrt::com_ptr<ID3D12GraphicsCommandList>> _frameCommandLists;
+	ID3D12GraphicsCommandList* _commandList = nullptr;
+	uint64_t _frameCount = 0;
 
 	winrt::com_ptr<ID3D12Fence1> _fence;
 	uint64_t _curFenceValue = 0;
+	wil::unique_event_nothrow _fenceEvent;
 
 	std::vector<uint64_t> _frameFenceValues;
 	uint32_t _curFrameIndex = 0;
 
+	GpuProfiler _gpuProfiler;
+
+	DeferredReleaseQueue<winrt::com_ptr<IUnknown>> _deferredReleaseQueue;
+
+	HeapAllocator _heapAllocator;
+	DeferredReleaseQueue<HeapAllocation> _deferredHeapFreeQueue;
+
+	winrt::com_ptr<ID3D12Resource> _uploadRingBuffer;
+	HeapAllocation _uploadRingBufferAllocation;
+	uint8_t* _uploadRingBufferData = nullptr;
+	LinearRingAllocator _uploadRingAllocator;
+
+	// 按 D3D12_DESCRIPTOR_HEAP_TYPE 索引
+	CpuDescriptorHeap _cpuDescriptorHeaps[D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES];
+	ShaderVisibleDescriptorHeap _shaderVisibleDescriptorHeap;
+	DeferredReleaseQueue<DescriptorAllocation> _deferredDescriptorFreeQueue;
+
+	ShaderArchive _shaderArchive;
+	PipelineCache _pipelineCache;
+	winrt::com_ptr<ID3D12RootSignature> _bindlessRootSignature;
+
+	std::wstring _adapterName;
+	PipelineCacheFile::AdapterIdentity _adapterIdentity;
+
 	D3D_ROOT_SIGNATURE_VERSION _rootSignatureVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
+	D3D_SHADER_MODEL _shaderModel = D3D_SHADER_MODEL_5_1;
 
 	bool _isWarp = false;
 	bool _isUMA = false;
 	bool _isHeapFlagCreateNotZeroedSupported = false;
 	bool _isGPUUploadHeapSupported = false;
-	bool _isSM6Supported = false;
+	bool _isBindlessSupported = false;
 };
@@ -0,0 +1,60 @@
+#pragma once
+#include <deque>
+
+// 持有 GPU 可能仍在使用的对象，直到对应的围栏值完成。不依赖 D3D12，T 可以是任何可移动的
+// 类型，围栏值由调用者提供。
+template <typename T>
+class DeferredReleaseQueue {
+public:
+	DeferredReleaseQueue() = default;
+	DeferredReleaseQueue(const DeferredReleaseQueue&) = delete;
+	DeferredReleaseQueue(DeferredReleaseQueue&&) = default;
+
+	// fenceValue 是最后一次使用 obj 的帧的围栏值，必须单调不减
+	void Push(uint64_t fenceValue, T&& obj) noexcept {
+		assert(_entries.empty() || _entries.back().fenceValue <= fenceValue);
+		_entries.push_back({ fenceValue, std::move(obj) });
+	}
+
+	// 释放所有围栏值不大于 completedFenceValue 的对象，返回释放的数量
+	uint32_t ReleaseCompleted(uint64_t completedFenceValue) noexcept {
+		uint32_t count = 0;
+		while (!_entries.empty() && _entries.front().fenceValue <= completedFenceValue) {
+			_entries.pop_front();
+			++count;
+		}
+		return count;
+	}
+
+	// 和上面相同，但释放前对每个对象调用 onRelease，用于需要显式回收的对象
+	template <typename F>
+	uint32_t ReleaseCompleted(uint64_t completedFenceValue, F&& onRelease) noexcept {
+		uint32_t count = 0;
+		while (!_entries.empty() && _entries.front().fenceValue <= completedFenceValue) {
+			onRelease(_entries.front().obj);
+			_entries.pop_front();
+			++count;
+		}
+		return count;
+	}
+
+	void Clear() noexcept {
+		_entries.clear();
+	}
+
+	size_t Size() const noexcept {
+		return _entries.size();
+	}
+
+	bool Empty() const noexcept {
+		return _entries.empty();
+	}
+
+private:
+	struct _Entry {
+		uint64_t fenceValue;
+		T obj;
+	};
+
+	std::deque<_Entry> _entries;
+};
@@ -0,0 +1,116 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <map>
+
+// 管理描述符堆中的连续区间，只管理索引，不依赖 D3D12。首次适配分配，释放时和相邻的空闲
+// 区间合并。
+class DescriptorFreeList {
+public:
+	static constexpr uint32_t INVALID_OFFSET = UINT32_MAX;
+
+	struct Stats {
+		uint32_t capacity = 0;
+		uint32_t usedCount = 0;
+		uint32_t maxUsedCount = 0;
+		uint32_t freeRangeCount = 0;
+		// 最大的空闲区间，和空闲描述符数的比例反映碎片
+		uint32_t largestFreeRange = 0;
+	};
+
+	DescriptorFreeList() = default;
+	DescriptorFreeList(const DescriptorFreeList&) = delete;
+	DescriptorFreeList(DescriptorFreeList&&) = default;
+	DescriptorFreeList& operator=(DescriptorFreeList&&) = default;
+
+	explicit DescriptorFreeList(uint32_t capacity) noexcept : _capacity(capacity) {
+		if (capacity > 0) {
+			_freeRanges.emplace(0, capacity);
+		}
+	}
+
+	uint32_t GetCapacity() const noexcept {
+		return _capacity;
+	}
+
+	bool IsEmpty() const noexcept {
+		return _usedCount == 0;
+	}
+
+	// 空间不足时返回 INVALID_OFFSET
+	uint32_t Allocate(uint32_t count) noexcept {
+		if (count == 0) {
+			return INVALID_OFFSET;
+		}
+
+		for (auto it = _freeRanges.begin(); it != _freeRanges.end(); ++it) {
+			const auto [offset, rangeCount] = *it;
+			if (rangeCount < count) {
+				continue;
+			}
+
+			_freeRanges.erase(it);
+			if (rangeCount > count) {
+				_freeRanges.emplace(offset + count, rangeCount - count);
+			}
+
+			_usedCount += count;
+			_maxUsedCount = std::max(_maxUsedCount, _usedCount);
+			return offset;
+		}
+
+		return INVALID_OFFSET;
+	}
+
+	void Free(uint32_t offset, uint32_t count) noexcept {
+		assert(count > 0 && offset + count <= _capacity && _usedCount >= count);
+		_usedCount -= count;
+
+		auto next = _freeRanges.lower_bound(offset);
+		assert(next == _freeRanges.end() || next->first >= offset + count);
+
+		// 和前一个空闲区间合并
+		if (next != _freeRanges.begin()) {
+			auto prev = std::prev(next);
+			assert(prev->first + prev->second <= offset);
+
+			if (prev->first + prev->second == offset) {
+				offset = prev->first;
+				count += prev->second;
+				_freeRanges.erase(prev);
+			}
+		}
+
+		// 和后一个空闲区间合并
+		if (next != _freeRanges.end() && next->first == offset + count) {
+			count += next->second;
+			_freeRanges.erase(next);
+		}
+
+		_freeRanges.emplace(offset, count);
+	}
+
+	Stats GetStats() const noexcept {
+		Stats stats = {
+			.capacity = _capacity,
+			.usedCount = _usedCount,
+			.maxUsedCount = _maxUsedCount,
+			.freeRangeCount = (uint32_t)_freeRanges.size()
+		};
+
+		for (const auto& [offset, count] : _freeRanges) {
+			stats.largestFreeRange = std::max(stats.largestFreeRange, count);
+		}
+
+		return stats;
+	}
+
+private:
+	uint32_t _capacity = 0;
+	// 空闲区间的起始索引到长度的映射
+	std::map<uint32_t, uint32_t> _freeRanges;
+	uint32_t _usedCount = 0;
+	uint32_t _maxUsedCount = 0;
+};
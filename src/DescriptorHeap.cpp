@@ -0,0 +1,130 @@
+#include "pch.h"
+#include "DescriptorHeap.h"
+
+void CpuDescriptorHeap::Initialize(ID3D12Device5* device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t pageSize) noexcept {
+	_device = device;
+	_type = type;
+	_pageSize = pageSize;
+	_descriptorSize = device->GetDescriptorHandleIncrementSize(type);
+}
+
+HRESULT CpuDescriptorHeap::Allocate(uint32_t count, DescriptorAllocation& allocation) noexcept {
+	if (count == 0 || count > _pageSize) {
+		return E_INVALIDARG;
+	}
+
+	uint32_t pageIndex = 0;
+	uint32_t offset = DescriptorFreeList::INVALID_OFFSET;
+	for (; pageIndex < (uint32_t)_pages.size(); ++pageIndex) {
+		offset = _pages[pageIndex].freeList.Allocate(count);
+		if (offset != DescriptorFreeList::INVALID_OFFSET) {
+			break;
+		}
+	}
+
+	if (offset == DescriptorFreeList::INVALID_OFFSET) {
+		// 已有的页都没有足够的空间，创建新的页
+		D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {
+			.Type = _type,
+			.NumDescriptors = _pageSize,
+			.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE
+		};
+
+		winrt::com_ptr<ID3D12DescriptorHeap> heap;
+		HRESULT hr = _device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&heap));
+		if (FAILED(hr)) {
+			return hr;
+		}
+
+		const D3D12_CPU_DESCRIPTOR_HANDLE start = heap->GetCPUDescriptorHandleForHeapStart();
+		_pages.push_back({ std::move(heap), start, DescriptorFreeList(_pageSize) });
+
+		pageIndex = (uint32_t)_pages.size() - 1;
+		offset = _pages.back().freeList.Allocate(count);
+		assert(offset == 0);
+	}
+
+	allocation = {
+		.cpuHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(_pages[pageIndex].start, (INT)offset, _descriptorSize),
+		.pageIndex = pageIndex,
+		.offset = offset,
+		.count = count
+	};
+	return S_OK;
+}
+
+void CpuDescriptorHeap::Free(DescriptorAllocation& allocation) noexcept {
+	if (!allocation.IsValid()) {
+		return;
+	}
+
+	_pages[allocation.pageIndex].freeList.Free(allocation.offset, allocation.count);
+	allocation = {};
+}
+
+DescriptorFreeList::Stats CpuDescriptorHeap::GetStats() const noexcept {
+	DescriptorFreeList::Stats stats;
+
+	for (const _Page& page : _pages) {
+		const DescriptorFreeList::Stats pageStats = page.freeList.GetStats();
+		stats.capacity += pageStats.capacity;
+		stats.usedCount += pageStats.usedCount;
+		stats.maxUsedCount += pageStats.maxUsedCount;
+		stats.freeRangeCount += pageStats.freeRangeCount;
+		stats.largestFreeRange = std::max(stats.largestFreeRange, pageStats.largestFreeRange);
+	}
+
+	return stats;
+}
+
+HRESULT ShaderVisibleDescriptorHeap::Initialize(
+	ID3D12Device5* device,
+	uint32_t persistentCount,
+	uint32_t ringCount
+) noexcept {
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {
+		.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+		.NumDescriptors = persistentCount + ringCount,
+		.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE
+	};
+
+	HRESULT hr = device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&_heap));
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	_cpuStart = _heap->GetCPUDescriptorHandleForHeapStart();
+	_gpuStart = _heap->GetGPUDescriptorHandleForHeapStart();
+	_descriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	_persistentCount = persistentCount;
+
+	_persistentFreeList = DescriptorFreeList(persistentCount);
+	_ringAllocator = LinearRingAllocator(ringCount);
+	return S_OK;
+}
+
+HRESULT ShaderVisibleDescriptorHeap::AllocatePersistent(uint32_t count, DescriptorAllocation& allocation) noexcept {
+	const uint32_t offset = _persistentFreeList.Allocate(count);
+	if (offset == DescriptorFreeList::INVALID_OFFSET) {
+		return E_OUTOFMEMORY;
+	}
+
+	allocation = _MakeAllocation(offset, count);
+	return S_OK;
+}
+
+void ShaderVisibleDescriptorHeap::FreePersistent(const DescriptorAllocation& allocation) noexcept {
+	if (allocation.IsValid()) {
+		assert(allocation.offset + allocation.count <= _persistentCount);
+		_persistentFreeList.Free(allocation.offset, allocation.count);
+	}
+}
+
+DescriptorAllocation ShaderVisibleDescriptorHeap::_MakeAllocation(uint32_t offset, uint32_t count) const noexcept {
+	return {
+		.cpuHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(_cpuStart, (INT)offset, _descriptorSize),
+		.gpuHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(_gpuStart, (INT)offset, _descriptorSize),
+		.offset = offset,
+		.count = count
+	};
+}
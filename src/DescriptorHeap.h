@@ -0,0 +1,117 @@
+#pragma once
+#include "DescriptorFreeList.h"
+#include "LinearRingAllocator.h"
+
+struct DescriptorAllocation {
+	D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle{};
+	// 只有着色器可见的描述符有效
+	D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle{};
+	uint32_t pageIndex = 0;
+	uint32_t offset = 0;
+	uint32_t count = 0;
+
+	bool IsValid() const noexcept {
+		return count > 0;
+	}
+
+	CD3DX12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(uint32_t index, uint32_t descriptorSize) const noexcept {
+		assert(index < count);
+		return CD3DX12_CPU_DESCRIPTOR_HANDLE(cpuHandle, (INT)index, descriptorSize);
+	}
+
+	CD3DX12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(uint32_t index, uint32_t descriptorSize) const noexcept {
+		assert(index < count);
+		return CD3DX12_GPU_DESCRIPTOR_HANDLE(gpuHandle, (INT)index, descriptorSize);
+	}
+};
+
+// 着色器不可见的描述符堆，用于 RTV、DSV 和暂存 CBV/SRV/UAV。空间不足时创建新的页，每页用
+// 空闲链表管理。这些描述符在录制命令时即被读取，因此命令录制完成后即可释放，无需等待 GPU。
+class CpuDescriptorHeap {
+public:
+	CpuDescriptorHeap() = default;
+	CpuDescriptorHeap(const CpuDescriptorHeap&) = delete;
+	CpuDescriptorHeap(CpuDescriptorHeap&&) = default;
+
+	void Initialize(ID3D12Device5* device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t pageSize) noexcept;
+
+	// 分配连续的 count 个描述符，count 不能超过页的大小
+	HRESULT Allocate(uint32_t count, DescriptorAllocation& allocation) noexcept;
+
+	void Free(DescriptorAllocation& allocation) noexcept;
+
+	uint32_t GetDescriptorSize() const noexcept {
+		return _descriptorSize;
+	}
+
+	// 所有页的统计数据之和
+	DescriptorFreeList::Stats GetStats() const noexcept;
+
+private:
+	struct _Page {
+		winrt::com_ptr<ID3D12DescriptorHeap> heap;
+		D3D12_CPU_DESCRIPTOR_HANDLE start;
+		DescriptorFreeList freeList;
+	};
+
+	ID3D12Device5* _device = nullptr;
+	D3D12_DESCRIPTOR_HEAP_TYPE _type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	uint32_t _pageSize = 0;
+	uint32_t _descriptorSize = 0;
+
+	std::vector<_Page> _pages;
+};
+
+// 唯一的着色器可见的 CBV/SRV/UAV 描述符堆。前半部分是持久的描述符，用空闲链表管理，释放由
+// 调用者延迟到 GPU 不再使用之后；后半部分是按帧划分的环，围栏值完成后整帧回收。切换描述符堆
+// 代价很高，因此所有命令列表都使用这一个堆。
+class ShaderVisibleDescriptorHeap {
+public:
+	ShaderVisibleDescriptorHeap() = default;
+	ShaderVisibleDescriptorHeap(const ShaderVisibleDescriptorHeap&) = delete;
+	ShaderVisibleDescriptorHeap(ShaderVisibleDescriptorHeap&&) = default;
+
+	HRESULT Initialize(ID3D12Device5* device, uint32_t persistentCount, uint32_t ringCount) noexcept;
+
+	ID3D12DescriptorHeap* GetHeap() const noexcept {
+		return _heap.get();
+	}
+
+	uint32_t GetDescriptorSize() const noexcept {
+		return _descriptorSize;
+	}
+
+	HRESULT AllocatePersistent(uint32_t count, DescriptorAllocation& allocation) noexcept;
+
+	// 调用者负责确保 GPU 不再使用这些描述符
+	void FreePersistent(const DescriptorAllocation& allocation) noexcept;
+
+	// 环由调用者分配和回收，偏移以描述符为单位
+	LinearRingAllocator& GetRingAllocator() noexcept {
+		return _ringAllocator;
+	}
+
+	DescriptorAllocation GetRingAllocation(uint32_t ringOffset, uint32_t count) const noexcept {
+		return _MakeAllocation(_persistentCount + ringOffset, count);
+	}
+
+	DescriptorFreeList::Stats GetPersistentStats() const noexcept {
+		return _persistentFreeList.GetStats();
+	}
+
+	const LinearRingAllocator::Stats& GetRingStats() const noexcept {
+		return _ringAllocator.GetStats();
+	}
+
+private:
+	DescriptorAllocation _MakeAllocation(uint32_t offset, uint32_t count) const noexcept;
+
+	winrt::com_ptr<ID3D12DescriptorHeap> _heap;
+	D3D12_CPU_DESCRIPTOR_HANDLE _cpuStart{};
+	D3D12_GPU_DESCRIPTOR_HANDLE _gpuStart{};
+	uint32_t _descriptorSize = 0;
+	uint32_t _persistentCount = 0;
+
+	DescriptorFreeList _persistentFreeList;
+	LinearRingAllocator _ringAllocator;
+};
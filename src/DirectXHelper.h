@@ -6,4 +6,12 @@ struct DirectXHelper {
 		// 这两个值来自 https://learn.microsoft.com/en-us/windows/win32/direct3ddxgi/d3d10-graphics-programming-guide-dxgi#new-info-about-enumerating-adapters-for-windows-8
 		return desc.VendorId == 0x1414 && desc.DeviceId == 0x8c;
 	}
+
+	static bool IsSameResourceDesc(const D3D12_RESOURCE_DESC& a, const D3D12_RESOURCE_DESC& b) noexcept {
+		// 结构体中有填充，不能使用 memcmp
+		return a.Dimension == b.Dimension && a.Alignment == b.Alignment && a.Width == b.Width &&
+			a.Height == b.Height && a.DepthOrArraySize == b.DepthOrArraySize && a.MipLevels == b.MipLevels &&
+			a.Format == b.Format && a.SampleDesc.Count == b.SampleDesc.Count &&
+			a.SampleDesc.Quality == b.SampleDesc.Quality && a.Layout == b.Layout && a.Flags == b.Flags;
+	}
 };
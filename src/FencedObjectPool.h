@@ -0,0 +1,87 @@
+#pragma once
+#include <deque>
+
+// 回收 GPU 使用过的对象（如命令分配器）的对象池。对象归还时记录最后使用它的围栏值，只有围栏
+// 值完成后才会再次取出。不依赖 D3D12，T 可以是任何可移动的类型，创建对象由调用者负责。
+template <typename T>
+class FencedObjectPool {
+public:
+	struct Stats {
+		// 池中对象总数，包括正在使用的
+		uint32_t totalCount = 0;
+		uint32_t inUseCount = 0;
+		// 历史峰值，用于确定池的大小
+		uint32_t maxTotalCount = 0;
+		uint32_t maxInUseCount = 0;
+	};
+
+	FencedObjectPool() = default;
+	FencedObjectPool(const FencedObjectPool&) = delete;
+	FencedObjectPool(FencedObjectPool&&) = default;
+
+	// 取出一个围栏值已完成的对象，没有可用对象时返回 false，调用者应创建新对象并调用
+	// OnCreated。
+	bool TryAcquire(uint64_t completedFenceValue, T& obj) noexcept {
+		// 归还时围栏值单调不减，只需检查最早归还的对象
+		if (_freeEntries.empty() || _freeEntries.front().fenceValue > completedFenceValue) {
+			return false;
+		}
+
+		obj = std::move(_freeEntries.front().obj);
+		_freeEntries.pop_front();
+		_OnAcquired();
+		return true;
+	}
+
+	// 调用者创建了一个新对象并立即使用
+	void OnCreated() noexcept {
+		++_stats.totalCount;
+		_stats.maxTotalCount = std::max(_stats.maxTotalCount, _stats.totalCount);
+		_OnAcquired();
+	}
+
+	// fenceValue 为最后使用 obj 的命令的围栏值，tick 用于计算空闲时间，两者都必须单调不减
+	void Release(T&& obj, uint64_t fenceValue, uint64_t tick) noexcept {
+		assert(_stats.inUseCount > 0);
+		assert(_freeEntries.empty() || _freeEntries.back().fenceValue <= fenceValue);
+
+		_freeEntries.push_back({ std::move(obj), fenceValue, tick });
+		--_stats.inUseCount;
+	}
+
+	// 销毁空闲超过 maxIdleTicks 且 GPU 已不再使用的对象，池中至少保留 minCount 个对象。
+	// 返回销毁的数量。
+	uint32_t Trim(uint64_t completedFenceValue, uint64_t curTick, uint64_t maxIdleTicks, uint32_t minCount) noexcept {
+		uint32_t count = 0;
+		while (!_freeEntries.empty() && _stats.totalCount > minCount) {
+			const _Entry& entry = _freeEntries.front();
+			if (entry.fenceValue > completedFenceValue || curTick - entry.tick <= maxIdleTicks) {
+				break;
+			}
+
+			_freeEntries.pop_front();
+			--_stats.totalCount;
+			++count;
+		}
+		return count;
+	}
+
+	const Stats& GetStats() const noexcept {
+		return _stats;
+	}
+
+private:
+	void _OnAcquired() noexcept {
+		++_stats.inUseCount;
+		_stats.maxInUseCount = std::max(_stats.maxInUseCount, _stats.inUseCount);
+	}
+
+	struct _Entry {
+		T obj;
+		uint64_t fenceValue;
+		uint64_t tick;
+	};
+
+	std::deque<_Entry> _freeEntries;
+	Stats _stats;
+};
@@ -0,0 +1,223 @@
+#include "pch.h"
+#include "GpuProfiler.h"
+#include <algorithm>
+
+HRESULT GpuProfiler::Initialize(ID3D12Device* device, uint32_t frameCount) noexcept {
+	_slots.resize(frameCount);
+	for (_FrameSlot& slot : _slots) {
+		slot.scopes.resize(MAX_SCOPE_COUNT);
+	}
+
+	if (!device) {
+		return S_OK;
+	}
+
+	const D3D12_QUERY_HEAP_DESC queryHeapDesc = {
+		.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP,
+		.Count = MAX_SCOPE_COUNT * 2 * frameCount
+	};
+	HRESULT hr = device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&_queryHeap));
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	// 只有几 KB，使用提交资源
+	const CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_READBACK);
+	const CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(_GetReadbackOffset(frameCount));
+	return device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&_readbackBuffer));
+}
+
+void GpuProfiler::BeginFrame(uint32_t frameIndex, uint64_t frameNumber) noexcept {
+	_completedFrame.frameNumber = UINT64_MAX;
+	_completedFrame.cpuBeginTime = 0;
+	_completedFrame.scopes.clear();
+
+	_FrameSlot& slot = _slots[frameIndex];
+
+	if (slot.isResolved && _readbackBuffer) {
+		const uint64_t offset = _GetReadbackOffset(frameIndex);
+		const D3D12_RANGE readRange = { offset, offset + sizeof(uint64_t) * 2 * slot.scopeCount };
+		void* data;
+		if (SUCCEEDED(_readbackBuffer->Map(0, &readRange, &data))) {
+			ReadFrame(frameIndex, std::span((const uint64_t*)((const uint8_t*)data + offset), slot.scopeCount * 2));
+
+			const D3D12_RANGE writtenRange{};
+			_readbackBuffer->Unmap(0, &writtenRange);
+		}
+	}
+
+	slot.frameNumber = frameNumber;
+	slot.scopeCount = 0;
+	slot.isResolved = false;
+
+	_curFrameIndex = frameIndex;
+	_curScopeCount.store(0, std::memory_order_relaxed);
+}
+
+uint32_t GpuProfiler::BeginScope(
+	ID3D12GraphicsCommandList* commandList,
+	const char* name,
+	uint32_t parent
+) noexcept {
+	const uint32_t scope = _curScopeCount.fetch_add(1, std::memory_order_relaxed);
+	if (scope >= MAX_SCOPE_COUNT) {
+		return NO_SCOPE;
+	}
+
+	// 父范围的索引总是更小，ReadFrame 依赖这一点
+	assert(parent == NO_SCOPE || parent < scope);
+
+	// 每个范围的记录只由录制它的线程写入，Resolve 之前录制线程已经完成
+	_slots[_curFrameIndex].scopes[scope] = { .name = name, .parent = parent, .isEnded = false };
+
+	if (commandList) {
+		commandList->EndQuery(_queryHeap.get(), D3D12_QUERY_TYPE_TIMESTAMP,
+			(_curFrameIndex * MAX_SCOPE_COUNT + scope) * 2);
+	}
+
+	return scope;
+}
+
+void GpuProfiler::EndScope(ID3D12GraphicsCommandList* commandList, uint32_t scope) noexcept {
+	if (scope == NO_SCOPE) {
+		return;
+	}
+
+	_slots[_curFrameIndex].scopes[scope].isEnded = true;
+
+	if (commandList) {
+		commandList->EndQuery(_queryHeap.get(), D3D12_QUERY_TYPE_TIMESTAMP,
+			(_curFrameIndex * MAX_SCOPE_COUNT + scope) * 2 + 1);
+	}
+}
+
+void GpuProfiler::Resolve(ID3D12GraphicsCommandList* commandList, const Calibration& calibration) noexcept {
+	_FrameSlot& slot = _slots[_curFrameIndex];
+	slot.scopeCount = std::min(_curScopeCount.load(std::memory_order_relaxed), MAX_SCOPE_COUNT);
+	slot.calibration = calibration;
+	slot.isResolved = true;
+
+	if (!commandList) {
+		return;
+	}
+
+	const uint32_t firstQuery = _curFrameIndex * MAX_SCOPE_COUNT * 2;
+
+	// 解析从未写入的查询是错误，没有结束的范围在这里结束，ReadFrame 会丢弃它们
+	for (uint32_t i = 0; i < slot.scopeCount; ++i) {
+		if (!slot.scopes[i].isEnded) {
+			commandList->EndQuery(_queryHeap.get(), D3D12_QUERY_TYPE_TIMESTAMP, firstQuery + i * 2 + 1);
+		}
+	}
+
+	commandList->ResolveQueryData(_queryHeap.get(), D3D12_QUERY_TYPE_TIMESTAMP, firstQuery,
+		slot.scopeCount * 2, _readbackBuffer.get(), _GetReadbackOffset(_curFrameIndex));
+}
+
+void GpuProfiler::ReadFrame(uint32_t frameIndex, std::span<const uint64_t> timestamps) noexcept {
+	_completedFrame.frameNumber = UINT64_MAX;
+	_completedFrame.cpuBeginTime = 0;
+	_completedFrame.scopes.clear();
+
+	const _FrameSlot& slot = _slots[frameIndex];
+	const Calibration& calibration = slot.calibration;
+	if (!slot.isResolved || calibration.gpuFrequency == 0) {
+		return;
+	}
+
+	const uint32_t count = slot.scopeCount;
+	assert(timestamps.size() >= count * 2);
+
+	// 筛选有效的范围并找出最早的时间戳。父范围的索引更小，因此已经检查过。
+	_newIndices.assign(count, NO_SCOPE);
+	uint64_t baseTimestamp = UINT64_MAX;
+	for (uint32_t i = 0; i < count; ++i) {
+		const _ScopeRecord& record = slot.scopes[i];
+		const uint64_t beginTimestamp = timestamps[i * 2];
+		const uint64_t endTimestamp = timestamps[i * 2 + 1];
+
+		// 时间戳可能在 GPU 切换电源状态时不连续
+		if (!record.isEnded || endTimestamp < beginTimestamp ||
+			(record.parent != NO_SCOPE && _newIndices[record.parent] == NO_SCOPE)) {
+			continue;
+		}
+
+		_newIndices[i] = 0;
+		baseTimestamp = std::min(baseTimestamp, beginTimestamp);
+	}
+
+	if (baseTimestamp == UINT64_MAX) {
+		return;
+	}
+
+	// 按父范围分组，count 位置存放顶层范围。_childCounts[p] 到 _childCounts[p + 1] 是 p 的子范围。
+	_childCounts.assign(count + 2, 0);
+	for (uint32_t i = 0; i < count; ++i) {
+		if (_newIndices[i] != NO_SCOPE) {
+			const uint32_t parent = slot.scopes[i].parent;
+			++_childCounts[(parent == NO_SCOPE ? count : parent) + 1];
+		}
+	}
+	for (uint32_t i = 1; i < count + 2; ++i) {
+		_childCounts[i] += _childCounts[i - 1];
+	}
+
+	_children.resize(_childCounts[count + 1]);
+	{
+		// 借用 _stack 作为每组的写入位置
+		_stack.assign(_childCounts.begin(), _childCounts.end() - 1);
+		for (uint32_t i = 0; i < count; ++i) {
+			if (_newIndices[i] != NO_SCOPE) {
+				const uint32_t parent = slot.scopes[i].parent;
+				_children[_stack[parent == NO_SCOPE ? count : parent]++] = i;
+			}
+		}
+	}
+
+	// 同级按开始时间排序，相同时保持开始录制的顺序
+	for (uint32_t group = 0; group <= count; ++group) {
+		std::sort(_children.begin() + _childCounts[group], _children.begin() + _childCounts[group + 1],
+			[&](uint32_t l, uint32_t r) {
+				return timestamps[l * 2] != timestamps[r * 2] ? timestamps[l * 2] < timestamps[r * 2] : l < r;
+			});
+	}
+
+	// 先序遍历，子范围逆序入栈
+	const double msPerTick = 1000.0 / calibration.gpuFrequency;
+	_stack.clear();
+	for (uint32_t i = _childCounts[count + 1]; i > _childCounts[count]; --i) {
+		_stack.push_back(_children[i - 1]);
+	}
+
+	_completedFrame.scopes.reserve(_children.size());
+	while (!_stack.empty()) {
+		const uint32_t scope = _stack.back();
+		_stack.pop_back();
+
+		const _ScopeRecord& record = slot.scopes[scope];
+		const uint32_t parent = record.parent == NO_SCOPE ? NO_SCOPE : _newIndices[record.parent];
+
+		_newIndices[scope] = (uint32_t)_completedFrame.scopes.size();
+		_completedFrame.scopes.push_back({
+			.name = record.name,
+			.parent = parent,
+			.depth = parent == NO_SCOPE ? 0 : _completedFrame.scopes[parent].depth + 1,
+			.beginTime = double(timestamps[scope * 2] - baseTimestamp) * msPerTick,
+			.endTime = double(timestamps[scope * 2 + 1] - baseTimestamp) * msPerTick
+		});
+
+		for (uint32_t i = _childCounts[scope + 1]; i > _childCounts[scope]; --i) {
+			_stack.push_back(_children[i - 1]);
+		}
+	}
+
+	_completedFrame.frameNumber = slot.frameNumber;
+
+	// 校准点和最早的时间戳通常只差几帧，转换成 CPU 时钟的误差可以忽略
+	if (calibration.cpuFrequency != 0 && calibration.cpuTimestamp != 0) {
+		const double gpuOffset = (double)(int64_t)(baseTimestamp - calibration.gpuTimestamp);
+		_completedFrame.cpuBeginTime = (int64_t)calibration.cpuTimestamp +
+			std::llround(gpuOffset * calibration.cpuFrequency / calibration.gpuFrequency);
+	}
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <span>
+
+// 层次化的 GPU 计时。命令列表中的命名范围由一对时间戳查询界定，范围可以嵌套，也可以跨越同一
+// 帧的多个命令列表。每个帧索引有独占的查询和回读位置，组成一个环：D3D12Context::EndFrame 将
+// 这一帧的查询解析到它的回读位置，BeginFrame 再次返回这个帧索引时 GPU 已经完成，因此结果在
+// GetMaxInFlightFrameCount() 帧之后读取，不会等待 GPU。
+//
+// 不传入设备初始化时不创建查询堆，命令列表可以为空，用 ReadFrame 传入合成的时间戳即可在没有
+// GPU 的情况下测试环和范围树的逻辑。
+class GpuProfiler {
+public:
+	static constexpr uint32_t NO_SCOPE = UINT32_MAX;
+	// 每帧最多的范围数，超出的范围不计时
+	static constexpr uint32_t MAX_SCOPE_COUNT = 256;
+
+	// GPU 时间戳和 QueryPerformanceCounter 的对应关系，每帧解析时获取一次。GPU 改变电源状态
+	// 时时间戳的频率可能改变，因此频率也每帧获取。
+	struct Calibration {
+		// ID3D12CommandQueue::GetClockCalibration 同时采样的两个时钟
+		uint64_t gpuTimestamp = 0;
+		uint64_t cpuTimestamp = 0;
+		// ID3D12CommandQueue::GetTimestampFrequency，为 0 时这一帧没有结果
+		uint64_t gpuFrequency = 0;
+		// QueryPerformanceFrequency
+		uint64_t cpuFrequency = 0;
+	};
+
+	struct Scope {
+		const char* name;
+		// 在 Frame::scopes 中的索引，顶层范围为 NO_SCOPE
+		uint32_t parent;
+		uint32_t depth;
+		// 相对于这一帧最早的时间戳，单位为毫秒
+		double beginTime;
+		double endTime;
+	};
+
+	struct Frame {
+		// D3D12Context 的帧序号，UINT64_MAX 表示没有结果
+		uint64_t frameNumber = UINT64_MAX;
+		// 最早的时间戳对应的 QueryPerformanceCounter 值，用于和 CPU 的计时对齐。没有校准时为 0。
+		int64_t cpuBeginTime = 0;
+		// 先序排列，子范围紧跟在父范围之后，同级的范围按开始时间排序。没有结束或时间戳不连续的
+		// 范围和它的子范围被丢弃。
+		std::vector<Scope> scopes;
+	};
+
+	GpuProfiler() = default;
+	GpuProfiler(const GpuProfiler&) = delete;
+	GpuProfiler(GpuProfiler&&) = delete;
+
+	// device 为空时只用于测试
+	HRESULT Initialize(ID3D12Device* device, uint32_t frameCount) noexcept;
+
+	// 由 D3D12Context::BeginFrame 在等待这个帧索引完成后调用。读取这个帧索引上次记录的帧作为
+	// GetCompletedFrame 的结果，然后开始记录新的帧。
+	void BeginFrame(uint32_t frameIndex, uint64_t frameNumber) noexcept;
+
+	// 在命令列表中开始一个范围，返回的索引传给 EndScope。parent 为外层范围，可以在另一个命令
+	// 列表中开始，但必须在这个范围之前。可以在多个线程同时录制不同的命令列表。
+	uint32_t BeginScope(ID3D12GraphicsCommandList* commandList, const char* name, uint32_t parent = NO_SCOPE) noexcept;
+
+	// 录制到范围的最后一个命令列表中，这个命令列表不能先于开始的命令列表提交
+	void EndScope(ID3D12GraphicsCommandList* commandList, uint32_t scope) noexcept;
+
+	bool HasScopes() const noexcept {
+		return _curScopeCount.load(std::memory_order_relaxed) > 0;
+	}
+
+	// 由 D3D12Context::EndFrame 在这一帧的所有命令列表录制完成后调用，commandList 在它们之后
+	// 提交。这一帧没有范围时无需调用。
+	void Resolve(ID3D12GraphicsCommandList* commandList, const Calibration& calibration) noexcept;
+
+	// 用时间戳生成这个帧索引上次解析的帧的结果，timestamps 依次为每个范围的开始和结束。
+	// BeginFrame 用回读的时间戳调用，测试时可以传入合成的时间戳。
+	void ReadFrame(uint32_t frameIndex, std::span<const uint64_t> timestamps) noexcept;
+
+	// 上次 BeginFrame 读取到的帧，通常是 GetMaxInFlightFrameCount() 帧之前的
+	const Frame& GetCompletedFrame() const noexcept {
+		return _completedFrame;
+	}
+
+private:
+	struct _ScopeRecord {
+		const char* name;
+		uint32_t parent;
+		bool isEnded;
+	};
+
+	struct _FrameSlot {
+		std::vector<_ScopeRecord> scopes;
+		Calibration calibration;
+		uint64_t frameNumber = UINT64_MAX;
+		uint32_t scopeCount = 0;
+		// 已录制 ResolveQueryData，BeginFrame 时可以读取
+		bool isResolved = false;
+	};
+
+	uint64_t _GetReadbackOffset(uint32_t frameIndex) const noexcept {
+		return sizeof(uint64_t) * 2 * MAX_SCOPE_COUNT * frameIndex;
+	}
+
+	winrt::com_ptr<ID3D12QueryHeap> _queryHeap;
+	winrt::com_ptr<ID3D12Resource> _readbackBuffer;
+
+	std::vector<_FrameSlot> _slots;
+	uint32_t _curFrameIndex = 0;
+	// 当前帧已分配的范围数，可能超过 MAX_SCOPE_COUNT
+	std::atomic<uint32_t> _curScopeCount = 0;
+
+	Frame _completedFrame;
+	// 以下为 ReadFrame 使用的临时数据
+	std::vector<uint32_t> _newIndices;
+	std::vector<uint32_t> _childCounts;
+	std::vector<uint32_t> _children;
+	std::vector<uint32_t> _stack;
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+// 64 位 FNV-1a 哈希，结果和平台无关，可以持久化。不依赖 D3D12。
+class Hasher {
+public:
+	void AddBytes(const void* data, size_t size) noexcept {
+		const uint8_t* bytes = (const uint8_t*)data;
+		for (size_t i = 0; i < size; ++i) {
+			_hash = (_hash ^ bytes[i]) * PRIME;
+		}
+	}
+
+	// T 不能有填充字节，否则哈希值不确定
+	template <typename T>
+	void Add(const T& value) noexcept {
+		static_assert(std::is_trivially_copyable_v<T>);
+		AddBytes(&value, sizeof(value));
+	}
+
+	// 包含长度以区分 "ab"+"c" 和 "a"+"bc"
+	void AddString(std::string_view str) noexcept {
+		Add((uint64_t)str.size());
+		AddBytes(str.data(), str.size());
+	}
+
+	uint64_t GetHash() const noexcept {
+		return _hash;
+	}
+
+	static uint64_t Hash(const void* data, size_t size) noexcept {
+		Hasher hasher;
+		hasher.AddBytes(data, size);
+		return hasher.GetHash();
+	}
+
+private:
+	static constexpr uint64_t OFFSET_BASIS = 0xCBF29CE484222325;
+	static constexpr uint64_t PRIME = 0x100000001B3;
+
+	uint64_t _hash = OFFSET_BASIS;
+};
@@ -0,0 +1,225 @@
+#include "pch.h"
+#include "HeapAllocator.h"
+
+// 放置资源的偏移至少按 64KB 对齐，以此作为最小块可以避免在块内再次对齐
+static constexpr uint64_t MIN_BLOCK_SIZE = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+void HeapAllocator::Initialize(ID3D12Device5* device, bool isHeapFlagCreateNotZeroedSupported, uint64_t heapSize) noexcept {
+	assert(heapSize >= MIN_BLOCK_SIZE && (heapSize & (heapSize - 1)) == 0);
+
+	_device = device;
+	_isHeapFlagCreateNotZeroedSupported = isHeapFlagCreateNotZeroedSupported;
+	_heapSize = heapSize;
+}
+
+HRESULT HeapAllocator::CreateResource(
+	D3D12_HEAP_TYPE heapType,
+	const D3D12_RESOURCE_DESC& desc,
+	D3D12_RESOURCE_STATES initialState,
+	const D3D12_CLEAR_VALUE* clearValue,
+	winrt::com_ptr<ID3D12Resource>& resource,
+	HeapAllocation& allocation
+) noexcept {
+	const D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = _device->GetResourceAllocationInfo(0, 1, &desc);
+	if (allocationInfo.SizeInBytes == UINT64_MAX) {
+		return E_INVALIDARG;
+	}
+
+	if (allocationInfo.SizeInBytes > _heapSize) {
+		// 太大的资源使用提交资源
+		D3D12_HEAP_FLAGS heapFlag = _isHeapFlagCreateNotZeroedSupported ?
+			D3D12_HEAP_FLAG_CREATE_NOT_ZEROED : D3D12_HEAP_FLAG_NONE;
+		CD3DX12_HEAP_PROPERTIES heapProperties(heapType);
+
+		HRESULT hr = _device->CreateCommittedResource(
+			&heapProperties,
+			heapFlag,
+			&desc,
+			initialState,
+			clearValue,
+			IID_PPV_ARGS(&resource)
+		);
+		if (FAILED(hr)) {
+			return hr;
+		}
+
+		allocation = {};
+		++_committedResourceCount;
+		return S_OK;
+	}
+
+	const uint32_t poolIndex = _GetPoolIndex(heapType, GetResourceCategory(desc));
+	_Pool& pool = _pools[poolIndex];
+
+	allocation = { .poolIndex = poolIndex };
+
+	// 先尝试已有的堆
+	uint32_t heapIndex = 0;
+	for (; heapIndex < (uint32_t)pool.heaps.size(); ++heapIndex) {
+		_Heap& heap = pool.heaps[heapIndex];
+		if (heap.heap && heap.allocator.Allocate(
+			allocationInfo.SizeInBytes, allocationInfo.Alignment, allocation.block)) {
+			break;
+		}
+	}
+
+	if (heapIndex == (uint32_t)pool.heaps.size()) {
+		// 创建新的堆，优先使用已销毁的堆的位置
+		heapIndex = 0;
+		while (heapIndex < (uint32_t)pool.heaps.size() && pool.heaps[heapIndex].heap) {
+			++heapIndex;
+		}
+		if (heapIndex == (uint32_t)pool.heaps.size()) {
+			pool.heaps.emplace_back();
+		}
+
+		_Heap& heap = pool.heaps[heapIndex];
+		HRESULT hr = _CreateHeap(pool, heap);
+		if (FAILED(hr)) {
+			return hr;
+		}
+
+		[[maybe_unused]] const bool success = heap.allocator.Allocate(
+			allocationInfo.SizeInBytes, allocationInfo.Alignment, allocation.block);
+		assert(success);
+	}
+
+	_Heap& heap = pool.heaps[heapIndex];
+	heap.lastUsedTick = _curTick;
+
+	HRESULT hr = _device->CreatePlacedResource(
+		heap.heap.get(),
+		allocation.block.offset,
+		&desc,
+		initialState,
+		clearValue,
+		IID_PPV_ARGS(&resource)
+	);
+	if (FAILED(hr)) {
+		heap.allocator.Free(allocation.block);
+		return hr;
+	}
+
+	allocation.heap = heap.heap.get();
+	allocation.heapIndex = heapIndex;
+	return S_OK;
+}
+
+void HeapAllocator::Free(const HeapAllocation& allocation) noexcept {
+	if (!allocation.heap) {
+		assert(_committedResourceCount > 0);
+		--_committedResourceCount;
+		return;
+	}
+
+	_Heap& heap = _pools[allocation.poolIndex].heaps[allocation.heapIndex];
+	assert(heap.heap.get() == allocation.heap);
+	heap.allocator.Free(allocation.block);
+}
+
+void HeapAllocator::Trim(uint64_t curTick, uint64_t maxIdleTicks) noexcept {
+	_curTick = curTick;
+
+	for (_Pool& pool : _pools) {
+		bool isFirst = true;
+		for (_Heap& heap : pool.heaps) {
+			if (!heap.heap) {
+				continue;
+			}
+
+			if (!heap.allocator.IsEmpty()) {
+				heap.lastUsedTick = curTick;
+			}
+
+			if (isFirst) {
+				isFirst = false;
+				continue;
+			}
+
+			if (heap.allocator.IsEmpty() && curTick - heap.lastUsedTick > maxIdleTicks) {
+				heap.heap = nullptr;
+			}
+		}
+	}
+}
+
+HeapAllocator::Stats HeapAllocator::GetStats() const noexcept {
+	Stats stats = { .committedResourceCount = _committedResourceCount };
+
+	for (const _Pool& pool : _pools) {
+		for (const _Heap& heap : pool.heaps) {
+			if (!heap.heap) {
+				continue;
+			}
+
+			const BuddyAllocator::Stats heapStats = heap.allocator.GetStats();
+			++stats.heapCount;
+			stats.heapSize += heapStats.capacity;
+			stats.usedSize += heapStats.usedSize;
+			stats.requestedSize += heapStats.requestedSize;
+			stats.largestFreeBlockSize = std::max(stats.largestFreeBlockSize, heapStats.largestFreeBlockSize);
+			stats.freeBlockCount += heapStats.freeBlockCount;
+			stats.placedResourceCount += heapStats.allocationCount;
+		}
+	}
+
+	return stats;
+}
+
+HeapAllocator::ResourceCategory HeapAllocator::GetResourceCategory(const D3D12_RESOURCE_DESC& desc) noexcept {
+	if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
+		return ResourceCategory::Buffer;
+	} else if (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) {
+		return ResourceCategory::RenderTargetOrDepthStencil;
+	} else {
+		return ResourceCategory::Texture;
+	}
+}
+
+D3D12_HEAP_FLAGS HeapAllocator::GetHeapFlags(ResourceCategory category) noexcept {
+	switch (category) {
+	case ResourceCategory::Buffer:
+		return D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+	case ResourceCategory::Texture:
+		return D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+	default:
+		return D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+	}
+}
+
+uint32_t HeapAllocator::_GetPoolIndex(D3D12_HEAP_TYPE heapType, ResourceCategory category) noexcept {
+	// 池很少，线性查找即可
+	for (uint32_t i = 0; i < (uint32_t)_pools.size(); ++i) {
+		if (_pools[i].heapType == heapType && _pools[i].category == category) {
+			return i;
+		}
+	}
+
+	_pools.push_back({ .heapType = heapType, .category = category });
+	return (uint32_t)_pools.size() - 1;
+}
+
+HRESULT HeapAllocator::_CreateHeap(_Pool& pool, _Heap& heap) noexcept {
+	D3D12_HEAP_FLAGS heapFlags = GetHeapFlags(pool.category);
+	if (_isHeapFlagCreateNotZeroedSupported) {
+		heapFlags |= D3D12_HEAP_FLAG_CREATE_NOT_ZEROED;
+	}
+
+	// 支持放置 MSAA 资源
+	const uint64_t alignment = pool.category == ResourceCategory::RenderTargetOrDepthStencil ?
+		D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+	CD3DX12_HEAP_DESC heapDesc(_heapSize, pool.heapType, alignment, heapFlags);
+	HRESULT hr = _device->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap.heap));
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	uint32_t maxOrder = 0;
+	while ((MIN_BLOCK_SIZE << maxOrder) < _heapSize) {
+		++maxOrder;
+	}
+	heap.allocator = BuddyAllocator(MIN_BLOCK_SIZE, maxOrder);
+
+	return S_OK;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "BuddyAllocator.h"
+
+struct HeapAllocation {
+	// 为空表示资源是提交资源，没有占用堆的空间
+	ID3D12Heap* heap = nullptr;
+	uint32_t poolIndex = 0;
+	uint32_t heapIndex = 0;
+	BuddyAllocator::Allocation block;
+};
+
+// 创建少量大的 ID3D12Heap 并将资源放置其中，避免每个资源都创建隐式堆。每种堆类型和资源类别
+// 使用独立的堆，因此也适用于 Resource Heap Tier 1。超出堆大小的资源回落到提交资源。
+class HeapAllocator {
+public:
+	struct Stats {
+		uint32_t heapCount = 0;
+		uint64_t heapSize = 0;
+		uint64_t usedSize = 0;
+		// 和 usedSize 的差为内部碎片
+		uint64_t requestedSize = 0;
+		// 所有堆中最大的空闲块，和空闲空间的比例反映外部碎片
+		uint64_t largestFreeBlockSize = 0;
+		uint32_t freeBlockCount = 0;
+		uint32_t placedResourceCount = 0;
+		uint32_t committedResourceCount = 0;
+	};
+
+	enum class ResourceCategory {
+		Buffer,
+		Texture,
+		RenderTargetOrDepthStencil
+	};
+
+	// Resource Heap Tier 1 要求每个堆只包含一种类别的资源
+	static ResourceCategory GetResourceCategory(const D3D12_RESOURCE_DESC& desc) noexcept;
+
+	static D3D12_HEAP_FLAGS GetHeapFlags(ResourceCategory category) noexcept;
+
+	HeapAllocator() = default;
+	HeapAllocator(const HeapAllocator&) = delete;
+	HeapAllocator(HeapAllocator&&) = default;
+
+	// heapSize 必须是 64KB 的 2 的幂倍
+	void Initialize(ID3D12Device5* device, bool isHeapFlagCreateNotZeroedSupported, uint64_t heapSize) noexcept;
+
+	HRESULT CreateResource(
+		D3D12_HEAP_TYPE heapType,
+		const D3D12_RESOURCE_DESC& desc,
+		D3D12_RESOURCE_STATES initialState,
+		const D3D12_CLEAR_VALUE* clearValue,
+		winrt::com_ptr<ID3D12Resource>& resource,
+		HeapAllocation& allocation
+	) noexcept;
+
+	// 调用者负责确保 GPU 不再使用 allocation 中的资源
+	void Free(const HeapAllocation& allocation) noexcept;
+
+	// 销毁空闲超过 maxIdleTicks 的空堆，每个池至少保留一个堆。curTick 用于计算空闲时间，必须
+	// 单调不减。调整尺寸时资源先释放再创建，立即销毁空堆会导致反复创建堆。
+	void Trim(uint64_t curTick, uint64_t maxIdleTicks) noexcept;
+
+	Stats GetStats() const noexcept;
+
+private:
+	struct _Heap {
+		winrt::com_ptr<ID3D12Heap> heap;
+		BuddyAllocator allocator;
+		// 最后一次非空的时刻
+		uint64_t lastUsedTick = 0;
+	};
+
+	struct _Pool {
+		D3D12_HEAP_TYPE heapType;
+		ResourceCategory category;
+		// 被销毁的堆保留位置，使 HeapAllocation 中的索引保持有效
+		std::vector<_Heap> heaps;
+	};
+
+	uint32_t _GetPoolIndex(D3D12_HEAP_TYPE heapType, ResourceCategory category) noexcept;
+
+	HRESULT _CreateHeap(_Pool& pool, _Heap& heap) noexcept;
+
+	ID3D12Device5* _device = nullptr;
+	uint64_t _heapSize = 0;
+	bool _isHeapFlagCreateNotZeroedSupported = false;
+
+	std::vector<_Pool> _pools;
+	uint32_t _committedResourceCount = 0;
+	// 上次 Trim 的时刻，新分配的堆以此作为最后使用的时刻
+	uint64_t _curTick = 0;
+};
@@ -0,0 +1,203 @@
+// 不依赖 D3D12，不使用预编译头，以便在其他平台测试
+#include "IccProfile.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// ICC.1:2022，所有数值都是大端序
+static constexpr size_t HEADER_SIZE = 128;
+static constexpr size_t TAG_ENTRY_SIZE = 12;
+
+static constexpr uint32_t MakeSignature(const char (&str)[5]) noexcept {
+	return ((uint32_t)(uint8_t)str[0] << 24) | ((uint32_t)(uint8_t)str[1] << 16) |
+		((uint32_t)(uint8_t)str[2] << 8) | (uint32_t)(uint8_t)str[3];
+}
+
+// para 每种函数类型的参数个数
+static constexpr uint32_t PARAMETRIC_PARAM_COUNTS[] = { 1, 3, 4, 5, 7 };
+
+static uint16_t ReadU16(std::span<const uint8_t> data, size_t offset) noexcept {
+	return uint16_t((data[offset] << 8) | data[offset + 1]);
+}
+
+static uint32_t ReadU32(std::span<const uint8_t> data, size_t offset) noexcept {
+	return ((uint32_t)data[offset] << 24) | ((uint32_t)data[offset + 1] << 16) |
+		((uint32_t)data[offset + 2] << 8) | (uint32_t)data[offset + 3];
+}
+
+static float ReadS15Fixed16(std::span<const uint8_t> data, size_t offset) noexcept {
+	return (float)(int32_t)ReadU32(data, offset) / 65536.0f;
+}
+
+// 标签表越界时返回 0
+static uint32_t GetTagCount(std::span<const uint8_t> data) noexcept {
+	const uint32_t tagCount = ReadU32(data, HEADER_SIZE);
+	return tagCount > (data.size() - HEADER_SIZE - 4) / TAG_ENTRY_SIZE ? 0 : tagCount;
+}
+
+static uint32_t GetTagSignature(std::span<const uint8_t> data, uint32_t index) noexcept {
+	return ReadU32(data, HEADER_SIZE + 4 + TAG_ENTRY_SIZE * index);
+}
+
+// 返回标签的数据，不存在或越界时返回空
+static std::span<const uint8_t> FindTag(std::span<const uint8_t> data, uint32_t signature) noexcept {
+	const uint32_t tagCount = GetTagCount(data);
+	for (uint32_t i = 0; i < tagCount; ++i) {
+		const size_t entry = HEADER_SIZE + 4 + TAG_ENTRY_SIZE * i;
+		if (GetTagSignature(data, i) != signature) {
+			continue;
+		}
+
+		const uint32_t offset = ReadU32(data, entry + 4);
+		const uint32_t size = ReadU32(data, entry + 8);
+		if (offset > data.size() || size > data.size() - offset) {
+			return {};
+		}
+		return data.subspan(offset, size);
+	}
+
+	return {};
+}
+
+static bool ParseXYZ(std::span<const uint8_t> tag, float (&xyz)[3]) noexcept {
+	if (tag.size() < 20 || ReadU32(tag, 0) != MakeSignature("XYZ ")) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < 3; ++i) {
+		xyz[i] = ReadS15Fixed16(tag, 8 + 4 * i);
+	}
+	return true;
+}
+
+static bool ParseCurve(std::span<const uint8_t> tag, IccProfile::Curve& curve) noexcept {
+	if (tag.size() < 12) {
+		return false;
+	}
+
+	const uint32_t type = ReadU32(tag, 0);
+	if (type == MakeSignature("curv")) {
+		const uint32_t count = ReadU32(tag, 8);
+		if (count > (tag.size() - 12) / 2) {
+			return false;
+		}
+
+		if (count == 0) {
+			// 恒等
+			curve.params[0] = 1.0f;
+		} else if (count == 1) {
+			// u8Fixed8Number 表示的指数
+			curve.params[0] = ReadU16(tag, 12) / 256.0f;
+		} else {
+			curve.table.resize(count);
+			for (uint32_t i = 0; i < count; ++i) {
+				curve.table[i] = ReadU16(tag, 12 + 2 * i) / 65535.0f;
+			}
+		}
+
+		return true;
+	}
+
+	if (type == MakeSignature("para")) {
+		curve.functionType = ReadU16(tag, 8);
+		if (curve.functionType >= std::size(PARAMETRIC_PARAM_COUNTS)) {
+			return false;
+		}
+
+		const uint32_t paramCount = PARAMETRIC_PARAM_COUNTS[curve.functionType];
+		if (tag.size() < 12 + 4 * paramCount) {
+			return false;
+		}
+
+		for (uint32_t i = 0; i < paramCount; ++i) {
+			curve.params[i] = ReadS15Fixed16(tag, 12 + 4 * i);
+		}
+		return true;
+	}
+
+	return false;
+}
+
+float IccProfile::Curve::Evaluate(float x) const noexcept {
+	x = std::clamp(x, 0.0f, 1.0f);
+
+	if (!table.empty()) {
+		const float position = x * (table.size() - 1);
+		const size_t index = std::min((size_t)position, table.size() - 2);
+		return std::clamp(std::lerp(table[index], table[index + 1], position - index), 0.0f, 1.0f);
+	}
+
+	const auto [g, a, b, c, d, e, f] = params;
+
+	float y;
+	switch (functionType) {
+	case 0:
+		y = std::pow(x, g);
+		break;
+	case 1:
+		y = x >= -b / a ? std::pow(a * x + b, g) : 0.0f;
+		break;
+	case 2:
+		y = x >= -b / a ? std::pow(a * x + b, g) + c : c;
+		break;
+	case 3:
+		y = x >= d ? std::pow(a * x + b, g) : c * x;
+		break;
+	default:
+		y = x >= d ? std::pow(a * x + b, g) + e : c * x + f;
+		break;
+	}
+
+	// 参数不合理时可能产生 NaN
+	return std::isnan(y) ? 0.0f : std::clamp(y, 0.0f, 1.0f);
+}
+
+bool IccProfile::Parse(std::span<const uint8_t> data, IccProfile& profile) noexcept {
+	if (data.size() < HEADER_SIZE + 4 || ReadU32(data, 36) != MakeSignature("acsp")) {
+		return false;
+	}
+
+	// 显示器配置文件的 PCS 总是 XYZ
+	if (ReadU32(data, 16) != MakeSignature("RGB ") || ReadU32(data, 20) != MakeSignature("XYZ ")) {
+		return false;
+	}
+
+	// 有 LUT 标签时 CMM 优先使用 LUT，只用矩阵/TRC 会偏离校准结果。vcgt 由校准软件加载到显卡的
+	// gamma 表，无法得知是否已经加载，TRC 是在它之上测得的。这两种都不支持。
+	static constexpr uint32_t UNSUPPORTED_TAGS[] = {
+		MakeSignature("A2B0"), MakeSignature("A2B1"), MakeSignature("A2B2"),
+		MakeSignature("B2A0"), MakeSignature("B2A1"), MakeSignature("B2A2"),
+		MakeSignature("vcgt")
+	};
+	const uint32_t tagCount = GetTagCount(data);
+	for (uint32_t i = 0; i < tagCount; ++i) {
+		if (std::ranges::find(UNSUPPORTED_TAGS, GetTagSignature(data, i)) != std::end(UNSUPPORTED_TAGS)) {
+			return false;
+		}
+	}
+
+	static constexpr uint32_t COLORANT_TAGS[] = {
+		MakeSignature("rXYZ"), MakeSignature("gXYZ"), MakeSignature("bXYZ")
+	};
+	static constexpr uint32_t CURVE_TAGS[] = {
+		MakeSignature("rTRC"), MakeSignature("gTRC"), MakeSignature("bTRC")
+	};
+
+	for (uint32_t i = 0; i < 3; ++i) {
+		float xyz[3];
+		if (!ParseXYZ(FindTag(data, COLORANT_TAGS[i]), xyz)) {
+			return false;
+		}
+
+		for (uint32_t row = 0; row < 3; ++row) {
+			profile.rgbToXYZ.m[row][i] = xyz[row];
+		}
+
+		profile.curves[i] = {};
+		if (!ParseCurve(FindTag(data, CURVE_TAGS[i]), profile.curves[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
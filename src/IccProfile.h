@@ -0,0 +1,30 @@
+#pragma once
+#include "ColorKernels.h"
+#include <array>
+#include <span>
+#include <vector>
+
+// 显示器 ICC 配置文件的最小解析，只支持矩阵/TRC 形式的 RGB 配置文件，即校准软件为显示器生成的
+// 常见形式：rXYZ、gXYZ、bXYZ 三个原色和 rTRC、gTRC、bTRC 三条曲线。含有 A2Bx、B2Ax 等 LUT
+// 标签或 vcgt 标签的配置文件不支持。不依赖 D3D12。
+struct IccProfile {
+	// curv 或 para 类型的曲线，将编码值映射到线性值
+	struct Curve {
+		// para 的函数类型，范围为 [0, 4]。curv 只有一个值时为类型 0。
+		uint32_t functionType = 0;
+		// 依次为 g、a、b、c、d、e、f，未使用的为 0
+		std::array<float, 7> params{ 1.0f };
+		// 非空时为 curv 的表，均匀采样 [0, 1]，忽略 params
+		std::vector<float> table;
+
+		// 结果截断到 [0, 1]
+		float Evaluate(float x) const noexcept;
+	};
+
+	// 每列是一个原色在 PCS 中的 XYZ，白点为 D50
+	ColorKernels::Matrix3x3 rgbToXYZ{};
+	std::array<Curve, 3> curves;
+
+	// 数据无效、不是矩阵/TRC 形式的 RGB 配置文件或者含有不支持的标签时返回 false
+	static bool Parse(std::span<const uint8_t> data, IccProfile& profile) noexcept;
+};
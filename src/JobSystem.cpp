@@ -0,0 +1,193 @@
+// 不依赖 D3D12，不使用预编译头，以便在其他平台测试
+#include "JobSystem.h"
+#include <algorithm>
+#include <cassert>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+// 当前线程所属的线程池和其中的序号
+static thread_local const JobSystem* tlsJobSystem = nullptr;
+static thread_local uint32_t tlsWorkerIndex = 0;
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard lock(_sleepMutex);
+		_isStopping = true;
+	}
+	_wakeCondition.notify_all();
+
+	for (std::thread& worker : _workers) {
+		worker.join();
+	}
+}
+
+bool JobSystem::Initialize(uint32_t workerCount) noexcept {
+	if (workerCount == 0) {
+		// 调用 Wait 的线程也会执行任务，因此少创建一个
+		const uint32_t coreCount = std::thread::hardware_concurrency();
+		workerCount = coreCount > 1 ? coreCount - 1 : 0;
+	}
+
+	_queueCount = workerCount + 1;
+	_queues = std::make_unique<_WorkQueue[]>(_queueCount);
+
+	try {
+		_workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; ++i) {
+			_workers.emplace_back(&JobSystem::_WorkerProc, this, i);
+		}
+	} catch (...) {
+		return false;
+	}
+
+	return true;
+}
+
+void JobSystem::Dispatch(Counter& counter, std::function<void()> job) noexcept {
+	counter._value.fetch_add(1, std::memory_order_relaxed);
+
+	// 必须在任务入队前递增。任务入队后可能立即被其他线程取出并递减，先入队会使计数暂时下溢。
+	// 计数暂时多于队列中的任务只会让工作线程多检查一次队列。
+	_pendingJobCount.fetch_add(1, std::memory_order_relaxed);
+
+	{
+		_WorkQueue& queue = _queues[_GetCurrentQueueIndex()];
+		std::lock_guard lock(queue.mutex);
+		queue.jobs.push_back({ std::move(job), &counter });
+	}
+
+	// 加锁以确保工作线程不会在检查条件后、进入睡眠前错过通知
+	{
+		std::lock_guard lock(_sleepMutex);
+	}
+	_wakeCondition.notify_one();
+}
+
+void JobSystem::Wait(Counter& counter) noexcept {
+	const uint32_t queueIndex = _GetCurrentQueueIndex();
+
+	while (true) {
+		// 必须在检查 counter 前读取
+		const uint32_t epoch = _completionEpoch.load(std::memory_order_acquire);
+		if (counter.IsDone()) {
+			return;
+		}
+
+		_Job job;
+		if (_TryPopJob(queueIndex, job)) {
+			_ExecuteJob(job);
+		} else {
+			// 剩余的任务正在其他线程上执行
+			_completionEpoch.wait(epoch, std::memory_order_acquire);
+		}
+	}
+}
+
+void JobSystem::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func) noexcept {
+	if (count == 0) {
+		return;
+	}
+
+	// 每个线程分几批以平衡负载，批次太多会增加调度开销
+	const uint32_t batchCount = std::min(count, _queueCount * 4);
+	const uint32_t batchSize = (count + batchCount - 1) / batchCount;
+
+	Counter counter;
+	for (uint32_t begin = batchSize; begin < count; begin += batchSize) {
+		const uint32_t end = std::min(begin + batchSize, count);
+		Dispatch(counter, [&func, begin, end]() {
+			for (uint32_t i = begin; i < end; ++i) {
+				func(i);
+			}
+		});
+	}
+
+	// 第一批在当前线程执行
+	for (uint32_t i = 0, end = std::min(batchSize, count); i < end; ++i) {
+		func(i);
+	}
+
+	Wait(counter);
+}
+
+void JobSystem::_WorkerProc(uint32_t workerIndex) noexcept {
+	tlsJobSystem = this;
+	tlsWorkerIndex = workerIndex;
+
+#ifdef _WIN32
+	SetThreadDescription(GetCurrentThread(), L"JobSystem worker");
+#endif
+
+	while (true) {
+		_Job job;
+		if (_TryPopJob(workerIndex, job)) {
+			_ExecuteJob(job);
+			continue;
+		}
+
+		std::unique_lock lock(_sleepMutex);
+		_wakeCondition.wait(lock, [this]() {
+			return _isStopping || _pendingJobCount.load(std::memory_order_acquire) > 0;
+		});
+
+		if (_isStopping) {
+			return;
+		}
+	}
+}
+
+uint32_t JobSystem::_GetCurrentQueueIndex() const noexcept {
+	return tlsJobSystem == this ? tlsWorkerIndex : _queueCount - 1;
+}
+
+bool JobSystem::_TryPopJob(uint32_t queueIndex, _Job& job) noexcept {
+	if (_pendingJobCount.load(std::memory_order_acquire) == 0) {
+		return false;
+	}
+
+	// 先从自己队列的队尾取出，最近提交的任务数据更可能还在缓存中
+	{
+		_WorkQueue& queue = _queues[queueIndex];
+		std::lock_guard lock(queue.mutex);
+		if (!queue.jobs.empty()) {
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			_OnJobPopped();
+			return true;
+		}
+	}
+
+	// 从其他队列的队首窃取
+	for (uint32_t i = 1; i < _queueCount; ++i) {
+		_WorkQueue& queue = _queues[(queueIndex + i) % _queueCount];
+		std::lock_guard lock(queue.mutex);
+		if (!queue.jobs.empty()) {
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			_OnJobPopped();
+			_stolenJobCount.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobSystem::_OnJobPopped() noexcept {
+	// Dispatch 先递增再入队，取出的任务一定已经计入
+	[[maybe_unused]] const uint32_t oldCount = _pendingJobCount.fetch_sub(1, std::memory_order_relaxed);
+	assert(oldCount > 0);
+}
+
+void JobSystem::_ExecuteJob(_Job& job) noexcept {
+	job.func();
+	_executedJobCount.fetch_add(1, std::memory_order_relaxed);
+
+	if (job.counter->_value.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		// 此后不能再访问 counter
+		_completionEpoch.fetch_add(1, std::memory_order_release);
+		_completionEpoch.notify_all();
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 任务窃取的线程池。每个工作线程有自己的任务队列，从队尾取出自己的任务，空闲时从其他
+// 队列的队首窃取。不属于线程池的线程提交的任务进入共享队列，它们等待任务完成时也会参与
+// 执行。
+class JobSystem {
+public:
+	// 记录未完成的任务数，用于等待一组任务完成
+	class Counter {
+	public:
+		bool IsDone() const noexcept {
+			return _value.load(std::memory_order_acquire) == 0;
+		}
+
+	private:
+		friend class JobSystem;
+
+		std::atomic<uint32_t> _value = 0;
+	};
+
+	JobSystem() = default;
+	JobSystem(const JobSystem&) = delete;
+	JobSystem(JobSystem&&) = delete;
+
+	~JobSystem();
+
+	// workerCount 为 0 则根据 CPU 核心数决定
+	bool Initialize(uint32_t workerCount = 0) noexcept;
+
+	uint32_t GetWorkerCount() const noexcept {
+		return (uint32_t)_workers.size();
+	}
+
+	// 提交一个任务，counter 在任务完成后减一
+	void Dispatch(Counter& counter, std::function<void()> job) noexcept;
+
+	// 等待 counter 归零，期间执行队列中的任务
+	void Wait(Counter& counter) noexcept;
+
+	// 将 [0, count) 分为若干批并行执行 func(index)，返回时全部完成
+	void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& func) noexcept;
+
+	struct Stats {
+		uint64_t executedJobCount;
+		uint64_t stolenJobCount;
+	};
+
+	Stats GetStats() const noexcept {
+		return {
+			_executedJobCount.load(std::memory_order_relaxed),
+			_stolenJobCount.load(std::memory_order_relaxed)
+		};
+	}
+
+private:
+	struct _Job {
+		std::function<void()> func;
+		Counter* counter;
+	};
+
+	struct alignas(64) _WorkQueue {
+		std::mutex mutex;
+		std::deque<_Job> jobs;
+	};
+
+	void _WorkerProc(uint32_t workerIndex) noexcept;
+
+	// 当前线程对应的队列，不属于线程池的线程使用最后一个共享队列
+	uint32_t _GetCurrentQueueIndex() const noexcept;
+
+	bool _TryPopJob(uint32_t queueIndex, _Job& job) noexcept;
+
+	// 在队列的锁内调用
+	void _OnJobPopped() noexcept;
+
+	void _ExecuteJob(_Job& job) noexcept;
+
+	std::vector<std::thread> _workers;
+	// 每个工作线程一个，最后一个是共享队列
+	std::unique_ptr<_WorkQueue[]> _queues;
+	uint32_t _queueCount = 0;
+
+	// 所有队列中的任务总数，可能暂时多于实际的数量，但不会少于
+	std::atomic<uint32_t> _pendingJobCount = 0;
+	// 每当有 Counter 归零时递增，等待线程在它上面睡眠。不能直接等待 Counter，因为它归零后
+	// 可能立即被销毁。
+	std::atomic<uint32_t> _completionEpoch = 0;
+	std::mutex _sleepMutex;
+	std::condition_variable _wakeCondition;
+	bool _isStopping = false;
+
+	std::atomic<uint64_t> _executedJobCount = 0;
+	std::atomic<uint64_t> _stolenJobCount = 0;
+};
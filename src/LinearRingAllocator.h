@@ -0,0 +1,145 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+
+// 按帧划分的环形线性分配策略，只管理偏移，不依赖 D3D12。每帧的分配在 FinishFrame 时和该帧
+// 的围栏值关联，围栏值完成后整帧的空间一起回收。
+class LinearRingAllocator {
+public:
+	static constexpr uint64_t INVALID_OFFSET = UINT64_MAX;
+
+	struct Stats {
+		// 上一帧使用的字节数，包括对齐和回绕浪费的空间
+		uint64_t lastFrameBytes = 0;
+		uint64_t maxFrameBytes = 0;
+		uint64_t wrapCount = 0;
+		// 空间不足需要等待 GPU 的次数，由调用者报告
+		uint64_t stallCount = 0;
+	};
+
+	LinearRingAllocator() = default;
+	LinearRingAllocator(const LinearRingAllocator&) = delete;
+	LinearRingAllocator(LinearRingAllocator&&) = default;
+	LinearRingAllocator& operator=(LinearRingAllocator&&) = default;
+
+	explicit LinearRingAllocator(uint64_t capacity) noexcept : _capacity(capacity) {}
+
+	uint64_t GetCapacity() const noexcept {
+		return _capacity;
+	}
+
+	uint64_t GetUsedSize() const noexcept {
+		return _usedSize;
+	}
+
+	// alignment 必须是 2 的幂。空间不足时返回 INVALID_OFFSET。
+	uint64_t Allocate(uint64_t size, uint64_t alignment) noexcept {
+		assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+		if (size == 0 || size > _capacity) {
+			return INVALID_OFFSET;
+		}
+
+		if (_usedSize == 0) {
+			// 环为空时从头开始，减少回绕
+			_head = 0;
+			_tail = 0;
+		}
+
+		const uint64_t offset = _AlignUp(_head, alignment);
+
+		if (_usedSize == 0 || _head > _tail) {
+			// 可用空间为 [head, capacity) 和 [0, tail)
+			if (offset + size <= _capacity) {
+				return _Commit(offset, size);
+			}
+
+			// 回绕到开头，浪费末尾的空间
+			if (_usedSize != 0 && size <= _tail) {
+				const uint64_t wasted = _capacity - _head;
+				_usedSize += wasted;
+				_curFrameBytes += wasted;
+				_head = 0;
+				++_stats.wrapCount;
+				return _Commit(0, size);
+			}
+
+			return INVALID_OFFSET;
+		} else {
+			// 可用空间为 [head, tail)
+			if (offset + size <= _tail) {
+				return _Commit(offset, size);
+			}
+
+			return INVALID_OFFSET;
+		}
+	}
+
+	// 将本帧的所有分配和 fenceValue 关联，fenceValue 必须单调递增
+	void FinishFrame(uint64_t fenceValue) noexcept {
+		assert(_frames.empty() || _frames.back().fenceValue < fenceValue);
+
+		if (_curFrameBytes > 0) {
+			_frames.push_back({ fenceValue, _head, _curFrameBytes });
+		}
+
+		_stats.lastFrameBytes = _curFrameBytes;
+		_stats.maxFrameBytes = std::max(_stats.maxFrameBytes, _curFrameBytes);
+		_curFrameBytes = 0;
+	}
+
+	// 回收围栏值已完成的帧
+	void ReleaseCompleted(uint64_t completedFenceValue) noexcept {
+		while (!_frames.empty() && _frames.front().fenceValue <= completedFenceValue) {
+			_tail = _frames.front().endOffset;
+			_usedSize -= _frames.front().size;
+			_frames.pop_front();
+		}
+	}
+
+	// 最早的未回收帧的围栏值，没有则返回 0。空间不足时调用者应等待它完成。
+	uint64_t GetOldestFenceValue() const noexcept {
+		return _frames.empty() ? 0 : _frames.front().fenceValue;
+	}
+
+	void OnStall() noexcept {
+		++_stats.stallCount;
+	}
+
+	const Stats& GetStats() const noexcept {
+		return _stats;
+	}
+
+private:
+	static uint64_t _AlignUp(uint64_t value, uint64_t alignment) noexcept {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	uint64_t _Commit(uint64_t offset, uint64_t size) noexcept {
+		const uint64_t consumed = offset + size - _head;
+		_usedSize += consumed;
+		_curFrameBytes += consumed;
+		_head = offset + size;
+		if (_head == _capacity) {
+			_head = 0;
+		}
+		return offset;
+	}
+
+	struct _Frame {
+		uint64_t fenceValue;
+		// 这一帧结束时的 head，回收后成为新的 tail
+		uint64_t endOffset;
+		uint64_t size;
+	};
+
+	uint64_t _capacity = 0;
+	uint64_t _head = 0;
+	uint64_t _tail = 0;
+	uint64_t _usedSize = 0;
+	uint64_t _curFrameBytes = 0;
+	std::deque<_Frame> _frames;
+	Stats _stats;
+};
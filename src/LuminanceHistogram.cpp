@@ -0,0 +1,107 @@
+#include "pch.h"
+#include "LuminanceHistogram.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+// BT.709 原色的亮度，和 ColorLut 相同
+static constexpr float LUMINANCE_R = 0.212639f;
+static constexpr float LUMINANCE_G = 0.715169f;
+static constexpr float LUMINANCE_B = 0.0721923f;
+
+// 去掉最暗和最亮的像素后计算平均亮度，避免小面积的黑色或高光左右曝光
+static constexpr float AVERAGE_LOW_PERCENTILE = 0.1f;
+static constexpr float AVERAGE_HIGH_PERCENTILE = 0.9f;
+static constexpr float HIGHLIGHT_PERCENTILE = 0.99f;
+
+// 平均亮度的目标，为 SDR 白的一半
+static constexpr float KEY_LUMINANCE = 0.5f;
+static constexpr float MIN_EXPOSURE = 0.25f;
+static constexpr float MAX_EXPOSURE = 4.0f;
+
+// 指数平滑的时间常数，单位为秒
+static constexpr float DARKEN_TIME_CONSTANT = 0.25f;
+static constexpr float BRIGHTEN_TIME_CONSTANT = 1.0f;
+
+// float 的低 19 位尾数被丢弃
+static constexpr uint32_t MANTISSA_SHIFT = 23 - std::countr_zero(LuminanceHistogram::BINS_PER_OCTAVE);
+static_assert(std::has_single_bit(LuminanceHistogram::BINS_PER_OCTAVE));
+// 2^MIN_LOG2_LUMINANCE 的位模式右移 MANTISSA_SHIFT 位
+static constexpr int32_t FIRST_BIN_BITS = (127 + LuminanceHistogram::MIN_LOG2_LUMINANCE) *
+	(int32_t)LuminanceHistogram::BINS_PER_OCTAVE;
+
+uint32_t LuminanceHistogram::GetBin(float luminance) noexcept {
+	// 也排除了 NaN
+	if (!(luminance > 0)) {
+		return 0;
+	}
+
+	const int32_t bin = (int32_t)(std::bit_cast<uint32_t>(luminance) >> MANTISSA_SHIFT) - FIRST_BIN_BITS;
+	return (uint32_t)std::clamp(bin, 0, (int32_t)BIN_COUNT - 1);
+}
+
+float LuminanceHistogram::GetBinLuminance(uint32_t bin) noexcept {
+	const int32_t exponent = MIN_LOG2_LUMINANCE + (int32_t)(bin / BINS_PER_OCTAVE);
+	const float mantissa = 1.0f + ((bin % BINS_PER_OCTAVE) + 0.5f) / BINS_PER_OCTAVE;
+	return std::ldexp(mantissa, exponent);
+}
+
+void LuminanceHistogram::Build(const float* const src[3], size_t count, Bins& bins) noexcept {
+	for (size_t i = 0; i < count; ++i) {
+		// 系数和 shaders/LuminanceHistogram_CS.hlsl 相同，舍入可能不同
+		const float luminance = src[0][i] * LUMINANCE_R + src[1][i] * LUMINANCE_G + src[2][i] * LUMINANCE_B;
+		++bins[GetBin(luminance)];
+	}
+}
+
+bool LuminanceHistogram::Analyze(const Bins& bins, Stats& stats) noexcept {
+	uint64_t totalCount = 0;
+	for (uint32_t count : bins) {
+		totalCount += count;
+	}
+	if (totalCount == 0) {
+		return false;
+	}
+
+	const double lowCount = totalCount * (double)AVERAGE_LOW_PERCENTILE;
+	const double highCount = totalCount * (double)AVERAGE_HIGH_PERCENTILE;
+	const double highlightCount = totalCount * (double)HIGHLIGHT_PERCENTILE;
+
+	double log2Sum = 0;
+	double weightSum = 0;
+	uint32_t highlightBin = UINT32_MAX;
+	uint64_t cumulativeCount = 0;
+	for (uint32_t i = 0; i < BIN_COUNT; ++i) {
+		const double begin = (double)cumulativeCount;
+		cumulativeCount += bins[i];
+		const double end = (double)cumulativeCount;
+
+		// 桶中落在 [lowCount, highCount) 中的部分参与平均
+		const double weight = std::min(end, highCount) - std::max(begin, lowCount);
+		if (weight > 0) {
+			log2Sum += std::log2((double)GetBinLuminance(i)) * weight;
+			weightSum += weight;
+		}
+
+		if (end > highlightCount && highlightBin == UINT32_MAX) {
+			highlightBin = i;
+		}
+	}
+
+	stats.averageLuminance = (float)std::exp2(log2Sum / weightSum);
+	stats.highlightLuminance = GetBinLuminance(highlightBin);
+	return true;
+}
+
+float LuminanceHistogram::ComputeExposure(const Stats& stats, float headroom) noexcept {
+	float exposure = KEY_LUMINANCE / stats.averageLuminance;
+	// SDR 下 headroom 为 1
+	exposure = std::min(exposure, std::max(headroom, 1.0f) / stats.highlightLuminance);
+	return std::clamp(exposure, MIN_EXPOSURE, MAX_EXPOSURE);
+}
+
+float LuminanceHistogram::SmoothExposure(float current, float target, float deltaTime) noexcept {
+	const float timeConstant = target < current ? DARKEN_TIME_CONSTANT : BRIGHTEN_TIME_CONSTANT;
+	const float t = 1.0f - std::exp(-deltaTime / timeConstant);
+	return std::exp2(std::lerp(std::log2(current), std::log2(target), t));
+}
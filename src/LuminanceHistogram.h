@@ -0,0 +1,46 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// 场景亮度的直方图和由它得到的曝光，用于自动曝光。亮度的单位和 scRGB 相同，1.0 为 SDR 白。
+// 直方图由 shaders/LuminanceHistogram_CS.hlsl 在 GPU 上生成，Build 是 CPU 上的参考实现，两者的
+// 分桶只使用整数运算，结果只在亮度的舍入不同时有差别。不依赖 D3D12。
+struct LuminanceHistogram {
+	// [2^MIN_LOG2_LUMINANCE, 2^MAX_LOG2_LUMINANCE) 中每个 2 的幂区间等分为 BINS_PER_OCTAVE 份，
+	// 即取 float 的指数和尾数的高 4 位。第 0 个桶还包括所有更低的亮度以及负值和 NaN，最后一个桶
+	// 还包括所有更高的亮度。
+	static constexpr uint32_t BINS_PER_OCTAVE = 16;
+	static constexpr int32_t MIN_LOG2_LUMINANCE = -8;
+	static constexpr int32_t MAX_LOG2_LUMINANCE = 8;
+	static constexpr uint32_t BIN_COUNT = BINS_PER_OCTAVE * (MAX_LOG2_LUMINANCE - MIN_LOG2_LUMINANCE);
+
+	using Bins = std::array<uint32_t, BIN_COUNT>;
+
+	// 由直方图得到的统计数据，亮度都取桶的中点
+	struct Stats {
+		// 去掉最暗和最亮的部分后亮度的几何平均
+		float averageLuminance;
+		// HIGHLIGHT_PERCENTILE 处的亮度
+		float highlightLuminance;
+	};
+
+	// 和 shaders/LuminanceHistogram_CS.hlsl 一致
+	static uint32_t GetBin(float luminance) noexcept;
+
+	// 桶中点的亮度
+	static float GetBinLuminance(uint32_t bin) noexcept;
+
+	// CPU 上的参考实现，RGB 为 scRGB 并按通道分开存储，结果累加到 bins
+	static void Build(const float* const src[3], size_t count, Bins& bins) noexcept;
+
+	// 直方图为空时返回 false
+	static bool Analyze(const Bins& bins, Stats& stats) noexcept;
+
+	// 使平均亮度接近 KEY_LUMINANCE，同时高光不超过显示器的 headroom，即最大亮度和 SDR 白的比值。
+	// 剩余超出的部分由 ColorLut 的色调映射压缩。
+	static float ComputeExposure(const Stats& stats, float headroom) noexcept;
+
+	// 在 log2 空间指数平滑，变暗比变亮更快。deltaTime 单位为秒。
+	static float SmoothExposure(float current, float target, float deltaTime) noexcept;
+};
@@ -2,7 +2,7 @@
 #include "MainWindow.h"
 #include <Uxtheme.h>
 
-bool MainWindow::Create() noexcept {
+bool MainWindow::Create(const Renderer::Options& rendererOptions, const Benchmark::Options* benchmarkOptions) noexcept {
 	static const wchar_t* MAIN_WINDOW_CLASS_NAME = L"D3D12Playground_Main";
 
 	const HINSTANCE hInst = wil::GetModuleInstanceHandle();
@@ -20,11 +20,15 @@ bool MainWindow::Create() noexcept {
 		return false;
 	}
 
+	_isBenchmark = benchmarkOptions != nullptr;
+	// 基准测试时不能调整大小和最大化
+	const DWORD style = _isBenchmark ? (WS_OVERLAPPEDWINDOW & ~(WS_THICKFRAME | WS_MAXIMIZEBOX)) : WS_OVERLAPPEDWINDOW;
+
 	CreateWindowEx(
 		WS_EX_NOREDIRECTIONBITMAP,
 		MAIN_WINDOW_CLASS_NAME,
 		nullptr,
-		WS_OVERLAPPEDWINDOW,
+		style,
 		CW_USEDEFAULT,
 		CW_USEDEFAULT,
 		CW_USEDEFAULT,
@@ -38,49 +42,51 @@ bool MainWindow::Create() noexcept {
 		return false;
 	}
 
-	const long clientWidth = std::lroundf(_dpiScale * 900);
-	const long clientHeight = std::lroundf(_dpiScale * 600);
+	// 基准测试的结果应和 DPI 无关，尺寸以像素为单位，场景也不缩放
+	const long clientWidth = _isBenchmark ? (long)benchmarkOptions->width : std::lroundf(_dpiScale * 900);
+	const long clientHeight = _isBenchmark ? (long)benchmarkOptions->height : std::lroundf(_dpiScale * 600);
 	{
 		RECT windowRect{ 0,0,clientWidth,clientHeight };
-		AdjustWindowRectExForDpi(&windowRect, WS_OVERLAPPEDWINDOW, FALSE, 0,
+		AdjustWindowRectExForDpi(&windowRect, style, FALSE, 0,
 			(UINT)std::lroundf(_dpiScale * USER_DEFAULT_SCREEN_DPI));
-		SetWindowPos(Handle(), NULL, 0, 0, windowRect.right - windowRect.left, windowRect.bottom - windowRect.top,
+		const SIZE windowSize = { windowRect.right - windowRect.left, windowRect.bottom - windowRect.top };
+		if (_isBenchmark) {
+			_benchmarkWindowSize = windowSize;
+		}
+		SetWindowPos(Handle(), NULL, 0, 0, windowSize.cx, windowSize.cy,
 			SWP_NOACTIVATE | SWP_NOMOVE | SWP_NOZORDER);
 	}
 
-	_renderer.emplace();
-	if (!_renderer->Initialize(Handle(), Size{ (uint32_t)clientWidth, (uint32_t)clientHeight }, _dpiScale)) {
-		return false;
+	// 基准测试的结果只有在指定的尺寸下才有意义
+	if (_isBenchmark) {
+		RECT clientRect;
+		if (!GetClientRect(Handle(), &clientRect) ||
+			clientRect.right != clientWidth || clientRect.bottom != clientHeight) {
+			return false;
+		}
 	}
 
-	if (!_Render()) {
+	_rendererSize = Size{ (uint32_t)clientWidth, (uint32_t)clientHeight };
+	if (!_renderThread.Start(Handle(), _rendererSize, _isBenchmark ? 1.0f : _dpiScale,
+		rendererOptions, benchmarkOptions)) {
 		return false;
 	}
+	_isRenderThreadStarted = true;
 
 	ShowWindow(Handle(), SW_SHOWNORMAL);
 	return true;
 }
 
 int MainWindow::MessageLoop() noexcept {
+	// 渲染在独立线程中进行，这里只需处理消息
 	MSG msg;
-	while (true) {
-		while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
-			if (msg.message == WM_QUIT) {
-				Destroy();
-				return (int)msg.wParam;
-			}
-
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
-		}
-
-		// 最小化时暂停渲染
-		if (_isMinimized) {
-			WaitMessage();
-		}else if (!_Render()) {
-			PostQuitMessage(1);
-		}
+	while (GetMessage(&msg, nullptr, 0, 0)) {
+		TranslateMessage(&msg);
+		DispatchMessage(&msg);
 	}
+
+	Destroy();
+	return (int)msg.wParam;
 }
 
 LRESULT MainWindow::_MessageHandler(UINT msg, WPARAM wParam, LPARAM lParam) noexcept {
@@ -98,6 +104,15 @@ LRESULT MainWindow::_MessageHandler(UINT msg, WPARAM wParam, LPARAM lParam) noex
 	{
 		_dpiScale = HIWORD(wParam) / float(USER_DEFAULT_SCREEN_DPI);
 
+		// 基准测试时保持客户区尺寸
+		if (_isBenchmark) {
+			return 0;
+		}
+
+		if (_isRenderThreadStarted) {
+			_renderThread.OnDpiChanged(_dpiScale);
+		}
+
 		RECT* newRect = (RECT*)lParam;
 		SetWindowPos(
 			Handle(),
@@ -113,6 +128,15 @@ LRESULT MainWindow::_MessageHandler(UINT msg, WPARAM wParam, LPARAM lParam) noex
 	}
 	case WM_GETMINMAXINFO:
 	{
+		// 基准测试使用指定的尺寸。默认的最大尺寸只比屏幕略大，更大的窗口会被截断，使客户区和
+		// _rendererSize 不一致。
+		if (_isBenchmark) {
+			MINMAXINFO& info = *(MINMAXINFO*)lParam;
+			info.ptMaxTrackSize.x = std::max(info.ptMaxTrackSize.x, _benchmarkWindowSize.cx);
+			info.ptMaxTrackSize.y = std::max(info.ptMaxTrackSize.y, _benchmarkWindowSize.cy);
+			return 0;
+		}
+
 		// 设置窗口最小尺寸
 		const long minClientSize = std::lroundf(400 * _dpiScale);
 		RECT windowRect{ 0,0,minClientSize,minClientSize };
@@ -140,9 +164,14 @@ LRESULT MainWindow::_MessageHandler(UINT msg, WPARAM wParam, LPARAM lParam) noex
 			}
 		}
 
+		const bool wasMinimized = _isMinimized;
 		_isMinimized = IsIconic(Handle());
 
-		if (_renderer) {
+		if (_isRenderThreadStarted) {
+			if (_isMinimized != wasMinimized) {
+				_renderThread.OnMinimizedChanged(_isMinimized);
+			}
+
 			NCCALCSIZE_PARAMS& params = *(NCCALCSIZE_PARAMS*)lParam;
 			// 第一个成员是新客户区边界矩形
 			const RECT& clientRect = params.rgrc[0];
@@ -152,9 +181,10 @@ LRESULT MainWindow::_MessageHandler(UINT msg, WPARAM wParam, LPARAM lParam) noex
 					uint32_t(clientRect.bottom - clientRect.top)
 				};
 
-				if (clientSize != _renderer->GetSize()) {
-					_renderer->OnResized(clientSize, _dpiScale);
-					_renderer->Render();
+				if (clientSize != _rendererSize) {
+					_rendererSize = clientSize;
+					// 等待渲染线程提交新尺寸的帧
+					_renderThread.OnResized(clientSize, _dpiScale);
 				}
 			}
 		}
@@ -163,8 +193,8 @@ LRESULT MainWindow::_MessageHandler(UINT msg, WPARAM wParam, LPARAM lParam) noex
 	}
 	case WM_WINDOWPOSCHANGED:
 	{
-		if (_renderer) {
-			_renderer->OnMsgWindowPosChanged();
+		if (_isRenderThreadStarted) {
+			_renderThread.OnMsgWindowPosChanged();
 		}
 
 		return 0;
@@ -180,8 +210,8 @@ LRESULT MainWindow::_MessageHandler(UINT msg, WPARAM wParam, LPARAM lParam) noex
 		if (_isPreparingForResize) {
 			_isResizing = true;
 
-			if (_renderer) {
-				_renderer->OnResizeStarted();
+			if (_isRenderThreadStarted) {
+				_renderThread.OnResizeStarted();
 			}
 		}
 
@@ -192,8 +222,8 @@ LRESULT MainWindow::_MessageHandler(UINT msg, WPARAM wParam, LPARAM lParam) noex
 		if (_isResizing) {
 			_isResizing = false;
 
-			if (_renderer) {
-				_renderer->OnResizeEnded();
+			if (_isRenderThreadStarted) {
+				_renderThread.OnResizeEnded();
 			}
 		}
 
@@ -201,8 +231,8 @@ LRESULT MainWindow::_MessageHandler(UINT msg, WPARAM wParam, LPARAM lParam) noex
 	}
 	case WM_DISPLAYCHANGE:
 	{
-		if (_renderer) {
-			_renderer->OnMsgDisplayChanged();
+		if (_isRenderThreadStarted) {
+			_renderThread.OnMsgDisplayChanged();
 		}
 
 		return 0;
@@ -210,7 +240,7 @@ LRESULT MainWindow::_MessageHandler(UINT msg, WPARAM wParam, LPARAM lParam) noex
 	case WM_KEYDOWN:
 	{
 		// 过滤长按按键产生的重复消息
-		if (wParam == 'F' && !(HIWORD(lParam) & KF_REPEAT)) {
+		if (wParam == 'F' && !(HIWORD(lParam) & KF_REPEAT) && !_isBenchmark) {
 			if (_isFullscreen) {
 				// 还原
 				_isFullscreen = false;
@@ -246,8 +276,20 @@ LRESULT MainWindow::_MessageHandler(UINT msg, WPARAM wParam, LPARAM lParam) noex
 
 		return 0;
 	}
+	case RenderThread::WM_RENDER_FAILED:
+	case RenderThread::WM_BENCHMARK_COMPLETED:
+	{
+		PostQuitMessage((int)wParam);
+		return 0;
+	}
 	case WM_DESTROY:
 	{
+		// 交换链销毁前窗口必须存在
+		if (_isRenderThreadStarted) {
+			_isRenderThreadStarted = false;
+			_renderThread.Stop();
+		}
+
 		PostQuitMessage(0);
 		break;
 	}
@@ -255,29 +297,3 @@ LRESULT MainWindow::_MessageHandler(UINT msg, WPARAM wParam, LPARAM lParam) noex
 
 	return base_type::_MessageHandler(msg, wParam, lParam);
 }
-
-bool MainWindow::_Render() noexcept {
-	ComponentState state = _renderer->Render();
-
-	if (state == ComponentState::NoError) {
-		return true;
-	} else if (state == ComponentState::DeviceLost) {
-		// 设备丢失重新创建 Renderer
-		_renderer.emplace();
-
-		RECT clientRect;
-		GetClientRect(Handle(), &clientRect);
-		Size clientSize = {
-			uint32_t(clientRect.right - clientRect.left),
-			uint32_t(clientRect.bottom - clientRect.top)
-		};
-		if (!_renderer->Initialize(Handle(), clientSize, _dpiScale)) {
-			return false;
-		}
-
-		// 如果设备再次丢失不再尝试恢复
-		return _renderer->Render() == ComponentState::NoError;
-	} else {
-		return false;
-	}
-}
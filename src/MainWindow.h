@@ -1,5 +1,5 @@
 #pragma once
-#include "Renderer.h"
+#include "RenderThread.h"
 #include "WindowBase.h"
 
 class MainWindow : public WindowBaseT<MainWindow> {
@@ -7,7 +7,8 @@ class MainWindow : public WindowBaseT<MainWindow> {
 	friend base_type;
 
 public:
-	bool Create() noexcept;
+	// benchmarkOptions 不为空时窗口的客户区尺寸固定，不能调整大小和全屏，也不随 DPI 缩放
+	bool Create(const Renderer::Options& rendererOptions, const Benchmark::Options* benchmarkOptions = nullptr) noexcept;
 
 	int MessageLoop() noexcept;
 
@@ -15,9 +16,10 @@ protected:
 	LRESULT _MessageHandler(UINT msg, WPARAM wParam, LPARAM lParam) noexcept;
 
 private:
-	bool _Render() noexcept;
-
-	std::optional<Renderer> _renderer;
+	RenderThread _renderThread;
+	// 最后一次通知渲染线程的尺寸
+	Size _rendererSize{};
+	bool _isRenderThreadStarted = false;
 
 	RECT _windowedRect{};
 
@@ -27,4 +29,7 @@ private:
 	bool _isResizing = false;
 	bool _isFullscreen = false;
 	bool _isMinimized = false;
+	bool _isBenchmark = false;
+	// 基准测试时窗口的尺寸，可能超过屏幕，见 WM_GETMINMAXINFO
+	SIZE _benchmarkWindowSize{};
 };
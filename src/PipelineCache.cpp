@@ -0,0 +1,208 @@
+#include "pch.h"
+#include "PipelineCache.h"
+#include "PipelineCacheKey.h"
+#include "Win32Helper.h"
+#include <array>
+
+// 库无法删除不再使用的 PSO，文件超过这个大小时丢弃，从空的库开始
+static constexpr uint64_t MAX_FILE_SIZE = 64 * 1024 * 1024;
+
+// 库中 PSO 的名字为键的十六进制表示
+static std::array<wchar_t, 17> GetPipelineName(uint64_t key) noexcept {
+	std::array<wchar_t, 17> name;
+	swprintf_s(name.data(), name.size(), L"%016llX", key);
+	return name;
+}
+
+void PipelineCache::Initialize(
+	ID3D12Device5* device,
+	D3D_ROOT_SIGNATURE_VERSION rootSignatureVersion,
+	const PipelineCacheFile::AdapterIdentity& adapter,
+	std::filesystem::path path
+) noexcept {
+	_device = device;
+	_rootSignatureVersion = rootSignatureVersion;
+	_adapter = adapter;
+	_path = std::move(path);
+
+	if (Win32Helper::ReadFileData(_path, MAX_FILE_SIZE, _fileData)) {
+		const std::span<const uint8_t> library = PipelineCacheFile::Read(_fileData, adapter);
+		// 文件头匹配时驱动仍可能拒绝，比如 D3D12_ERROR_DRIVER_VERSION_MISMATCH，此时从空的库开始
+		if (!library.empty() && SUCCEEDED(device->CreatePipelineLibrary(
+			library.data(), library.size(), IID_PPV_ARGS(&_library)))) {
+			_stats.isLibraryLoaded = true;
+			return;
+		}
+	}
+
+	_fileData.clear();
+
+	// 一些驱动和调试工具不支持 ID3D12PipelineLibrary，此时只使用内存中的缓存
+	if (FAILED(device->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&_library)))) {
+		_library = nullptr;
+	}
+}
+
+HRESULT PipelineCache::CreateRootSignature(
+	const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc,
+	winrt::com_ptr<ID3D12RootSignature>& rootSignature
+) noexcept {
+	const uint64_t key = PipelineCacheKey::HashRootSignatureDesc(desc);
+
+	// 创建根签名很快，整个过程都持有锁
+	std::lock_guard lock(_mutex);
+
+	if (key != 0) {
+		auto it = _rootSignatures.find(key);
+		if (it != _rootSignatures.end()) {
+			rootSignature = it->second;
+			return S_OK;
+		}
+	}
+
+	winrt::com_ptr<ID3DBlob> signature;
+	HRESULT hr = D3DX12SerializeVersionedRootSignature(&desc, _rootSignatureVersion, signature.put(), nullptr);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	hr = _device->CreateRootSignature(
+		0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&rootSignature));
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	if (key != 0) {
+		// 缓存持有根签名，因此指针不会被复用
+		_rootSignatures.emplace(key, rootSignature);
+		_rootSignatureHashes.emplace(rootSignature.get(), key);
+	}
+
+	return S_OK;
+}
+
+template <typename LoadFunc, typename CreateFunc>
+HRESULT PipelineCache::_GetOrCreatePipelineState(
+	uint64_t key,
+	LoadFunc&& load,
+	CreateFunc&& create,
+	winrt::com_ptr<ID3D12PipelineState>& pipelineState
+) noexcept {
+	const std::array<wchar_t, 17> name = GetPipelineName(key);
+
+	{
+		std::lock_guard lock(_mutex);
+
+		auto it = _pipelineStates.find(key);
+		if (it != _pipelineStates.end()) {
+			pipelineState = it->second;
+			++_stats.memoryHitCount;
+			return S_OK;
+		}
+
+		// 从库中加载远快于编译，因此在锁内进行。库中没有这个名字或者描述不匹配时返回 E_INVALIDARG
+		if (_library && SUCCEEDED(load(name.data()))) {
+			++_stats.libraryHitCount;
+			_pipelineStates.emplace(key, pipelineState);
+			return S_OK;
+		}
+	}
+
+	HRESULT hr = create();
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	std::lock_guard lock(_mutex);
+
+	++_stats.missCount;
+
+	// 其他线程可能同时创建了相同的 PSO，使用先完成的
+	auto [it, inserted] = _pipelineStates.emplace(key, pipelineState);
+	if (!inserted) {
+		pipelineState = it->second;
+		return S_OK;
+	}
+
+	// 名字已存在时失败，说明哈希冲突，不覆盖已有的 PSO
+	if (_library && SUCCEEDED(_library->StorePipeline(name.data(), pipelineState.get()))) {
+		_isLibraryDirty = true;
+	}
+
+	return S_OK;
+}
+
+HRESULT PipelineCache::CreateGraphicsPipelineState(
+	const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+	winrt::com_ptr<ID3D12PipelineState>& pipelineState
+) noexcept {
+	const uint64_t rootSignatureHash = _GetRootSignatureHash(desc.pRootSignature);
+	if (rootSignatureHash == 0) {
+		// 无法计算键
+		return _device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+	}
+
+	return _GetOrCreatePipelineState(
+		PipelineCacheKey::HashGraphicsPipelineDesc(desc, rootSignatureHash),
+		[&](const wchar_t* name) {
+			return _library->LoadGraphicsPipeline(name, &desc, IID_PPV_ARGS(&pipelineState));
+		},
+		[&]() {
+			return _device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+		},
+		pipelineState
+	);
+}
+
+HRESULT PipelineCache::CreateComputePipelineState(
+	const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc,
+	winrt::com_ptr<ID3D12PipelineState>& pipelineState
+) noexcept {
+	const uint64_t rootSignatureHash = _GetRootSignatureHash(desc.pRootSignature);
+	if (rootSignatureHash == 0) {
+		return _device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+	}
+
+	return _GetOrCreatePipelineState(
+		PipelineCacheKey::HashComputePipelineDesc(desc, rootSignatureHash),
+		[&](const wchar_t* name) {
+			return _library->LoadComputePipeline(name, &desc, IID_PPV_ARGS(&pipelineState));
+		},
+		[&]() {
+			return _device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+		},
+		pipelineState
+	);
+}
+
+HRESULT PipelineCache::Save() noexcept {
+	std::lock_guard lock(_mutex);
+
+	if (!_library || !_isLibraryDirty) {
+		return S_OK;
+	}
+
+	const SIZE_T librarySize = _library->GetSerializedSize();
+	std::vector<uint8_t> data(PipelineCacheFile::GetFileSize(librarySize));
+
+	HRESULT hr = _library->Serialize(PipelineCacheFile::GetLibrary(data).data(), librarySize);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	PipelineCacheFile::WriteHeader(_adapter, data);
+
+	hr = Win32Helper::WriteFileData(_path, data);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	_isLibraryDirty = false;
+	return S_OK;
+}
+
+uint64_t PipelineCache::_GetRootSignatureHash(ID3D12RootSignature* rootSignature) const noexcept {
+	std::lock_guard lock(_mutex);
+	auto it = _rootSignatureHashes.find(rootSignature);
+	return it == _rootSignatureHashes.end() ? 0 : it->second;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "PipelineCacheFile.h"
+#include <mutex>
+#include <unordered_map>
+
+// 根签名和 PSO 的缓存，键为描述和着色器字节码的哈希。内存中的缓存使切换颜色模式时无需
+// 重新创建；PSO 同时存入 ID3D12PipelineLibrary 并持久化到文件，下次启动或设备丢失后重建时
+// 直接加载，不必让驱动重新编译。缓存属于设备，设备重建时也要重建。
+//
+// 可以在多个线程同时调用，PSO 的编译在锁外进行。
+class PipelineCache {
+public:
+	// PSO 的统计数据
+	struct Stats {
+		// 命中内存中的缓存
+		uint32_t memoryHitCount = 0;
+		// 从 ID3D12PipelineLibrary 加载
+		uint32_t libraryHitCount = 0;
+		uint32_t missCount = 0;
+		// 启动时从文件加载了有效的库
+		bool isLibraryLoaded = false;
+	};
+
+	PipelineCache() = default;
+	PipelineCache(const PipelineCache&) = delete;
+	PipelineCache(PipelineCache&&) = delete;
+
+	// 文件无效或不支持 ID3D12PipelineLibrary 时只使用内存中的缓存
+	void Initialize(
+		ID3D12Device5* device,
+		D3D_ROOT_SIGNATURE_VERSION rootSignatureVersion,
+		const PipelineCacheFile::AdapterIdentity& adapter,
+		std::filesystem::path path
+	) noexcept;
+
+	// 只有通过这里创建的根签名才能用于缓存 PSO
+	HRESULT CreateRootSignature(
+		const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc,
+		winrt::com_ptr<ID3D12RootSignature>& rootSignature
+	) noexcept;
+
+	HRESULT CreateGraphicsPipelineState(
+		const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+		winrt::com_ptr<ID3D12PipelineState>& pipelineState
+	) noexcept;
+
+	HRESULT CreateComputePipelineState(
+		const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc,
+		winrt::com_ptr<ID3D12PipelineState>& pipelineState
+	) noexcept;
+
+	// 库中有新的 PSO 时写入文件
+	HRESULT Save() noexcept;
+
+	Stats GetStats() const noexcept {
+		std::lock_guard lock(_mutex);
+		return _stats;
+	}
+
+private:
+	// 在内存和库中查找，都没有时在锁外调用 create 创建并存入库
+	template <typename LoadFunc, typename CreateFunc>
+	HRESULT _GetOrCreatePipelineState(
+		uint64_t key,
+		LoadFunc&& load,
+		CreateFunc&& create,
+		winrt::com_ptr<ID3D12PipelineState>& pipelineState
+	) noexcept;
+
+	uint64_t _GetRootSignatureHash(ID3D12RootSignature* rootSignature) const noexcept;
+
+	// 保护下面所有可变的成员
+	mutable std::mutex _mutex;
+
+	ID3D12Device5* _device = nullptr;
+	D3D_ROOT_SIGNATURE_VERSION _rootSignatureVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
+	PipelineCacheFile::AdapterIdentity _adapter;
+	std::filesystem::path _path;
+
+	// 为空时只使用内存中的缓存
+	winrt::com_ptr<ID3D12PipelineLibrary> _library;
+	// 库直接引用文件数据，必须和库的生命周期相同
+	std::vector<uint8_t> _fileData;
+	bool _isLibraryDirty = false;
+
+	std::unordered_map<uint64_t, winrt::com_ptr<ID3D12RootSignature>> _rootSignatures;
+	// 根签名到描述哈希的映射，用于计算 PSO 的键
+	std::unordered_map<ID3D12RootSignature*, uint64_t> _rootSignatureHashes;
+	std::unordered_map<uint64_t, winrt::com_ptr<ID3D12PipelineState>> _pipelineStates;
+
+	Stats _stats;
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include "Hasher.h"
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+// 管线缓存文件的格式：文件头之后是 ID3D12PipelineLibrary 序列化的数据。文件头记录显卡和
+// 驱动版本，任一改变时缓存失效。只处理字节，不依赖 D3D12。
+struct PipelineCacheFile {
+	struct AdapterIdentity {
+		uint32_t vendorId = 0;
+		uint32_t deviceId = 0;
+		uint32_t subSysId = 0;
+		uint32_t revision = 0;
+		// 用户模式驱动的版本
+		uint64_t driverVersion = 0;
+
+		bool operator==(const AdapterIdentity&) const noexcept = default;
+	};
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		AdapterIdentity adapter;
+		uint64_t librarySize;
+		// 检测文件损坏，驱动不一定会检查库数据是否完整
+		uint64_t libraryHash;
+	};
+	// 没有填充字节，文件内容是确定的
+	static_assert(sizeof(Header) == 48);
+
+	// "PLC0"
+	static constexpr uint32_t MAGIC = 0x30434C50;
+	// 格式改变时递增
+	static constexpr uint32_t VERSION = 1;
+	static constexpr size_t HEADER_SIZE = sizeof(Header);
+
+	static size_t GetFileSize(size_t librarySize) noexcept {
+		return HEADER_SIZE + librarySize;
+	}
+
+	// 库数据的位置，调用者在这里写入序列化的数据之后调用 WriteHeader
+	static std::span<uint8_t> GetLibrary(std::span<uint8_t> data) noexcept {
+		assert(data.size() >= HEADER_SIZE);
+		return data.subspan(HEADER_SIZE);
+	}
+
+	static void WriteHeader(const AdapterIdentity& adapter, std::span<uint8_t> data) noexcept {
+		const std::span<uint8_t> library = GetLibrary(data);
+
+		const Header header = {
+			.magic = MAGIC,
+			.version = VERSION,
+			.adapter = adapter,
+			.librarySize = library.size(),
+			.libraryHash = Hasher::Hash(library.data(), library.size())
+		};
+		std::memcpy(data.data(), &header, sizeof(header));
+	}
+
+	// 返回文件中的库数据，文件无效或者显卡、驱动版本不匹配时返回空
+	static std::span<const uint8_t> Read(std::span<const uint8_t> data, const AdapterIdentity& adapter) noexcept {
+		if (data.size() < HEADER_SIZE) {
+			return {};
+		}
+
+		// 文件数据不一定对齐
+		Header header;
+		std::memcpy(&header, data.data(), sizeof(header));
+
+		if (header.magic != MAGIC || header.version != VERSION || header.adapter != adapter) {
+			return {};
+		}
+
+		const std::span<const uint8_t> library = data.subspan(HEADER_SIZE);
+		if (header.librarySize != library.size() ||
+			header.libraryHash != Hasher::Hash(library.data(), library.size())) {
+			return {};
+		}
+
+		return library;
+	}
+};
@@ -0,0 +1,156 @@
+#pragma once
+#include "Hasher.h"
+
+// 根签名和 PSO 描述的哈希，用作管线缓存的键。逐个成员计算以跳过指针和填充字节。需要 D3D12
+// 的类型定义，因此只能在 Windows 上构建，哈希本身由 Hasher 计算。
+struct PipelineCacheKey {
+	// 只支持 1.1 版本的描述，其他版本返回 0，表示不缓存
+	static uint64_t HashRootSignatureDesc(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc) noexcept {
+		if (desc.Version != D3D_ROOT_SIGNATURE_VERSION_1_1) {
+			return 0;
+		}
+
+		const D3D12_ROOT_SIGNATURE_DESC1& desc1 = desc.Desc_1_1;
+
+		Hasher hasher;
+		hasher.Add(desc1.NumParameters);
+		for (UINT i = 0; i < desc1.NumParameters; ++i) {
+			const D3D12_ROOT_PARAMETER1& param = desc1.pParameters[i];
+			hasher.Add(param.ParameterType);
+			hasher.Add(param.ShaderVisibility);
+
+			switch (param.ParameterType) {
+			case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+				hasher.Add(param.DescriptorTable.NumDescriptorRanges);
+				// D3D12_DESCRIPTOR_RANGE1 的成员都是 4 字节
+				hasher.AddBytes(param.DescriptorTable.pDescriptorRanges,
+					sizeof(D3D12_DESCRIPTOR_RANGE1) * param.DescriptorTable.NumDescriptorRanges);
+				break;
+			case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+				hasher.Add(param.Constants);
+				break;
+			default:
+				hasher.Add(param.Descriptor);
+				break;
+			}
+		}
+
+		// D3D12_STATIC_SAMPLER_DESC 的成员都是 4 字节
+		hasher.Add(desc1.NumStaticSamplers);
+		hasher.AddBytes(desc1.pStaticSamplers, sizeof(D3D12_STATIC_SAMPLER_DESC) * desc1.NumStaticSamplers);
+		hasher.Add(desc1.Flags);
+
+		// 避免和表示不缓存的 0 冲突
+		return hasher.GetHash() | 1;
+	}
+
+	// rootSignatureHash 为 HashRootSignatureDesc 的结果
+	static uint64_t HashGraphicsPipelineDesc(
+		const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+		uint64_t rootSignatureHash
+	) noexcept {
+		Hasher hasher;
+		hasher.Add(rootSignatureHash);
+
+		_AddShader(hasher, desc.VS);
+		_AddShader(hasher, desc.PS);
+		_AddShader(hasher, desc.DS);
+		_AddShader(hasher, desc.HS);
+		_AddShader(hasher, desc.GS);
+
+		{
+			const D3D12_STREAM_OUTPUT_DESC& so = desc.StreamOutput;
+			hasher.Add(so.NumEntries);
+			for (UINT i = 0; i < so.NumEntries; ++i) {
+				const D3D12_SO_DECLARATION_ENTRY& entry = so.pSODeclaration[i];
+				hasher.Add(entry.Stream);
+				hasher.AddString(entry.SemanticName ? entry.SemanticName : "");
+				hasher.Add(entry.SemanticIndex);
+				hasher.Add(entry.StartComponent);
+				hasher.Add(entry.ComponentCount);
+				hasher.Add(entry.OutputSlot);
+			}
+			hasher.Add(so.NumStrides);
+			hasher.AddBytes(so.pBufferStrides, sizeof(UINT) * so.NumStrides);
+			hasher.Add(so.RasterizedStream);
+		}
+
+		{
+			// D3D12_RENDER_TARGET_BLEND_DESC 末尾有填充
+			const D3D12_BLEND_DESC& blend = desc.BlendState;
+			hasher.Add(blend.AlphaToCoverageEnable);
+			hasher.Add(blend.IndependentBlendEnable);
+			for (const D3D12_RENDER_TARGET_BLEND_DESC& rt : blend.RenderTarget) {
+				hasher.Add(rt.BlendEnable);
+				hasher.Add(rt.LogicOpEnable);
+				hasher.Add(rt.SrcBlend);
+				hasher.Add(rt.DestBlend);
+				hasher.Add(rt.BlendOp);
+				hasher.Add(rt.SrcBlendAlpha);
+				hasher.Add(rt.DestBlendAlpha);
+				hasher.Add(rt.BlendOpAlpha);
+				hasher.Add(rt.LogicOp);
+				hasher.Add(rt.RenderTargetWriteMask);
+			}
+		}
+
+		hasher.Add(desc.SampleMask);
+		// D3D12_RASTERIZER_DESC 的成员都是 4 字节
+		hasher.Add(desc.RasterizerState);
+
+		{
+			// StencilWriteMask 之后有填充
+			const D3D12_DEPTH_STENCIL_DESC& ds = desc.DepthStencilState;
+			hasher.Add(ds.DepthEnable);
+			hasher.Add(ds.DepthWriteMask);
+			hasher.Add(ds.DepthFunc);
+			hasher.Add(ds.StencilEnable);
+			hasher.Add(ds.StencilReadMask);
+			hasher.Add(ds.StencilWriteMask);
+			hasher.Add(ds.FrontFace);
+			hasher.Add(ds.BackFace);
+		}
+
+		hasher.Add(desc.InputLayout.NumElements);
+		for (UINT i = 0; i < desc.InputLayout.NumElements; ++i) {
+			const D3D12_INPUT_ELEMENT_DESC& element = desc.InputLayout.pInputElementDescs[i];
+			hasher.AddString(element.SemanticName);
+			hasher.Add(element.SemanticIndex);
+			hasher.Add(element.Format);
+			hasher.Add(element.InputSlot);
+			hasher.Add(element.AlignedByteOffset);
+			hasher.Add(element.InputSlotClass);
+			hasher.Add(element.InstanceDataStepRate);
+		}
+
+		hasher.Add(desc.IBStripCutValue);
+		hasher.Add(desc.PrimitiveTopologyType);
+		hasher.Add(desc.NumRenderTargets);
+		hasher.Add(desc.RTVFormats);
+		hasher.Add(desc.DSVFormat);
+		hasher.Add(desc.SampleDesc);
+		hasher.Add(desc.NodeMask);
+		hasher.Add(desc.Flags);
+		// 不包含 CachedPSO
+
+		return hasher.GetHash();
+	}
+
+	static uint64_t HashComputePipelineDesc(
+		const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc,
+		uint64_t rootSignatureHash
+	) noexcept {
+		Hasher hasher;
+		hasher.Add(rootSignatureHash);
+		_AddShader(hasher, desc.CS);
+		hasher.Add(desc.NodeMask);
+		hasher.Add(desc.Flags);
+		return hasher.GetHash();
+	}
+
+private:
+	static void _AddShader(Hasher& hasher, const D3D12_SHADER_BYTECODE& shader) noexcept {
+		hasher.Add((uint64_t)shader.BytecodeLength);
+		hasher.AddBytes(shader.pShaderBytecode, shader.BytecodeLength);
+	}
+};
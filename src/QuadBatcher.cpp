@@ -0,0 +1,622 @@
+#include "pch.h"
+#include "QuadBatcher.h"
+#include "JobSystem.h"
+#include "BufferCapacity.h"
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include <bit>
+#include <chrono>
+
+static constexpr D3D12_INPUT_ELEMENT_DESC INPUT_ELEMENTS[] = {
+	{ "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	{ "RECT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+	{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 1, 16, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+	{ "TEXINDEX", 0, DXGI_FORMAT_R32_UINT, 1, 20, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 }
+};
+
+// 每种材质的像素着色器，第二组用于 HDR10。支持 bindless 时 Textured 使用 BINDLESS_PIXEL_SHADERS。
+static constexpr ShaderId MATERIAL_PIXEL_SHADERS[2][(size_t)QuadMaterial::COUNT] = {
+	{ ShaderId::QuadSolid_PS, ShaderId::QuadGradient_PS, ShaderId::QuadTextured_PS },
+	{ ShaderId::QuadSolidHDR10_PS, ShaderId::QuadGradientHDR10_PS, ShaderId::QuadTexturedHDR10_PS }
+};
+static constexpr ShaderId BINDLESS_PIXEL_SHADERS[2] = {
+	ShaderId::QuadTexturedBindless_PS,
+	ShaderId::QuadTexturedBindlessHDR10_PS
+};
+
+// 单位四边形，顶点顺序和 SceneGeometry::GetSquareVertex 相同
+static constexpr VertexPositionTexture UNIT_QUAD_VERTICES[] = {
+	{ { 0.0f, 0.0f }, { 0.0f, 0.0f } },
+	{ { 1.0f, 0.0f }, { 1.0f, 0.0f } },
+	{ { 0.0f, 1.0f }, { 0.0f, 1.0f } },
+	{ { 1.0f, 1.0f }, { 1.0f, 1.0f } }
+};
+
+// 每个任务打包的四边形数，太小会增加调度开销
+static constexpr uint32_t PACK_BATCH_SIZE = 16384;
+
+// 实例上传缓冲的最小容量，约 100KB
+static constexpr uint32_t MIN_INSTANCE_UPLOAD_CAPACITY = 4096;
+
+// 和 shaders/QuadCull_CS.hlsl 一致
+static constexpr uint32_t CULL_THREAD_GROUP_SIZE = 64;
+
+// QuadCulling.h 不依赖 D3D12 和 DirectXMath，布局必须一致
+static_assert(sizeof(QuadInstance::Float4) == sizeof(DirectX::XMFLOAT4));
+static_assert(sizeof(QuadCulling::DrawArguments) == sizeof(D3D12_DRAW_ARGUMENTS));
+
+QuadBatcher::~QuadBatcher() {
+	if (!_d3d12Context) {
+		return;
+	}
+
+	// 全部延迟到 GPU 不再使用时释放
+	for (_InstanceUploadBuffer& upload : _instanceUploadBuffers) {
+		_d3d12Context->ReleaseResource(std::move(upload.buffer), upload.allocation);
+	}
+
+	for (uint32_t i = 0; i < TEXTURE_COUNT; ++i) {
+		_d3d12Context->ReleaseResource(std::move(_textures[i]), _textureAllocations[i]);
+	}
+	_d3d12Context->ReleasePersistentDescriptors(_textureDescriptors);
+
+	_d3d12Context->ReleaseResource(std::move(_drawArgsBuffer), _drawArgsBufferAllocation);
+	_d3d12Context->ReleaseResource(std::move(_visibleInstanceBuffer), _visibleInstanceBufferAllocation);
+}
+
+HRESULT QuadBatcher::Initialize(D3D12Context& d3d12Context, JobSystem& jobSystem) noexcept {
+	_d3d12Context = &d3d12Context;
+	_jobSystem = &jobSystem;
+	_isBindless = d3d12Context.IsBindlessSupported();
+	_instanceUploadBuffers.resize(d3d12Context.GetMaxInFlightFrameCount());
+
+	HRESULT hr = _CreateRootSignature(d3d12Context);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	hr = _CreateTextures(d3d12Context);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	// 不支持 SM6 时回落到 CPU 剔除
+	_isGpuCulling = d3d12Context.IsSM6Supported();
+	if (!_isGpuCulling) {
+		return S_OK;
+	}
+
+	return _InitializeGpuCulling(d3d12Context);
+}
+
+HRESULT QuadBatcher::CreatePipelineState(
+	D3D12Context& d3d12Context,
+	QuadMaterial material,
+	ShaderPermutations::ColorMode colorMode,
+	winrt::com_ptr<ID3D12PipelineState>& pipelineState
+) const noexcept {
+	// SDR 和 scRGB 的着色器相同，只有渲染目标格式不同
+	const bool isHDR10 = colorMode == ShaderPermutations::ColorMode::HDR10;
+	// bindless 要求 SM6.6，见 D3D12Context::IsBindlessSupported
+	const ShaderId ps = material == QuadMaterial::Textured && _isBindless ?
+		BINDLESS_PIXEL_SHADERS[isHDR10] : MATERIAL_PIXEL_SHADERS[isHDR10][(size_t)material];
+	assert(ShaderPermutations::HasByteCode(ps, ShaderPermutations::GetShaderTier(d3d12Context.IsSM6Supported())));
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {
+		.pRootSignature = _rootSignature.get(),
+		.VS = d3d12Context.GetShaderByteCode(ShaderId::QuadBatchVS),
+		.PS = d3d12Context.GetShaderByteCode(ps),
+		.BlendState = {
+			.RenderTarget = {{ .RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL }}
+		},
+		.SampleMask = UINT_MAX,
+		.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT),
+		.InputLayout = {
+			.pInputElementDescs = INPUT_ELEMENTS,
+			.NumElements = (UINT)std::size(INPUT_ELEMENTS)
+		},
+		.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE,
+		.NumRenderTargets = 1,
+		.RTVFormats = { ShaderPermutations::GetRtvFormat(colorMode) },
+		.SampleDesc = { .Count = 1 }
+	};
+	return d3d12Context.CreateGraphicsPipelineState(psoDesc, pipelineState);
+}
+
+HRESULT QuadBatcher::Prepare(D3D12Context& d3d12Context, uint32_t frameIndex, Size viewportSize) noexcept {
+	_batches = {};
+	_stats = {};
+
+	_hasTextureUpload = false;
+	if (!_isTextureUploaded) {
+		HRESULT hr = _PrepareTextureUpload(d3d12Context);
+		if (FAILED(hr)) {
+			return hr;
+		}
+	}
+
+	uint32_t totalCount = 0;
+	for (const std::vector<Quad>& quads : _quads) {
+		totalCount += (uint32_t)quads.size();
+	}
+
+	if (totalCount == 0) {
+		return S_OK;
+	}
+
+	UploadAllocation vertexAllocation;
+	HRESULT hr = d3d12Context.AllocateUpload(
+		sizeof(UNIT_QUAD_VERTICES), sizeof(VertexPositionTexture), vertexAllocation);
+	if (FAILED(hr)) {
+		return hr;
+	}
+	std::memcpy(vertexAllocation.cpuAddress, UNIT_QUAD_VERTICES, sizeof(UNIT_QUAD_VERTICES));
+
+	// 所有材质的实例数据连续存放，每种材质一段
+	hr = _PrepareInstanceUpload(d3d12Context, frameIndex, totalCount);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	const _InstanceUploadBuffer& instanceUpload = _instanceUploadBuffers[frameIndex];
+	const D3D12_GPU_VIRTUAL_ADDRESS instanceBufferAddress = instanceUpload.buffer->GetGPUVirtualAddress();
+
+	const auto start = std::chrono::steady_clock::now();
+
+	QuadInstance* instances = instanceUpload.data;
+	uint32_t startInstance = 0;
+	for (size_t i = 0; i < _quads.size(); ++i) {
+		std::vector<Quad>& quads = _quads[i];
+		if (quads.empty()) {
+			continue;
+		}
+
+		const uint32_t count = (uint32_t)quads.size();
+		uint32_t instanceCount = count;
+
+		if (_isGpuCulling) {
+			_PackInstancesParallel(*_jobSystem, quads.data(), count, viewportSize, instances + startInstance);
+		} else {
+			_scratchInstances.resize(count);
+			_PackInstancesParallel(*_jobSystem, quads.data(), count, viewportSize, _scratchInstances.data());
+			instanceCount = QuadCulling::CullInstances(_scratchInstances.data(), count, instances + startInstance);
+		}
+
+		_batches[i] = { .startInstance = startInstance, .instanceCount = instanceCount };
+		startInstance += instanceCount;
+
+		if (instanceCount > 0) {
+			++_stats.drawCount;
+		}
+
+		// 保留容量供下一帧使用
+		quads.clear();
+	}
+
+	_stats.quadCount = totalCount;
+	_stats.packTime = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start).count();
+
+	_vertexBufferViews[0] = {
+		.BufferLocation = vertexAllocation.gpuAddress,
+		.SizeInBytes = (UINT)sizeof(UNIT_QUAD_VERTICES),
+		.StrideInBytes = (UINT)sizeof(VertexPositionTexture)
+	};
+	_vertexBufferViews[1] = {
+		.BufferLocation = instanceBufferAddress,
+		.SizeInBytes = totalCount * (UINT)sizeof(QuadInstance),
+		.StrideInBytes = (UINT)sizeof(QuadInstance)
+	};
+
+	if (_isGpuCulling) {
+		_instanceBufferAddress = instanceBufferAddress;
+		return _PrepareGpuCulling(d3d12Context, totalCount);
+	}
+
+	return S_OK;
+}
+
+void QuadBatcher::RecordUploadAndCulling(ID3D12GraphicsCommandList* commandList) const noexcept {
+	if (_hasTextureUpload) {
+		_RecordTextureUpload(commandList);
+	}
+
+	if (!_isGpuCulling || _stats.quadCount == 0) {
+		return;
+	}
+
+	// 重置绘制参数，缓冲区从 COMMON 隐式提升为 COPY_DEST
+	commandList->CopyBufferRegion(_drawArgsBuffer.get(), 0, _drawArgsUpload.resource,
+		_drawArgsUpload.offset, sizeof(D3D12_DRAW_ARGUMENTS) * _batches.size());
+
+	{
+		D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+			_drawArgsBuffer.get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+		commandList->ResourceBarrier(1, &barrier);
+	}
+
+	commandList->SetComputeRootSignature(_cullRootSignature.get());
+	commandList->SetPipelineState(_cullPipelineState.get());
+	commandList->SetComputeRootShaderResourceView(1, _instanceBufferAddress);
+	commandList->SetComputeRootUnorderedAccessView(2, _visibleInstanceBuffer->GetGPUVirtualAddress());
+	commandList->SetComputeRootUnorderedAccessView(3, _drawArgsBuffer->GetGPUVirtualAddress());
+
+	for (size_t i = 0; i < _batches.size(); ++i) {
+		const QuadCulling::Batch& batch = _batches[i];
+		if (batch.instanceCount == 0) {
+			continue;
+		}
+
+		// 布局见 shaders/QuadCull_CS.hlsl
+		const uint32_t constants[] = {
+			batch.startInstance,
+			batch.instanceCount,
+			uint32_t(sizeof(D3D12_DRAW_ARGUMENTS) * i)
+		};
+		commandList->SetComputeRoot32BitConstants(0, (UINT)std::size(constants), constants, 0);
+		commandList->Dispatch((batch.instanceCount + CULL_THREAD_GROUP_SIZE - 1) / CULL_THREAD_GROUP_SIZE, 1, 1);
+	}
+
+	{
+		D3D12_RESOURCE_BARRIER barriers[] = {
+			CD3DX12_RESOURCE_BARRIER::Transition(_drawArgsBuffer.get(),
+				D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT),
+			CD3DX12_RESOURCE_BARRIER::Transition(_visibleInstanceBuffer.get(),
+				D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER)
+		};
+		commandList->ResourceBarrier((UINT)std::size(barriers), barriers);
+	}
+}
+
+void QuadBatcher::Record(ID3D12GraphicsCommandList* commandList, float boost) const noexcept {
+	if (_stats.quadCount == 0) {
+		return;
+	}
+
+	commandList->SetGraphicsRootSignature(_rootSignature.get());
+	if (_isBindless) {
+		// 布局见 shaders/QuadTexturedBindless_PS.hlsl
+		const uint32_t constants[] = { std::bit_cast<uint32_t>(boost), _textureDescriptors.offset };
+		commandList->SetGraphicsRoot32BitConstants(0, (UINT)std::size(constants), constants, 0);
+	} else {
+		commandList->SetGraphicsRoot32BitConstants(0, 1, &boost, 0);
+		commandList->SetGraphicsRootDescriptorTable(1, _textureDescriptors.gpuHandle);
+	}
+	commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+	commandList->IASetVertexBuffers(0, (UINT)std::size(_vertexBufferViews), _vertexBufferViews);
+
+	for (size_t i = 0; i < _batches.size(); ++i) {
+		const QuadCulling::Batch& batch = _batches[i];
+		if (batch.instanceCount == 0) {
+			continue;
+		}
+
+		commandList->SetPipelineState(_pipelineStates[i].get());
+
+		if (_isGpuCulling) {
+			// 可见实例数由计算着色器写入
+			commandList->ExecuteIndirect(_commandSignature.get(), 1, _drawArgsBuffer.get(),
+				sizeof(D3D12_DRAW_ARGUMENTS) * i, nullptr, 0);
+		} else {
+			commandList->DrawInstanced(
+				(UINT)std::size(UNIT_QUAD_VERTICES), batch.instanceCount, 0, batch.startInstance);
+		}
+	}
+}
+
+void QuadBatcher::PackInstances(
+	const Quad* quads,
+	uint32_t count,
+	Size viewportSize,
+	QuadInstance* instances
+) noexcept {
+	using namespace DirectX;
+
+	// 像素坐标转换为 NDC，y 轴方向相反
+	const float scaleX = 2.0f / viewportSize.width;
+	const float scaleY = -2.0f / viewportSize.height;
+	const XMVECTOR scale = XMVectorSet(scaleX, scaleY, scaleX, scaleY);
+	const XMVECTOR bias = XMVectorSet(-1.0f, 1.0f, 0.0f, 0.0f);
+
+	for (uint32_t i = 0; i < count; ++i) {
+		const XMVECTOR rect = XMVectorMultiplyAdd(XMLoadFloat4(&quads[i].rect), scale, bias);
+		XMStoreFloat4((XMFLOAT4*)&instances[i].rect, rect);
+
+		PackedVector::XMUBYTEN4 color;
+		PackedVector::XMStoreUByteN4(&color, XMLoadFloat4(&quads[i].color));
+		instances[i].color = color.v;
+		instances[i].texture = quads[i].texture;
+	}
+}
+
+double QuadBatcher::BenchmarkPacking(JobSystem& jobSystem, uint32_t quadCount, uint32_t iterationCount) noexcept {
+	constexpr Size viewportSize{ 1920, 1080 };
+
+	std::vector<Quad> quads(quadCount);
+	for (uint32_t i = 0; i < quadCount; ++i) {
+		const float x = float(i % viewportSize.width);
+		const float y = float(i / viewportSize.width % viewportSize.height);
+		quads[i] = {
+			.rect = { x, y, 8.0f, 8.0f },
+			.color = { x / viewportSize.width, y / viewportSize.height, 0.5f, 1.0f }
+		};
+	}
+
+	std::vector<QuadInstance> instances(quadCount);
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < iterationCount; ++i) {
+		_PackInstancesParallel(jobSystem, quads.data(), quadCount, viewportSize, instances.data());
+	}
+
+	const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+	return (double)quadCount * iterationCount / duration.count();
+}
+
+HRESULT QuadBatcher::_CreateRootSignature(D3D12Context& d3d12Context) noexcept {
+	if (_isBindless) {
+		// 布局见 shaders/QuadTexturedBindless_PS.hlsl
+		_rootSignature.copy_from(d3d12Context.GetBindlessRootSignature());
+		return S_OK;
+	}
+
+	// 和场景相同，根常量为 HDR 下的亮度。所有纹理绑定为一个描述符表，布局见
+	// shaders/QuadTextured_PS.hlsl
+	const CD3DX12_DESCRIPTOR_RANGE1 srvRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, TEXTURE_COUNT, 0);
+
+	CD3DX12_ROOT_PARAMETER1 rootParams[2];
+	rootParams[0].InitAsConstants(1, 0, 0, D3D12_SHADER_VISIBILITY_PIXEL);
+	rootParams[1].InitAsDescriptorTable(1, &srvRange, D3D12_SHADER_VISIBILITY_PIXEL);
+
+	const CD3DX12_STATIC_SAMPLER_DESC samplerDesc(
+		0,
+		D3D12_FILTER_MIN_MAG_MIP_LINEAR,
+		D3D12_TEXTURE_ADDRESS_MODE_CLAMP,
+		D3D12_TEXTURE_ADDRESS_MODE_CLAMP,
+		D3D12_TEXTURE_ADDRESS_MODE_CLAMP
+	);
+
+	CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc((UINT)std::size(rootParams), rootParams,
+		1, &samplerDesc, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+
+	return d3d12Context.CreateRootSignature(rootSignatureDesc, _rootSignature);
+}
+
+HRESULT QuadBatcher::_CreateTextures(D3D12Context& d3d12Context) noexcept {
+	ID3D12Device5* device = d3d12Context.GetDevice();
+
+	HRESULT hr = d3d12Context.AllocatePersistentDescriptors(TEXTURE_COUNT, _textureDescriptors);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	const uint32_t descriptorSize = d3d12Context.GetDescriptorSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	const CD3DX12_RESOURCE_DESC textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(
+		DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, QuadTextures::SIZE, QuadTextures::SIZE, 1, 1);
+
+	for (uint32_t i = 0; i < TEXTURE_COUNT; ++i) {
+		hr = d3d12Context.CreateResource(D3D12_HEAP_TYPE_DEFAULT, textureDesc,
+			D3D12_RESOURCE_STATE_COPY_DEST, nullptr, _textures[i], _textureAllocations[i]);
+		if (FAILED(hr)) {
+			return hr;
+		}
+
+		// SRV 直接写入着色器可见的描述符堆，之后不再改变
+		device->CreateShaderResourceView(_textures[i].get(), nullptr,
+			_textureDescriptors.GetCpuHandle(i, descriptorSize));
+	}
+
+	return S_OK;
+}
+
+HRESULT QuadBatcher::_PrepareTextureUpload(D3D12Context& d3d12Context) noexcept {
+	// 所有纹理的描述相同，布局也相同
+	const D3D12_RESOURCE_DESC textureDesc = _textures[0]->GetDesc();
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+	uint64_t textureUploadSize;
+	d3d12Context.GetDevice()->GetCopyableFootprints(
+		&textureDesc, 0, 1, 0, &footprint, nullptr, nullptr, &textureUploadSize);
+
+	const uint64_t textureStride = (textureUploadSize + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) &
+		~uint64_t(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+
+	UploadAllocation uploadAllocation;
+	HRESULT hr = d3d12Context.AllocateUpload(
+		textureStride * TEXTURE_COUNT, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, uploadAllocation);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	for (uint32_t i = 0; i < TEXTURE_COUNT; ++i) {
+		uint8_t* data = (uint8_t*)uploadAllocation.cpuAddress + textureStride * i;
+
+		for (uint32_t y = 0; y < QuadTextures::SIZE; ++y) {
+			uint32_t* row = (uint32_t*)(data + (size_t)footprint.Footprint.RowPitch * y);
+			for (uint32_t x = 0; x < QuadTextures::SIZE; ++x) {
+				row[x] = QuadTextures::GetTexel(i, x, y);
+			}
+		}
+
+		_textureUploadFootprints[i] = footprint;
+		_textureUploadFootprints[i].Offset = uploadAllocation.offset + textureStride * i;
+	}
+
+	_textureUploadBuffer = uploadAllocation.resource;
+	_hasTextureUpload = true;
+	_isTextureUploaded = true;
+	return S_OK;
+}
+
+void QuadBatcher::_RecordTextureUpload(ID3D12GraphicsCommandList* commandList) const noexcept {
+	for (uint32_t i = 0; i < TEXTURE_COUNT; ++i) {
+		const CD3DX12_TEXTURE_COPY_LOCATION dest(_textures[i].get(), 0);
+		const CD3DX12_TEXTURE_COPY_LOCATION src(_textureUploadBuffer, _textureUploadFootprints[i]);
+		commandList->CopyTextureRegion(&dest, 0, 0, 0, &src, nullptr);
+	}
+
+	D3D12_RESOURCE_BARRIER barriers[TEXTURE_COUNT];
+	for (uint32_t i = 0; i < TEXTURE_COUNT; ++i) {
+		barriers[i] = CD3DX12_RESOURCE_BARRIER::Transition(_textures[i].get(),
+			D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+	}
+	commandList->ResourceBarrier(TEXTURE_COUNT, barriers);
+}
+
+HRESULT QuadBatcher::_InitializeGpuCulling(D3D12Context& d3d12Context) noexcept {
+	ID3D12Device5* device = d3d12Context.GetDevice();
+
+	{
+		// 布局见 shaders/QuadCull_CS.hlsl
+		CD3DX12_ROOT_PARAMETER1 rootParams[4];
+		rootParams[0].InitAsConstants(3, 0);
+		rootParams[1].InitAsShaderResourceView(0);
+		rootParams[2].InitAsUnorderedAccessView(0);
+		rootParams[3].InitAsUnorderedAccessView(1);
+
+		CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc(
+			(UINT)std::size(rootParams), rootParams, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+		HRESULT hr = d3d12Context.CreateRootSignature(rootSignatureDesc, _cullRootSignature);
+		if (FAILED(hr)) {
+			return hr;
+		}
+	}
+
+	{
+		D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {
+			.pRootSignature = _cullRootSignature.get(),
+			.CS = d3d12Context.GetShaderByteCode(ShaderId::QuadCull_CS)
+		};
+		HRESULT hr = d3d12Context.CreateComputePipelineState(psoDesc, _cullPipelineState);
+		if (FAILED(hr)) {
+			return hr;
+		}
+	}
+
+	{
+		// 只改变绘制参数，因此无需根签名
+		D3D12_INDIRECT_ARGUMENT_DESC argumentDesc = { .Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW };
+		D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc = {
+			.ByteStride = sizeof(D3D12_DRAW_ARGUMENTS),
+			.NumArgumentDescs = 1,
+			.pArgumentDescs = &argumentDesc
+		};
+		HRESULT hr = device->CreateCommandSignature(
+			&commandSignatureDesc, nullptr, IID_PPV_ARGS(&_commandSignature));
+		if (FAILED(hr)) {
+			return hr;
+		}
+	}
+
+	CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(
+		sizeof(D3D12_DRAW_ARGUMENTS) * _batches.size(), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+	return d3d12Context.CreateResource(D3D12_HEAP_TYPE_DEFAULT, bufferDesc,
+		D3D12_RESOURCE_STATE_COMMON, nullptr, _drawArgsBuffer, _drawArgsBufferAllocation);
+}
+
+HRESULT QuadBatcher::_PrepareInstanceUpload(
+	D3D12Context& d3d12Context,
+	uint32_t frameIndex,
+	uint32_t instanceCount
+) noexcept {
+	_InstanceUploadBuffer& upload = _instanceUploadBuffers[frameIndex];
+
+	const uint32_t capacity = BufferCapacity::Grow(upload.capacity, instanceCount, MIN_INSTANCE_UPLOAD_CAPACITY);
+	if (capacity == upload.capacity) {
+		return S_OK;
+	}
+
+	// 顶点缓冲视图的大小是 32 位的
+	const uint64_t bufferSize = (uint64_t)sizeof(QuadInstance) * capacity;
+	if (bufferSize > UINT32_MAX) {
+		return E_OUTOFMEMORY;
+	}
+
+	// 这个帧索引上次的绘制已经完成，但 ReleaseResource 仍然延迟释放，和其他资源保持一致
+	d3d12Context.ReleaseResource(std::move(upload.buffer), upload.allocation);
+	upload = {};
+
+	// 超过堆的大小时 CreateResource 创建提交资源
+	HRESULT hr = d3d12Context.CreateResource(D3D12_HEAP_TYPE_UPLOAD, CD3DX12_RESOURCE_DESC::Buffer(bufferSize),
+		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, upload.buffer, upload.allocation);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	// 上传堆可以一直保持映射，CPU 不读取
+	const CD3DX12_RANGE readRange(0, 0);
+	hr = upload.buffer->Map(0, &readRange, (void**)&upload.data);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	upload.capacity = capacity;
+	return S_OK;
+}
+
+HRESULT QuadBatcher::_PrepareGpuCulling(D3D12Context& d3d12Context, uint32_t instanceCount) noexcept {
+	if (instanceCount > _visibleInstanceCapacity) {
+		const uint32_t capacity = BufferCapacity::Grow(_visibleInstanceCapacity, instanceCount, 1024);
+
+		// 之前的帧可能仍在使用
+		d3d12Context.ReleaseResource(std::move(_visibleInstanceBuffer), _visibleInstanceBufferAllocation);
+		_visibleInstanceCapacity = 0;
+
+		CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(
+			(uint64_t)sizeof(QuadInstance) * capacity, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+		HRESULT hr = d3d12Context.CreateResource(D3D12_HEAP_TYPE_DEFAULT, bufferDesc,
+			D3D12_RESOURCE_STATE_COMMON, nullptr, _visibleInstanceBuffer, _visibleInstanceBufferAllocation);
+		if (FAILED(hr)) {
+			return hr;
+		}
+
+		_visibleInstanceCapacity = capacity;
+	}
+
+	// 每种材质的实例数从 0 开始累加
+	HRESULT hr = d3d12Context.AllocateUpload(
+		sizeof(D3D12_DRAW_ARGUMENTS) * _batches.size(), sizeof(D3D12_DRAW_ARGUMENTS), _drawArgsUpload);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	D3D12_DRAW_ARGUMENTS* drawArgs = (D3D12_DRAW_ARGUMENTS*)_drawArgsUpload.cpuAddress;
+	for (size_t i = 0; i < _batches.size(); ++i) {
+		drawArgs[i] = {
+			.VertexCountPerInstance = (UINT)std::size(UNIT_QUAD_VERTICES),
+			.InstanceCount = 0,
+			.StartVertexLocation = 0,
+			.StartInstanceLocation = _batches[i].startInstance
+		};
+	}
+
+	_vertexBufferViews[1] = {
+		.BufferLocation = _visibleInstanceBuffer->GetGPUVirtualAddress(),
+		.SizeInBytes = (UINT)sizeof(QuadInstance) * _visibleInstanceCapacity,
+		.StrideInBytes = (UINT)sizeof(QuadInstance)
+	};
+
+	return S_OK;
+}
+
+void QuadBatcher::_PackInstancesParallel(
+	JobSystem& jobSystem,
+	const Quad* quads,
+	uint32_t count,
+	Size viewportSize,
+	QuadInstance* instances
+) noexcept {
+	if (count <= PACK_BATCH_SIZE) {
+		PackInstances(quads, count, viewportSize, instances);
+		return;
+	}
+
+	const uint32_t batchCount = (count + PACK_BATCH_SIZE - 1) / PACK_BATCH_SIZE;
+	jobSystem.ParallelFor(batchCount, [&](uint32_t batch) {
+		const uint32_t begin = batch * PACK_BATCH_SIZE;
+		const uint32_t end = std::min(begin + PACK_BATCH_SIZE, count);
+		PackInstances(quads + begin, end - begin, viewportSize, instances + begin);
+	});
+}
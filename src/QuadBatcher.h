@@ -0,0 +1,176 @@
+#pragma once
+#include "D3D12Context.h"
+#include "QuadCulling.h"
+#include "QuadTextures.h"
+#include "SceneGeometry.h"
+#include <array>
+#include <span>
+
+class JobSystem;
+
+// 调用者提交的四边形
+struct Quad {
+	// 左上角和尺寸，单位为像素
+	DirectX::XMFLOAT4 rect;
+	// 线性颜色，每个分量范围为 [0, 1]
+	DirectX::XMFLOAT4 color;
+	// QuadMaterial::Textured 使用的纹理，范围为 [0, QuadBatcher::TEXTURE_COUNT)
+	uint32_t texture = 0;
+};
+
+enum class QuadMaterial {
+	Solid,
+	Gradient,
+	// 纹理和颜色相乘，同一次绘制中每个实例可以使用不同的纹理
+	Textured,
+	COUNT
+};
+
+// 批量绘制大量四边形。每帧提交的四边形按材质分组打包为实例数据，每种材质一次实例化绘制。
+// 实例数据随四边形数增长，因此不放在容量固定的上传环中，而是写入每个在途帧独立的上传缓冲。
+// 支持 SM6 时由计算着色器剔除视口外的四边形并写入绘制参数，每种材质一次 ExecuteIndirect，
+// 否则在 CPU 上剔除，剔除逻辑见 QuadCulling.h。支持 SM 6.6 时使用 D3D12Context 的 bindless 根签名，
+// 像素着色器直接索引 ResourceDescriptorHeap，否则将所有纹理绑定为一个描述符表。两种方式都无需
+// 在绘制之间改变描述符。
+class QuadBatcher {
+public:
+	struct Stats {
+		uint32_t quadCount = 0;
+		uint32_t drawCount = 0;
+		// 打包耗时，单位为微秒
+		uint64_t packTime = 0;
+	};
+
+	static constexpr uint32_t TEXTURE_COUNT = QuadTextures::COUNT;
+
+	QuadBatcher() = default;
+	QuadBatcher(const QuadBatcher&) = delete;
+	// 析构时通过 _d3d12Context 释放纹理、缓冲和描述符
+	QuadBatcher(QuadBatcher&&) = delete;
+
+	~QuadBatcher();
+
+	HRESULT Initialize(D3D12Context& d3d12Context, JobSystem& jobSystem) noexcept;
+
+	using PipelineStates = std::array<winrt::com_ptr<ID3D12PipelineState>, (size_t)QuadMaterial::COUNT>;
+
+	// 每种材质和颜色模式一个 PSO。可以在工作线程并行调用，调用者负责在颜色模式改变时调用
+	// SetPipelineStates。
+	HRESULT CreatePipelineState(
+		D3D12Context& d3d12Context,
+		QuadMaterial material,
+		ShaderPermutations::ColorMode colorMode,
+		winrt::com_ptr<ID3D12PipelineState>& pipelineState
+	) const noexcept;
+
+	void SetPipelineStates(const PipelineStates& pipelineStates) noexcept {
+		_pipelineStates = pipelineStates;
+	}
+
+	void AddQuad(QuadMaterial material, const Quad& quad) noexcept {
+		_quads[(size_t)material].push_back(quad);
+	}
+
+	void AddQuads(QuadMaterial material, std::span<const Quad> quads) noexcept {
+		std::vector<Quad>& dest = _quads[(size_t)material];
+		dest.insert(dest.end(), quads.begin(), quads.end());
+	}
+
+	// 在渲染线程调用，将本帧提交的四边形打包到 frameIndex 的上传缓冲并清空
+	HRESULT Prepare(D3D12Context& d3d12Context, uint32_t frameIndex, Size viewportSize) noexcept;
+
+	// 在 Prepare 之后、Record 所在的命令列表之前执行，录制纹理的首次上传和 GPU 剔除
+	void RecordUploadAndCulling(ID3D12GraphicsCommandList* commandList) const noexcept;
+
+	// 可以在工作线程调用，调用者负责设置视口、渲染目标和 D3D12Context 的着色器可见描述符堆
+	void Record(ID3D12GraphicsCommandList* commandList, float boost) const noexcept;
+
+	const Stats& GetStats() const noexcept {
+		return _stats;
+	}
+
+	// 将像素坐标转换为 NDC 并压缩颜色，使用 SIMD 指令
+	static void PackInstances(
+		const Quad* quads,
+		uint32_t count,
+		Size viewportSize,
+		QuadInstance* instances
+	) noexcept;
+
+	// 在 CPU 上测试打包的吞吐量，不需要 GPU。返回每秒打包的四边形数。
+	static double BenchmarkPacking(JobSystem& jobSystem, uint32_t quadCount, uint32_t iterationCount) noexcept;
+
+private:
+	struct _InstanceUploadBuffer {
+		winrt::com_ptr<ID3D12Resource> buffer;
+		HeapAllocation allocation;
+		QuadInstance* data = nullptr;
+		uint32_t capacity = 0;
+	};
+
+	static void _PackInstancesParallel(
+		JobSystem& jobSystem,
+		const Quad* quads,
+		uint32_t count,
+		Size viewportSize,
+		QuadInstance* instances
+	) noexcept;
+
+	HRESULT _CreateRootSignature(D3D12Context& d3d12Context) noexcept;
+
+	HRESULT _CreateTextures(D3D12Context& d3d12Context) noexcept;
+
+	HRESULT _PrepareTextureUpload(D3D12Context& d3d12Context) noexcept;
+
+	void _RecordTextureUpload(ID3D12GraphicsCommandList* commandList) const noexcept;
+
+	HRESULT _InitializeGpuCulling(D3D12Context& d3d12Context) noexcept;
+
+	HRESULT _PrepareInstanceUpload(D3D12Context& d3d12Context, uint32_t frameIndex, uint32_t instanceCount) noexcept;
+
+	HRESULT _PrepareGpuCulling(D3D12Context& d3d12Context, uint32_t instanceCount) noexcept;
+
+	D3D12Context* _d3d12Context = nullptr;
+	JobSystem* _jobSystem = nullptr;
+
+	// 支持 bindless 时为 D3D12Context 的根签名
+	winrt::com_ptr<ID3D12RootSignature> _rootSignature;
+	bool _isBindless = false;
+	PipelineStates _pipelineStates;
+
+	std::array<std::vector<Quad>, (size_t)QuadMaterial::COUNT> _quads;
+	std::array<QuadCulling::Batch, (size_t)QuadMaterial::COUNT> _batches;
+	// 第一个是单位四边形的顶点，第二个是实例数据
+	D3D12_VERTEX_BUFFER_VIEW _vertexBufferViews[2]{};
+	// CPU 剔除时暂存打包结果，避免读取上传堆
+	std::vector<QuadInstance> _scratchInstances;
+	// 每个在途帧一个，保持映射。BeginFrame 已等待这个帧索引上次的绘制完成，因此可以直接覆盖。
+	std::vector<_InstanceUploadBuffer> _instanceUploadBuffers;
+
+	std::array<winrt::com_ptr<ID3D12Resource>, TEXTURE_COUNT> _textures;
+	std::array<HeapAllocation, TEXTURE_COUNT> _textureAllocations;
+	// 所有纹理的 SRV 连续存放，既是 bindless 的索引基址也是描述符表
+	DescriptorAllocation _textureDescriptors;
+	// 纹理只上传一次，上传的帧中 _hasTextureUpload 为 true
+	bool _isTextureUploaded = false;
+	bool _hasTextureUpload = false;
+	std::array<D3D12_PLACED_SUBRESOURCE_FOOTPRINT, TEXTURE_COUNT> _textureUploadFootprints{};
+	ID3D12Resource* _textureUploadBuffer = nullptr;
+
+	bool _isGpuCulling = false;
+	winrt::com_ptr<ID3D12RootSignature> _cullRootSignature;
+	winrt::com_ptr<ID3D12PipelineState> _cullPipelineState;
+	winrt::com_ptr<ID3D12CommandSignature> _commandSignature;
+	// 每种材质一个 D3D12_DRAW_ARGUMENTS，InstanceCount 由计算着色器累加
+	winrt::com_ptr<ID3D12Resource> _drawArgsBuffer;
+	HeapAllocation _drawArgsBufferAllocation;
+	// 剔除后的实例，每种材质的起始位置和剔除前相同
+	winrt::com_ptr<ID3D12Resource> _visibleInstanceBuffer;
+	HeapAllocation _visibleInstanceBufferAllocation;
+	uint32_t _visibleInstanceCapacity = 0;
+	// 本帧的实例数据和上传的绘制参数初值
+	D3D12_GPU_VIRTUAL_ADDRESS _instanceBufferAddress = 0;
+	UploadAllocation _drawArgsUpload{};
+
+	Stats _stats;
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <span>
+
+// 不依赖 D3D12 和 DirectXMath，以便在其他平台测试四边形的剔除。
+
+// 每个四边形的实例数据，由 shaders/QuadBatchVS.hlsl 读取
+struct QuadInstance {
+	// 和 DirectX::XMFLOAT4 的布局相同
+	struct Float4 {
+		float x;
+		float y;
+		float z;
+		float w;
+	};
+
+	// 左上角和尺寸，单位为 NDC，高度为负
+	Float4 rect;
+	// R8G8B8A8_UNORM
+	uint32_t color;
+	uint32_t texture;
+};
+
+namespace QuadCulling {
+
+// 和 D3D12_DRAW_ARGUMENTS 的布局相同
+struct DrawArguments {
+	uint32_t vertexCountPerInstance;
+	uint32_t instanceCount;
+	uint32_t startVertexLocation;
+	uint32_t startInstanceLocation;
+};
+
+// 一种材质的实例在实例数据中的范围
+struct Batch {
+	uint32_t startInstance = 0;
+	uint32_t instanceCount = 0;
+};
+
+// 和 shaders/QuadCull_CS.hlsl 中的剔除逻辑保持一致。只和视口边缘相接的四边形不可见。
+inline bool IsInstanceVisible(const QuadInstance& instance) noexcept {
+	const QuadInstance::Float4& rect = instance.rect;
+	return rect.z > 0 && rect.w < 0 &&
+		rect.x < 1 && rect.x + rect.z > -1 && rect.y > -1 && rect.y + rect.w < 1;
+}
+
+// 不支持 SM6 时在 CPU 上剔除。可见的实例按原顺序写入 visibleInstances，返回可见的数量。
+inline uint32_t CullInstances(
+	const QuadInstance* instances,
+	uint32_t count,
+	QuadInstance* visibleInstances
+) noexcept {
+	uint32_t visibleCount = 0;
+	for (uint32_t i = 0; i < count; ++i) {
+		if (IsInstanceVisible(instances[i])) {
+			visibleInstances[visibleCount++] = instances[i];
+		}
+	}
+	return visibleCount;
+}
+
+// GPU 剔除的参考实现，用于验证 shaders/QuadCull_CS.hlsl 的结果。每种材质剔除后的实例写入
+// visibleInstances 中和剔除前相同的起始位置，drawArgs 的 InstanceCount 为可见的数量，
+// StartInstanceLocation 为这个起始位置，没有实例的材质绘制 0 个实例。GPU 上每种材质内可见实例的
+// 顺序不确定，这里保持原顺序。
+inline void CullBatches(
+	std::span<const Batch> batches,
+	const QuadInstance* instances,
+	uint32_t vertexCountPerInstance,
+	QuadInstance* visibleInstances,
+	DrawArguments* drawArgs
+) noexcept {
+	for (size_t i = 0; i < batches.size(); ++i) {
+		const Batch& batch = batches[i];
+		drawArgs[i] = {
+			.vertexCountPerInstance = vertexCountPerInstance,
+			.instanceCount = CullInstances(instances + batch.startInstance,
+				batch.instanceCount, visibleInstances + batch.startInstance),
+			.startVertexLocation = 0,
+			.startInstanceLocation = batch.startInstance
+		};
+	}
+}
+
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// QuadMaterial::Textured 使用的纹理，程序生成的棋盘格，每个纹理的颜色不同。QuadBatcher 上传到
+// GPU，SoftwareRenderer 在 CPU 上采样，两者必须使用相同的定义。不依赖 D3D12。
+namespace QuadTextures {
+
+static constexpr uint32_t COUNT = 8;
+static constexpr uint32_t SIZE = 64;
+static constexpr uint32_t CELL_SIZE = 8;
+
+// R8G8B8A8_UNORM_SRGB
+static constexpr uint32_t COLORS[] = {
+	0xFF3030E0, 0xFF30A0F0, 0xFF30E0E0, 0xFF30C040,
+	0xFFD0C030, 0xFFE06030, 0xFFC030A0, 0xFF808080
+};
+static_assert(std::size(COLORS) == COUNT);
+
+// 为 true 时纹素为 COLORS 中的颜色，否则为白色
+constexpr bool IsColoredTexel(uint32_t x, uint32_t y) noexcept {
+	return (x / CELL_SIZE + y / CELL_SIZE) % 2 == 0;
+}
+
+constexpr uint32_t GetTexel(uint32_t texture, uint32_t x, uint32_t y) noexcept {
+	return IsColoredTexel(x, y) ? COLORS[texture] : 0xFFFFFFFF;
+}
+
+}
@@ -0,0 +1,478 @@
+#include "pch.h"
+#include "RenderGraph.h"
+#include "DirectXHelper.h"
+#include <chrono>
+
+// 这些状态只能单独使用，不能和其他状态组合
+static constexpr D3D12_RESOURCE_STATES WRITE_STATES = D3D12_RESOURCE_STATE_RENDER_TARGET |
+	D3D12_RESOURCE_STATE_UNORDERED_ACCESS | D3D12_RESOURCE_STATE_DEPTH_WRITE | D3D12_RESOURCE_STATE_STREAM_OUT |
+	D3D12_RESOURCE_STATE_COPY_DEST | D3D12_RESOURCE_STATE_RESOLVE_DEST;
+
+static bool IsReadOnlyState(D3D12_RESOURCE_STATES state) noexcept {
+	return (state & WRITE_STATES) == 0;
+}
+
+void RenderGraph::Reset() noexcept {
+	_resources.clear();
+	_passes.clear();
+}
+
+RenderGraphResource RenderGraph::ImportResource(
+	ID3D12Resource* resource,
+	D3D12_RESOURCE_STATES initialState,
+	D3D12_RESOURCE_STATES finalState
+) noexcept {
+	_resources.push_back({
+		.resource = resource,
+		.initialState = initialState,
+		.finalState = finalState,
+		.isImported = true,
+		.hasFinalState = true
+	});
+	return { (uint32_t)_resources.size() - 1 };
+}
+
+RenderGraphResource RenderGraph::ImportBuffer(ID3D12Resource* resource) noexcept {
+	_resources.push_back({
+		.resource = resource,
+		.initialState = D3D12_RESOURCE_STATE_COMMON,
+		.isImported = true,
+		.isBuffer = true
+	});
+	return { (uint32_t)_resources.size() - 1 };
+}
+
+RenderGraphResource RenderGraph::CreateTransientResource(const D3D12_RESOURCE_DESC& desc) noexcept {
+	_resources.push_back({
+		.desc = desc,
+		.isBuffer = desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER
+	});
+	return { (uint32_t)_resources.size() - 1 };
+}
+
+uint32_t RenderGraph::AddPass(
+	const char* name,
+	uint32_t commandListIndex,
+	std::function<void(ID3D12GraphicsCommandList*)> execute,
+	bool hasSideEffects
+) noexcept {
+	// 命令列表按索引顺序提交，因此 pass 的命令列表索引不能递减
+	assert(_passes.empty() || _passes.back().commandListIndex <= commandListIndex);
+
+	_passes.push_back({
+		.name = name,
+		.commandListIndex = commandListIndex,
+		.execute = std::move(execute),
+		.hasSideEffects = hasSideEffects
+	});
+	return (uint32_t)_passes.size() - 1;
+}
+
+void RenderGraph::ReadResource(uint32_t pass, RenderGraphResource resource, D3D12_RESOURCE_STATES state) noexcept {
+	assert(resource.IsValid());
+	_passes[pass].accesses.push_back({ resource.index, state, false });
+}
+
+void RenderGraph::WriteResource(uint32_t pass, RenderGraphResource resource, D3D12_RESOURCE_STATES state) noexcept {
+	assert(resource.IsValid());
+	_passes[pass].accesses.push_back({ resource.index, state, true });
+}
+
+void RenderGraph::Compile() noexcept {
+	_CullPasses();
+	_AssignPhysicalResources();
+	_ComputeBarriers();
+}
+
+std::span<const RenderGraph::Barrier> RenderGraph::GetPassBarriers(uint32_t pass) const noexcept {
+	const uint32_t position = _passes[pass].position;
+	if (position == UINT32_MAX) {
+		return {};
+	}
+	return _positionBarriers[position];
+}
+
+void RenderGraph::AddAliasingBarrier(uint32_t physicalIndex) noexcept {
+	const uint32_t firstTransientPhysicalIndex = (uint32_t)(_physicalResources.size() - _transientResources.size());
+	const TransientResourceInfo& info = _transientResources[physicalIndex - firstTransientPhysicalIndex];
+
+	// 放在最后，共享内存的上一个资源的转换必须在别名屏障之前
+	_positionBarriers[info.firstPosition].push_back({
+		.resource = physicalIndex,
+		.type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING,
+		.stateAfter = info.initialState,
+		.flags = D3D12_RESOURCE_BARRIER_FLAG_NONE
+	});
+}
+
+std::span<const RenderGraph::Barrier> RenderGraph::GetFinalBarriers() const noexcept {
+	return _positionBarriers.back();
+}
+
+void RenderGraph::Execute(
+	ID3D12GraphicsCommandList* commandList,
+	uint32_t commandListIndex,
+	GpuProfiler* profiler,
+	uint32_t parentScope
+) const noexcept {
+	for (uint32_t position = 0; position < (uint32_t)_livePasses.size(); ++position) {
+		const _Pass& pass = _passes[_livePasses[position]];
+		if (pass.commandListIndex != commandListIndex) {
+			continue;
+		}
+
+		const uint32_t scope = profiler ?
+			profiler->BeginScope(commandList, pass.name, parentScope) : GpuProfiler::NO_SCOPE;
+
+		_RecordBarriers(commandList, position);
+
+		if (pass.execute) {
+			pass.execute(commandList);
+		}
+
+		if (profiler) {
+			profiler->EndScope(commandList, scope);
+		}
+	}
+
+	const uint32_t finalPosition = (uint32_t)_livePasses.size();
+	if (_GetCommandListIndex(finalPosition) == commandListIndex) {
+		_RecordBarriers(commandList, finalPosition);
+	}
+}
+
+double RenderGraph::BenchmarkCompile(uint32_t passCount, uint32_t iterationCount) noexcept {
+	const D3D12_RESOURCE_DESC textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R16G16B16A16_FLOAT,
+		1920, 1080, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+
+	RenderGraph graph;
+	std::chrono::duration<double> duration{};
+
+	for (uint32_t iteration = 0; iteration < iterationCount; ++iteration) {
+		// 每个 pass 读取上一个 pass 的输出并写入新的瞬态纹理，每隔几个 pass 写入一次 UAV 缓冲区
+		graph.Reset();
+		const RenderGraphResource backBuffer = graph.ImportResource(
+			nullptr, D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_PRESENT);
+		const RenderGraphResource buffer = graph.ImportBuffer(nullptr);
+
+		RenderGraphResource prevTexture = graph.CreateTransientResource(textureDesc);
+		graph.WriteResource(graph.AddPass("Pass", 0, {}), prevTexture, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+		for (uint32_t i = 1; i < passCount; ++i) {
+			const uint32_t pass = graph.AddPass("Pass", i * 2 / passCount, {});
+			graph.ReadResource(pass, prevTexture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+			if (i % 8 == 0) {
+				graph.WriteResource(pass, buffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+			}
+
+			const RenderGraphResource texture = i + 1 == passCount ?
+				backBuffer : graph.CreateTransientResource(textureDesc);
+			graph.WriteResource(pass, texture, D3D12_RESOURCE_STATE_RENDER_TARGET);
+			prevTexture = texture;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		graph.Compile();
+		duration += std::chrono::steady_clock::now() - start;
+	}
+
+	return duration.count() * 1e6 / iterationCount;
+}
+
+void RenderGraph::_CullPasses() noexcept {
+	// 从后向前遍历，写入外部资源或被存活 pass 读取的资源的 pass 是存活的
+	std::vector<bool> isNeeded(_resources.size());
+	for (uint32_t i = 0; i < (uint32_t)_resources.size(); ++i) {
+		isNeeded[i] = _resources[i].isImported;
+	}
+
+	uint32_t liveCount = 0;
+	for (uint32_t i = (uint32_t)_passes.size(); i-- > 0;) {
+		_Pass& pass = _passes[i];
+
+		bool isLive = pass.hasSideEffects;
+		if (!isLive) {
+			for (const _Access& access : pass.accesses) {
+				if (access.isWrite && isNeeded[access.resource]) {
+					isLive = true;
+					break;
+				}
+			}
+		}
+
+		if (!isLive) {
+			pass.position = UINT32_MAX;
+			continue;
+		}
+
+		// 暂时标记为存活
+		pass.position = 0;
+		++liveCount;
+
+		for (const _Access& access : pass.accesses) {
+			if (!access.isWrite) {
+				isNeeded[access.resource] = true;
+			}
+		}
+	}
+
+	_livePasses.clear();
+	_livePasses.reserve(liveCount);
+	for (uint32_t i = 0; i < (uint32_t)_passes.size(); ++i) {
+		if (_passes[i].position != UINT32_MAX) {
+			_passes[i].position = (uint32_t)_livePasses.size();
+			_livePasses.push_back(i);
+		}
+	}
+}
+
+void RenderGraph::_AssignPhysicalResources() noexcept {
+	const uint32_t resourceCount = (uint32_t)_resources.size();
+
+	_firstPositions.assign(resourceCount, UINT32_MAX);
+	_lastPositions.assign(resourceCount, 0);
+
+	for (uint32_t position = 0; position < (uint32_t)_livePasses.size(); ++position) {
+		for (const _Access& access : _passes[_livePasses[position]].accesses) {
+			_firstPositions[access.resource] = std::min(_firstPositions[access.resource], position);
+			_lastPositions[access.resource] = std::max(_lastPositions[access.resource], position);
+		}
+	}
+
+	_physicalResources.clear();
+	_transientResources.clear();
+
+	// 外部资源各自对应一个物理资源
+	std::vector<uint32_t> transients;
+	for (uint32_t i = 0; i < resourceCount; ++i) {
+		_Resource& resource = _resources[i];
+
+		if (resource.isImported) {
+			resource.physicalIndex = (uint32_t)_physicalResources.size();
+			_physicalResources.push_back({ resource.resource, i, _lastPositions[i] });
+		} else if (_firstPositions[i] == UINT32_MAX) {
+			// 没有存活的 pass 使用
+			resource.physicalIndex = UINT32_MAX;
+		} else {
+			transients.push_back(i);
+		}
+	}
+
+	// 按第一次使用的顺序分配，复用描述相同且生命周期不重叠的物理资源
+	std::stable_sort(transients.begin(), transients.end(), [&](uint32_t a, uint32_t b) {
+		return _firstPositions[a] < _firstPositions[b];
+	});
+
+	const uint32_t firstTransientPhysicalIndex = (uint32_t)_physicalResources.size();
+
+	for (uint32_t i : transients) {
+		_Resource& resource = _resources[i];
+
+		uint32_t physicalIndex = firstTransientPhysicalIndex;
+		for (; physicalIndex < (uint32_t)_physicalResources.size(); ++physicalIndex) {
+			const _PhysicalResource& physical = _physicalResources[physicalIndex];
+			if (physical.lastPosition < _firstPositions[i] &&
+				DirectXHelper::IsSameResourceDesc(_resources[physical.firstResource].desc, resource.desc)) {
+				break;
+			}
+		}
+
+		if (physicalIndex == (uint32_t)_physicalResources.size()) {
+			_physicalResources.push_back({ nullptr, i, _lastPositions[i] });
+			_transientResources.push_back({
+				.physicalIndex = physicalIndex,
+				.desc = resource.desc,
+				.firstPosition = _firstPositions[i],
+				.lastPosition = _lastPositions[i]
+			});
+		} else {
+			_physicalResources[physicalIndex].lastPosition = _lastPositions[i];
+			_transientResources[physicalIndex - firstTransientPhysicalIndex].lastPosition = _lastPositions[i];
+		}
+
+		resource.physicalIndex = physicalIndex;
+	}
+}
+
+void RenderGraph::_ComputeBarriers() noexcept {
+	const uint32_t liveCount = (uint32_t)_livePasses.size();
+	const uint32_t physicalCount = (uint32_t)_physicalResources.size();
+
+	_positionBarriers.resize(liveCount + 1);
+	for (std::vector<Barrier>& barriers : _positionBarriers) {
+		barriers.clear();
+	}
+
+	// 将每个物理资源的访问按顺序分组，连续的只读访问合并为一组
+	_accessGroups.resize(physicalCount);
+	for (std::vector<_AccessGroup>& groups : _accessGroups) {
+		groups.clear();
+	}
+
+	for (uint32_t position = 0; position < liveCount; ++position) {
+		for (const _Access& access : _passes[_livePasses[position]].accesses) {
+			std::vector<_AccessGroup>& groups = _accessGroups[_resources[access.resource].physicalIndex];
+
+			if (!groups.empty()) {
+				_AccessGroup& lastGroup = groups.back();
+				if (lastGroup.lastPosition == position) {
+					// 同一个 pass 多次访问，状态相同或者都是只读状态时才能合并。比如同时读写的 pass
+					// 只能使用 UNORDERED_ACCESS 这样既可读又可写的状态，RENDER_TARGET 和
+					// PIXEL_SHADER_RESOURCE 的组合是无效的。
+					assert(lastGroup.state == access.state ||
+						(!lastGroup.isWrite && !access.isWrite &&
+						IsReadOnlyState(lastGroup.state) && IsReadOnlyState(access.state)));
+					lastGroup.state |= access.state;
+					lastGroup.isWrite |= access.isWrite;
+					continue;
+				}
+
+				// 以 UNORDERED_ACCESS 等写入状态读取时不能和其他读取合并
+				if (!lastGroup.isWrite && !access.isWrite &&
+					IsReadOnlyState(lastGroup.state) && IsReadOnlyState(access.state)) {
+					lastGroup.state |= access.state;
+					lastGroup.lastPosition = position;
+					continue;
+				}
+			}
+
+			groups.push_back({ position, position, access.state, access.isWrite });
+		}
+	}
+
+	const uint32_t firstTransientPhysicalIndex = physicalCount - (uint32_t)_transientResources.size();
+
+	for (uint32_t physicalIndex = 0; physicalIndex < physicalCount; ++physicalIndex) {
+		const _Resource& firstResource = _resources[_physicalResources[physicalIndex].firstResource];
+		const std::vector<_AccessGroup>& groups = _accessGroups[physicalIndex];
+
+		D3D12_RESOURCE_STATES state;
+		bool isPromotable = false;
+		bool isPrevWrite = false;
+		// 拆分屏障最早可以开始的位置
+		uint32_t beginPosition = 0;
+		size_t groupIndex = 0;
+
+		if (firstResource.isImported) {
+			state = firstResource.initialState;
+			isPromotable = firstResource.isBuffer && state == D3D12_RESOURCE_STATE_COMMON;
+		} else {
+			// 瞬态资源以第一次访问的状态创建
+			const _AccessGroup& firstGroup = groups[0];
+			state = firstGroup.state;
+			isPrevWrite = firstGroup.isWrite;
+			beginPosition = firstGroup.lastPosition + 1;
+			groupIndex = 1;
+
+			_transientResources[physicalIndex - firstTransientPhysicalIndex].initialState = state;
+		}
+
+		for (; groupIndex < groups.size(); ++groupIndex) {
+			const _AccessGroup& group = groups[groupIndex];
+
+			if (group.state == state) {
+				if (state == D3D12_RESOURCE_STATE_UNORDERED_ACCESS && (isPrevWrite || group.isWrite)) {
+					_positionBarriers[group.firstPosition].push_back({
+						.resource = physicalIndex,
+						.type = D3D12_RESOURCE_BARRIER_TYPE_UAV,
+						.flags = D3D12_RESOURCE_BARRIER_FLAG_NONE
+					});
+				}
+			} else if (!isPromotable) {
+				_AddTransition(physicalIndex, state, group.state, beginPosition, group.firstPosition);
+			}
+
+			// 只有第一次访问可以隐式提升
+			isPromotable = false;
+			state = group.state;
+			isPrevWrite = group.isWrite;
+			beginPosition = group.lastPosition + 1;
+		}
+
+		if (firstResource.isImported) {
+			if (firstResource.hasFinalState && state != firstResource.finalState) {
+				_AddTransition(physicalIndex, state, firstResource.finalState, beginPosition, liveCount);
+			}
+		} else {
+			// 瞬态资源立即转换回初始状态，之后这块内存可能被其他资源使用
+			const D3D12_RESOURCE_STATES initialState =
+				_transientResources[physicalIndex - firstTransientPhysicalIndex].initialState;
+			if (state != initialState) {
+				_AddTransition(physicalIndex, state, initialState, beginPosition, beginPosition);
+			}
+		}
+	}
+}
+
+void RenderGraph::_AddTransition(
+	uint32_t physicalIndex,
+	D3D12_RESOURCE_STATES stateBefore,
+	D3D12_RESOURCE_STATES stateAfter,
+	uint32_t beginPosition,
+	uint32_t endPosition
+) noexcept {
+	Barrier barrier = {
+		.resource = physicalIndex,
+		.type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION,
+		.stateBefore = stateBefore,
+		.stateAfter = stateAfter,
+		.flags = D3D12_RESOURCE_BARRIER_FLAG_NONE
+	};
+
+	// 拆分屏障的开始和结束必须在同一个命令列表中。命令列表索引不递减，因此两端相同即可。
+	if (beginPosition < endPosition && _GetCommandListIndex(beginPosition) == _GetCommandListIndex(endPosition)) {
+		barrier.flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+		_positionBarriers[beginPosition].push_back(barrier);
+		barrier.flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+	}
+
+	_positionBarriers[endPosition].push_back(barrier);
+}
+
+uint32_t RenderGraph::_GetCommandListIndex(uint32_t position) const noexcept {
+	if (_livePasses.empty()) {
+		return 0;
+	}
+
+	// 结束时的屏障录制到最后一个 pass 所在的命令列表
+	position = std::min(position, (uint32_t)_livePasses.size() - 1);
+	return _passes[_livePasses[position]].commandListIndex;
+}
+
+void RenderGraph::_RecordBarriers(ID3D12GraphicsCommandList* commandList, uint32_t position) const noexcept {
+	const std::vector<Barrier>& barriers = _positionBarriers[position];
+
+	D3D12_RESOURCE_BARRIER d3dBarriers[16];
+	uint32_t count = 0;
+
+	for (const Barrier& barrier : barriers) {
+		ID3D12Resource* resource = _physicalResources[barrier.resource].resource;
+
+		if (barrier.type == D3D12_RESOURCE_BARRIER_TYPE_UAV) {
+			d3dBarriers[count++] = CD3DX12_RESOURCE_BARRIER::UAV(resource);
+		} else if (barrier.type == D3D12_RESOURCE_BARRIER_TYPE_ALIASING) {
+			d3dBarriers[count++] = CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, resource);
+		} else {
+			d3dBarriers[count++] = CD3DX12_RESOURCE_BARRIER::Transition(resource, barrier.stateBefore,
+				barrier.stateAfter, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, barrier.flags);
+		}
+
+		if (count == (uint32_t)std::size(d3dBarriers)) {
+			commandList->ResourceBarrier(count, d3dBarriers);
+			count = 0;
+		}
+	}
+
+	if (count > 0) {
+		commandList->ResourceBarrier(count, d3dBarriers);
+	}
+
+	// 别名屏障之后渲染目标和深度模板的第一个操作必须是清空、丢弃或复制
+	for (const Barrier& barrier : barriers) {
+		if (barrier.type == D3D12_RESOURCE_BARRIER_TYPE_ALIASING && (barrier.stateAfter &
+			(D3D12_RESOURCE_STATE_RENDER_TARGET | D3D12_RESOURCE_STATE_DEPTH_WRITE))) {
+			commandList->DiscardResource(_physicalResources[barrier.resource].resource, nullptr);
+		}
+	}
+}
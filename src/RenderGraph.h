@@ -0,0 +1,204 @@
+#pragma once
+#include "GpuProfiler.h"
+#include <functional>
+#include <span>
+
+struct RenderGraphResource {
+	uint32_t index = UINT32_MAX;
+
+	bool IsValid() const noexcept {
+		return index != UINT32_MAX;
+	}
+};
+
+// 每帧构建的渲染图。pass 声明读写的资源和状态，Compile 据此剔除无用的 pass、复用生命周期不
+// 重叠的瞬态资源并计算屏障。Compile 不调用 D3D12，相同的输入总是产生相同的结果。
+//
+// 屏障的计算规则：
+// 1. 连续的只读访问合并为一次转换，状态为所有读取状态的并集。一个 pass 多次访问同一个资源时
+//    状态必须相同或者都是只读状态，同时读写只能使用 UNORDERED_ACCESS 这样的可写状态。
+// 2. 同一个命令列表中两次访问之间有其他 pass 时使用拆分屏障
+// 3. 连续写入 UAV 时插入 UAV 屏障
+// 4. 处于 COMMON 状态的缓冲区第一次访问时隐式提升，无需屏障
+// 5. 每个 pass 之前的屏障一次提交
+// 6. 瞬态资源最后一次使用后转换回创建时的状态，因此可以跨帧复用
+class RenderGraph {
+public:
+	struct Barrier {
+		// 物理资源的索引
+		uint32_t resource;
+		D3D12_RESOURCE_BARRIER_TYPE type;
+		D3D12_RESOURCE_STATES stateBefore;
+		// 对于别名屏障是资源当前的状态
+		D3D12_RESOURCE_STATES stateAfter;
+		D3D12_RESOURCE_BARRIER_FLAGS flags;
+
+		bool operator==(const Barrier&) const noexcept = default;
+	};
+
+	struct TransientResourceInfo {
+		uint32_t physicalIndex;
+		D3D12_RESOURCE_DESC desc;
+		// 资源应以这个状态创建，即第一次访问时的状态
+		D3D12_RESOURCE_STATES initialState;
+		// 使用这个资源的第一个和最后一个 pass 在所有存活 pass 中的位置
+		uint32_t firstPosition;
+		uint32_t lastPosition;
+	};
+
+	RenderGraph() = default;
+	RenderGraph(const RenderGraph&) = delete;
+	RenderGraph(RenderGraph&&) = default;
+
+	// 清空所有 pass 和资源，保留分配的内存
+	void Reset() noexcept;
+
+	// 外部资源，执行完所有 pass 后转换到 finalState
+	RenderGraphResource ImportResource(
+		ID3D12Resource* resource,
+		D3D12_RESOURCE_STATES initialState,
+		D3D12_RESOURCE_STATES finalState
+	) noexcept;
+
+	// 外部缓冲区，开始时处于 COMMON 状态，结束时由 ExecuteCommandLists 衰减回 COMMON
+	RenderGraphResource ImportBuffer(ID3D12Resource* resource) noexcept;
+
+	// 瞬态资源只在这一帧使用，Compile 后由调用者创建并通过 BindTransientResource 绑定
+	RenderGraphResource CreateTransientResource(const D3D12_RESOURCE_DESC& desc) noexcept;
+
+	// commandListIndex 表示 pass 录制到哪个命令列表，命令列表必须按索引顺序提交。
+	// hasSideEffects 为 true 的 pass 不会被剔除。
+	uint32_t AddPass(
+		const char* name,
+		uint32_t commandListIndex,
+		std::function<void(ID3D12GraphicsCommandList*)> execute,
+		bool hasSideEffects = false
+	) noexcept;
+
+	// 只读状态可以组合，比如 PIXEL_SHADER_RESOURCE | NON_PIXEL_SHADER_RESOURCE
+	void ReadResource(uint32_t pass, RenderGraphResource resource, D3D12_RESOURCE_STATES state) noexcept;
+
+	void WriteResource(uint32_t pass, RenderGraphResource resource, D3D12_RESOURCE_STATES state) noexcept;
+
+	void Compile() noexcept;
+
+	const std::vector<TransientResourceInfo>& GetTransientResources() const noexcept {
+		return _transientResources;
+	}
+
+	void BindTransientResource(uint32_t physicalIndex, ID3D12Resource* resource) noexcept {
+		_physicalResources[physicalIndex].resource = resource;
+	}
+
+	// 绑定瞬态资源之后可用，用于创建视图。资源必须被存活的 pass 使用。
+	ID3D12Resource* GetResource(RenderGraphResource resource) const noexcept {
+		const uint32_t physicalIndex = _resources[resource.index].physicalIndex;
+		assert(physicalIndex != UINT32_MAX);
+		return _physicalResources[physicalIndex].resource;
+	}
+
+	// 瞬态资源和其他资源共享内存时，在第一次使用前插入别名屏障。内存中的内容是未定义的，渲染
+	// 目标和深度模板会被丢弃，其他资源由第一个 pass 负责完全覆盖。
+	void AddAliasingBarrier(uint32_t physicalIndex) noexcept;
+
+	bool IsPassCulled(uint32_t pass) const noexcept {
+		return _passes[pass].position == UINT32_MAX;
+	}
+
+	// 在 pass 之前执行的屏障，用于验证 Compile 的结果
+	std::span<const Barrier> GetPassBarriers(uint32_t pass) const noexcept;
+
+	std::span<const Barrier> GetFinalBarriers() const noexcept;
+
+	uint32_t GetPhysicalResourceCount() const noexcept {
+		return (uint32_t)_physicalResources.size();
+	}
+
+	// 按顺序录制属于这个命令列表的 pass，如果最后一个存活 pass 属于这个命令列表，还会录制
+	// 结束时的屏障。不修改渲染图，可以在多个线程同时录制不同的命令列表。profiler 不为空时
+	// 每个 pass 和它之前的屏障是 parentScope 下以 pass 命名的范围。
+	void Execute(
+		ID3D12GraphicsCommandList* commandList,
+		uint32_t commandListIndex,
+		GpuProfiler* profiler = nullptr,
+		uint32_t parentScope = GpuProfiler::NO_SCOPE
+	) const noexcept;
+
+	// 测试 Compile 的耗时，不需要 GPU。返回每次 Compile 的平均耗时，单位为微秒。
+	static double BenchmarkCompile(uint32_t passCount, uint32_t iterationCount) noexcept;
+
+private:
+	struct _Resource {
+		D3D12_RESOURCE_DESC desc;
+		ID3D12Resource* resource;
+		D3D12_RESOURCE_STATES initialState;
+		D3D12_RESOURCE_STATES finalState;
+		bool isImported;
+		bool isBuffer;
+		bool hasFinalState;
+		uint32_t physicalIndex;
+	};
+
+	struct _Access {
+		uint32_t resource;
+		D3D12_RESOURCE_STATES state;
+		bool isWrite;
+	};
+
+	struct _Pass {
+		const char* name;
+		uint32_t commandListIndex;
+		std::function<void(ID3D12GraphicsCommandList*)> execute;
+		std::vector<_Access> accesses;
+		bool hasSideEffects;
+		// 在存活 pass 中的位置，被剔除则为 UINT32_MAX
+		uint32_t position;
+	};
+
+	struct _PhysicalResource {
+		ID3D12Resource* resource;
+		// 对应的第一个逻辑资源
+		uint32_t firstResource;
+		uint32_t lastPosition;
+	};
+
+	// 一个物理资源上状态相同的连续访问
+	struct _AccessGroup {
+		uint32_t firstPosition;
+		uint32_t lastPosition;
+		D3D12_RESOURCE_STATES state;
+		bool isWrite;
+	};
+
+	void _CullPasses() noexcept;
+
+	void _AssignPhysicalResources() noexcept;
+
+	void _ComputeBarriers() noexcept;
+
+	void _AddTransition(
+		uint32_t physicalIndex,
+		D3D12_RESOURCE_STATES stateBefore,
+		D3D12_RESOURCE_STATES stateAfter,
+		uint32_t beginPosition,
+		uint32_t endPosition
+	) noexcept;
+
+	uint32_t _GetCommandListIndex(uint32_t position) const noexcept;
+
+	void _RecordBarriers(ID3D12GraphicsCommandList* commandList, uint32_t position) const noexcept;
+
+	std::vector<_Resource> _resources;
+	std::vector<_Pass> _passes;
+
+	// 编译结果
+	std::vector<uint32_t> _livePasses;
+	std::vector<_PhysicalResource> _physicalResources;
+	std::vector<TransientResourceInfo> _transientResources;
+	// 每个位置之前的屏障，最后一个位置是结束时的屏障
+	std::vector<std::vector<Barrier>> _positionBarriers;
+	// 以下为 Compile 使用的临时数据
+	std::vector<uint32_t> _firstPositions;
+	std::vector<uint32_t> _lastPositions;
+	std::vector<std::vector<_AccessGroup>> _accessGroups;
+};
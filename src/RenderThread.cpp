@@ -0,0 +1,351 @@
+#include "pch.h"
+#include "RenderThread.h"
+#include "WaitMultiplexer.h"
+#include "Win32Helper.h"
+
+// 渲染线程可能向窗口发送消息（如 SetWindowText），UI 线程等待它时必须处理发送来的消息，
+// 否则会死锁。
+static void WaitPumpingSentMessages(HANDLE handle) noexcept {
+	while (true) {
+		const DWORD result = MsgWaitForMultipleObjectsEx(1, &handle, INFINITE, QS_SENDMESSAGE, 0);
+		if (result != WAIT_OBJECT_0 + 1) {
+			return;
+		}
+
+		// 只处理发送的消息，不会从队列中移除消息
+		MSG msg;
+		PeekMessage(&msg, NULL, 0, 0, PM_NOREMOVE | PM_QS_SENDMESSAGE);
+	}
+}
+
+RenderThread::~RenderThread() {
+	Stop();
+}
+
+bool RenderThread::Start(
+	HWND hwndMain,
+	Size size,
+	float dpiScale,
+	const Renderer::Options& options,
+	const Benchmark::Options* benchmarkOptions
+) noexcept {
+	assert(!_thread.joinable());
+	assert(!benchmarkOptions || options.measureFrameTimes);
+
+	_hwndMain = hwndMain;
+	_size = size;
+	_dpiScale = dpiScale;
+	_options = options;
+
+	if (benchmarkOptions) {
+		_benchmark.emplace(*benchmarkOptions);
+	}
+
+	if (FAILED(_wakeEvent.create(wil::EventOptions::None))) {
+		return false;
+	}
+	if (FAILED(_syncEvent.create(wil::EventOptions::None))) {
+		return false;
+	}
+
+	// 第一个同步点是初始化完成
+	const uint64_t syncId = _syncHandshake.Begin();
+	_syncHandshake.Request(syncId);
+
+	try {
+		_thread = std::thread(&RenderThread::_ThreadProc, this);
+	} catch (...) {
+		return false;
+	}
+
+	while (!_syncHandshake.IsCompleted(syncId)) {
+		WaitPumpingSentMessages(_syncEvent.get());
+	}
+
+	return _isInitialized.load(std::memory_order_relaxed);
+}
+
+void RenderThread::Stop() noexcept {
+	if (!_thread.joinable()) {
+		return;
+	}
+
+	// 渲染线程出错时已自行退出
+	if (!_isExited.load(std::memory_order_acquire)) {
+		_PostEvent({ .type = _EventType::Exit });
+	}
+
+	WaitPumpingSentMessages(_thread.native_handle());
+	_thread.join();
+}
+
+void RenderThread::OnResized(Size size, float dpiScale) noexcept {
+	const uint64_t syncId = _syncHandshake.Begin();
+	_PostEvent({ .type = _EventType::Resized, .size = size, .dpiScale = dpiScale, .syncId = syncId });
+
+	while (!_syncHandshake.IsCompleted(syncId)) {
+		WaitPumpingSentMessages(_syncEvent.get());
+	}
+}
+
+void RenderThread::OnDpiChanged(float dpiScale) noexcept {
+	_PostEvent({ .type = _EventType::DpiChanged, .dpiScale = dpiScale });
+}
+
+void RenderThread::OnMinimizedChanged(bool isMinimized) noexcept {
+	_PostEvent({ .type = _EventType::MinimizedChanged, .isMinimized = isMinimized });
+}
+
+void RenderThread::OnResizeStarted() noexcept {
+	_PostEvent({ .type = _EventType::ResizeStarted });
+}
+
+void RenderThread::OnResizeEnded() noexcept {
+	_PostEvent({ .type = _EventType::ResizeEnded });
+}
+
+void RenderThread::OnMsgWindowPosChanged() noexcept {
+	_PostEvent({ .type = _EventType::WindowPosChanged });
+}
+
+void RenderThread::OnMsgDisplayChanged() noexcept {
+	_PostEvent({ .type = _EventType::DisplayChanged });
+}
+
+void RenderThread::_PostEvent(const _Event& event) noexcept {
+	// 事件很少，队列满时让出时间片等待渲染线程处理即可。渲染线程已退出时队列不会再被
+	// 取出，丢弃事件。
+	while (!_eventQueue.TryPush(event)) {
+		if (_isExited.load(std::memory_order_acquire)) {
+			return;
+		}
+
+		_wakeEvent.SetEvent();
+		SwitchToThread();
+	}
+
+	_wakeEvent.SetEvent();
+}
+
+void RenderThread::_ThreadProc() noexcept {
+	winrt::init_apartment(winrt::apartment_type::single_threaded);
+
+	_renderer.emplace();
+	const bool success = _jobSystem.Initialize()
+		&& _renderer->Initialize(_jobSystem, _hwndMain, _size, _dpiScale, _options)
+		&& _Render();
+	_isInitialized.store(success, std::memory_order_relaxed);
+	_syncHandshake.Complete();
+	_syncEvent.SetEvent();
+
+	if (success) {
+		WaitMultiplexer waitMultiplexer;
+
+		while (true) {
+			// DisplayInformation 通过 DispatcherQueue 在这个线程上触发事件
+			MSG msg;
+			while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+				DispatchMessage(&msg);
+			}
+
+			if (!_ProcessEvents()) {
+				break;
+			}
+
+			if (_syncHandshake.IsPending()) {
+				// UI 线程正在等待新帧，立即渲染
+				const bool rendered = _Render();
+				_syncHandshake.Complete();
+				_syncEvent.SetEvent();
+
+				if (!rendered) {
+					PostMessage(_hwndMain, WM_RENDER_FAILED, 1, 0);
+					break;
+				}
+
+				continue;
+			}
+
+			waitMultiplexer.Clear();
+			waitMultiplexer.Add(_wakeEvent.get());
+
+			// 最小化时暂停渲染
+			if (_isMinimized) {
+				waitMultiplexer.Wait(INFINITE);
+				continue;
+			}
+
+			if (_renderer->IsReadyToRender(waitMultiplexer)) {
+				if (!_Render()) {
+					PostMessage(_hwndMain, WM_RENDER_FAILED, 1, 0);
+					break;
+				}
+
+				continue;
+			}
+
+			// 同时等待可用的后备缓冲、GPU、新事件和新消息
+			waitMultiplexer.WaitForFrame(1000);
+		}
+	}
+
+	_renderer.reset();
+
+	// 渲染线程已退出，UI 线程不应再等待
+	_isExited.store(true, std::memory_order_release);
+	_syncHandshake.Abandon();
+	_syncEvent.SetEvent();
+}
+
+bool RenderThread::_ProcessEvents() noexcept {
+	_Event event;
+	while (_eventQueue.TryPop(event)) {
+		switch (event.type) {
+		case _EventType::Resized:
+		{
+			_size = event.size;
+			_dpiScale = event.dpiScale;
+
+			if (_size != _renderer->GetSize()) {
+				_renderer->OnResized(_size, _dpiScale);
+			}
+
+			_syncHandshake.Request(event.syncId);
+			break;
+		}
+		case _EventType::DpiChanged:
+		{
+			_dpiScale = event.dpiScale;
+			_renderer->OnDpiChanged(_dpiScale);
+			break;
+		}
+		case _EventType::MinimizedChanged:
+		{
+			_isMinimized = event.isMinimized;
+			break;
+		}
+		case _EventType::ResizeStarted:
+		{
+			_renderer->OnResizeStarted();
+			break;
+		}
+		case _EventType::ResizeEnded:
+		{
+			_renderer->OnResizeEnded();
+			break;
+		}
+		case _EventType::WindowPosChanged:
+		{
+			_renderer->OnMsgWindowPosChanged();
+			break;
+		}
+		case _EventType::DisplayChanged:
+		{
+			_renderer->OnMsgDisplayChanged();
+			break;
+		}
+		case _EventType::Exit:
+		{
+			return false;
+		}
+		}
+	}
+
+	return true;
+}
+
+bool RenderThread::_Render() noexcept {
+	const ComponentState state = _renderer->Render();
+
+	if (state == ComponentState::NoError) {
+		if (_benchmark) {
+			_AddBenchmarkFrame();
+		}
+		return true;
+	} else if (state == ComponentState::DeviceLost) {
+		return _RecreateRenderer();
+	} else {
+		return false;
+	}
+}
+
+static std::string ToUtf8(std::wstring_view str) noexcept {
+	if (str.empty()) {
+		return {};
+	}
+
+	const int length = WideCharToMultiByte(CP_UTF8, 0, str.data(), (int)str.size(), nullptr, 0, nullptr, nullptr);
+	if (length <= 0) {
+		return {};
+	}
+
+	std::string result(length, '\0');
+	WideCharToMultiByte(CP_UTF8, 0, str.data(), (int)str.size(), result.data(), length, nullptr, nullptr);
+	return result;
+}
+
+void RenderThread::_AddBenchmarkFrame() noexcept {
+	if (!_benchmark->AddFrame(_renderer->GetLastFrameTiming())) {
+		return;
+	}
+
+	const D3D12Context& d3d12Context = _renderer->GetD3D12Context();
+	const PipelineCacheFile::AdapterIdentity& adapterIdentity = d3d12Context.GetAdapterIdentity();
+	const Benchmark::Environment environment = {
+		.adapterName = ToUtf8(d3d12Context.GetAdapterName()),
+		.vendorId = adapterIdentity.vendorId,
+		.deviceId = adapterIdentity.deviceId,
+		.driverVersion = adapterIdentity.driverVersion,
+		.colorMode = _renderer->GetColorModeName(),
+		.commandLine = ToUtf8(GetCommandLine())
+	};
+	const LinearRingAllocator::Stats& uploadRingStats = d3d12Context.GetUploadRingStats();
+	const auto& commandAllocatorPoolStats = d3d12Context.GetCommandAllocatorPoolStats();
+	const HeapAllocator::Stats heapAllocatorStats = d3d12Context.GetHeapAllocatorStats();
+	// 管线编译的统计单位为微秒
+	const Renderer::PipelineStats& pipelineStats = _renderer->GetPipelineStats();
+	using ColorMode = ShaderPermutations::ColorMode;
+	const Benchmark::RendererStats rendererStats = {
+		.uploadLastFrameBytes = uploadRingStats.lastFrameBytes,
+		.uploadMaxFrameBytes = uploadRingStats.maxFrameBytes,
+		.uploadWrapCount = uploadRingStats.wrapCount,
+		.uploadStallCount = uploadRingStats.stallCount,
+		.commandAllocatorCount = commandAllocatorPoolStats.totalCount,
+		.commandAllocatorInUseCount = commandAllocatorPoolStats.inUseCount,
+		.maxCommandAllocatorCount = commandAllocatorPoolStats.maxTotalCount,
+		.maxCommandAllocatorInUseCount = commandAllocatorPoolStats.maxInUseCount,
+		.heapCount = heapAllocatorStats.heapCount,
+		.heapSize = heapAllocatorStats.heapSize,
+		.heapUsedSize = heapAllocatorStats.usedSize,
+		.heapRequestedSize = heapAllocatorStats.requestedSize,
+		.largestFreeBlockSize = heapAllocatorStats.largestFreeBlockSize,
+		.freeBlockCount = heapAllocatorStats.freeBlockCount,
+		.placedResourceCount = heapAllocatorStats.placedResourceCount,
+		.committedResourceCount = heapAllocatorStats.committedResourceCount,
+		.sdrPipelineCompileTime = pipelineStats.compileTimes[(size_t)ColorMode::SDR] / 1000.0,
+		.advancedColorPipelineCompileTime = pipelineStats.compileTimes[(size_t)ColorMode::AdvancedColor] / 1000.0,
+		.hdr10PipelineCompileTime = pipelineStats.compileTimes[(size_t)ColorMode::HDR10] / 1000.0,
+		.pipelineWaitTime = pipelineStats.waitTime / 1000.0,
+		.deferredColorModeSwitchCount = pipelineStats.deferredSwitchCount
+	};
+	const std::string report = _benchmark->GenerateReport(environment, rendererStats);
+
+	const HRESULT hr = Win32Helper::WriteFileData(_benchmark->GetOptions().outputPath,
+		std::span((const uint8_t*)report.data(), report.size()));
+	PostMessage(_hwndMain, WM_BENCHMARK_COMPLETED, SUCCEEDED(hr) ? 0 : 1, 0);
+
+	// 只报告一次，之后继续渲染直到主窗口退出
+	_benchmark.reset();
+}
+
+bool RenderThread::_RecreateRenderer() noexcept {
+	// 设备丢失重新创建 Renderer
+	_renderer.emplace();
+
+	if (!_renderer->Initialize(_jobSystem, _hwndMain, _size, _dpiScale, _options)) {
+		return false;
+	}
+
+	// 如果设备再次丢失不再尝试恢复
+	return _renderer->Render() == ComponentState::NoError;
+}
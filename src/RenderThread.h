@@ -0,0 +1,109 @@
+#pragma once
+#include "Benchmark.h"
+#include "JobSystem.h"
+#include "Renderer.h"
+#include "SpscQueue.h"
+#include "SyncHandshake.h"
+#include <thread>
+
+// 在独立线程中渲染，Renderer 和 D3D12Context 只在渲染线程访问。UI 线程通过无锁队列发送
+// 窗口事件，因此拖动窗口和菜单的模态循环不会影响渲染。
+class RenderThread {
+public:
+	// 渲染出错时向主窗口发送这个消息，wParam 为退出代码
+	static constexpr UINT WM_RENDER_FAILED = WM_APP + 1;
+	// 基准测试结束并写入报告后向主窗口发送这个消息，wParam 为退出代码
+	static constexpr UINT WM_BENCHMARK_COMPLETED = WM_APP + 2;
+
+	RenderThread() = default;
+	RenderThread(const RenderThread&) = delete;
+	RenderThread(RenderThread&&) = delete;
+
+	~RenderThread();
+
+	// 启动渲染线程并等待第一帧渲染完成。benchmarkOptions 不为空时运行基准测试，options 应启用
+	// measureFrameTimes。
+	bool Start(
+		HWND hwndMain,
+		Size size,
+		float dpiScale,
+		const Renderer::Options& options,
+		const Benchmark::Options* benchmarkOptions = nullptr
+	) noexcept;
+
+	void Stop() noexcept;
+
+	// 下面的方法只能在 UI 线程调用
+
+	// 尺寸变化后必须同步渲染新帧以减少边缘闪烁，返回时新帧已提交
+	void OnResized(Size size, float dpiScale) noexcept;
+
+	void OnDpiChanged(float dpiScale) noexcept;
+
+	void OnMinimizedChanged(bool isMinimized) noexcept;
+
+	void OnResizeStarted() noexcept;
+
+	void OnResizeEnded() noexcept;
+
+	void OnMsgWindowPosChanged() noexcept;
+
+	void OnMsgDisplayChanged() noexcept;
+
+private:
+	enum class _EventType {
+		Resized,
+		DpiChanged,
+		MinimizedChanged,
+		ResizeStarted,
+		ResizeEnded,
+		WindowPosChanged,
+		DisplayChanged,
+		Exit
+	};
+
+	struct _Event {
+		_EventType type;
+		Size size;
+		float dpiScale;
+		bool isMinimized;
+		// 非零表示 UI 线程正在等待这个事件之后的第一帧
+		uint64_t syncId;
+	};
+
+	void _PostEvent(const _Event& event) noexcept;
+
+	void _ThreadProc() noexcept;
+
+	bool _ProcessEvents() noexcept;
+
+	bool _Render() noexcept;
+
+	// 记录成功渲染的帧，基准测试结束时写入报告并通知主窗口
+	void _AddBenchmarkFrame() noexcept;
+
+	bool _RecreateRenderer() noexcept;
+
+	// 渲染线程使用
+	JobSystem _jobSystem;
+	std::optional<Renderer> _renderer;
+	Size _size{};
+	float _dpiScale = 1.0f;
+	bool _isMinimized = false;
+	// 设备丢失重新创建 Renderer 时也使用
+	Renderer::Options _options;
+	std::optional<Benchmark> _benchmark;
+
+	// 两个线程共享
+	std::thread _thread;
+	SpscQueue<_Event, 64> _eventQueue;
+	wil::unique_event_nothrow _wakeEvent;
+	wil::unique_event_nothrow _syncEvent;
+	SyncHandshake _syncHandshake;
+	std::atomic<bool> _isInitialized = false;
+	// 渲染线程已退出消息循环，不再处理事件
+	std::atomic<bool> _isExited = false;
+
+	// UI 线程使用
+	HWND _hwndMain = NULL;
+};
@@ -1,36 +1,192 @@
 #include "pch.h"
 #include "Renderer.h"
-#include "shaders/AdvancedColor_PS.h"
-#include "shaders/AdvancedColor_PS_SM5.h"
-#include "shaders/SimpleVS.h"
-#include "shaders/SimpleVS_SM5.h"
-#include "shaders/sRGB_PS.h"
-#include "shaders/sRGB_PS_SM5.h"
+#include "ColorKernels.h"
+#include "JobSystem.h"
+#include "WaitMultiplexer.h"
+#include <algorithm>
 #include <dispatcherqueue.h>
 #include <windows.graphics.display.interop.h>
 
-static constexpr float SCENE_REFERRED_SDR_WHITE_LEVEL = 80.0f;
+// 线性颜色，WCG/HDR 下乘以 SDR 内容亮度，使用 LUT 时由 LUT 完成
+static constexpr float CLEAR_COLOR[] = { 0.8f, 0.8f, 0.6f };
 
-struct VertexPositionTexture {
-	DirectX::XMFLOAT2 position;
-	DirectX::XMFLOAT2 texCoord;
+// 清屏不经过像素着色器，在 CPU 上完成 shaders/ColorOutput.hlsli 中的编码
+static void EncodeHDR10(float (&color)[4]) noexcept {
+	float* const channels[] = { &color[0], &color[1], &color[2] };
+	ColorKernels::TransformGamut(channels, channels, 1, ColorKernels::BT709_TO_BT2020);
+	ColorKernels::LinearToPQ(color, color, 3, ColorKernels::SCRGB_WHITE_NITS / ColorKernels::PQ_MAX_NITS);
+}
 
-	static constexpr D3D12_INPUT_ELEMENT_DESC InputElements[] = {
-		{ "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
-	};
+// VertexPositionTexture 的输入布局，不使用顶点拉取时使用
+static constexpr D3D12_INPUT_ELEMENT_DESC VERTEX_INPUT_ELEMENTS[] = {
+	{ "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
 };
 
+// 渲染图中 pass 使用的命令列表，按索引顺序提交。场景是唯一录制开销较大的部分，因此只在一个
+// 工作线程上录制一个场景命令列表，没有为每个工作线程分配命令列表。需要时可以增加索引，每个
+// 命令列表由一个任务录制。
+static constexpr uint32_t MAIN_COMMAND_LIST = 0;
+static constexpr uint32_t SCENE_COMMAND_LIST = 1;
+
 Renderer::~Renderer() {
+	// 后台编译管线的任务引用这个对象
+	if (_jobSystem) {
+		for (_Pipelines& pipelines : _pipelines) {
+			_jobSystem->Wait(pipelines.counter);
+		}
+	}
+
 	_d3d12Context.WaitForGpu();
 }
 
-bool Renderer::Initialize(HWND hwndMain, Size size, float dpiScale) noexcept {
+bool Renderer::Initialize(
+	JobSystem& jobSystem,
+	HWND hwndMain,
+	Size size,
+	float dpiScale,
+	const Options& options
+) noexcept {
 	_hwndMain = hwndMain;
+	_options = options;
+	_hCurMonitor = MonitorFromWindow(hwndMain, MONITOR_DEFAULTTONEAREST);
+
+	if (!_InitializeDevice(jobSystem, size, dpiScale, false)) {
+		return false;
+	}
+
+	// 失败则回落到使用传统方法获取颜色显示能力
+	_TryInitDisplayInfo();
+
+	if (!_UpdateColorInfo()) {
+		return false;
+	}
+
+	// 直方图使用 wave 指令
+	_isAutoExposureUnsupported = options.useAutoExposure &&
+		(_isSoftwareRendering || !_d3d12Context.IsSM6Supported());
+
+	_UpdateWindowTitle();
+
+	if (!_swapChain.Initialize(_d3d12Context, hwndMain, size, _GetPipelineVariant(_colorInfo), _colorInfo)) {
+		return false;
+	}
+	_swapChain.SetVSyncDisabled(options.disableVSync);
+
+	_measureFrameTimes = options.measureFrameTimes;
+
+	if (_isSoftwareRendering) {
+		return true;
+	}
+
+	_useColorLut = options.useColorLut || (options.useAutoExposure && !_isAutoExposureUnsupported);
+
+	if (!_InitializeGpuRendering()) {
+		return false;
+	}
+
+	// 其他颜色模式的管线在后台编译，切换时通常已经完成
+	const _PipelineVariant curVariant = _GetPipelineVariant(_colorInfo);
+	for (uint32_t i = 0; i < (uint32_t)_PipelineVariant::COUNT; ++i) {
+		const _PipelineVariant variant = (_PipelineVariant)i;
+		if (variant == curVariant || (variant == _PipelineVariant::HDR10 && !_options.preferHDR10)) {
+			continue;
+		}
+
+		if (FAILED(_CompilePipelinesAsync(variant))) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+Renderer::SoftwareRenderingBenchmark Renderer::BenchmarkSoftwareRendering(
+	JobSystem& jobSystem,
+	Size size,
+	uint32_t frameCount
+) noexcept {
+	SoftwareRenderingBenchmark result;
+
+	for (bool isSoftwareRendering : { false, true }) {
+		Renderer renderer;
+		if (!renderer._InitializeOffscreen(jobSystem, size, isSoftwareRendering)) {
+			return {};
+		}
+
+		// 第一帧包含纹理的上传和上传缓冲的创建，不计入
+		if (FAILED(renderer._RenderOffscreenFrame())) {
+			return {};
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+
+		for (uint32_t i = 0; i < frameCount; ++i) {
+			if (FAILED(renderer._RenderOffscreenFrame())) {
+				return {};
+			}
+		}
+
+		const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+		const double pixelsPerSecond = (double)size.width * size.height * frameCount / duration.count();
+
+		if (isSoftwareRendering) {
+			result.softwarePixelsPerSecond = pixelsPerSecond;
+		} else {
+			result.warpPixelsPerSecond = pixelsPerSecond;
+		}
+	}
+
+	return result;
+}
+
+HRESULT Renderer::CompareSoftwareRendering(
+	JobSystem& jobSystem,
+	Size size,
+	SoftwareRenderingComparison& result
+) noexcept {
+	std::vector<uint32_t> pixels[2];
+
+	for (bool isSoftwareRendering : { false, true }) {
+		Renderer renderer;
+		if (!renderer._InitializeOffscreen(jobSystem, size, isSoftwareRendering)) {
+			return E_FAIL;
+		}
+
+		HRESULT hr = renderer._RenderOffscreenFrame();
+		if (FAILED(hr)) {
+			return hr;
+		}
+
+		hr = renderer._ReadOffscreenTarget(pixels[isSoftwareRendering]);
+		if (FAILED(hr)) {
+			return hr;
+		}
+	}
+
+	result = { .pixelCount = size.width * size.height };
+	for (uint32_t i = 0; i < result.pixelCount; ++i) {
+		uint32_t difference = 0;
+		// alpha 总是 1，只比较颜色
+		for (uint32_t c = 0; c < 3; ++c) {
+			const int32_t gpuValue = (pixels[0][i] >> (c * 8)) & 0xFF;
+			const int32_t softwareValue = (pixels[1][i] >> (c * 8)) & 0xFF;
+			difference = std::max(difference, (uint32_t)std::abs(gpuValue - softwareValue));
+		}
+
+		result.maxDifference = std::max(result.maxDifference, difference);
+		if (difference > 1) {
+			++result.mismatchCount;
+		}
+	}
+
+	return S_OK;
+}
+
+bool Renderer::_InitializeDevice(JobSystem& jobSystem, Size size, float dpiScale, bool forceWarp) noexcept {
+	_jobSystem = &jobSystem;
 	_dpiScale = dpiScale;
 	_size = size;
-
-	_hCurMonitor = MonitorFromWindow(hwndMain, MONITOR_DEFAULTTONEAREST);
 	
 	[[maybe_unused]] static int _ = [] {
 #ifdef _DEBUG
@@ -54,75 +210,215 @@ bool Renderer::Initialize(HWND hwndMain, Size size, float dpiScale) noexcept {
 		return 0;
 	}();
 
-	if (!_d3d12Context.Initialize(2)) {
+	if (!_d3d12Context.Initialize(2, forceWarp)) {
 		return false;
 	}
 
-	ID3D12Device5* device = _d3d12Context.GetDevice();
+	// 离屏渲染时由 _InitializeOffscreen 覆盖
+	_isSoftwareRendering = _options.useSoftwareRendering;
+	_softwareFrames.resize(_d3d12Context.GetMaxInFlightFrameCount());
 
-	{
-		const UINT vertexBufferSize = sizeof(VertexPositionTexture) * 22;
-
-		D3D12_HEAP_FLAGS heapFlag = _d3d12Context.IsHeapFlagCreateNotZeroedSupported() ?
-			D3D12_HEAP_FLAG_CREATE_NOT_ZEROED : D3D12_HEAP_FLAG_NONE;
-		CD3DX12_HEAP_PROPERTIES heapProperties(
-			_d3d12Context.IsGPUUploadHeapSupported() ? D3D12_HEAP_TYPE_GPU_UPLOAD : D3D12_HEAP_TYPE_UPLOAD);
-		CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize);
-
-		if (FAILED(device->CreateCommittedResource(
-			&heapProperties,
-			heapFlag,
-			&bufferDesc,
-			_d3d12Context.IsGPUUploadHeapSupported() ? D3D12_RESOURCE_STATE_COMMON : D3D12_RESOURCE_STATE_GENERIC_READ,
+	return true;
+}
+
+bool Renderer::_InitializeGpuRendering() noexcept {
+	_isVertexPulling = _d3d12Context.IsSM6Supported();
+
+	_vertexBufferView.StrideInBytes = sizeof(VertexPositionTexture);
+	_vertexBufferView.SizeInBytes = (UINT)sizeof(_vertices);
+
+	// 集成显卡可高效使用上传堆，每帧直接从上传环中读取顶点，否则复制到显存
+	if (!_isVertexPulling && !_d3d12Context.IsGPUUploadHeapSupported() && !_d3d12Context.IsUMA()) {
+		CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(sizeof(_vertices));
+
+		if (FAILED(_d3d12Context.CreateResource(
+			D3D12_HEAP_TYPE_DEFAULT,
+			bufferDesc,
+			D3D12_RESOURCE_STATE_COMMON,
 			nullptr,
-			IID_PPV_ARGS(&_vertexUploadBuffer)
+			_vertexBuffer,
+			_vertexBufferAllocation
 		))) {
 			return false;
 		}
 
-		// 无需解除映射
-		D3D12_RANGE readRange{};
-		if (FAILED(_vertexUploadBuffer->Map(0, &readRange, &_vertexUploadBufferData))) {
+		_vertexBufferView.BufferLocation = _vertexBuffer->GetGPUVirtualAddress();
+	}
+
+	if (FAILED(_quadBatcher.Initialize(_d3d12Context, *_jobSystem))) {
+		return false;
+	}
+
+	if (_useColorLut) {
+		if (FAILED(_colorLutPass.Initialize(_d3d12Context, *_jobSystem))) {
 			return false;
 		}
 
-		// 集成显卡可高效使用上传堆
-		if (_d3d12Context.IsGPUUploadHeapSupported() || _d3d12Context.IsUMA()) {
-			_vertexBufferView.BufferLocation = _vertexUploadBuffer->GetGPUVirtualAddress();
-		} else {
-			heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
-			if (FAILED(device->CreateCommittedResource(
-				&heapProperties,
-				heapFlag,
-				&bufferDesc,
-				D3D12_RESOURCE_STATE_COMMON,
-				nullptr,
-				IID_PPV_ARGS(&_vertexBuffer)
-			))) {
+		if (FAILED(_d3d12Context.AllocateCpuDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 1, _sceneRtv))) {
+			return false;
+		}
+
+		if (_options.useAutoExposure && !_isAutoExposureUnsupported) {
+			if (FAILED(_autoExposurePass.Initialize(_d3d12Context))) {
 				return false;
 			}
+			_useAutoExposure = true;
+		}
 
-			_vertexBufferView.BufferLocation = _vertexBuffer->GetGPUVirtualAddress();
+		if (FAILED(_UpdateColorLut())) {
+			return false;
 		}
-		
-		_vertexBufferView.StrideInBytes = sizeof(VertexPositionTexture);
-		_vertexBufferView.SizeInBytes = vertexBufferSize;
 	}
 
-	// 失败则回落到使用传统方法获取颜色显示能力
-	_TryInitDisplayInfo();
+	// 场景和每种材质的 PSO 并行编译，首帧前等待
+	const _PipelineVariant curVariant = _GetPipelineVariant(_colorInfo);
+	if (FAILED(_CompilePipelinesAsync(curVariant)) || FAILED(_WaitForPipelines(curVariant))) {
+		return false;
+	}
+	_ApplyPipelines(curVariant);
 
-	if (!_UpdateColorInfo()) {
+	return true;
+}
+
+bool Renderer::_InitializeOffscreen(JobSystem& jobSystem, Size size, bool isSoftwareRendering) noexcept {
+	if (!_InitializeDevice(jobSystem, size, 1.0f, true)) {
 		return false;
 	}
 
-	_UpdateWindowTitle();
+	// 两种方式都在 WARP 设备上运行，区别只在于场景由谁渲染
+	_isSoftwareRendering = isSoftwareRendering;
+
+	const CD3DX12_RESOURCE_DESC textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(
+		DXGI_FORMAT_R8G8B8A8_UNORM, size.width, size.height, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+	if (FAILED(_d3d12Context.CreateResource(D3D12_HEAP_TYPE_DEFAULT, textureDesc,
+		D3D12_RESOURCE_STATE_PRESENT, nullptr, _offscreenTarget, _offscreenTargetAllocation))) {
+		return false;
+	}
+
+	if (FAILED(_d3d12Context.AllocateCpuDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 1, _offscreenRtv))) {
+		return false;
+	}
+
+	// 和 SwapChain 相同，以 sRGB 格式写入
+	const D3D12_RENDER_TARGET_VIEW_DESC rtvDesc = {
+		.Format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+		.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D
+	};
+	_d3d12Context.GetDevice()->CreateRenderTargetView(_offscreenTarget.get(), &rtvDesc, _offscreenRtv.cpuHandle);
+
+	return isSoftwareRendering || _InitializeGpuRendering();
+}
+
+HRESULT Renderer::_RenderOffscreenFrame() noexcept {
+	HRESULT hr = _RenderFrame(_offscreenTarget.get(), CD3DX12_CPU_DESCRIPTOR_HANDLE(_offscreenRtv.cpuHandle));
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	hr = _d3d12Context.EndFrame();
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	// 计入 GPU 的耗时，对 WARP 来说就是光栅化的耗时
+	return _d3d12Context.WaitForGpu();
+}
+
+HRESULT Renderer::_ReadOffscreenTarget(std::vector<uint32_t>& pixels) noexcept {
+	const D3D12_RESOURCE_DESC textureDesc = _offscreenTarget->GetDesc();
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+	uint64_t bufferSize;
+	_d3d12Context.GetDevice()->GetCopyableFootprints(
+		&textureDesc, 0, 1, 0, &footprint, nullptr, nullptr, &bufferSize);
+
+	winrt::com_ptr<ID3D12Resource> readbackBuffer;
+	HeapAllocation readbackAllocation;
+	HRESULT hr = _d3d12Context.CreateResource(D3D12_HEAP_TYPE_READBACK, CD3DX12_RESOURCE_DESC::Buffer(bufferSize),
+		D3D12_RESOURCE_STATE_COPY_DEST, nullptr, readbackBuffer, readbackAllocation);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	// 所有路径结束时 _offscreenTarget 都处于 PRESENT 状态
+	uint32_t frameIndex;
+	hr = _d3d12Context.BeginFrame(frameIndex);
+	if (FAILED(hr)) {
+		return hr;
+	}
 
-	if (!_swapChain.Initialize(_d3d12Context, hwndMain, size, _colorInfo)) {
+	ID3D12GraphicsCommandList* commandList = _d3d12Context.GetCommandList();
+	{
+		const D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+			_offscreenTarget.get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_COPY_SOURCE);
+		commandList->ResourceBarrier(1, &barrier);
+	}
+	{
+		const CD3DX12_TEXTURE_COPY_LOCATION dest(readbackBuffer.get(), footprint);
+		const CD3DX12_TEXTURE_COPY_LOCATION src(_offscreenTarget.get(), 0);
+		commandList->CopyTextureRegion(&dest, 0, 0, 0, &src, nullptr);
+	}
+	{
+		const D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
+			_offscreenTarget.get(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_PRESENT);
+		commandList->ResourceBarrier(1, &barrier);
+	}
+
+	hr = commandList->Close();
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	ID3D12CommandList* commandLists[] = { commandList };
+	_d3d12Context.GetCommandQueue()->ExecuteCommandLists(1, commandLists);
+
+	hr = _d3d12Context.EndFrame();
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	hr = _d3d12Context.WaitForGpu();
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	const uint8_t* data;
+	const CD3DX12_RANGE readRange(0, (SIZE_T)bufferSize);
+	hr = readbackBuffer->Map(0, &readRange, (void**)&data);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	const uint32_t width = footprint.Footprint.Width;
+	const uint32_t height = footprint.Footprint.Height;
+	pixels.resize((size_t)width * height);
+	for (uint32_t y = 0; y < height; ++y) {
+		std::memcpy(pixels.data() + (size_t)width * y,
+			data + footprint.Offset + (size_t)footprint.Footprint.RowPitch * y, (size_t)width * 4);
+	}
+
+	const CD3DX12_RANGE writtenRange(0, 0);
+	readbackBuffer->Unmap(0, &writtenRange);
+
+	_d3d12Context.ReleaseResource(std::move(readbackBuffer), readbackAllocation);
+	return S_OK;
+}
+
+bool Renderer::IsReadyToRender(WaitMultiplexer& waitMultiplexer) noexcept {
+	// 出错时立即调用 Render 以便调用者处理
+	if (_state != ComponentState::NoError) {
+		return true;
+	}
+
+	// 和 Render 中的顺序一致
+	if (HANDLE handle = _swapChain.GetFrameWaitHandle()) {
+		waitMultiplexer.Add(handle, [this]() {
+			_swapChain.OnFrameLatencyWaitableObjectSignaled();
+		});
 		return false;
 	}
 
-	if (FAILED(_InitializePSO())) {
+	if (HANDLE handle = _d3d12Context.GetFrameWaitHandle()) {
+		waitMultiplexer.Add(handle);
 		return false;
 	}
 
@@ -134,30 +430,293 @@ ComponentState Renderer::Render(bool waitForGpu) noexcept {
 		return _state;
 	}
 
+	const auto startTime = std::chrono::steady_clock::now();
+
+	if (!_CheckResult(_UpdatePipelineCompilation())) {
+		return _state;
+	}
+
+	// 推迟的颜色模式切换在管线编译完成后重试
+	if (_isColorSpaceUpdatePending && !_IsCompilingPipelines()) {
+		_isColorSpaceUpdatePending = false;
+		if (!_CheckResult(_UpdateColorSpace())) {
+			return _state;
+		}
+	}
+
 	// SwapChain::BeginFrame 和 D3D12Context::BeginFrame 无顺序要求，不过
 	// 前者通常等待时间更久，将它放在前面可以减少等待次数。
 	ID3D12Resource* frameTex;
 	CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle;
 	_swapChain.BeginFrame(&frameTex, rtvHandle);
 
-	uint32_t frameIndex;
-	if (!_CheckResult(_d3d12Context.BeginFrame(frameIndex, _pipelineState.get()))) {
+	if (!_CheckResult(_RenderFrame(frameTex, rtvHandle))) {
+		return _state;
+	}
+
+	if (!_CheckResult(_swapChain.EndFrame(waitForGpu))) {
 		return _state;
 	}
 
+	const auto presentTime = std::chrono::steady_clock::now();
+
+	// D3D12Context::EndFrame 必须在 SwapChain::EndFrame 之后
+	if (!_CheckResult(_d3d12Context.EndFrame())) {
+		return _state;
+	}
+
+	if (_measureFrameTimes) {
+		_frameTiming.cpuTime = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - startTime).count();
+		_frameTiming.presentTime = presentTime;
+	}
+
+	return _state;
+}
+
+HRESULT Renderer::_RenderFrame(ID3D12Resource* frameTex, const CD3DX12_CPU_DESCRIPTOR_HANDLE& rtvHandle) noexcept {
+	uint32_t frameIndex;
+	HRESULT hr = _d3d12Context.BeginFrame(frameIndex, _pipelineState.get());
+	if (FAILED(hr)) {
+		return hr;
+	}
+
 	ID3D12GraphicsCommandList* commandList = _d3d12Context.GetCommandList();
-	
-	if (_shouldUpdateSizeDependentResources) {
-		_shouldUpdateSizeDependentResources = false;
-		_UpdateSizeDependentResources(commandList);
+
+	// 整帧的范围从主命令列表开始，到最后提交的命令列表结束
+	GpuProfiler* profiler = nullptr;
+	uint32_t frameScope = GpuProfiler::NO_SCOPE;
+	if (_measureFrameTimes) {
+		profiler = &_d3d12Context.GetGpuProfiler();
+
+		// BeginFrame 读取到的是之前的帧，所有范围都在整帧之内，因此第一个范围是整帧
+		const GpuProfiler::Frame& gpuFrame = profiler->GetCompletedFrame();
+		if (!gpuFrame.scopes.empty()) {
+			_frameTiming.gpuFrameNumber = gpuFrame.frameNumber;
+			_frameTiming.gpuTime = gpuFrame.scopes[0].endTime - gpuFrame.scopes[0].beginTime;
+		} else {
+			_frameTiming.gpuTime = -1;
+		}
+		_frameTiming.frameNumber = _d3d12Context.GetFrameCount();
+
+		frameScope = profiler->BeginScope(commandList, "Frame");
+	}
+
+	if (_isSoftwareRendering) {
+		hr = _RenderSoftwareFrame(frameTex, frameIndex);
+		if (FAILED(hr)) {
+			return hr;
+		}
+	} else {
+		// 必须在录制场景前完成，场景需要 _vertexBufferView
+		if (!_isVertexPulling) {
+			hr = _UpdateVertices();
+			if (FAILED(hr)) {
+				return hr;
+			}
+		}
+
+		// 上传环只能在这个线程使用，因此在录制场景前打包
+		_SubmitQuads();
+		hr = _quadBatcher.Prepare(_d3d12Context, frameIndex, _size);
+		if (FAILED(hr)) {
+			return hr;
+		}
+
+		if (_useColorLut) {
+			hr = _colorLutPass.Prepare(_d3d12Context);
+			if (FAILED(hr)) {
+				return hr;
+			}
+		}
+
+		if (_useAutoExposure) {
+			// 读取的是之前的帧的直方图，无需等待
+			hr = _autoExposurePass.Prepare(
+				_d3d12Context, frameIndex, _colorInfo.maxLuminance / _colorInfo.sdrWhiteLevel);
+			if (FAILED(hr)) {
+				return hr;
+			}
+			_colorLutPass.SetExposure(_autoExposurePass.GetExposure());
+		}
+	}
+
+	hr = _BuildRenderGraph(frameTex, rtvHandle, frameIndex);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	// 场景在工作线程上录制到使用独立命令分配器的命令列表，和主命令列表的录制并行。CPU 渲染时
+	// 只需复制，没有场景的命令列表。
+	ID3D12GraphicsCommandList* sceneCommandList = nullptr;
+	if (!_isSoftwareRendering) {
+		hr = _d3d12Context.AcquireCommandList(_pipelineState.get(), &sceneCommandList);
+		if (FAILED(hr)) {
+			return hr;
+		}
+	}
+
+	JobSystem::Counter counter;
+	HRESULT sceneHr = S_OK;
+	if (sceneCommandList) {
+		_jobSystem->Dispatch(counter, [&]() {
+			_renderGraph.Execute(sceneCommandList, SCENE_COMMAND_LIST, profiler, frameScope);
+			if (profiler) {
+				profiler->EndScope(sceneCommandList, frameScope);
+			}
+			sceneHr = sceneCommandList->Close();
+		});
 	}
 
+	_renderGraph.Execute(commandList, MAIN_COMMAND_LIST, profiler, frameScope);
+	if (profiler && !sceneCommandList) {
+		profiler->EndScope(commandList, frameScope);
+	}
+
+	hr = commandList->Close();
+	_jobSystem->Wait(counter);
+
+	if (FAILED(hr)) {
+		return hr;
+	}
+	if (FAILED(sceneHr)) {
+		return sceneHr;
+	}
+
+	// 按录制顺序一次提交
+	ID3D12CommandList* commandLists[] = { commandList, sceneCommandList };
+	_d3d12Context.GetCommandQueue()->ExecuteCommandLists(sceneCommandList ? 2 : 1, commandLists);
+	return S_OK;
+}
+
+HRESULT Renderer::_BuildRenderGraph(
+	ID3D12Resource* frameTex,
+	const CD3DX12_CPU_DESCRIPTOR_HANDLE& rtvHandle,
+	uint32_t frameIndex
+) noexcept {
+	_renderGraph.Reset();
+
+	const RenderGraphResource backBuffer = _renderGraph.ImportResource(
+		frameTex, D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_PRESENT);
+
+	if (_isSoftwareRendering) {
+		const uint32_t pass = _renderGraph.AddPass("CopySoftwareFrame", MAIN_COMMAND_LIST,
+			[this, frameTex, frameIndex](ID3D12GraphicsCommandList* commandList) {
+				const CD3DX12_TEXTURE_COPY_LOCATION dest(frameTex, 0);
+				const CD3DX12_TEXTURE_COPY_LOCATION src(
+					_softwareFrames[frameIndex].buffer.get(), _softwareFrameFootprint);
+				commandList->CopyTextureRegion(&dest, 0, 0, 0, &src, nullptr);
+			});
+		_renderGraph.WriteResource(pass, backBuffer, D3D12_RESOURCE_STATE_COPY_DEST);
+
+		_renderGraph.Compile();
+		return _transientResourceAllocator.Allocate(_d3d12Context, _renderGraph);
+	}
+
+	RenderGraphResource vertexBuffer;
+	if (_vertexBuffer) {
+		vertexBuffer = _renderGraph.ImportBuffer(_vertexBuffer.get());
+
+		if (_vertexUpload.resource) {
+			const uint32_t pass = _renderGraph.AddPass("UploadVertices", MAIN_COMMAND_LIST,
+				[this](ID3D12GraphicsCommandList* commandList) {
+					commandList->CopyBufferRegion(_vertexBuffer.get(), 0,
+						_vertexUpload.resource, _vertexUpload.offset, sizeof(_vertices));
+				});
+			_renderGraph.WriteResource(pass, vertexBuffer, D3D12_RESOURCE_STATE_COPY_DEST);
+		}
+	}
+
+	// 纹理和剔除结果由 QuadBatcher 内部的资源传递给场景，它自己管理这些资源的状态
+	_renderGraph.AddPass("PrepareQuads", MAIN_COMMAND_LIST, [this](ID3D12GraphicsCommandList* commandList) {
+		_quadBatcher.RecordUploadAndCulling(commandList);
+	}, true);
+
+	// 使用 LUT 时场景渲染到 scRGB 的中间纹理，由 ColorLutPass 写入后备缓冲
+	RenderGraphResource sceneTarget = backBuffer;
+	CD3DX12_CPU_DESCRIPTOR_HANDLE sceneRtvHandle = rtvHandle;
+	if (_useColorLut) {
+		sceneTarget = _renderGraph.CreateTransientResource(CD3DX12_RESOURCE_DESC::Tex2D(
+			ShaderPermutations::GetRtvFormat(ShaderPermutations::ColorMode::AdvancedColor),
+			_size.width, _size.height, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET));
+		sceneRtvHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(_sceneRtv.cpuHandle);
+	}
+
+	{
+		const uint32_t pass = _renderGraph.AddPass("Clear", MAIN_COMMAND_LIST,
+			[this, sceneRtvHandle](ID3D12GraphicsCommandList* commandList) {
+				// 使用 LUT 时场景中 1.0 为 SDR 白
+				const float scale = _useColorLut ? 1.0f : _colorInfo.sdrWhiteLevel;
+				float clearColor[] = {
+					CLEAR_COLOR[0] * scale,
+					CLEAR_COLOR[1] * scale,
+					CLEAR_COLOR[2] * scale,
+					1.0f
+				};
+				if (_GetSceneColorMode(_GetPipelineVariant(_colorInfo)) == ShaderPermutations::ColorMode::HDR10) {
+					EncodeHDR10(clearColor);
+				}
+				commandList->ClearRenderTargetView(sceneRtvHandle, clearColor, 0, nullptr);
+			});
+		_renderGraph.WriteResource(pass, sceneTarget, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	}
+
+	{
+		const uint32_t pass = _renderGraph.AddPass("Scene", SCENE_COMMAND_LIST,
+			[this, sceneRtvHandle](ID3D12GraphicsCommandList* commandList) {
+				_RecordScene(commandList, sceneRtvHandle);
+			});
+		_renderGraph.WriteResource(pass, sceneTarget, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		if (vertexBuffer.IsValid()) {
+			_renderGraph.ReadResource(pass, vertexBuffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+		}
+	}
+
+	if (_useColorLut) {
+		// 和场景录制到同一个命令列表，描述符堆已由场景设置
+		if (_useAutoExposure) {
+			_autoExposurePass.AddPasses(_renderGraph, SCENE_COMMAND_LIST, sceneTarget, frameIndex, _size);
+		}
+		_colorLutPass.AddPasses(_renderGraph, SCENE_COMMAND_LIST, sceneTarget, backBuffer, rtvHandle, _size);
+	}
+
+	_renderGraph.Compile();
+
+	HRESULT hr = _transientResourceAllocator.Allocate(_d3d12Context, _renderGraph);
+	if (FAILED(hr) || !_useColorLut) {
+		return hr;
+	}
+
+	// 瞬态纹理可能每帧不同，RTV 在录制时才被读取，因此可以覆盖
+	ID3D12Resource* sceneTex = _renderGraph.GetResource(sceneTarget);
+	_d3d12Context.GetDevice()->CreateRenderTargetView(sceneTex, nullptr, _sceneRtv.cpuHandle);
+
+	if (_useAutoExposure) {
+		hr = _autoExposurePass.BindScene(_d3d12Context, sceneTex);
+		if (FAILED(hr)) {
+			return hr;
+		}
+	}
+
+	return _colorLutPass.BindScene(_d3d12Context, sceneTex);
+}
+
+void Renderer::_RecordScene(
+	ID3D12GraphicsCommandList* commandList,
+	const CD3DX12_CPU_DESCRIPTOR_HANDLE& rtvHandle
+) const noexcept {
+	// 支持 bindless 时必须在设置根签名之前设置描述符堆
+	ID3D12DescriptorHeap* descriptorHeap = _d3d12Context.GetShaderVisibleDescriptorHeap();
+	commandList->SetDescriptorHeaps(1, &descriptorHeap);
 	commandList->SetGraphicsRootSignature(_rootSignature.get());
 
-	if (_colorInfo.kind != winrt::AdvancedColorKind::StandardDynamicRange) {
-		// HDR 下提高彩色正方形亮度
-		float boost = _colorInfo.kind == winrt::AdvancedColorKind::WideColorGamut ?
-			1.0f : std::min(_colorInfo.sdrWhiteLevel + 1, _colorInfo.maxLuminance);
+	const float boost = _GetBoost();
+
+	if (_isVertexPulling) {
+		// 布局见 shaders/QuadVS.hlsl
+		const float constants[] = { boost, _dpiScale, (float)_size.width, (float)_size.height };
+		commandList->SetGraphicsRoot32BitConstants(0, (UINT)std::size(constants), constants, 0);
+	} else if (_GetSceneColorMode(_GetPipelineVariant(_colorInfo)) != ShaderPermutations::ColorMode::SDR) {
 		commandList->SetGraphicsRoot32BitConstants(0, 1, &boost, 0);
 	}
 
@@ -169,48 +728,30 @@ ComponentState Renderer::Render(bool waitForGpu) noexcept {
 		CD3DX12_RECT scissorRect(0, 0, (LONG)_size.width, (LONG)_size.height);
 		commandList->RSSetScissorRects(1, &scissorRect);
 	}
-	
-	{
-		CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-			frameTex, D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
-		commandList->ResourceBarrier(1, &barrier);
-	}
 
 	commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
 
-	{
-		const float clearColor[] = {
-			0.8f * _colorInfo.sdrWhiteLevel,
-			0.8f * _colorInfo.sdrWhiteLevel,
-			0.6f * _colorInfo.sdrWhiteLevel,
-			1.0f
-		};
-		commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-	}
-
 	commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-	commandList->IASetVertexBuffers(0, 1, &_vertexBufferView);
-	commandList->DrawInstanced(22, 1, 0, 0);
-	
-	{
-		CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-			frameTex, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-		commandList->ResourceBarrier(1, &barrier);
-	}
-
-	if (!_CheckResult(commandList->Close())) {
-		return _state;
+	if (_isVertexPulling) {
+		// 每个实例是一个正方形
+		commandList->DrawInstanced(SceneGeometry::SQUARE_VERTEX_COUNT, SceneGeometry::SQUARE_COUNT, 0, 0);
+	} else {
+		commandList->IASetVertexBuffers(0, 1, &_vertexBufferView);
+		commandList->DrawInstanced(SceneGeometry::STRIP_VERTEX_COUNT, 1, 0, 0);
 	}
 
-	_d3d12Context.GetCommandQueue()->ExecuteCommandLists(1, CommandListCast(&commandList));
+	_quadBatcher.Record(commandList, boost);
+}
 
-	if (!_CheckResult(_swapChain.EndFrame(waitForGpu))) {
-		return _state;
+float Renderer::_GetBoost() const noexcept {
+	// HDR 下提高彩色正方形亮度
+	if (_colorInfo.kind == winrt::AdvancedColorKind::HighDynamicRange) {
+		const float boost = std::min(_colorInfo.sdrWhiteLevel + 1, _colorInfo.maxLuminance);
+		// 使用 LUT 时场景中 1.0 为 SDR 白
+		return _useColorLut ? boost / _colorInfo.sdrWhiteLevel : boost;
+	} else {
+		return 1.0f;
 	}
-
-	// D3D12Context::EndFrame 必须在 SwapChain::EndFrame 之后
-	_CheckResult(_d3d12Context.EndFrame());
-	return _state;
 }
 
 void Renderer::OnResizeStarted() noexcept {
@@ -246,9 +787,17 @@ void Renderer::OnResized(Size size, float dpiScale) noexcept {
 	}
 }
 
+void Renderer::OnDpiChanged(float dpiScale) noexcept {
+	if (_state != ComponentState::NoError || _dpiScale == dpiScale) {
+		return;
+	}
+
+	_dpiScale = dpiScale;
+	_shouldUpdateSizeDependentResources = true;
+}
+
 void Renderer::OnMsgWindowPosChanged() noexcept {
-	// winrt::DisplayInformation 可用时已通过事件监听颜色配置变化
-	if (_state != ComponentState::NoError || _displayInfo) {
+	if (_state != ComponentState::NoError) {
 		return;
 	}
 
@@ -258,7 +807,13 @@ void Renderer::OnMsgWindowPosChanged() noexcept {
 	}
 	_hCurMonitor = hCurMonitor;
 
-	_CheckResult(_UpdateColorSpace());
+	if (!_displayInfo) {
+		_CheckResult(_UpdateColorSpace());
+	} else if (_useColorLut) {
+		// winrt::DisplayInformation 可用时已通过事件监听颜色配置变化，但 ICC 配置文件随显示器
+		// 改变
+		_CheckResult(_UpdateColorLut());
+	}
 }
 
 void Renderer::OnMsgDisplayChanged() noexcept {
@@ -279,54 +834,116 @@ void Renderer::OnMsgDisplayChanged() noexcept {
 	}
 }
 
-// 调用前需等待 GPU 完成
-void Renderer::_UpdateSizeDependentResources(ID3D12GraphicsCommandList* commandList) noexcept {
-	const float squareWidth = 200.0f * _dpiScale / _size.width * 2.0f;
-	const float squareHeight = 200.0f * _dpiScale / _size.height * 2.0f;
-	alignas(64) VertexPositionTexture triangleVertices[] = {
-		// 左上
-		{ { -1.0f, 1.0f }, { 0.0f, 0.0f } },
-		{ { -1.0f + squareWidth, 1.0f }, { 1.0f, 0.0f } },
-		{ { -1.0f, 1.0f - squareHeight }, { 0.0f, 1.0f } },
-		{ { -1.0f + squareWidth, 1.0f - squareHeight }, { 1.0f, 1.0f } },
-		// 退化
-		{ { -1.0f + squareWidth, 1.0f - squareHeight }, { 0.0f, 0.0f } },
-		{ { 1.0f - squareWidth, 1.0f }, { 0.0f, 0.0f } },
-		// 右上
-		{ { 1.0f - squareWidth, 1.0f }, { 1.0f, 0.0f } },
-		{ { 1.0f, 1.0f }, { 0.0f, 0.0f } },
-		{ { 1.0f - squareWidth, 1.0f - squareHeight }, { 1.0f, 1.0f } },
-		{ { 1.0f, 1.0f - squareHeight }, { 0.0f, 1.0f } },
-		// 退化
-		{ { 1.0f, 1.0f - squareHeight }, { 0.0f, 0.0f } },
-		{ { 1.0f - squareWidth, -1.0f + squareHeight }, { 0.0f, 0.0f } },
-		// 右下
-		{ { 1.0f - squareWidth, -1.0f + squareHeight }, { 1.0f, 1.0f } },
-		{ { 1.0f, -1.0f + squareHeight }, { 0.0f, 1.0f } },
-		{ { 1.0f - squareWidth, -1.0f }, { 1.0f, 0.0f } },
-		{ { 1.0f, -1.0f }, { 0.0f, 0.0f } },
-		// 退化
-		{ { 1.0f, -1.0f }, { 0.0f, 0.0f } },
-		{ { -1.0f, -1.0f + squareHeight }, { 0.0f, 0.0f } },
-		// 左下
-		{ { -1.0f, -1.0f + squareHeight }, { 0.0f, 1.0f } },
-		{ { -1.0f + squareWidth, -1.0f + squareHeight }, { 1.0f, 1.0f } },
-		{ { -1.0f, -1.0f }, { 0.0f, 0.0f } },
-		{ { -1.0f + squareWidth, -1.0f }, { 1.0f, 0.0f } },
+void Renderer::_UpdateSizeDependentResources() noexcept {
+	SceneGeometry::GetStripVertices(_dpiScale, (float)_size.width, (float)_size.height, _vertices);
+}
+
+HRESULT Renderer::_UpdateSoftwareFrames(ID3D12Resource* frameTex) noexcept {
+	const D3D12_RESOURCE_DESC frameDesc = frameTex->GetDesc();
+	const D3D12_SUBRESOURCE_FOOTPRINT& footprint = _softwareFrameFootprint.Footprint;
+	if (_softwareFrames[0].buffer && frameDesc.Width == footprint.Width &&
+		frameDesc.Height == footprint.Height && frameDesc.Format == footprint.Format) {
+		return S_OK;
+	}
+
+	uint64_t bufferSize;
+	_d3d12Context.GetDevice()->GetCopyableFootprints(
+		&frameDesc, 0, 1, 0, &_softwareFrameFootprint, nullptr, nullptr, &bufferSize);
+
+	// 上传环默认为 4MB，而 1080p 的一帧在 SDR 下约 8MB，scRGB 下约 16MB，因此每个在途帧使用
+	// 独立的缓冲。超过堆的大小时 CreateResource 创建提交资源。
+	const CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(bufferSize);
+	for (_SoftwareFrame& frame : _softwareFrames) {
+		// GPU 可能仍在复制旧的缓冲
+		_d3d12Context.ReleaseResource(std::move(frame.buffer), frame.allocation);
+		frame = {};
+
+		HRESULT hr = _d3d12Context.CreateResource(D3D12_HEAP_TYPE_UPLOAD, bufferDesc,
+			D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, frame.buffer, frame.allocation);
+		if (FAILED(hr)) {
+			return hr;
+		}
+
+		// 上传堆可以一直保持映射，CPU 不读取
+		const CD3DX12_RANGE readRange(0, 0);
+		hr = frame.buffer->Map(0, &readRange, (void**)&frame.data);
+		if (FAILED(hr)) {
+			return hr;
+		}
+	}
+
+	return S_OK;
+}
+
+HRESULT Renderer::_RenderSoftwareFrame(ID3D12Resource* frameTex, uint32_t frameIndex) noexcept {
+	HRESULT hr = _UpdateSoftwareFrames(frameTex);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	_SubmitQuads();
+
+	// 交换链的格式决定颜色模式
+	const D3D12_SUBRESOURCE_FOOTPRINT& footprint = _softwareFrameFootprint.Footprint;
+	SoftwareRenderer::Format format;
+	if (footprint.Format == DXGI_FORMAT_R16G16B16A16_FLOAT) {
+		format = SoftwareRenderer::Format::R16G16B16A16_FLOAT;
+	} else if (footprint.Format == DXGI_FORMAT_R10G10B10A2_UNORM) {
+		format = SoftwareRenderer::Format::R10G10B10A2_UNORM;
+	} else {
+		format = SoftwareRenderer::Format::R8G8B8A8_UNORM_SRGB;
+	}
+
+	const SoftwareRenderer::Frame frame = {
+		.width = footprint.Width,
+		.height = footprint.Height,
+		.format = format,
+		.squareSize = SceneGeometry::SQUARE_SIZE * _dpiScale,
+		.clearColor = {
+			CLEAR_COLOR[0] * _colorInfo.sdrWhiteLevel,
+			CLEAR_COLOR[1] * _colorInfo.sdrWhiteLevel,
+			CLEAR_COLOR[2] * _colorInfo.sdrWhiteLevel
+		},
+		.boost = _GetBoost()
 	};
 
-	memcpy(_vertexUploadBufferData, triangleVertices, sizeof(triangleVertices));
+	// D3D12Context::BeginFrame 已等待这个在途帧上次的复制完成
+	_softwareRenderer.Render(*_jobSystem, frame, _softwareFrames[frameIndex].data, footprint.RowPitch);
+	return S_OK;
+}
 
-	if (_vertexBuffer) {
-		commandList->CopyResource(_vertexBuffer.get(), _vertexUploadBuffer.get());
+HRESULT Renderer::_UpdateVertices() noexcept {
+	_vertexUpload = {};
 
-		D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-			_vertexBuffer.get(),
-			D3D12_RESOURCE_STATE_COPY_DEST,
-			D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER
-		);
-		commandList->ResourceBarrier(1, &barrier);
+	bool shouldUpload = !_vertexBuffer;
+
+	if (_shouldUpdateSizeDependentResources) {
+		_shouldUpdateSizeDependentResources = false;
+		_UpdateSizeDependentResources();
+		shouldUpload = true;
+	}
+
+	if (!shouldUpload) {
+		return S_OK;
+	}
+
+	// 上传环中的数据只在这一帧有效
+	UploadAllocation allocation;
+	HRESULT hr = _d3d12Context.AllocateUpload(sizeof(_vertices), sizeof(VertexPositionTexture), allocation);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	std::memcpy(allocation.cpuAddress, _vertices, sizeof(_vertices));
+
+	if (_vertexBuffer) {
+		// 由渲染图中的 UploadVertices 复制
+		_vertexUpload = allocation;
+	} else {
+		_vertexBufferView.BufferLocation = allocation.gpuAddress;
 	}
+
+	return S_OK;
 }
 
 bool Renderer::_TryInitDisplayInfo() noexcept {
@@ -420,8 +1037,8 @@ bool Renderer::_UpdateColorInfo() noexcept {
 
 		_colorInfo.kind = acInfo.CurrentAdvancedColorKind();
 		if (_colorInfo.kind == winrt::AdvancedColorKind::HighDynamicRange) {
-			_colorInfo.maxLuminance = acInfo.MaxLuminanceInNits() / SCENE_REFERRED_SDR_WHITE_LEVEL;
-			_colorInfo.sdrWhiteLevel = acInfo.SdrWhiteLevelInNits() / SCENE_REFERRED_SDR_WHITE_LEVEL;
+			_colorInfo.maxLuminance = acInfo.MaxLuminanceInNits() / ColorKernels::SCRGB_WHITE_NITS;
+			_colorInfo.sdrWhiteLevel = acInfo.SdrWhiteLevelInNits() / ColorKernels::SCRGB_WHITE_NITS;
 		} else {
 			_colorInfo.maxLuminance = 1.0f;
 			_colorInfo.sdrWhiteLevel = 1.0f;
@@ -451,7 +1068,7 @@ bool Renderer::_UpdateColorInfo() noexcept {
 					// DXGI 将 WCG 视为 SDR
 					if (desc.ColorSpace == DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020) {
 						_colorInfo.kind = winrt::AdvancedColorKind::HighDynamicRange;
-						_colorInfo.maxLuminance = desc.MaxLuminance / SCENE_REFERRED_SDR_WHITE_LEVEL;
+						_colorInfo.maxLuminance = desc.MaxLuminance / ColorKernels::SCRGB_WHITE_NITS;
 						_colorInfo.sdrWhiteLevel = GetSDRWhiteLevel(desc.DeviceName);
 					} else {
 						_colorInfo.kind = winrt::AdvancedColorKind::StandardDynamicRange;
@@ -479,123 +1096,326 @@ HRESULT Renderer::_UpdateColorSpace() noexcept {
 	}
 
 	if (oldColorInfo == _colorInfo) {
-		return S_OK;
+		// 颜色配置不变时显示器仍可能改变
+		return _useColorLut ? _UpdateColorLut() : S_OK;
+	}
+
+	// 颜色模式改变时需要改变交换链格式和着色器
+	const _PipelineVariant variant = _GetPipelineVariant(_colorInfo);
+	const bool shouldUpdatePipelines = variant != _GetPipelineVariant(oldColorInfo);
+
+	if (shouldUpdatePipelines && _pipelines[(size_t)variant].isCompiling) {
+		if (!_pipelines[(size_t)variant].counter.IsDone()) {
+			// 编译完成前继续使用旧的颜色模式和管线渲染，由 Render 重试
+			_colorInfo = oldColorInfo;
+			_isColorSpaceUpdatePending = true;
+			++_pipelineStats.deferredSwitchCount;
+			return S_OK;
+		}
+
+		HRESULT hr = _FinishPipelineCompilation(variant);
+		if (FAILED(hr)) {
+			return hr;
+		}
 	}
 
 	_UpdateWindowTitle();
 
-	// 等待 GPU 完成然后改变交换链格式
-	HRESULT hr = _swapChain.OnColorInfoChanged(_colorInfo);
+	// 交换链格式改变时 ResizeBuffers 要求 GPU 不再使用后备缓冲，因此内部会等待 GPU
+	HRESULT hr = _swapChain.OnColorInfoChanged(variant, _colorInfo);
 	if (FAILED(hr)) {
 		return hr;
 	}
 
-	// SDR<->其他的转换需要改变交换链格式和着色器
-	const bool shouldUpdateResources =
-		(oldColorInfo.kind == winrt::AdvancedColorKind::StandardDynamicRange) !=
-		(_colorInfo.kind == winrt::AdvancedColorKind::StandardDynamicRange);
-
-	if (shouldUpdateResources) {
-		hr = _InitializePSO();
-		if (FAILED(hr)) {
-			return hr;
-		}
+	if (shouldUpdatePipelines) {
+		_ApplyPipelines(variant);
 	}
 
-	return S_OK;
+	return _useColorLut ? _UpdateColorLut() : S_OK;
 }
 
-void Renderer::_UpdateWindowTitle() const noexcept {
-	const wchar_t* title;
+const char* Renderer::GetColorModeName() const noexcept {
 	if (_colorInfo.kind == winrt::AdvancedColorKind::StandardDynamicRange) {
-		title = L"D3D12Playground | SDR";
+		return "SDR";
 	} else if (_colorInfo.kind == winrt::AdvancedColorKind::WideColorGamut) {
-		title = L"D3D12Playground | WCG";
+		return "WCG";
+	} else if (_GetPipelineVariant(_colorInfo) == _PipelineVariant::HDR10) {
+		return "HDR10";
 	} else {
-		title = L"D3D12Playground | HDR";
+		return "HDR";
 	}
-	SetWindowText(_hwndMain, title);
 }
 
-HRESULT Renderer::_InitializePSO() noexcept {
-	// 创建根签名
-	winrt::com_ptr<ID3DBlob> signature;
-	if (_colorInfo.kind == winrt::AdvancedColorKind::StandardDynamicRange) {
-		CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc(
-			0, (D3D12_ROOT_PARAMETER1*)nullptr, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+void Renderer::_UpdateWindowTitle() const noexcept {
+	wchar_t title[128];
+	swprintf_s(title, L"D3D12Playground | %hs%s", GetColorModeName(),
+		_isAutoExposureUnsupported ? L" | Auto exposure unsupported (requires SM6 and GPU rendering)" : L"");
+	SetWindowText(_hwndMain, title);
+}
 
-		HRESULT hr = D3DX12SerializeVersionedRootSignature(
-			&rootSignatureDesc, _d3d12Context.GetRootSignatureVersion(), signature.put(), nullptr);
-		if (FAILED(hr)) {
-			return hr;
-		}
+Renderer::_PipelineVariant Renderer::_GetPipelineVariant(const ColorInfo& colorInfo) const noexcept {
+	if (colorInfo.kind == winrt::AdvancedColorKind::StandardDynamicRange) {
+		return _PipelineVariant::SDR;
+	} else if (colorInfo.kind == winrt::AdvancedColorKind::HighDynamicRange && _options.preferHDR10) {
+		return _PipelineVariant::HDR10;
 	} else {
-		D3D12_ROOT_PARAMETER1 rootParam = {
+		// WCG 下显示器不接受 PQ，只能使用 scRGB
+		return _PipelineVariant::AdvancedColor;
+	}
+}
+
+ShaderPermutations::ColorMode Renderer::_GetSceneColorMode(_PipelineVariant variant) const noexcept {
+	return _useColorLut ? ShaderPermutations::ColorMode::AdvancedColor : variant;
+}
+
+HRESULT Renderer::_UpdateColorLut() noexcept {
+	return _colorLutPass.Update(_hCurMonitor, _GetPipelineVariant(_colorInfo), _colorInfo);
+}
+
+HRESULT Renderer::_CreateRootSignature(
+	_PipelineVariant variant,
+	winrt::com_ptr<ID3D12RootSignature>& rootSignature
+) noexcept {
+	using RootLayout = ShaderPermutations::RootLayout;
+
+	const ShaderPermutations::Scene& scene = ShaderPermutations::GetScene(
+		ShaderPermutations::GetShaderTier(_d3d12Context.IsSM6Supported()), _GetSceneColorMode(variant));
+	assert((scene.rootLayout == RootLayout::VertexPulling) == _isVertexPulling);
+
+	if (_d3d12Context.IsBindlessSupported()) {
+		// 所有颜色模式和 QuadBatcher 共用一个根签名，根常量布局和顶点拉取模式相同
+		static_assert(D3D12Context::BINDLESS_ROOT_CONSTANT_COUNT >=
+			ShaderPermutations::VERTEX_PULLING_ROOT_CONSTANT_COUNT);
+		assert(scene.rootLayout == RootLayout::VertexPulling);
+		rootSignature.copy_from(_d3d12Context.GetBindlessRootSignature());
+		return S_OK;
+	}
+
+	D3D12_ROOT_PARAMETER1 rootParam{};
+	UINT rootParamCount = 1;
+	D3D12_ROOT_SIGNATURE_FLAGS flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+
+	switch (scene.rootLayout) {
+	case RootLayout::InputAssembler:
+		rootParamCount = 0;
+		break;
+	case RootLayout::InputAssemblerLuminance:
+		rootParam = {
 			.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS,
 			.Constants = {
 				.Num32BitValues = 1
 			},
 			.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL
 		};
-		CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc(
-			1, &rootParam, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
-
-		HRESULT hr = D3DX12SerializeVersionedRootSignature(
-			&rootSignatureDesc, _d3d12Context.GetRootSignatureVersion(), signature.put(), nullptr);
-		if (FAILED(hr)) {
-			return hr;
-		}
-	}
-
-	ID3D12Device5* device = _d3d12Context.GetDevice();
-
-	HRESULT hr = device->CreateRootSignature(
-		0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&_rootSignature));
-	if (FAILED(hr)) {
-		return hr;
+		break;
+	default:
+		rootParam = {
+			.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS,
+			.Constants = {
+				.Num32BitValues = ShaderPermutations::VERTEX_PULLING_ROOT_CONSTANT_COUNT
+			},
+			.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL
+		};
+		flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
+		break;
 	}
 
-	// 创建 PSO
-	D3D12_SHADER_BYTECODE vsByteCode;
-	D3D12_SHADER_BYTECODE psByteCode;
-	if (_d3d12Context.IsSM6Supported()) {
-		vsByteCode = { SimpleVS, sizeof(SimpleVS) };
+	CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+	rootSignatureDesc.Init_1_1(rootParamCount, rootParamCount == 0 ? nullptr : &rootParam, 0, nullptr, flags);
 
-		if (_colorInfo.kind == winrt::AdvancedColorKind::StandardDynamicRange) {
-			psByteCode = { sRGB_PS, sizeof(sRGB_PS) };
-		} else {
-			psByteCode = { AdvancedColor_PS, sizeof(AdvancedColor_PS) };
-		}
-	} else {
-		vsByteCode = { SimpleVS_SM5, sizeof(SimpleVS_SM5) };
+	return _d3d12Context.CreateRootSignature(rootSignatureDesc, rootSignature);
+}
 
-		if (_colorInfo.kind == winrt::AdvancedColorKind::StandardDynamicRange) {
-			psByteCode = { sRGB_PS_SM5, sizeof(sRGB_PS_SM5) };
-		} else {
-			psByteCode = { AdvancedColor_PS_SM5, sizeof(AdvancedColor_PS_SM5) };
-		}
-	}
+HRESULT Renderer::_CreatePipelineState(
+	_PipelineVariant variant,
+	ID3D12RootSignature* rootSignature,
+	winrt::com_ptr<ID3D12PipelineState>& pipelineState
+) noexcept {
+	const ShaderPermutations::Scene& scene = ShaderPermutations::GetScene(
+		ShaderPermutations::GetShaderTier(_d3d12Context.IsSM6Supported()), _GetSceneColorMode(variant));
+	// 顶点拉取模式没有输入布局
+	const bool hasInputLayout = scene.rootLayout != ShaderPermutations::RootLayout::VertexPulling;
 
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {
-		.pRootSignature = _rootSignature.get(),
-		.VS = vsByteCode,
-		.PS = psByteCode,
+		.pRootSignature = rootSignature,
+		.VS = _d3d12Context.GetShaderByteCode(scene.vs),
+		.PS = _d3d12Context.GetShaderByteCode(scene.ps),
 		.BlendState = {
 			.RenderTarget = {{ .RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL }}
 		},
 		.SampleMask = UINT_MAX,
 		.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT),
 		.InputLayout = {
-			.pInputElementDescs = VertexPositionTexture::InputElements,
-			.NumElements = (UINT)std::size(VertexPositionTexture::InputElements)
+			.pInputElementDescs = hasInputLayout ? VERTEX_INPUT_ELEMENTS : nullptr,
+			.NumElements = hasInputLayout ? (UINT)std::size(VERTEX_INPUT_ELEMENTS) : 0
 		},
 		.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE,
 		.NumRenderTargets = 1,
-		.RTVFormats = { _colorInfo.kind == winrt::AdvancedColorKind::StandardDynamicRange ?
-		DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R16G16B16A16_FLOAT },
+		.RTVFormats = { scene.rtvFormat },
 		.SampleDesc = { .Count = 1 }
 	};
-	return device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&_pipelineState));
+	return _d3d12Context.CreateGraphicsPipelineState(psoDesc, pipelineState);
+}
+
+HRESULT Renderer::_CompilePipelinesAsync(_PipelineVariant variant) noexcept {
+	_Pipelines& pipelines = _pipelines[(size_t)variant];
+	assert(!pipelines.isCompiling);
+
+	// 根签名很快，在当前线程创建
+	HRESULT hr = _CreateRootSignature(variant, pipelines.rootSignature);
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	pipelines.hr.store(S_OK, std::memory_order_relaxed);
+	pipelines.isCompiling = true;
+	pipelines.dispatchTime = std::chrono::steady_clock::now();
+
+	// 场景、每种材质和 ColorLutPass 的 PSO 各一个任务
+	_jobSystem->Dispatch(pipelines.counter, [this, &pipelines, variant]() {
+		_CompletePipelineJob(pipelines, 0,
+			_CreatePipelineState(variant, pipelines.rootSignature.get(), pipelines.pipelineState));
+	});
+
+	const ShaderPermutations::ColorMode sceneColorMode = _GetSceneColorMode(variant);
+	for (uint32_t i = 0; i < (uint32_t)QuadMaterial::COUNT; ++i) {
+		_jobSystem->Dispatch(pipelines.counter, [this, &pipelines, sceneColorMode, i]() {
+			_CompletePipelineJob(pipelines, i + 1, _quadBatcher.CreatePipelineState(
+				_d3d12Context, (QuadMaterial)i, sceneColorMode, pipelines.quadPipelineStates[i]));
+		});
+	}
+
+	if (_useColorLut) {
+		// 场景的管线和颜色模式无关，只有这个 PSO 的渲染目标格式不同
+		_jobSystem->Dispatch(pipelines.counter, [this, &pipelines, variant]() {
+			_CompletePipelineJob(pipelines, (uint32_t)pipelines.completionTimes.size() - 1,
+				_colorLutPass.CreatePipelineState(_d3d12Context, variant, pipelines.colorLutPipelineState));
+		});
+	}
+
+	return S_OK;
+}
+
+void Renderer::_CompletePipelineJob(_Pipelines& pipelines, uint32_t jobIndex, HRESULT hr) noexcept {
+	if (FAILED(hr)) {
+		pipelines.hr.store(hr, std::memory_order_relaxed);
+	}
+	// 由 Counter 归零同步到渲染线程
+	pipelines.completionTimes[jobIndex] = std::chrono::steady_clock::now();
+}
+
+HRESULT Renderer::_WaitForPipelines(_PipelineVariant variant) noexcept {
+	_Pipelines& pipelines = _pipelines[(size_t)variant];
+	if (!pipelines.isCompiling) {
+		return S_OK;
+	}
+
+	if (!pipelines.counter.IsDone()) {
+		const auto start = std::chrono::steady_clock::now();
+		_jobSystem->Wait(pipelines.counter);
+		_pipelineStats.waitTime += (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - start).count();
+	}
+
+	return _FinishPipelineCompilation(variant);
+}
+
+HRESULT Renderer::_FinishPipelineCompilation(_PipelineVariant variant) noexcept {
+	_Pipelines& pipelines = _pipelines[(size_t)variant];
+	assert(pipelines.isCompiling && pipelines.counter.IsDone());
+	pipelines.isCompiling = false;
+
+	// 最晚完成的任务决定编译耗时
+	const auto completionTime = *std::max_element(
+		pipelines.completionTimes.begin(), pipelines.completionTimes.end());
+	_pipelineStats.compileTimes[(size_t)variant] = (uint64_t)std::chrono::duration_cast<
+		std::chrono::microseconds>(completionTime - pipelines.dispatchTime).count();
+
+	return pipelines.hr.load(std::memory_order_relaxed);
+}
+
+HRESULT Renderer::_UpdatePipelineCompilation() noexcept {
+	bool isCompiling = false;
+
+	for (uint32_t i = 0; i < (uint32_t)_PipelineVariant::COUNT; ++i) {
+		_Pipelines& pipelines = _pipelines[i];
+		if (!pipelines.isCompiling) {
+			continue;
+		}
+
+		if (pipelines.counter.IsDone()) {
+			HRESULT hr = _FinishPipelineCompilation((_PipelineVariant)i);
+			if (FAILED(hr)) {
+				return hr;
+			}
+		} else {
+			isCompiling = true;
+		}
+	}
+
+	if (!isCompiling && !_isPipelineCacheSaved) {
+		// 所有颜色模式编译完成后保存一次。写入失败不影响渲染，下次启动时重新编译。
+		_d3d12Context.SavePipelineCache();
+		_isPipelineCacheSaved = true;
+	}
+
+	return S_OK;
+}
+
+bool Renderer::_IsCompilingPipelines() const noexcept {
+	return std::any_of(_pipelines.begin(), _pipelines.end(),
+		[](const _Pipelines& pipelines) { return pipelines.isCompiling; });
+}
+
+void Renderer::_ApplyPipelines(_PipelineVariant variant) noexcept {
+	const _Pipelines& pipelines = _pipelines[(size_t)variant];
+	assert(!pipelines.isCompiling);
+
+	// 所有颜色模式的管线一直保留在 _pipelines 中，因此无需延迟释放
+	_rootSignature = pipelines.rootSignature;
+	_pipelineState = pipelines.pipelineState;
+	_quadBatcher.SetPipelineStates(pipelines.quadPipelineStates);
+	if (_useColorLut) {
+		_colorLutPass.SetPipelineState(pipelines.colorLutPipelineState.get());
+	}
+}
+
+void Renderer::_SubmitQuads() noexcept {
+	// 在窗口中央绘制由小方块组成的网格，三种材质交替，带纹理的方块使用不同的纹理
+	static constexpr uint32_t GRID_SIZE = 32;
+	static constexpr float CELL_SIZE = 8.0f;
+	static constexpr float CELL_SPACING = 4.0f;
+
+	const float cellSize = CELL_SIZE * _dpiScale;
+	const float cellStride = (CELL_SIZE + CELL_SPACING) * _dpiScale;
+	const float left = (_size.width - cellStride * GRID_SIZE + CELL_SPACING * _dpiScale) / 2;
+	const float top = (_size.height - cellStride * GRID_SIZE + CELL_SPACING * _dpiScale) / 2;
+
+	static_assert((uint32_t)SoftwareRenderer::Material::COUNT == (uint32_t)QuadMaterial::COUNT);
+
+	for (uint32_t y = 0; y < GRID_SIZE; ++y) {
+		for (uint32_t x = 0; x < GRID_SIZE; ++x) {
+			const uint32_t material = (x + y) % (uint32_t)QuadMaterial::COUNT;
+			const Quad quad = {
+				.rect = { left + x * cellStride, top + y * cellStride, cellSize, cellSize },
+				.color = { float(x) / (GRID_SIZE - 1), float(y) / (GRID_SIZE - 1), 1.0f, 1.0f },
+				.texture = (x / 3 + y) % QuadBatcher::TEXTURE_COUNT
+			};
+
+			if (_isSoftwareRendering) {
+				_softwareRenderer.AddQuad((SoftwareRenderer::Material)material, {
+					.left = quad.rect.x,
+					.top = quad.rect.y,
+					.width = quad.rect.z,
+					.height = quad.rect.w,
+					.color = { quad.color.x, quad.color.y, quad.color.z },
+					.texture = quad.texture
+				});
+			} else {
+				_quadBatcher.AddQuad((QuadMaterial)material, quad);
+			}
+		}
+	}
 }
 
 bool Renderer::_CheckResult(bool success) noexcept {
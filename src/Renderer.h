@@ -1,16 +1,76 @@
 #pragma once
+#include "AutoExposurePass.h"
+#include "Benchmark.h"
+#include "ColorLutPass.h"
 #include "D3D12Context.h"
+#include "JobSystem.h"
+#include "QuadBatcher.h"
+#include "RenderGraph.h"
+#include "SceneGeometry.h"
+#include "SoftwareRenderer.h"
 #include "SwapChain.h"
+#include "TransientResourceAllocator.h"
+#include <chrono>
+
+class WaitMultiplexer;
 
 class Renderer {
 public:
+	// 管线编译的统计数据，时间单位为微秒
+	struct PipelineStats {
+		// 每种颜色模式从派发到全部完成的时间，依次为 SDR、WCG/HDR 和 HDR10，未使用的为 0
+		std::array<uint64_t, (size_t)ShaderPermutations::ColorMode::COUNT> compileTimes{};
+		// 渲染线程等待编译完成的总时间
+		uint64_t waitTime = 0;
+		// 因管线未就绪而推迟的颜色模式切换次数
+		uint32_t deferredSwitchCount = 0;
+	};
+
+	// 离屏渲染内置场景的吞吐量，单位为每秒像素数，失败时为 0
+	struct SoftwareRenderingBenchmark {
+		double softwarePixelsPerSecond = 0;
+		double warpPixelsPerSecond = 0;
+	};
+
+	// SoftwareRenderer 和 WARP 渲染的内置场景逐像素比较的结果，比较 sRGB 编码后的 8 位值
+	struct SoftwareRenderingComparison {
+		uint32_t pixelCount = 0;
+		// 任一通道相差超过 1 的像素数
+		uint32_t mismatchCount = 0;
+		// 所有通道中最大的差值
+		uint32_t maxDifference = 0;
+	};
+
+	struct Options {
+		// HDR 下使用 HDR10 交换链代替 scRGB，WCG 仍使用 scRGB
+		bool preferHDR10 = false;
+		// 场景渲染到 FP16 的中间纹理，由 ColorLutPass 转换为交换链的格式，SDR 下应用显示器的 ICC
+		// 配置文件。CPU 渲染时忽略。
+		bool useColorLut = false;
+		// 根据场景亮度的直方图调整曝光，由 ColorLutPass 应用，因此隐含 useColorLut。需要 SM6，
+		// 不支持或 CPU 渲染时不启用，也不隐含 useColorLut，在窗口标题中报告。
+		bool useAutoExposure = false;
+		// 记录每帧的 CPU 耗时、GPU 耗时和 Present 的时刻，供基准测试使用。GPU 上整帧和渲染图
+		// 的每个 pass 都是 GpuProfiler 的范围。
+		bool measureFrameTimes = false;
+		// 关闭垂直同步，支持时允许撕裂，供基准测试使用。否则帧时间受显示器刷新率限制。
+		bool disableVSync = false;
+		// 由 SoftwareRenderer 在 CPU 上渲染场景，结果复制到后备缓冲。WARP 执行通用的光栅化管线，
+		// 对于内置场景远慢于专门的 CPU 实现，但默认仍使用 GPU 渲染，和显卡上的路径一致。
+		bool useSoftwareRendering = false;
+	};
+
 	Renderer() = default;
 	Renderer(const Renderer&) = delete;
-	Renderer(Renderer&&) = default;
+	// 后台任务引用 this
+	Renderer(Renderer&&) = delete;
 
 	~Renderer();
 
-	bool Initialize(HWND hwndMain, Size size, float dpiScale) noexcept;
+	bool Initialize(JobSystem& jobSystem, HWND hwndMain, Size size, float dpiScale, const Options& options) noexcept;
+
+	// 检查 Render 是否可以无阻塞地执行，否则将需要等待的句柄添加到 waitMultiplexer
+	bool IsReadyToRender(WaitMultiplexer& waitMultiplexer) noexcept;
 
 	ComponentState Render(bool waitForGpu = false) noexcept;
 
@@ -24,12 +84,111 @@ public:
 
 	void OnResized(Size size, float dpiScale) noexcept;
 
+	void OnDpiChanged(float dpiScale) noexcept;
+
 	void OnMsgWindowPosChanged() noexcept;
 
 	void OnMsgDisplayChanged() noexcept;
 
+	const PipelineStats& GetPipelineStats() const noexcept {
+		return _pipelineStats;
+	}
+
+	// 上次成功的 Render 的计时，需要 Options::measureFrameTimes
+	const Benchmark::FrameTiming& GetLastFrameTiming() const noexcept {
+		return _frameTiming;
+	}
+
+	const D3D12Context& GetD3D12Context() const noexcept {
+		return _d3d12Context;
+	}
+
+	// 当前的颜色模式，即窗口标题中显示的
+	const char* GetColorModeName() const noexcept;
+
+	// 在 WARP 设备上离屏渲染 SDR 的内置场景，分别测试 SoftwareRenderer 和 WARP 的吞吐量。每帧
+	// 都等待 GPU 完成，不创建窗口。
+	static SoftwareRenderingBenchmark BenchmarkSoftwareRendering(
+		JobSystem& jobSystem,
+		Size size,
+		uint32_t frameCount
+	) noexcept;
+
+	// 在 WARP 设备上离屏渲染 SDR 的内置场景，比较 SoftwareRenderer 和 GPU 渲染的结果
+	static HRESULT CompareSoftwareRendering(
+		JobSystem& jobSystem,
+		Size size,
+		SoftwareRenderingComparison& result
+	) noexcept;
+
 private:
-	void _UpdateSizeDependentResources(ID3D12GraphicsCommandList* commandList) noexcept;
+	// 不使用 HDR10 时 WCG 和 HDR 使用相同的管线
+	using _PipelineVariant = ShaderPermutations::ColorMode;
+
+	// 一种颜色模式的所有管线，由工作线程编译
+	struct _Pipelines {
+		winrt::com_ptr<ID3D12RootSignature> rootSignature;
+		winrt::com_ptr<ID3D12PipelineState> pipelineState;
+		QuadBatcher::PipelineStates quadPipelineStates;
+		// 只在使用 LUT 时编译
+		winrt::com_ptr<ID3D12PipelineState> colorLutPipelineState;
+
+		JobSystem::Counter counter;
+		// 任一任务失败时为失败的结果
+		std::atomic<HRESULT> hr = S_OK;
+		std::chrono::steady_clock::time_point dispatchTime;
+		// 每个任务的完成时间，第一个为场景的 PSO，最后一个为 ColorLutPass 的 PSO
+		std::array<std::chrono::steady_clock::time_point, 2 + (size_t)QuadMaterial::COUNT> completionTimes;
+		// 已派发但尚未由渲染线程确认完成
+		bool isCompiling = false;
+	};
+
+	// CPU 渲染的结果，持久映射的上传缓冲，布局为后备缓冲的 footprint
+	struct _SoftwareFrame {
+		winrt::com_ptr<ID3D12Resource> buffer;
+		HeapAllocation allocation;
+		uint8_t* data = nullptr;
+	};
+
+	// 创建设备和不依赖窗口的资源
+	bool _InitializeDevice(JobSystem& jobSystem, Size size, float dpiScale, bool forceWarp) noexcept;
+
+	// 不使用 SoftwareRenderer 时调用，创建顶点缓冲和 QuadBatcher，编译当前颜色模式的管线并
+	// 等待完成
+	bool _InitializeGpuRendering() noexcept;
+
+	// 只用于 BenchmarkSoftwareRendering 和 CompareSoftwareRendering，渲染到离屏的纹理
+	bool _InitializeOffscreen(JobSystem& jobSystem, Size size, bool isSoftwareRendering) noexcept;
+
+	HRESULT _RenderOffscreenFrame() noexcept;
+
+	// 将 _offscreenTarget 复制到回读缓冲并等待完成，每个像素为 R8G8B8A8
+	HRESULT _ReadOffscreenTarget(std::vector<uint32_t>& pixels) noexcept;
+
+	// 在 SwapChain::BeginFrame 和 SwapChain::EndFrame 之间调用，录制并提交这一帧的命令
+	HRESULT _RenderFrame(ID3D12Resource* frameTex, const CD3DX12_CPU_DESCRIPTOR_HANDLE& rtvHandle) noexcept;
+
+	HRESULT _BuildRenderGraph(
+		ID3D12Resource* frameTex,
+		const CD3DX12_CPU_DESCRIPTOR_HANDLE& rtvHandle,
+		uint32_t frameIndex
+	) noexcept;
+
+	void _RecordScene(
+		ID3D12GraphicsCommandList* commandList,
+		const CD3DX12_CPU_DESCRIPTOR_HANDLE& rtvHandle
+	) const noexcept;
+
+	float _GetBoost() const noexcept;
+
+	void _UpdateSizeDependentResources() noexcept;
+
+	// 后备缓冲的尺寸或格式改变时重新创建 _softwareFrames
+	HRESULT _UpdateSoftwareFrames(ID3D12Resource* frameTex) noexcept;
+
+	HRESULT _RenderSoftwareFrame(ID3D12Resource* frameTex, uint32_t frameIndex) noexcept;
+
+	HRESULT _UpdateVertices() noexcept;
 
 	bool _TryInitDisplayInfo() noexcept;
 
@@ -39,7 +198,42 @@ private:
 
 	void _UpdateWindowTitle() const noexcept;
 
-	HRESULT _InitializePSO() noexcept;
+	_PipelineVariant _GetPipelineVariant(const ColorInfo& colorInfo) const noexcept;
+
+	// 场景和 QuadBatcher 的颜色模式，使用 LUT 时总是 scRGB
+	ShaderPermutations::ColorMode _GetSceneColorMode(_PipelineVariant variant) const noexcept;
+
+	HRESULT _UpdateColorLut() noexcept;
+
+	HRESULT _CreateRootSignature(
+		_PipelineVariant variant,
+		winrt::com_ptr<ID3D12RootSignature>& rootSignature
+	) noexcept;
+
+	// 在工作线程调用
+	HRESULT _CreatePipelineState(
+		_PipelineVariant variant,
+		ID3D12RootSignature* rootSignature,
+		winrt::com_ptr<ID3D12PipelineState>& pipelineState
+	) noexcept;
+
+	// 在当前线程创建根签名，PSO 派发到工作线程编译
+	HRESULT _CompilePipelinesAsync(_PipelineVariant variant) noexcept;
+
+	static void _CompletePipelineJob(_Pipelines& pipelines, uint32_t jobIndex, HRESULT hr) noexcept;
+
+	HRESULT _WaitForPipelines(_PipelineVariant variant) noexcept;
+
+	HRESULT _FinishPipelineCompilation(_PipelineVariant variant) noexcept;
+
+	// 每帧检查后台编译是否完成，全部完成后保存管线缓存
+	HRESULT _UpdatePipelineCompilation() noexcept;
+
+	bool _IsCompilingPipelines() const noexcept;
+
+	void _ApplyPipelines(_PipelineVariant variant) noexcept;
+
+	void _SubmitQuads() noexcept;
 
 	bool _CheckResult(bool success) noexcept;
 
@@ -50,21 +244,65 @@ private:
 	Size _size{};
 	float _dpiScale = 1.0f;
 
+	JobSystem* _jobSystem = nullptr;
 	D3D12Context _d3d12Context;
 	SwapChain _swapChain;
 
+	// 所有可能用到的颜色模式的管线，启动时全部编译
+	std::array<_Pipelines, (size_t)_PipelineVariant::COUNT> _pipelines;
+	PipelineStats _pipelineStats;
+	// 当前颜色模式的根签名和 PSO
 	winrt::com_ptr<ID3D12RootSignature> _rootSignature;
 	winrt::com_ptr<ID3D12PipelineState> _pipelineState;
-	winrt::com_ptr<ID3D12Resource> _vertexUploadBuffer;
-	void* _vertexUploadBufferData = nullptr;
+	// 不支持 SM6 时使用顶点缓冲，否则在顶点着色器中根据 SV_VertexID 生成顶点
+	bool _isVertexPulling = false;
+	VertexPositionTexture _vertices[SceneGeometry::STRIP_VERTEX_COUNT]{};
+	// 独立显卡上顶点位于显存，否则为空
 	winrt::com_ptr<ID3D12Resource> _vertexBuffer;
+	HeapAllocation _vertexBufferAllocation;
 	D3D12_VERTEX_BUFFER_VIEW _vertexBufferView{};
+	// 这一帧需要复制到 _vertexBuffer 的顶点，不需要复制时 resource 为空
+	UploadAllocation _vertexUpload{};
+
+	QuadBatcher _quadBatcher;
+
+	// 使用 LUT 时场景渲染到瞬态纹理，_sceneRtv 每帧重新创建
+	bool _useColorLut = false;
+	ColorLutPass _colorLutPass;
+	DescriptorAllocation _sceneRtv;
+	bool _useAutoExposure = false;
+	// 请求了自动曝光但设备不支持
+	bool _isAutoExposureUnsupported = false;
+	AutoExposurePass _autoExposurePass;
+
+	// Options::useSoftwareRendering 时由 SoftwareRenderer 渲染，结果复制到后备缓冲，不使用管线、
+	// 顶点缓冲和 QuadBatcher
+	bool _isSoftwareRendering = false;
+	SoftwareRenderer _softwareRenderer;
+	// 每个在途帧一个
+	std::vector<_SoftwareFrame> _softwareFrames;
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT _softwareFrameFootprint{};
+
+	// 离屏渲染时代替后备缓冲，格式和 SDR 的交换链相同
+	winrt::com_ptr<ID3D12Resource> _offscreenTarget;
+	HeapAllocation _offscreenTargetAllocation;
+	DescriptorAllocation _offscreenRtv;
+
+	RenderGraph _renderGraph;
+	TransientResourceAllocator _transientResourceAllocator;
+
+	bool _measureFrameTimes = false;
+	Benchmark::FrameTiming _frameTiming;
 
 	HWND _hwndMain = NULL;
 	winrt::DisplayInformation _displayInfo{ nullptr };
 	winrt::DisplayInformation::AdvancedColorInfoChanged_revoker _acInfoChangedRevoker;
 	HMONITOR _hCurMonitor = NULL;
 	ColorInfo _colorInfo;
+	Options _options;
 
 	bool _shouldUpdateSizeDependentResources = true;
+	// 颜色模式改变时目标管线仍在编译，完成后重试
+	bool _isColorSpaceUpdatePending = false;
+	bool _isPipelineCacheSaved = false;
 };
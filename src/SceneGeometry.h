@@ -0,0 +1,80 @@
+#pragma once
+#include <cmath>
+
+// 不依赖 D3D12 和 DirectXMath，以便在其他平台测试顶点的计算。输入布局由使用者定义。
+struct VertexPositionTexture {
+	// 和 DirectX::XMFLOAT2 的布局相同
+	struct Float2 {
+		float x;
+		float y;
+	};
+
+	Float2 position;
+	Float2 texCoord;
+};
+
+namespace SceneGeometry {
+
+// 每个正方形的边长，单位为 DIP
+static constexpr float SQUARE_SIZE = 200.0f;
+// 四个角各一个正方形，每个正方形是 4 个顶点的三角形带
+static constexpr uint32_t SQUARE_COUNT = 4;
+static constexpr uint32_t SQUARE_VERTEX_COUNT = 4;
+// 顶点缓冲将所有正方形合成一个三角形带，之间插入两个退化顶点
+static constexpr uint32_t STRIP_VERTEX_COUNT = SQUARE_COUNT * SQUARE_VERTEX_COUNT + (SQUARE_COUNT - 1) * 2;
+
+// 第 squareIndex 个正方形的第 vertexIndex 个顶点。shaders/QuadVS.hlsl 根据 SV_VertexID 和
+// SV_InstanceID 执行相同的计算，两者必须保持一致。
+inline VertexPositionTexture GetSquareVertex(
+	uint32_t vertexIndex,
+	uint32_t squareIndex,
+	float dpiScale,
+	float viewportWidth,
+	float viewportHeight
+) noexcept {
+	const float squareWidth = SQUARE_SIZE * dpiScale / viewportWidth * 2.0f;
+	const float squareHeight = SQUARE_SIZE * dpiScale / viewportHeight * 2.0f;
+
+	// 顶点顺序为左上、右上、左下、右下
+	const float cornerX = float(vertexIndex & 1);
+	const float cornerY = float(vertexIndex >> 1);
+	// 右侧和下方的正方形纹理坐标镜像，使窗口的角始终对应 (0, 0)
+	const float mirrorX = float(squareIndex & 1);
+	const float mirrorY = float(squareIndex >> 1);
+
+	return {
+		.position = {
+			-1.0f + mirrorX * (2.0f - squareWidth) + cornerX * squareWidth,
+			1.0f - mirrorY * (2.0f - squareHeight) - cornerY * squareHeight
+		},
+		.texCoord = { std::abs(cornerX - mirrorX), std::abs(cornerY - mirrorY) }
+	};
+}
+
+// 不支持顶点拉取时使用的顶点缓冲，所有正方形合成一个三角形带，相邻正方形之间插入两个退化顶点
+inline void GetStripVertices(
+	float dpiScale,
+	float viewportWidth,
+	float viewportHeight,
+	VertexPositionTexture (&vertices)[STRIP_VERTEX_COUNT]
+) noexcept {
+	uint32_t count = 0;
+	for (uint32_t square = 0; square < SQUARE_COUNT; ++square) {
+		for (uint32_t vertex = 0; vertex < SQUARE_VERTEX_COUNT; ++vertex) {
+			const VertexPositionTexture v = GetSquareVertex(vertex, square, dpiScale, viewportWidth, viewportHeight);
+
+			if (vertex == 0 && square != 0) {
+				vertices[count++] = v;
+			}
+
+			vertices[count++] = v;
+
+			if (vertex == SQUARE_VERTEX_COUNT - 1 && square != SQUARE_COUNT - 1) {
+				vertices[count++] = v;
+			}
+		}
+	}
+	assert(count == STRIP_VERTEX_COUNT);
+}
+
+}
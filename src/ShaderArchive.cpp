@@ -0,0 +1,57 @@
+#include "pch.h"
+#include "ShaderArchive.h"
+
+HRESULT ShaderArchive::Initialize(const std::filesystem::path& path) noexcept {
+	wil::unique_hfile hFile(CreateFile2(path.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr));
+	if (!hFile) {
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(hFile.get(), &size)) {
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	if (size.QuadPart == 0 || (uint64_t)size.QuadPart > UINT32_MAX) {
+		return E_FAIL;
+	}
+
+	// 视图保持映射有效，文件和映射的句柄可以关闭
+	wil::unique_handle hFileMapping(CreateFileMapping(hFile.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+	if (!hFileMapping) {
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	_view.reset((uint8_t*)MapViewOfFile(hFileMapping.get(), FILE_MAP_READ, 0, 0, 0));
+	if (!_view) {
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	_data = std::span<const uint8_t>(_view.get(), (size_t)size.QuadPart);
+
+	// 只读取索引，字节码在使用时才从磁盘读取
+	if (ShaderArchiveFile::ReadHeader(_data) != (uint32_t)ShaderId::COUNT) {
+		return E_FAIL;
+	}
+
+	for (uint32_t i = 0; i < (uint32_t)ShaderId::COUNT; ++i) {
+		const ShaderArchiveFile::Entry entry = ShaderArchiveFile::ReadEntry(_data, i);
+		if (entry.nameHash != ShaderArchiveFile::HashName(SHADER_NAMES[i])) {
+			return E_FAIL;
+		}
+	}
+
+	return S_OK;
+}
+
+D3D12_SHADER_BYTECODE ShaderArchive::GetByteCode(
+	ShaderId shader,
+	ShaderPermutations::ShaderTier shaderTier
+) const noexcept {
+	assert(shader < ShaderId::COUNT);
+
+	const ShaderArchiveFile::Entry entry = ShaderArchiveFile::ReadEntry(_data, (uint32_t)shader);
+	const std::span<const uint8_t> byteCode = ShaderArchiveFile::ReadVariant(
+		_data, entry.variants[shaderTier == ShaderPermutations::ShaderTier::SM6 ? 0 : 1]);
+	return { byteCode.data(), byteCode.size() };
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "ShaderArchiveFile.h"
+#include "ShaderPermutations.h"
+
+// 运行时读取着色器包。文件映射到内存，只有设备使用的变体会被访问，其他变体不占用工作集。
+// 初始化后只读，可以在多个线程同时调用。
+class ShaderArchive {
+public:
+	ShaderArchive() = default;
+	ShaderArchive(const ShaderArchive&) = delete;
+	ShaderArchive(ShaderArchive&&) = default;
+
+	// 检查文件头和索引，着色器和 ShaderId 不匹配时失败
+	HRESULT Initialize(const std::filesystem::path& path) noexcept;
+
+	// 失败时返回空，字节码损坏时也是如此
+	D3D12_SHADER_BYTECODE GetByteCode(ShaderId shader, ShaderPermutations::ShaderTier shaderTier) const noexcept;
+
+private:
+	wil::unique_mapview_ptr<uint8_t> _view;
+	std::span<const uint8_t> _data;
+};
@@ -0,0 +1,159 @@
+#pragma once
+#include "Hasher.h"
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// 着色器包的格式：文件头之后是每个着色器的索引，之后是对齐的字节码。每个着色器有两个变体，
+// 依次为 FxCompile 的 ShaderModel 指定的版本和 SM5.1 版本，后者可以为空。着色器的顺序和
+// ShaderId 相同，索引中记录名字的哈希用于检查是否匹配。编译时由 tools/PackShaders 调用 Write
+// 写入。只处理字节，不依赖 D3D12。
+struct ShaderArchiveFile {
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t shaderCount;
+		uint32_t reserved;
+	};
+	static_assert(sizeof(Header) == 16);
+
+	struct Variant {
+		// 相对于文件开头
+		uint32_t offset;
+		// 为 0 表示没有这个变体
+		uint32_t size;
+		// 字节码的哈希，读取时检查
+		uint64_t hash;
+	};
+
+	static constexpr uint32_t VARIANT_COUNT = 2;
+
+	struct Entry {
+		uint64_t nameHash;
+		Variant variants[VARIANT_COUNT];
+	};
+	// 没有填充字节
+	static_assert(sizeof(Entry) == 40);
+
+	// "SHA0"
+	static constexpr uint32_t MAGIC = 0x30414853;
+	// 格式改变时递增
+	static constexpr uint32_t VERSION = 1;
+	static constexpr size_t HEADER_SIZE = sizeof(Header);
+	// 字节码的对齐
+	static constexpr uint32_t ALIGNMENT = 16;
+
+	// 一个着色器的字节码，变体的顺序和 Entry::variants 相同，没有的变体为空
+	struct Shader {
+		std::string_view name;
+		std::span<const uint8_t> variants[VARIANT_COUNT];
+	};
+
+	// 返回整个文件的内容，字节码的总大小超过 4GB 时返回空
+	static std::vector<uint8_t> Write(std::span<const Shader> shaders) noexcept {
+		const uint32_t shaderCount = (uint32_t)shaders.size();
+
+		// 先确定每个变体的位置，字节码依次放在索引之后
+		std::vector<Entry> entries(shaderCount);
+		uint64_t fileSize = HEADER_SIZE + sizeof(Entry) * shaderCount;
+		for (uint32_t i = 0; i < shaderCount; ++i) {
+			entries[i].nameHash = HashName(shaders[i].name);
+
+			for (uint32_t j = 0; j < VARIANT_COUNT; ++j) {
+				const std::span<const uint8_t> byteCode = shaders[i].variants[j];
+				if (byteCode.empty()) {
+					entries[i].variants[j] = {};
+					continue;
+				}
+
+				fileSize = (fileSize + ALIGNMENT - 1) & ~uint64_t(ALIGNMENT - 1);
+				if (fileSize + byteCode.size() > UINT32_MAX) {
+					return {};
+				}
+
+				entries[i].variants[j] = {
+					.offset = (uint32_t)fileSize,
+					.size = (uint32_t)byteCode.size(),
+					.hash = Hasher::Hash(byteCode.data(), byteCode.size())
+				};
+				fileSize += byteCode.size();
+			}
+		}
+
+		// 对齐的空隙为 0
+		std::vector<uint8_t> data((size_t)fileSize);
+
+		const Header header = {
+			.magic = MAGIC,
+			.version = VERSION,
+			.shaderCount = shaderCount,
+			.reserved = 0
+		};
+		std::memcpy(data.data(), &header, sizeof(header));
+		if (shaderCount > 0) {
+			std::memcpy(data.data() + HEADER_SIZE, entries.data(), sizeof(Entry) * shaderCount);
+		}
+
+		for (uint32_t i = 0; i < shaderCount; ++i) {
+			for (uint32_t j = 0; j < VARIANT_COUNT; ++j) {
+				const std::span<const uint8_t> byteCode = shaders[i].variants[j];
+				if (!byteCode.empty()) {
+					std::memcpy(data.data() + entries[i].variants[j].offset, byteCode.data(), byteCode.size());
+				}
+			}
+		}
+
+		return data;
+	}
+
+	// 检查文件头，返回着色器数量，文件无效时返回 0。不读取索引之后的数据。
+	static uint32_t ReadHeader(std::span<const uint8_t> data) noexcept {
+		if (data.size() < HEADER_SIZE) {
+			return 0;
+		}
+
+		// 数据不一定对齐
+		Header header;
+		std::memcpy(&header, data.data(), sizeof(header));
+
+		if (header.magic != MAGIC || header.version != VERSION) {
+			return 0;
+		}
+
+		if ((data.size() - HEADER_SIZE) / sizeof(Entry) < header.shaderCount) {
+			return 0;
+		}
+
+		return header.shaderCount;
+	}
+
+	// index 必须小于 ReadHeader 的结果
+	static Entry ReadEntry(std::span<const uint8_t> data, uint32_t index) noexcept {
+		assert(HEADER_SIZE + sizeof(Entry) * ((size_t)index + 1) <= data.size());
+
+		Entry entry;
+		std::memcpy(&entry, data.data() + HEADER_SIZE + sizeof(Entry) * index, sizeof(entry));
+		return entry;
+	}
+
+	static uint64_t HashName(std::string_view name) noexcept {
+		return Hasher::Hash(name.data(), name.size());
+	}
+
+	// 返回变体的字节码，没有这个变体、越界或哈希不匹配时返回空。只读取这个变体的数据。
+	static std::span<const uint8_t> ReadVariant(std::span<const uint8_t> data, const Variant& variant) noexcept {
+		if (variant.size == 0 || variant.offset > data.size() || variant.size > data.size() - variant.offset) {
+			return {};
+		}
+
+		const std::span<const uint8_t> byteCode = data.subspan(variant.offset, variant.size);
+		if (Hasher::Hash(byteCode.data(), byteCode.size()) != variant.hash) {
+			return {};
+		}
+
+		return byteCode;
+	}
+};
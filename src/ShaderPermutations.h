@@ -0,0 +1,152 @@
+#pragma once
+// 由 D3D12Playground.vcxproj 中的 GenerateShaderList 生成，包含 ShaderId 和每个着色器的变体
+#include "shaders/ShaderList.h"
+
+// 着色器排列。场景管线的每种组合在编译期确定着色器、根签名布局和渲染目标格式，选择时只需
+// 一次查表，无效的组合在编译时报错。添加着色器或颜色模式只需修改表。
+struct ShaderPermutations {
+	enum class ShaderTier {
+		// 不支持 SM6 时使用 FxCompileSM5 编译的版本
+		SM5,
+		SM6,
+		COUNT
+	};
+
+	// 颜色模式只影响交换链格式和像素着色器
+	enum class ColorMode {
+		SDR,
+		// WCG 和 HDR，写入 scRGB
+		AdvancedColor,
+		// 可选的 HDR 模式，像素着色器将 scRGB 转换为 BT.2020 并编码为 PQ，后备缓冲的大小是
+		// scRGB 的一半
+		HDR10,
+		COUNT
+	};
+
+	enum class RootLayout {
+		// 无根参数，使用输入布局
+		InputAssembler,
+		// 像素着色器的 1 个根常量为 WCG/HDR 下的亮度，使用输入布局
+		InputAssemblerLuminance,
+		// 所有着色器共享 4 个根常量，在顶点着色器中生成顶点，布局见 shaders/QuadVS.hlsl。
+		// 和 D3D12Context 的 bindless 根签名兼容。
+		VertexPulling
+	};
+
+	struct Scene {
+		// 用于检查表的顺序
+		ShaderTier shaderTier;
+		ColorMode colorMode;
+
+		ShaderId vs;
+		ShaderId ps;
+		RootLayout rootLayout;
+		DXGI_FORMAT rtvFormat;
+	};
+
+	static constexpr uint32_t VERTEX_PULLING_ROOT_CONSTANT_COUNT = 4;
+
+	// 按 ShaderTier 和 ColorMode 排列
+	static constexpr Scene SCENES[] = {
+		{
+			.shaderTier = ShaderTier::SM5,
+			.colorMode = ColorMode::SDR,
+			.vs = ShaderId::SimpleVS,
+			.ps = ShaderId::sRGB_PS,
+			.rootLayout = RootLayout::InputAssembler,
+			.rtvFormat = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB
+		},
+		{
+			.shaderTier = ShaderTier::SM5,
+			.colorMode = ColorMode::AdvancedColor,
+			.vs = ShaderId::SimpleVS,
+			.ps = ShaderId::AdvancedColor_PS,
+			.rootLayout = RootLayout::InputAssemblerLuminance,
+			.rtvFormat = DXGI_FORMAT_R16G16B16A16_FLOAT
+		},
+		{
+			.shaderTier = ShaderTier::SM5,
+			.colorMode = ColorMode::HDR10,
+			.vs = ShaderId::SimpleVS,
+			.ps = ShaderId::AdvancedColorHDR10_PS,
+			.rootLayout = RootLayout::InputAssemblerLuminance,
+			.rtvFormat = DXGI_FORMAT_R10G10B10A2_UNORM
+		},
+		{
+			.shaderTier = ShaderTier::SM6,
+			.colorMode = ColorMode::SDR,
+			.vs = ShaderId::QuadVS,
+			.ps = ShaderId::sRGB_PS,
+			.rootLayout = RootLayout::VertexPulling,
+			.rtvFormat = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB
+		},
+		{
+			.shaderTier = ShaderTier::SM6,
+			.colorMode = ColorMode::AdvancedColor,
+			.vs = ShaderId::QuadVS,
+			.ps = ShaderId::AdvancedColor_PS,
+			.rootLayout = RootLayout::VertexPulling,
+			.rtvFormat = DXGI_FORMAT_R16G16B16A16_FLOAT
+		},
+		{
+			.shaderTier = ShaderTier::SM6,
+			.colorMode = ColorMode::HDR10,
+			.vs = ShaderId::QuadVS,
+			.ps = ShaderId::AdvancedColorHDR10_PS,
+			.rootLayout = RootLayout::VertexPulling,
+			.rtvFormat = DXGI_FORMAT_R10G10B10A2_UNORM
+		}
+	};
+
+	static constexpr ShaderTier GetShaderTier(bool isSM6Supported) noexcept {
+		return isSM6Supported ? ShaderTier::SM6 : ShaderTier::SM5;
+	}
+
+	static constexpr const Scene& GetScene(ShaderTier shaderTier, ColorMode colorMode) noexcept {
+		return SCENES[(size_t)shaderTier * (size_t)ColorMode::COUNT + (size_t)colorMode];
+	}
+
+	// 交换链格式只取决于颜色模式，见 Validate
+	static constexpr DXGI_FORMAT GetRtvFormat(ColorMode colorMode) noexcept {
+		return GetScene(ShaderTier::SM5, colorMode).rtvFormat;
+	}
+
+	// 字节码位于着色器包中，见 ShaderArchive。SM6 版本的着色器模型由 FxCompile 的 ShaderModel
+	// 决定，SkipSM5 的着色器没有 SM5 版本。
+	static constexpr bool HasByteCode(ShaderId shader, ShaderTier shaderTier) noexcept {
+		return shaderTier == ShaderTier::SM6 || SHADER_HAS_SM5[(size_t)shader];
+	}
+
+	// 检查表的顺序和每种组合的约束
+	static consteval bool Validate() noexcept {
+		if (std::size(SCENES) != (size_t)ShaderTier::COUNT * (size_t)ColorMode::COUNT) {
+			return false;
+		}
+
+		for (size_t i = 0; i < std::size(SCENES); ++i) {
+			const Scene& scene = SCENES[i];
+
+			if (&GetScene(scene.shaderTier, scene.colorMode) != &scene) {
+				return false;
+			}
+
+			// 跳过 SM5.1 的着色器只能用于 SM6
+			if (!HasByteCode(scene.vs, scene.shaderTier) || !HasByteCode(scene.ps, scene.shaderTier)) {
+				return false;
+			}
+
+			// 只有 SM6 支持顶点拉取，bindless 要求 SM6.6，因此 SM6 必须使用兼容的布局
+			if ((scene.rootLayout == RootLayout::VertexPulling) != (scene.shaderTier == ShaderTier::SM6)) {
+				return false;
+			}
+
+			if (scene.rtvFormat != GetRtvFormat(scene.colorMode)) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+};
+
+static_assert(ShaderPermutations::Validate(), "着色器排列表无效");
@@ -0,0 +1,313 @@
+// 不依赖 D3D12，不使用预编译头，以便在其他平台测试
+#include "SoftwareRenderer.h"
+#include "ColorKernels.h"
+#include "JobSystem.h"
+#include "QuadTextures.h"
+#include <algorithm>
+#include <cmath>
+
+using Color = std::array<float, 3>;
+
+// 双线性渐变，四个角依次为 uv 为 (0, 0)、(1, 0)、(0, 1)、(1, 1) 处的颜色
+struct Gradient {
+	Color corners[4];
+};
+
+// shaders/sRGB_PS.hlsl，shaders/QuadGradient_PS.hlsl 在所有颜色模式下也使用它
+static constexpr Gradient SRGB_GRADIENT = { {
+	{ 0.0f, 0.0f, 1.0f },
+	{ 0.5f, 0.0f, 0.5f },
+	{ 0.0f, 1.0f, 0.0f },
+	{ 1.0f, 0.0f, 0.0f }
+} };
+
+// P3 的一个原色在 scRGB 中的值
+static constexpr Color GetP3Primary(uint32_t index) noexcept {
+	const ColorKernels::Matrix3x3& matrix = ColorKernels::P3_TO_BT709;
+	return { matrix.m[0][index], matrix.m[1][index], matrix.m[2][index] };
+}
+
+// shaders/AdvancedColor_PS.hlsl
+static constexpr Gradient P3_GRADIENT = { {
+	GetP3Primary(2),
+	{
+		(GetP3Primary(0)[0] + GetP3Primary(2)[0]) / 2,
+		(GetP3Primary(0)[1] + GetP3Primary(2)[1]) / 2,
+		(GetP3Primary(0)[2] + GetP3Primary(2)[2]) / 2
+	},
+	GetP3Primary(1),
+	GetP3Primary(0)
+} };
+
+// 一行的线性颜色，按通道分开存储
+struct Row {
+	float* channels[3];
+};
+
+// 像素中心位于 [begin, end) 内的像素范围，和光栅化的左上规则一致
+static void GetPixelSpan(float begin, float end, uint32_t limit, uint32_t& first, uint32_t& last) noexcept {
+	first = (uint32_t)std::clamp(std::ceil(begin - 0.5f), 0.0f, (float)limit);
+	last = (uint32_t)std::clamp(std::ceil(end - 0.5f), (float)first, (float)limit);
+}
+
+static void FillSolid(const Row& row, uint32_t first, uint32_t last, const Color& color) noexcept {
+	for (uint32_t c = 0; c < 3; ++c) {
+		std::fill(row.channels[c] + first, row.channels[c] + last, color[c]);
+	}
+}
+
+// 渐变的第 v 行为 a + u * d，已乘以 tint
+static void GetGradientRow(const Gradient& gradient, float v, const Color& tint, Color& a, Color& d) noexcept {
+	for (uint32_t c = 0; c < 3; ++c) {
+		const float left = std::lerp(gradient.corners[0][c], gradient.corners[2][c], v);
+		const float right = std::lerp(gradient.corners[1][c], gradient.corners[3][c], v);
+		a[c] = left * tint[c];
+		d[c] = (right - left) * tint[c];
+	}
+}
+
+// u 从 first 处的 uStart 开始每像素增加 uStep
+static void FillGradient(
+	const Row& row,
+	uint32_t first,
+	uint32_t last,
+	float uStart,
+	float uStep,
+	const Color& a,
+	const Color& d
+) noexcept {
+	for (uint32_t c = 0; c < 3; ++c) {
+		float* channel = row.channels[c] + first;
+		for (uint32_t i = 0, count = last - first; i < count; ++i) {
+			channel[i] = a[c] + (uStart + (float)i * uStep) * d[c];
+		}
+	}
+}
+
+// 纹理坐标 t 处双线性采样的两个纹素和第二个的权重，寻址模式为 CLAMP
+struct BilinearTaps {
+	uint32_t texel0;
+	uint32_t texel1;
+	float weight1;
+};
+
+static BilinearTaps GetBilinearTaps(float t) noexcept {
+	const float texel = t * QuadTextures::SIZE - 0.5f;
+	const float base = std::floor(texel);
+	const int32_t index = (int32_t)base;
+	return {
+		(uint32_t)std::clamp(index, 0, (int32_t)QuadTextures::SIZE - 1),
+		(uint32_t)std::clamp(index + 1, 0, (int32_t)QuadTextures::SIZE - 1),
+		texel - base
+	};
+}
+
+// shaders/QuadTextured_PS.hlsl。纹素只有白色和纹理的颜色两种，sRGB 纹理在过滤前解码，因此采样
+// 结果是两者以彩色纹素的权重插值。
+static void FillTextured(
+	const Row& row,
+	uint32_t first,
+	uint32_t last,
+	float uStart,
+	float uStep,
+	float v,
+	const Color& textureColor,
+	const Color& tint
+) noexcept {
+	const BilinearTaps y = GetBilinearTaps(v);
+
+	for (uint32_t x = first; x < last; ++x) {
+		const BilinearTaps taps = GetBilinearTaps(uStart + (float)(x - first) * uStep);
+
+		const float weight0 = std::lerp(
+			(float)QuadTextures::IsColoredTexel(taps.texel0, y.texel0),
+			(float)QuadTextures::IsColoredTexel(taps.texel1, y.texel0),
+			taps.weight1
+		);
+		const float weight1 = std::lerp(
+			(float)QuadTextures::IsColoredTexel(taps.texel0, y.texel1),
+			(float)QuadTextures::IsColoredTexel(taps.texel1, y.texel1),
+			taps.weight1
+		);
+		const float weight = std::lerp(weight0, weight1, y.weight1);
+
+		for (uint32_t c = 0; c < 3; ++c) {
+			row.channels[c][x] = std::lerp(1.0f, textureColor[c], weight) * tint[c];
+		}
+	}
+}
+
+// 纹理的颜色解码到线性空间
+static const std::array<Color, QuadTextures::COUNT>& GetTextureColors() noexcept {
+	static const std::array<Color, QuadTextures::COUNT> colors = [] {
+		float channels[3][QuadTextures::COUNT];
+		float* const dst[3] = { channels[0], channels[1], channels[2] };
+		ColorKernels::UnpackSRGB8(QuadTextures::COLORS, dst, QuadTextures::COUNT);
+
+		std::array<Color, QuadTextures::COUNT> result;
+		for (uint32_t i = 0; i < QuadTextures::COUNT; ++i) {
+			result[i] = { channels[0][i], channels[1][i], channels[2][i] };
+		}
+		return result;
+	}();
+	return colors;
+}
+
+void SoftwareRenderer::AddQuad(Material material, const Quad& quad) noexcept {
+	Quad& added = _quads[(size_t)material].emplace_back(quad);
+
+	// 和 QuadBatcher 打包到 R8G8B8A8_UNORM 的结果相同
+	for (float& c : added.color) {
+		c = std::round(std::clamp(c, 0.0f, 1.0f) * 255.0f) / 255.0f;
+	}
+}
+
+void SoftwareRenderer::Render(JobSystem& jobSystem, const Frame& frame, uint8_t* data, size_t rowPitch) noexcept {
+	jobSystem.ParallelFor(GetTileCount(frame), [&](uint32_t tileIndex) {
+		RenderTile(frame, tileIndex, data, rowPitch);
+	});
+
+	ClearQuads();
+}
+
+void SoftwareRenderer::RenderTile(const Frame& frame, uint32_t tileIndex, uint8_t* data, size_t rowPitch) const noexcept {
+	const uint32_t tileTop = tileIndex * TILE_HEIGHT;
+	const uint32_t tileBottom = std::min(tileTop + TILE_HEIGHT, frame.height);
+	const bool isSRGB = frame.format == Format::R8G8B8A8_UNORM_SRGB;
+
+	// 和这一块相交的矩形在块内覆盖的像素
+	struct Span {
+		float left;
+		float top;
+		float width;
+		float height;
+		uint32_t firstX;
+		uint32_t lastX;
+		uint32_t firstY;
+		uint32_t lastY;
+	};
+
+	const auto getSpan = [&](float left, float top, float width, float height, Span& span) {
+		span = { .left = left, .top = top, .width = width, .height = height };
+		GetPixelSpan(top, top + height, frame.height, span.firstY, span.lastY);
+		span.firstY = std::max(span.firstY, tileTop);
+		span.lastY = std::min(span.lastY, tileBottom);
+		if (span.firstY >= span.lastY) {
+			return false;
+		}
+
+		GetPixelSpan(left, left + width, frame.width, span.firstX, span.lastX);
+		return span.firstX < span.lastX;
+	};
+
+	// 四个角的正方形，右侧和下方的镜像，使窗口的角始终对应 uv 为 (0, 0)。和
+	// SceneGeometry::GetSquareVertex 一致。
+	const float squareSize = frame.squareSize;
+	std::array<Span, 4> squares;
+	std::array<bool, 4> isSquareVisible;
+	for (uint32_t i = 0; i < 4; ++i) {
+		const float left = (i & 1) ? frame.width - squareSize : 0.0f;
+		const float top = (i >> 1) ? frame.height - squareSize : 0.0f;
+		isSquareVisible[i] = getSpan(left, top, squareSize, squareSize, squares[i]);
+	}
+
+	struct QuadSpan {
+		Span span;
+		Material material;
+		const Quad* quad;
+	};
+
+	// 每个线程复用
+	thread_local std::vector<float> rowBuffer;
+	thread_local std::vector<QuadSpan> quadSpans;
+
+	quadSpans.clear();
+	for (uint32_t material = 0; material < (uint32_t)Material::COUNT; ++material) {
+		for (const Quad& quad : _quads[material]) {
+			Span span;
+			if (getSpan(quad.left, quad.top, quad.width, quad.height, span)) {
+				quadSpans.push_back({ span, (Material)material, &quad });
+			}
+		}
+	}
+
+	rowBuffer.resize((size_t)frame.width * 3);
+	const Row row = { { rowBuffer.data(), rowBuffer.data() + frame.width, rowBuffer.data() + frame.width * 2 } };
+
+	const Gradient& sceneGradient = isSRGB ? SRGB_GRADIENT : P3_GRADIENT;
+	const Color boost = { frame.boost, frame.boost, frame.boost };
+	const std::array<Color, QuadTextures::COUNT>& textureColors = GetTextureColors();
+
+	for (uint32_t y = tileTop; y < tileBottom; ++y) {
+		const float centerY = y + 0.5f;
+
+		FillSolid(row, 0, frame.width, frame.clearColor);
+
+		for (uint32_t i = 0; i < 4; ++i) {
+			const Span& square = squares[i];
+			if (!isSquareVisible[i] || y < square.firstY || y >= square.lastY) {
+				continue;
+			}
+
+			float v = (centerY - square.top) / squareSize;
+			if (i >> 1) {
+				v = 1.0f - v;
+			}
+
+			Color a, d;
+			GetGradientRow(sceneGradient, v, boost, a, d);
+
+			float uStart = (square.firstX + 0.5f - square.left) / squareSize;
+			float uStep = 1.0f / squareSize;
+			if (i & 1) {
+				uStart = 1.0f - uStart;
+				uStep = -uStep;
+			}
+
+			FillGradient(row, square.firstX, square.lastX, uStart, uStep, a, d);
+		}
+
+		for (const QuadSpan& quadSpan : quadSpans) {
+			const Span& span = quadSpan.span;
+			if (y < span.firstY || y >= span.lastY) {
+				continue;
+			}
+
+			const Quad& quad = *quadSpan.quad;
+			const Color tint = { quad.color[0] * frame.boost, quad.color[1] * frame.boost, quad.color[2] * frame.boost };
+			const float v = (centerY - span.top) / span.height;
+			const float uStart = (span.firstX + 0.5f - span.left) / span.width;
+			const float uStep = 1.0f / span.width;
+
+			switch (quadSpan.material) {
+			case Material::Solid:
+				FillSolid(row, span.firstX, span.lastX, tint);
+				break;
+			case Material::Gradient:
+			{
+				Color a, d;
+				GetGradientRow(SRGB_GRADIENT, v, tint, a, d);
+				FillGradient(row, span.firstX, span.lastX, uStart, uStep, a, d);
+				break;
+			}
+			default:
+				FillTextured(row, span.firstX, span.lastX, uStart, uStep, v, textureColors[quad.texture], tint);
+				break;
+			}
+		}
+
+		uint8_t* dest = data + rowPitch * y;
+		if (isSRGB) {
+			ColorKernels::PackSRGB8(row.channels, (uint32_t*)dest, frame.width);
+		} else if (frame.format == Format::R16G16B16A16_FLOAT) {
+			ColorKernels::PackHalf(row.channels, (uint16_t*)dest, frame.width);
+		} else {
+			ColorKernels::TransformGamut(row.channels, row.channels, frame.width, ColorKernels::BT709_TO_BT2020);
+			for (float* channel : row.channels) {
+				ColorKernels::LinearToPQ(channel, channel, frame.width,
+					ColorKernels::SCRGB_WHITE_NITS / ColorKernels::PQ_MAX_NITS);
+			}
+			ColorKernels::PackUNorm10(row.channels, (uint32_t*)dest, frame.width);
+		}
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// 在 CPU 上渲染内置场景，指定 Renderer::Options::useSoftwareRendering 时代替 GPU 渲染，结果
+// 由调用者复制到后备缓冲。帧按行分为若干块，每块由一个任务渲染：逐行在线性空间的浮点行缓冲
+// 中依次绘制清屏颜色、四个角的渐变正方形和四边形，再编码为交换链的格式。着色计算和 shaders/
+// 中对应的着色器一致，行内的循环按通道分开存储以便编译器向量化。不依赖 D3D12，也可以作为
+// GPU 渲染结果的参考。
+class SoftwareRenderer {
+public:
+	// 和交换链的格式对应
+	enum class Format {
+		// SDR，写入 sRGB 编码后的值，使用 shaders/sRGB_PS.hlsl 的渐变
+		R8G8B8A8_UNORM_SRGB,
+		// WCG/HDR，写入 scRGB，使用 shaders/AdvancedColor_PS.hlsl 的渐变
+		R16G16B16A16_FLOAT,
+		// HDR10，和 R16G16B16A16_FLOAT 相同，但写入前转换到 BT.2020 并编码为 PQ，见
+		// shaders/ColorOutput.hlsli
+		R10G10B10A2_UNORM
+	};
+
+	// 和 QuadMaterial 一致
+	enum class Material {
+		Solid,
+		Gradient,
+		Textured,
+		COUNT
+	};
+
+	struct Quad {
+		// 左上角和尺寸，单位为像素
+		float left;
+		float top;
+		float width;
+		float height;
+		// 线性颜色，每个分量范围为 [0, 1]。和 GPU 一样量化为 8 位，alpha 总是 1。
+		std::array<float, 3> color;
+		// Material::Textured 使用的纹理，范围为 [0, QuadTextures::COUNT)
+		uint32_t texture = 0;
+	};
+
+	struct Frame {
+		uint32_t width;
+		uint32_t height;
+		Format format;
+		// 四个角的正方形的边长，单位为像素
+		float squareSize;
+		// 线性颜色
+		std::array<float, 3> clearColor;
+		// 正方形和四边形的亮度倍数，和着色器的 boost 相同，SDR 下为 1
+		float boost;
+	};
+
+	// 每块的行数，太小会增加调度开销，太大则块数不足以分给所有工作线程
+	static constexpr uint32_t TILE_HEIGHT = 16;
+
+	SoftwareRenderer() = default;
+	SoftwareRenderer(const SoftwareRenderer&) = delete;
+	SoftwareRenderer(SoftwareRenderer&&) = default;
+
+	static uint32_t GetBytesPerPixel(Format format) noexcept {
+		return format == Format::R16G16B16A16_FLOAT ? 8 : 4;
+	}
+
+	static uint32_t GetTileCount(const Frame& frame) noexcept {
+		return (frame.height + TILE_HEIGHT - 1) / TILE_HEIGHT;
+	}
+
+	// 和 QuadBatcher 一样按材质分组绘制，同一材质按提交顺序绘制
+	void AddQuad(Material material, const Quad& quad) noexcept;
+
+	// 在工作线程并行渲染所有块并清空提交的四边形。data 的每行至少有
+	// frame.width * GetBytesPerPixel(frame.format) 字节，行距为 rowPitch。
+	void Render(JobSystem& jobSystem, const Frame& frame, uint8_t* data, size_t rowPitch) noexcept;
+
+	// 渲染第 tileIndex 块，可以在多个线程同时调用。不清空提交的四边形。
+	void RenderTile(const Frame& frame, uint32_t tileIndex, uint8_t* data, size_t rowPitch) const noexcept;
+
+	void ClearQuads() noexcept {
+		for (std::vector<Quad>& quads : _quads) {
+			quads.clear();
+		}
+	}
+
+private:
+	std::array<std::vector<Quad>, (size_t)Material::COUNT> _quads;
+};
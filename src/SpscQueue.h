@@ -0,0 +1,58 @@
+#pragma once
+#include <array>
+#include <atomic>
+
+// 有界无锁单生产者单消费者队列。TryPush 只能由一个线程调用，TryPop 只能由另一个线程调用。
+template <typename T, uint32_t Capacity>
+class SpscQueue {
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity 必须是 2 的幂");
+
+public:
+	SpscQueue() = default;
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue(SpscQueue&&) = delete;
+
+	// 生产者线程调用，队列已满时返回 false
+	bool TryPush(const T& value) noexcept {
+		const uint32_t tail = _tail.load(std::memory_order_relaxed);
+		if (tail - _cachedHead == Capacity) {
+			// 只在缓存的位置表明已满时才读取消费者的位置，减少缓存行争用
+			_cachedHead = _head.load(std::memory_order_acquire);
+			if (tail - _cachedHead == Capacity) {
+				return false;
+			}
+		}
+
+		_items[tail & (Capacity - 1)] = value;
+		_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// 消费者线程调用，队列为空时返回 false
+	bool TryPop(T& value) noexcept {
+		const uint32_t head = _head.load(std::memory_order_relaxed);
+		if (head == _cachedTail) {
+			_cachedTail = _tail.load(std::memory_order_acquire);
+			if (head == _cachedTail) {
+				return false;
+			}
+		}
+
+		value = std::move(_items[head & (Capacity - 1)]);
+		_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	static constexpr size_t _CACHE_LINE_SIZE = 64;
+
+	// 消费者写入
+	alignas(_CACHE_LINE_SIZE) std::atomic<uint32_t> _head = 0;
+	uint32_t _cachedTail = 0;
+
+	// 生产者写入
+	alignas(_CACHE_LINE_SIZE) std::atomic<uint32_t> _tail = 0;
+	uint32_t _cachedHead = 0;
+
+	alignas(_CACHE_LINE_SIZE) std::array<T, Capacity> _items{};
+};
@@ -1,22 +1,50 @@
 #include "pch.h"
 #include "SwapChain.h"
+#include "ColorKernels.h"
 #include "D3D12Context.h"
 #include "Win32Helper.h"
+#include <algorithm>
 #include <dcomp.h>
 #include <dwmapi.h>
 
+using ColorMode = ShaderPermutations::ColorMode;
+
+// SDR 下 RTV 使用对应的 sRGB 格式
+static DXGI_FORMAT GetBufferFormat(ColorMode colorMode) noexcept {
+	const DXGI_FORMAT rtvFormat = ShaderPermutations::GetRtvFormat(colorMode);
+	return rtvFormat == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB ? DXGI_FORMAT_R8G8B8A8_UNORM : rtvFormat;
+}
+
+static DXGI_COLOR_SPACE_TYPE GetColorSpace(ColorMode colorMode) noexcept {
+	switch (colorMode) {
+	case ColorMode::SDR:
+		return DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_P709;
+	case ColorMode::AdvancedColor:
+		return DXGI_COLOR_SPACE_RGB_FULL_G10_NONE_P709;
+	default:
+		return DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020;
+	}
+}
+
+SwapChain::~SwapChain() {
+	// RTV 只在录制命令时读取，无需等待 GPU
+	if (_graphicContext) {
+		_graphicContext->FreeCpuDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_RTV, _rtvAllocation);
+	}
+}
+
 bool SwapChain::Initialize(
 	D3D12Context& graphicContext,
 	HWND hwndAttach,
 	Size size,
+	ColorMode colorMode,
 	const ColorInfo& colorInfo
 ) noexcept {
 	_graphicContext = &graphicContext;
 	_size = size;
-	_isScRGB = colorInfo.kind != winrt::AdvancedColorKind::StandardDynamicRange;
+	_colorMode = colorMode;
 
 	IDXGIFactory7* dxgiFactory = graphicContext.GetDXGIFactory();
-	ID3D12Device5* device = graphicContext.GetDevice();
 
 	// 检查撕裂支持
 	{
@@ -35,8 +63,7 @@ bool SwapChain::Initialize(
 	DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {
 		.Width = size.width,
 		.Height = size.height,
-		// 默认色域正是我们想要的，无需额外设置
-		.Format = _isScRGB ? DXGI_FORMAT_R16G16B16A16_FLOAT : DXGI_FORMAT_R8G8B8A8_UNORM,
+		.Format = GetBufferFormat(colorMode),
 		.SampleDesc = {
 			.Count = 1
 		},
@@ -84,30 +111,48 @@ bool SwapChain::Initialize(
 
 	dxgiFactory->MakeWindowAssociation(hwndAttach, DXGI_MWA_NO_ALT_ENTER);
 
-	{
-		D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {
-			.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV,
-			.NumDescriptors = _bufferCount
-		};
-		if (FAILED(device->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&_rtvHeap)))) {
+	// SDR 和 scRGB 的默认色彩空间正是我们想要的，HDR10 必须显式设置
+	if (colorMode == ColorMode::HDR10) {
+		if (FAILED(_dxgiSwapChain->SetColorSpace1(GetColorSpace(colorMode)))) {
 			return false;
 		}
+
+		_UpdateHDRMetadata(colorInfo);
 	}
 
-	_rtvDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+	// 后备缓冲重新创建时复用这些描述符
+	if (FAILED(graphicContext.AllocateCpuDescriptors(D3D12_DESCRIPTOR_HEAP_TYPE_RTV, _bufferCount, _rtvAllocation))) {
+		return false;
+	}
+
+	_rtvDescriptorSize = graphicContext.GetDescriptorSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 
 	_frameBuffers.resize(_bufferCount);
 	
 	return SUCCEEDED(_LoadBufferResources());
 }
 
+HANDLE SwapChain::GetFrameWaitHandle() noexcept {
+	if (_isFrameLatencyAcquired) {
+		return NULL;
+	}
+
+	if (_frameLatencyWaitableObject.wait(0)) {
+		_isFrameLatencyAcquired = true;
+		return NULL;
+	}
+
+	return _frameLatencyWaitableObject.get();
+}
+
 void SwapChain::BeginFrame(ID3D12Resource** frameTex, CD3DX12_CPU_DESCRIPTOR_HANDLE& rtvHandle) noexcept {
-	_frameLatencyWaitableObject.wait(1000);
+	if (!std::exchange(_isFrameLatencyAcquired, false)) {
+		_frameLatencyWaitableObject.wait(1000);
+	}
 
 	const uint32_t curBufferIndex = _dxgiSwapChain->GetCurrentBackBufferIndex();
 	*frameTex = _frameBuffers[curBufferIndex].get();
-	rtvHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(
-		_rtvHeap->GetCPUDescriptorHandleForHeapStart(), curBufferIndex, _rtvDescriptorSize);
+	rtvHandle = _rtvAllocation.GetCpuHandle(curBufferIndex, _rtvDescriptorSize);
 }
 
 // 和 DwmFlush 效果相同但更准确
@@ -191,6 +236,11 @@ HRESULT SwapChain::EndFrame(bool waitForGpu) noexcept {
 		WaitForDwmComposition();
 	}
 
+	if (_isVSyncDisabled) {
+		// 不支持撕裂时仍受 DWM 合成的限制
+		return _dxgiSwapChain->Present(0, _isTearingSupported ? DXGI_PRESENT_ALLOW_TEARING : 0);
+	}
+
 	return _dxgiSwapChain->Present(isRecreated ? 0 : 1, 0);
 }
 
@@ -222,24 +272,35 @@ HRESULT SwapChain::OnResized(Size size) noexcept {
 	return _RecreateBuffers();
 }
 
-HRESULT SwapChain::OnColorInfoChanged(const ColorInfo& colorInfo) noexcept {
-	const bool wasScRGB = _isScRGB;
-	_isScRGB = colorInfo.kind != winrt::AdvancedColorKind::StandardDynamicRange;
+HRESULT SwapChain::OnColorInfoChanged(ColorMode colorMode, const ColorInfo& colorInfo) noexcept {
+	if (colorMode != _colorMode) {
+		const ColorMode oldColorMode = std::exchange(_colorMode, colorMode);
 
-	if (_isScRGB == wasScRGB) {
-		return S_OK;
+		HRESULT hr = _RecreateBuffers();
+		if (FAILED(hr)) {
+			return hr;
+		}
+
+		hr = _dxgiSwapChain->SetColorSpace1(GetColorSpace(colorMode));
+		if (FAILED(hr)) {
+			return hr;
+		}
+
+		if (oldColorMode == ColorMode::HDR10) {
+			_dxgiSwapChain->SetHDRMetaData(DXGI_HDR_METADATA_TYPE_NONE, 0, nullptr);
+		}
 	}
 
-	HRESULT hr = _RecreateBuffers();
-	if (FAILED(hr)) {
-		return hr;
+	// 颜色模式不变时显示器的亮度也可能改变
+	if (colorMode == ColorMode::HDR10) {
+		_UpdateHDRMetadata(colorInfo);
 	}
 
-	return _dxgiSwapChain->SetColorSpace1(
-		_isScRGB ? DXGI_COLOR_SPACE_RGB_FULL_G10_NONE_P709 : DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_P709);
+	return S_OK;
 }
 
 HRESULT SwapChain::_RecreateBuffers() noexcept {
+	// ResizeBuffers 要求 GPU 不再使用任何后备缓冲，这里无法延迟释放
 	HRESULT hr = _graphicContext->WaitForGpu();
 	if (FAILED(hr)) {
 		return hr;
@@ -251,7 +312,7 @@ HRESULT SwapChain::_RecreateBuffers() noexcept {
 	// 最大帧延迟，需要额外等待 FrameLatencyWaitableObject 来修正内部状态。
 	hr = _dxgiSwapChain->ResizeBuffers(
 		_bufferCount, _size.width, _size.height,
-		_isScRGB ? DXGI_FORMAT_R16G16B16A16_FLOAT : DXGI_FORMAT_R8G8B8A8_UNORM,
+		GetBufferFormat(_colorMode),
 		UINT((_isTearingSupported ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0)
 			| DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT)
 	);
@@ -264,9 +325,32 @@ HRESULT SwapChain::_RecreateBuffers() noexcept {
 	return _LoadBufferResources();
 }
 
+void SwapChain::_UpdateHDRMetadata(const ColorInfo& colorInfo) noexcept {
+	// 色度坐标的单位为 0.00002。内容的色域是 P3，见 shaders/AdvancedColor_PS.hlsl。
+	const float maxNits = colorInfo.maxLuminance * ColorKernels::SCRGB_WHITE_NITS;
+	DXGI_HDR_METADATA_HDR10 metadata = {
+		.RedPrimary = { 34000, 16000 },
+		.GreenPrimary = { 13250, 34500 },
+		.BluePrimary = { 7500, 3000 },
+		.WhitePoint = { 15635, 16450 },
+		// 以显示器的能力作为母版显示器的亮度范围
+		.MaxMasteringLuminance = (UINT)std::lroundf(maxNits),
+		// 单位为 0.0001nit
+		.MinMasteringLuminance = 0,
+		// boost 不超过 maxLuminance，因此内容基本不会更亮
+		.MaxContentLightLevel = (UINT16)std::lroundf(std::min(maxNits, 65535.0f)),
+		// 画面大部分是 SDR 亮度的清屏颜色
+		.MaxFrameAverageLightLevel = (UINT16)std::lroundf(std::min(
+			colorInfo.sdrWhiteLevel * ColorKernels::SCRGB_WHITE_NITS, maxNits))
+	};
+
+	// 元数据只是给显示器色调映射的提示，失败不影响显示
+	_dxgiSwapChain->SetHDRMetaData(DXGI_HDR_METADATA_TYPE_HDR10, sizeof(metadata), &metadata);
+}
+
 HRESULT SwapChain::_LoadBufferResources() noexcept {
 	ID3D12Device5* device = _graphicContext->GetDevice();
-	CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(_rtvHeap->GetCPUDescriptorHandleForHeapStart());
+	CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(_rtvAllocation.cpuHandle);
 	for (uint32_t i = 0; i < _bufferCount; ++i) {
 		HRESULT hr = _dxgiSwapChain->GetBuffer(i, IID_PPV_ARGS(&_frameBuffers[i]));
 		if (FAILED(hr)) {
@@ -274,7 +358,7 @@ HRESULT SwapChain::_LoadBufferResources() noexcept {
 		}
 
 		D3D12_RENDER_TARGET_VIEW_DESC rtvDesc = {
-			.Format = _isScRGB ? DXGI_FORMAT_R16G16B16A16_FLOAT : DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+			.Format = ShaderPermutations::GetRtvFormat(_colorMode),
 			.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D
 		};
 		device->CreateRenderTargetView(_frameBuffers[i].get(), &rtvDesc, rtvHandle);
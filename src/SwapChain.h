@@ -1,4 +1,6 @@
 #pragma once
+#include "DescriptorHeap.h"
+#include "ShaderPermutations.h"
 
 class D3D12Context;
 
@@ -6,30 +8,51 @@ class SwapChain {
 public:
 	SwapChain() = default;
 	SwapChain(const SwapChain&) = delete;
-	SwapChain(SwapChain&&) = default;
+	// 析构时通过 _graphicContext 释放描述符
+	SwapChain(SwapChain&&) = delete;
+
+	~SwapChain();
 
 	bool Initialize(
 		D3D12Context& graphicContext,
 		HWND hwndAttach,
 		Size size,
+		ShaderPermutations::ColorMode colorMode,
 		const ColorInfo& colorInfo
 	) noexcept;
 
+	// 返回开始新帧前需要等待的 FrameLatencyWaitableObject，返回 NULL 表示无需等待。
+	// 等待成功后必须调用 OnFrameLatencyWaitableObjectSignaled。
+	HANDLE GetFrameWaitHandle() noexcept;
+
+	void OnFrameLatencyWaitableObjectSignaled() noexcept {
+		_isFrameLatencyAcquired = true;
+	}
+
 	void BeginFrame(ID3D12Resource** frameTex, CD3DX12_CPU_DESCRIPTOR_HANDLE& rtvHandle) noexcept;
 
 	HRESULT EndFrame(bool waitForGpu = false) noexcept;
 
+	// 为 true 时 Present 的同步间隔为 0，支持时允许撕裂，帧率不受显示器刷新率限制
+	void SetVSyncDisabled(bool value) noexcept {
+		_isVSyncDisabled = value;
+	}
+
 	void OnResizeStarted() noexcept;
 
 	HRESULT OnResizeEnded() noexcept;
 
 	HRESULT OnResized(Size size) noexcept;
 
-	HRESULT OnColorInfoChanged(const ColorInfo& colorInfo) noexcept;
+	// 颜色模式决定格式和色彩空间，HDR10 下还使用 colorInfo 更新 HDR 元数据
+	HRESULT OnColorInfoChanged(ShaderPermutations::ColorMode colorMode, const ColorInfo& colorInfo) noexcept;
 
 private:
 	HRESULT _RecreateBuffers() noexcept;
 
+	// 只用于 HDR10
+	void _UpdateHDRMetadata(const ColorInfo& colorInfo) noexcept;
+
 	HRESULT _LoadBufferResources() noexcept;
 
 	D3D12Context* _graphicContext = nullptr;
@@ -38,14 +61,17 @@ private:
 	wil::unique_event_nothrow _frameLatencyWaitableObject;
 	std::vector<winrt::com_ptr<ID3D12Resource>> _frameBuffers;
 	
-	winrt::com_ptr<ID3D12DescriptorHeap> _rtvHeap;
+	DescriptorAllocation _rtvAllocation;
 	uint32_t _rtvDescriptorSize = 0;
 
 	Size _size{};
 	uint32_t _bufferCount = 0;
-	bool _isScRGB = false;
+	ShaderPermutations::ColorMode _colorMode = ShaderPermutations::ColorMode::SDR;
 	
 	bool _isTearingSupported = false;
+	bool _isVSyncDisabled = false;
 	bool _isRecreated = true;
 	bool _isResizing = false;
+	// FrameLatencyWaitableObject 是信号量，等待会减少计数，因此需记录是否已在外部等待过
+	bool _isFrameLatencyAcquired = false;
 };
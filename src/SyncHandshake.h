@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <utility>
+
+// UI 线程和渲染线程之间的同步点。UI 线程用 Begin 分配递增的 id，随事件发送给渲染线程后等待
+// IsCompleted 返回 true；渲染线程处理事件时用 Request 记录 id，渲染新帧后调用 Complete。多个
+// 未完成的请求合并为最新的一个。不依赖 Win32，等待和唤醒由调用者负责。
+class SyncHandshake {
+public:
+	SyncHandshake() = default;
+	SyncHandshake(const SyncHandshake&) = delete;
+	SyncHandshake(SyncHandshake&&) = delete;
+
+	// 下面两个方法只能在 UI 线程调用
+
+	uint64_t Begin() noexcept {
+		return ++_lastSyncId;
+	}
+
+	// 返回 true 时渲染线程在 Complete 之前的写入对调用者可见
+	bool IsCompleted(uint64_t syncId) const noexcept {
+		return _completedSyncId.load(std::memory_order_acquire) >= syncId;
+	}
+
+	// 下面的方法只能在渲染线程调用，启动渲染线程前也可以调用
+
+	void Request(uint64_t syncId) noexcept {
+		_pendingSyncId = std::max(_pendingSyncId, syncId);
+	}
+
+	bool IsPending() const noexcept {
+		return _pendingSyncId != 0;
+	}
+
+	void Complete() noexcept {
+		assert(_pendingSyncId != 0);
+		_completedSyncId.store(std::exchange(_pendingSyncId, 0), std::memory_order_release);
+	}
+
+	// 渲染线程退出时调用，之后 UI 线程不应再等待
+	void Abandon() noexcept {
+		_pendingSyncId = 0;
+		_completedSyncId.store(UINT64_MAX, std::memory_order_release);
+	}
+
+private:
+	// UI 线程使用
+	uint64_t _lastSyncId = 0;
+	// 渲染线程使用
+	uint64_t _pendingSyncId = 0;
+	// 两个线程共享
+	std::atomic<uint64_t> _completedSyncId = 0;
+};
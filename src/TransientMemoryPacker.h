@@ -0,0 +1,148 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+// 将生命周期不重叠的资源放置在同一块内存的相同位置，只计算偏移，不依赖 D3D12。生命周期用
+// 渲染图中 pass 的位置表示，首尾都包含在内。
+//
+// 按大小从大到小依次放置，每个资源放在和已放置的、生命周期重叠的资源都不冲突的最低偏移。
+class TransientMemoryPacker {
+public:
+	struct Item {
+		uint64_t size;
+		// 必须是 2 的幂
+		uint64_t alignment;
+		uint32_t firstPosition;
+		uint32_t lastPosition;
+	};
+
+	struct Stats {
+		// 放置后需要的内存大小
+		uint64_t peakSize = 0;
+		// 每个资源独占内存时需要的大小
+		uint64_t naiveSize = 0;
+		// 和其他资源共享内存的资源数
+		uint32_t aliasedCount = 0;
+	};
+
+	TransientMemoryPacker() = default;
+	TransientMemoryPacker(const TransientMemoryPacker&) = delete;
+	TransientMemoryPacker(TransientMemoryPacker&&) = default;
+
+	// 相同的输入总是产生相同的结果，返回需要的内存大小
+	uint64_t Pack(std::span<const Item> items) noexcept {
+		const uint32_t count = (uint32_t)items.size();
+
+		_offsets.assign(count, 0);
+		_isAliased.assign(count, false);
+		_stats = {};
+
+		_order.resize(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			_order[i] = i;
+		}
+
+		// 先放置大的资源，小的资源更容易填进空隙
+		std::sort(_order.begin(), _order.end(), [&](uint32_t a, uint32_t b) {
+			if (items[a].size != items[b].size) {
+				return items[a].size > items[b].size;
+			}
+			if (items[a].firstPosition != items[b].firstPosition) {
+				return items[a].firstPosition < items[b].firstPosition;
+			}
+			return a < b;
+		});
+
+		for (uint32_t k = 0; k < count; ++k) {
+			const uint32_t i = _order[k];
+			const Item& item = items[i];
+
+			// 收集生命周期重叠的已放置资源占用的区间
+			_ranges.clear();
+			for (uint32_t l = 0; l < k; ++l) {
+				const uint32_t j = _order[l];
+				if (_IsLifetimeOverlapping(item, items[j])) {
+					_ranges.emplace_back(_offsets[j], _offsets[j] + items[j].size);
+				}
+			}
+			std::sort(_ranges.begin(), _ranges.end());
+
+			// 查找第一个足够大的空隙
+			uint64_t offset = 0;
+			for (const auto& [rangeBegin, rangeEnd] : _ranges) {
+				if (_AlignUp(offset, item.alignment) + item.size <= rangeBegin) {
+					break;
+				}
+				offset = std::max(offset, rangeEnd);
+			}
+			offset = _AlignUp(offset, item.alignment);
+
+			_offsets[i] = offset;
+			_stats.peakSize = std::max(_stats.peakSize, offset + item.size);
+
+			// 不共享内存时依次排列
+			_stats.naiveSize = _AlignUp(_stats.naiveSize, item.alignment) + item.size;
+		}
+
+		// 对齐造成的空隙太多时可能不如依次排列
+		if (_stats.peakSize > _stats.naiveSize) {
+			uint64_t offset = 0;
+			for (uint32_t i : _order) {
+				_offsets[i] = _AlignUp(offset, items[i].alignment);
+				offset = _offsets[i] + items[i].size;
+			}
+			_stats.peakSize = _stats.naiveSize;
+		}
+
+		// 共享内存的资源首次使用前需要别名屏障
+		for (uint32_t i = 0; i < count; ++i) {
+			for (uint32_t j = i + 1; j < count; ++j) {
+				if (_offsets[i] < _offsets[j] + items[j].size && _offsets[j] < _offsets[i] + items[i].size) {
+					assert(!_IsLifetimeOverlapping(items[i], items[j]));
+					_isAliased[i] = true;
+					_isAliased[j] = true;
+				}
+			}
+		}
+
+		for (uint32_t i = 0; i < count; ++i) {
+			if (_isAliased[i]) {
+				++_stats.aliasedCount;
+			}
+		}
+
+		return _stats.peakSize;
+	}
+
+	uint64_t GetOffset(uint32_t item) const noexcept {
+		return _offsets[item];
+	}
+
+	bool IsAliased(uint32_t item) const noexcept {
+		return _isAliased[item];
+	}
+
+	const Stats& GetStats() const noexcept {
+		return _stats;
+	}
+
+private:
+	static uint64_t _AlignUp(uint64_t value, uint64_t alignment) noexcept {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	static bool _IsLifetimeOverlapping(const Item& a, const Item& b) noexcept {
+		return a.firstPosition <= b.lastPosition && b.firstPosition <= a.lastPosition;
+	}
+
+	std::vector<uint64_t> _offsets;
+	std::vector<bool> _isAliased;
+	Stats _stats;
+	// 以下为 Pack 使用的临时数据
+	std::vector<uint32_t> _order;
+	std::vector<std::pair<uint64_t, uint64_t>> _ranges;
+};
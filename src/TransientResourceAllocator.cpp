@@ -0,0 +1,215 @@
+#include "pch.h"
+#include "TransientResourceAllocator.h"
+#include "D3D12Context.h"
+#include "DirectXHelper.h"
+#include "RenderGraph.h"
+
+HRESULT TransientResourceAllocator::Allocate(D3D12Context& d3d12Context, RenderGraph& renderGraph) noexcept {
+	const std::vector<RenderGraph::TransientResourceInfo>& infos = renderGraph.GetTransientResources();
+	ID3D12Device5* device = d3d12Context.GetDevice();
+
+	_stats = { .resourceCount = (uint32_t)infos.size() };
+
+	// 按类别分组，Resource Heap Tier 1 不允许不同类别的资源共享堆
+	for (_Heap& heap : _heaps) {
+		heap.items.clear();
+	}
+
+	_placements.resize(infos.size());
+	for (uint32_t i = 0; i < (uint32_t)infos.size(); ++i) {
+		const RenderGraph::TransientResourceInfo& info = infos[i];
+
+		const D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = device->GetResourceAllocationInfo(0, 1, &info.desc);
+		if (allocationInfo.SizeInBytes == UINT64_MAX) {
+			return E_INVALIDARG;
+		}
+
+		const uint32_t category = (uint32_t)HeapAllocator::GetResourceCategory(info.desc);
+		std::vector<TransientMemoryPacker::Item>& items = _heaps[category].items;
+
+		_placements[i] = { category, (uint32_t)items.size() };
+		items.push_back({
+			.size = allocationInfo.SizeInBytes,
+			.alignment = allocationInfo.Alignment,
+			.firstPosition = info.firstPosition,
+			.lastPosition = info.lastPosition
+		});
+	}
+
+	for (uint32_t category = 0; category < CATEGORY_COUNT; ++category) {
+		_Heap& heap = _heaps[category];
+
+		const uint64_t size = heap.packer.Pack(heap.items);
+		HRESULT hr = _EnsureHeapSize(d3d12Context, category, size);
+		if (FAILED(hr)) {
+			return hr;
+		}
+
+		const TransientMemoryPacker::Stats& packerStats = heap.packer.GetStats();
+		_stats.heapSize += heap.size;
+		_stats.peakSize += packerStats.peakSize;
+		_stats.naiveSize += packerStats.naiveSize;
+		_stats.aliasedResourceCount += packerStats.aliasedCount;
+	}
+
+	// 多余的资源可能仍在使用
+	while (_resources.size() > infos.size()) {
+		d3d12Context.DeferRelease(std::move(_resources.back().resource));
+		_resources.pop_back();
+	}
+	_resources.resize(infos.size());
+
+	for (uint32_t i = 0; i < (uint32_t)infos.size(); ++i) {
+		const RenderGraph::TransientResourceInfo& info = infos[i];
+		const _Placement& placement = _placements[i];
+		const _Heap& heap = _heaps[placement.category];
+		const uint64_t offset = heap.packer.GetOffset(placement.item);
+
+		_Resource& resource = _resources[i];
+
+		// 描述、初始状态和位置都不变时复用上一帧的资源
+		const bool shouldCreate = !resource.resource || resource.heap != heap.heap.get() ||
+			resource.offset != offset || resource.initialState != info.initialState ||
+			!DirectXHelper::IsSameResourceDesc(resource.desc, info.desc);
+
+		if (shouldCreate) {
+			d3d12Context.DeferRelease(std::move(resource.resource));
+
+			HRESULT hr = device->CreatePlacedResource(
+				heap.heap.get(),
+				offset,
+				&info.desc,
+				info.initialState,
+				nullptr,
+				IID_PPV_ARGS(&resource.resource)
+			);
+			if (FAILED(hr)) {
+				return hr;
+			}
+
+			resource.desc = info.desc;
+			resource.initialState = info.initialState;
+			resource.heap = heap.heap.get();
+			resource.offset = offset;
+			++_stats.createdResourceCount;
+		}
+
+		renderGraph.BindTransientResource(info.physicalIndex, resource.resource.get());
+
+		// 新创建的放置资源和共享内存的资源一样，内容是未定义的
+		if (shouldCreate || heap.packer.IsAliased(placement.item)) {
+			renderGraph.AddAliasingBarrier(info.physicalIndex);
+		}
+	}
+
+	return S_OK;
+}
+
+TransientResourceAllocator::Stats TransientResourceAllocator::EstimateSavings(Size size, uint32_t passCount) noexcept {
+	const D3D12_RESOURCE_DESC textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R16G16B16A16_FLOAT,
+		size.width, size.height, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+
+	// 场景渲染到第一个纹理，之后每个 pass 读取上一个 pass 的输出，最后和场景合成到后备缓冲
+	RenderGraph renderGraph;
+	const RenderGraphResource backBuffer = renderGraph.ImportResource(
+		nullptr, D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_PRESENT);
+
+	const RenderGraphResource scene = renderGraph.CreateTransientResource(textureDesc);
+	renderGraph.WriteResource(renderGraph.AddPass("Scene", 0, {}), scene, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+	RenderGraphResource prevTexture = scene;
+	for (uint32_t i = 0; i < passCount; ++i) {
+		const uint32_t pass = renderGraph.AddPass("PostProcess", 0, {});
+		renderGraph.ReadResource(pass, prevTexture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+		const RenderGraphResource texture = renderGraph.CreateTransientResource(textureDesc);
+		renderGraph.WriteResource(pass, texture, D3D12_RESOURCE_STATE_RENDER_TARGET);
+		prevTexture = texture;
+	}
+
+	{
+		const uint32_t pass = renderGraph.AddPass("Composite", 0, {});
+		renderGraph.ReadResource(pass, scene, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		renderGraph.ReadResource(pass, prevTexture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		renderGraph.WriteResource(pass, backBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	}
+
+	renderGraph.Compile();
+
+	const uint64_t textureSize = (uint64_t(size.width) * size.height * 8 +
+		D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1) & ~uint64_t(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1);
+
+	std::vector<TransientMemoryPacker::Item> items;
+	for (const RenderGraph::TransientResourceInfo& info : renderGraph.GetTransientResources()) {
+		items.push_back({
+			.size = textureSize,
+			.alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+			.firstPosition = info.firstPosition,
+			.lastPosition = info.lastPosition
+		});
+	}
+
+	TransientMemoryPacker packer;
+	packer.Pack(items);
+
+	// 渲染图已经复用了描述相同的资源，naiveSize 按每个逻辑资源单独创建计算
+	const TransientMemoryPacker::Stats& packerStats = packer.GetStats();
+	return {
+		.heapSize = packerStats.peakSize,
+		.peakSize = packerStats.peakSize,
+		.naiveSize = textureSize * (passCount + 1),
+		.resourceCount = passCount + 1,
+		.aliasedResourceCount = packerStats.aliasedCount
+	};
+}
+
+HRESULT TransientResourceAllocator::_EnsureHeapSize(
+	D3D12Context& d3d12Context,
+	uint32_t category,
+	uint64_t size
+) noexcept {
+	_Heap& heap = _heaps[category];
+
+	// 堆够用并且没有过于浪费时保留，避免尺寸变化时频繁重新创建
+	if (size <= heap.size && size > heap.size / 4) {
+		return S_OK;
+	}
+
+	if (size == 0) {
+		// 没有资源时保留已有的堆，下一帧很可能仍然需要
+		return S_OK;
+	}
+
+	// 先释放放置在旧堆中的资源
+	for (_Resource& resource : _resources) {
+		if (resource.heap && resource.heap == heap.heap.get()) {
+			d3d12Context.DeferRelease(std::move(resource.resource));
+			resource.heap = nullptr;
+		}
+	}
+	d3d12Context.DeferRelease(std::move(heap.heap));
+	heap.size = 0;
+
+	const uint64_t alignedSize = (size + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1) &
+		~uint64_t(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1);
+
+	const HeapAllocator::ResourceCategory resourceCategory = (HeapAllocator::ResourceCategory)category;
+	D3D12_HEAP_FLAGS heapFlags = HeapAllocator::GetHeapFlags(resourceCategory);
+	if (d3d12Context.IsHeapFlagCreateNotZeroedSupported()) {
+		// 瞬态资源每次使用前都会被覆盖
+		heapFlags |= D3D12_HEAP_FLAG_CREATE_NOT_ZEROED;
+	}
+
+	// 支持放置 MSAA 资源
+	const uint64_t alignment = resourceCategory == HeapAllocator::ResourceCategory::RenderTargetOrDepthStencil ?
+		D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+	CD3DX12_HEAP_DESC heapDesc(alignedSize, D3D12_HEAP_TYPE_DEFAULT, alignment, heapFlags);
+	HRESULT hr = d3d12Context.GetDevice()->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap.heap));
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	heap.size = alignedSize;
+	return S_OK;
+}
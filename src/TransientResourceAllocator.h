@@ -0,0 +1,70 @@
+#pragma once
+#include "HeapAllocator.h"
+#include "TransientMemoryPacker.h"
+#include <array>
+
+class D3D12Context;
+class RenderGraph;
+
+// 为渲染图的瞬态资源分配显存。每种资源类别使用一个堆，生命周期不重叠的资源放置在相同的
+// 偏移，共享内存的资源在第一次使用前插入别名屏障。渲染图的结果不变时复用上一帧的资源。
+class TransientResourceAllocator {
+public:
+	struct Stats {
+		// 所有堆的大小
+		uint64_t heapSize = 0;
+		uint64_t peakSize = 0;
+		// 每个资源单独创建时需要的大小
+		uint64_t naiveSize = 0;
+		uint32_t resourceCount = 0;
+		uint32_t aliasedResourceCount = 0;
+		// 这一帧新创建的资源数
+		uint32_t createdResourceCount = 0;
+	};
+
+	TransientResourceAllocator() = default;
+	TransientResourceAllocator(const TransientResourceAllocator&) = delete;
+	TransientResourceAllocator(TransientResourceAllocator&&) = default;
+
+	// 在 RenderGraph::Compile 之后调用，创建瞬态资源并绑定到渲染图
+	HRESULT Allocate(D3D12Context& d3d12Context, RenderGraph& renderGraph) noexcept;
+
+	const Stats& GetStats() const noexcept {
+		return _stats;
+	}
+
+	// 不需要 GPU，用一个 size 分辨率的 FP16 后处理链估算别名节省的显存。资源大小按行主序
+	// 布局估算，和驱动报告的值略有出入。
+	static Stats EstimateSavings(Size size, uint32_t passCount) noexcept;
+
+private:
+	static constexpr uint32_t CATEGORY_COUNT = 3;
+
+	struct _Heap {
+		winrt::com_ptr<ID3D12Heap> heap;
+		uint64_t size = 0;
+		TransientMemoryPacker packer;
+		std::vector<TransientMemoryPacker::Item> items;
+	};
+
+	struct _Resource {
+		winrt::com_ptr<ID3D12Resource> resource;
+		D3D12_RESOURCE_DESC desc;
+		D3D12_RESOURCE_STATES initialState;
+		ID3D12Heap* heap;
+		uint64_t offset;
+	};
+
+	// 每个瞬态资源所在的堆和在堆中的序号
+	struct _Placement {
+		uint32_t category;
+		uint32_t item;
+	};
+
+	HRESULT _EnsureHeapSize(D3D12Context& d3d12Context, uint32_t category, uint64_t size) noexcept;
+
+	std::array<_Heap, CATEGORY_COUNT> _heaps;
+	std::vector<_Resource> _resources;
+	std::vector<_Placement> _placements;
+	Stats _stats;
+};
@@ -0,0 +1,53 @@
+#include "pch.h"
+#include "WaitMultiplexer.h"
+
+bool WaitMultiplexer::Add(HANDLE handle, std::function<void()> callback) noexcept {
+	assert(handle);
+
+	if (_handles.size() >= MAX_HANDLE_COUNT) {
+		return false;
+	}
+
+	_handles.push_back(handle);
+	_callbacks.push_back(std::move(callback));
+	return true;
+}
+
+WaitMultiplexer::WaitResult WaitMultiplexer::Wait(DWORD timeout) noexcept {
+	const DWORD count = (DWORD)_handles.size();
+	const DWORD result = _waitFunc(count, _handles.data(), timeout);
+
+	if (result < WAIT_OBJECT_0 + count) {
+		if (const std::function<void()>& callback = _callbacks[result - WAIT_OBJECT_0]) {
+			callback();
+		}
+		return WaitResult::Signaled;
+	} else if (result == WAIT_OBJECT_0 + count) {
+		return WaitResult::MessageAvailable;
+	} else if (result == WAIT_TIMEOUT) {
+		return WaitResult::Timeout;
+	} else {
+		return WaitResult::Failed;
+	}
+}
+
+void WaitMultiplexer::SignalAll() noexcept {
+	for (const std::function<void()>& callback : _callbacks) {
+		if (callback) {
+			callback();
+		}
+	}
+}
+
+WaitMultiplexer::WaitResult WaitMultiplexer::WaitForFrame(DWORD timeout) noexcept {
+	const WaitResult result = Wait(timeout);
+	if (result == WaitResult::Timeout || result == WaitResult::Failed) {
+		SignalAll();
+	}
+	return result;
+}
+
+DWORD WaitMultiplexer::_MsgWait(DWORD count, const HANDLE* handles, DWORD timeout) noexcept {
+	// MWMO_INPUTAVAILABLE: 即使消息已被 PeekMessage 看到过也立即返回
+	return MsgWaitForMultipleObjectsEx(count, handles, timeout, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+}
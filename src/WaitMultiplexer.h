@@ -0,0 +1,54 @@
+#pragma once
+#include <functional>
+
+// 同时等待多个内核对象和消息队列，用于在消息循环中等待渲染条件而不阻塞消息处理
+class WaitMultiplexer {
+public:
+	// 和 MsgWaitForMultipleObjectsEx 语义相同，返回 WAIT_OBJECT_0 + count 表示有新消息。
+	// 测试时可替换为模拟实现。
+	using WaitFunc = DWORD(*)(DWORD count, const HANDLE* handles, DWORD timeout);
+
+	// MsgWaitForMultipleObjectsEx 最多支持 MAXIMUM_WAIT_OBJECTS - 1 个句柄
+	static constexpr uint32_t MAX_HANDLE_COUNT = MAXIMUM_WAIT_OBJECTS - 1;
+
+	enum class WaitResult {
+		Signaled,
+		MessageAvailable,
+		Timeout,
+		Failed
+	};
+
+	WaitMultiplexer(WaitFunc waitFunc = _MsgWait) noexcept : _waitFunc(waitFunc) {}
+	WaitMultiplexer(const WaitMultiplexer&) = delete;
+	WaitMultiplexer(WaitMultiplexer&&) = default;
+
+	// callback 在 handle 被触发后调用，可以为空
+	bool Add(HANDLE handle, std::function<void()> callback = {}) noexcept;
+
+	void Clear() noexcept {
+		_handles.clear();
+		_callbacks.clear();
+	}
+
+	uint32_t Count() const noexcept {
+		return (uint32_t)_handles.size();
+	}
+
+	// 等待任一句柄被触发或有新消息。没有添加句柄时只等待消息。
+	WaitResult Wait(DWORD timeout) noexcept;
+
+	// 视为所有句柄都已触发，用于等待超时后强制继续
+	void SignalAll() noexcept;
+
+	// 渲染线程等待下一帧的渲染条件。句柄被触发时调用它的回调；超时或等待失败时调用所有回调强制
+	// 继续，和 SwapChain::BeginFrame 中等待超时的行为一致。无论结果如何调用者都应回到消息循环，
+	// 处理新消息和事件后再检查是否可以渲染。
+	WaitResult WaitForFrame(DWORD timeout) noexcept;
+
+private:
+	static DWORD _MsgWait(DWORD count, const HANDLE* handles, DWORD timeout) noexcept;
+
+	WaitFunc _waitFunc;
+	std::vector<HANDLE> _handles;
+	std::vector<std::function<void()>> _callbacks;
+};
@@ -26,3 +26,47 @@ const std::filesystem::path& Win32Helper::GetExePath() noexcept {
 	}();
 	return result;
 }
+
+bool Win32Helper::ReadFileData(
+	const std::filesystem::path& path,
+	uint64_t maxSize,
+	std::vector<uint8_t>& data
+) noexcept {
+	wil::unique_hfile hFile(CreateFile2(path.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr));
+	if (!hFile) {
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(hFile.get(), &size) || (uint64_t)size.QuadPart > maxSize) {
+		return false;
+	}
+
+	data.resize((size_t)size.QuadPart);
+
+	DWORD readSize;
+	return ReadFile(hFile.get(), data.data(), (DWORD)data.size(), &readSize, nullptr) && readSize == data.size();
+}
+
+HRESULT Win32Helper::WriteFileData(const std::filesystem::path& path, std::span<const uint8_t> data) noexcept {
+	std::filesystem::path tempPath = path;
+	tempPath += L".tmp";
+
+	{
+		wil::unique_hfile hFile(CreateFile2(tempPath.c_str(), GENERIC_WRITE, 0, CREATE_ALWAYS, nullptr));
+		if (!hFile) {
+			return HRESULT_FROM_WIN32(GetLastError());
+		}
+
+		DWORD writtenSize;
+		if (!WriteFile(hFile.get(), data.data(), (DWORD)data.size(), &writtenSize, nullptr)) {
+			return HRESULT_FROM_WIN32(GetLastError());
+		}
+	}
+
+	if (!MoveFileEx(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+		return HRESULT_FROM_WIN32(GetLastError());
+	}
+
+	return S_OK;
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <span>
 
 struct Win32Helper {
 	template<typename T, std::enable_if_t<std::is_function_v<T>, int> = 0>
@@ -58,4 +59,14 @@ struct Win32Helper {
 	static const OSVersion& GetOSVersion() noexcept;
 
 	static const std::filesystem::path& GetExePath() noexcept;
+
+	// 文件不存在、超过 maxSize 或读取失败时返回 false
+	static bool ReadFileData(
+		const std::filesystem::path& path,
+		uint64_t maxSize,
+		std::vector<uint8_t>& data
+	) noexcept;
+
+	// 先写入临时文件再替换，中断时不会留下不完整的文件
+	static HRESULT WriteFileData(const std::filesystem::path& path, std::span<const uint8_t> data) noexcept;
 };
@@ -1,21 +1,207 @@
 #include "pch.h"
+#include "Benchmark.h"
+#include "ColorKernels.h"
+#include "JobSystem.h"
 #include "MainWindow.h"
+#include "QuadBatcher.h"
+#include "RenderGraph.h"
+#include "Renderer.h"
+#include "ShaderArchive.h"
+#include "TransientResourceAllocator.h"
+#include "Win32Helper.h"
 
 extern "C" { __declspec(dllexport) extern const UINT D3D12SDKVersion = 619; }
 // D3D12 相关 dll 不能放在 dll 搜索目录，否则如果 OS 的 D3D12 运行时更新将会错误
 // 加载随程序部署的旧版本依赖 dll（包括 D3D12SDKLayers.dll 和 d3d10warp.dll）。
 extern "C" { __declspec(dllexport) extern const char* D3D12SDKPath = ".\\D3D12\\"; }
 
+// D3D12Context 从 exe 所在目录的 Shaders.bin 读取着色器，文件缺失或和程序不匹配时无法初始化。
+// 创建设备前检查，报告原因而不是直接退出。
+static bool CheckShaderArchive() noexcept {
+	ShaderArchive shaderArchive;
+	const HRESULT hr = shaderArchive.Initialize(Win32Helper::GetExePath().parent_path() / L"Shaders.bin");
+	if (SUCCEEDED(hr)) {
+		return true;
+	}
+
+	wchar_t message[256];
+	if (hr == HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND)) {
+		wcscpy_s(message, L"Shaders.bin was not found next to the executable. Build the project to generate it.");
+	} else {
+		swprintf_s(message, L"Failed to load Shaders.bin (0x%08X). It may be corrupted or built for a different "
+			L"version of the program; rebuild the project.", (uint32_t)hr);
+	}
+	MessageBox(NULL, message, L"D3D12Playground", MB_OK | MB_ICONERROR);
+	return false;
+}
+
+// 在 CPU 上测试四边形打包的吞吐量，不创建窗口和 D3D 设备
+static int BenchmarkQuadPacking() noexcept {
+	JobSystem jobSystem;
+	if (!jobSystem.Initialize()) {
+		return 1;
+	}
+
+	const double quadsPerSecond = QuadBatcher::BenchmarkPacking(jobSystem, 1 << 22, 20);
+
+	wchar_t message[64];
+	swprintf_s(message, L"%.1f M quads/s", quadsPerSecond / 1e6);
+	MessageBox(NULL, message, L"D3D12Playground", MB_OK);
+	return 0;
+}
+
+// 测试渲染图的编译耗时，不创建窗口和 D3D 设备
+static int BenchmarkRenderGraph() noexcept {
+	const double compileTime = RenderGraph::BenchmarkCompile(500, 200);
+
+	wchar_t message[64];
+	swprintf_s(message, L"500 passes: %.1f us/compile", compileTime);
+	MessageBox(NULL, message, L"D3D12Playground", MB_OK);
+	return 0;
+}
+
+// 估算 4K FP16 后处理链中瞬态资源共享内存节省的显存
+static int EstimateTransientAliasing() noexcept {
+	const TransientResourceAllocator::Stats stats = TransientResourceAllocator::EstimateSavings({ 3840, 2160 }, 8);
+
+	wchar_t message[128];
+	swprintf_s(message, L"%u transient resources: %llu MB -> %llu MB",
+		stats.resourceCount, stats.naiveSize >> 20, stats.peakSize >> 20);
+	MessageBox(NULL, message, L"D3D12Playground", MB_OK);
+	return 0;
+}
+
+// 比较颜色转换在各个指令集下的吞吐量，不创建窗口和 D3D 设备
+static int BenchmarkColorKernels() noexcept {
+	const std::vector<ColorKernels::BenchmarkResult> results = ColorKernels::Benchmark(1 << 20, 20);
+
+	std::wstring message = L"M pixels/s";
+	for (const ColorKernels::BenchmarkResult& result : results) {
+		wchar_t line[64];
+		swprintf_s(line, L"\n\n%hs", ColorKernels::GetInstructionSetName(result.instructionSet));
+		message += line;
+
+		for (uint32_t i = 0; i < (uint32_t)ColorKernels::Kernel::COUNT; ++i) {
+			swprintf_s(line, L"\n%hs: %.1f",
+				ColorKernels::GetKernelName((ColorKernels::Kernel)i), result.pixelsPerSecond[i] / 1e6);
+			message += line;
+		}
+	}
+
+	MessageBox(NULL, message.c_str(), L"D3D12Playground", MB_OK);
+	return 0;
+}
+
+// 命令行选项以空格分隔，渲染选项可以组合
+static bool HasFlag(std::wstring_view cmdLine, std::wstring_view flag) noexcept {
+	while (!cmdLine.empty()) {
+		const size_t end = cmdLine.find(L' ');
+		if (cmdLine.substr(0, end) == flag) {
+			return true;
+		}
+		if (end == std::wstring_view::npos) {
+			break;
+		}
+		cmdLine.remove_prefix(end + 1);
+	}
+	return false;
+}
+
+// 形如 "-name=value" 的选项，值中不能有空格，不存在时返回 false
+static bool GetFlagValue(std::wstring_view cmdLine, std::wstring_view prefix, std::wstring_view& value) noexcept {
+	while (!cmdLine.empty()) {
+		const size_t end = cmdLine.find(L' ');
+		const std::wstring_view token = cmdLine.substr(0, end);
+		if (token.starts_with(prefix)) {
+			value = token.substr(prefix.size());
+			return true;
+		}
+		if (end == std::wstring_view::npos) {
+			break;
+		}
+		cmdLine.remove_prefix(end + 1);
+	}
+	return false;
+}
+
+// 以固定的窗口尺寸渲染内置场景，结束后将帧时间的统计写入 JSON 并退出。默认在预热后统计
+// 1000 帧，客户区为 1280x720，关闭垂直同步，报告写入程序所在目录的 benchmark.json。
+static Benchmark::Options ParseBenchmarkOptions(std::wstring_view cmdLine) noexcept {
+	Benchmark::Options options;
+
+	std::wstring_view value;
+	if (GetFlagValue(cmdLine, L"-benchmark-frames=", value)) {
+		options.frameCount = (uint32_t)std::wcstoul(std::wstring(value).c_str(), nullptr, 10);
+	}
+	if (GetFlagValue(cmdLine, L"-benchmark-seconds=", value)) {
+		options.duration = std::wcstod(std::wstring(value).c_str(), nullptr);
+	}
+	if (options.frameCount == 0 && options.duration <= 0) {
+		options.frameCount = 1000;
+	}
+
+	// 无效的值使用默认尺寸
+	if (GetFlagValue(cmdLine, L"-benchmark-width=", value)) {
+		if (const uint32_t width = (uint32_t)std::wcstoul(std::wstring(value).c_str(), nullptr, 10)) {
+			options.width = width;
+		}
+	}
+	if (GetFlagValue(cmdLine, L"-benchmark-height=", value)) {
+		if (const uint32_t height = (uint32_t)std::wcstoul(std::wstring(value).c_str(), nullptr, 10)) {
+			options.height = height;
+		}
+	}
+
+	if (GetFlagValue(cmdLine, L"-benchmark-output=", value) && !value.empty()) {
+		options.outputPath = value;
+	} else {
+		options.outputPath = Win32Helper::GetExePath().parent_path() / L"benchmark.json";
+	}
+
+	return options;
+}
+
 int APIENTRY wWinMain(
 	_In_ HINSTANCE /*hInstance*/,
 	_In_opt_ HINSTANCE /*hPrevInstance*/,
-	_In_ LPWSTR /*lpCmdLine*/,
+	_In_ LPWSTR lpCmdLine,
 	_In_ int /*nCmdShow*/
 ) {
+	if (HasFlag(lpCmdLine, L"-bench-quad-packing")) {
+		return BenchmarkQuadPacking();
+	}
+
+	if (HasFlag(lpCmdLine, L"-bench-render-graph")) {
+		return BenchmarkRenderGraph();
+	}
+
+	if (HasFlag(lpCmdLine, L"-estimate-transient-aliasing")) {
+		return EstimateTransientAliasing();
+	}
+
+	if (HasFlag(lpCmdLine, L"-bench-color-kernels")) {
+		return BenchmarkColorKernels();
+	}
+
+	if (!CheckShaderArchive()) {
+		return 1;
+	}
+
 	winrt::init_apartment(winrt::apartment_type::single_threaded);
 
+	const bool isBenchmark = HasFlag(lpCmdLine, L"-benchmark");
+	const Renderer::Options rendererOptions = {
+		.preferHDR10 = HasFlag(lpCmdLine, L"-hdr10"),
+		.useColorLut = HasFlag(lpCmdLine, L"-color-lut"),
+		.useAutoExposure = HasFlag(lpCmdLine, L"-auto-exposure"),
+		.measureFrameTimes = isBenchmark,
+		.disableVSync = isBenchmark,
+		.useSoftwareRendering = HasFlag(lpCmdLine, L"-software-rendering")
+	};
+	const Benchmark::Options benchmarkOptions = isBenchmark ? ParseBenchmarkOptions(lpCmdLine) : Benchmark::Options{};
+
 	MainWindow mainWindow;
-	if (!mainWindow.Create()) {
+	if (!mainWindow.Create(rendererOptions, isBenchmark ? &benchmarkOptions : nullptr)) {
 		return 1;
 	}
 
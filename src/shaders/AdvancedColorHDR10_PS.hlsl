@@ -0,0 +1,3 @@
+// HDR10 交换链使用，见 ColorOutput.hlsli
+#define HDR10
+#include "AdvancedColor_PS.hlsl"
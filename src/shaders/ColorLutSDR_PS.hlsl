@@ -0,0 +1,3 @@
+// SDR 交换链使用，LUT 的坐标空间不同，见 ColorLut::GetGrid
+#define SDR
+#include "ColorLut_PS.hlsl"
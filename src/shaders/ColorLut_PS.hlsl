@@ -0,0 +1,44 @@
+// 颜色管理的 3D LUT，见 ColorLut.h。场景以 scRGB 渲染到中间纹理，这里将它转换为 LUT 的坐标再
+// 采样一次，结果已经是交换链的格式。曝光为 1 时和 ColorLut::Apply 一致，后者是 CPU 上的参考实现。
+#include "ColorOutput.hlsli"
+
+// 即 ColorLut::SIZE
+static const float LUT_SIZE = 33;
+
+// 坐标空间，和 ColorLut::GetGrid 一致
+#ifdef SDR
+static const float3x3 FROM_SCRGB = {
+	1, 0, 0,
+	0, 1, 0,
+	0, 0, 1
+};
+static const float PQ_SCALE = 0.25;
+static const float ZERO_INDEX = 8;
+#else
+static const float3x3 FROM_SCRGB = BT709_TO_BT2020;
+static const float PQ_SCALE = SCRGB_TO_PQ_SCALE;
+static const float ZERO_INDEX = 0;
+#endif
+
+cbuffer RootConstants : register(b0) {
+	// 自动曝光，见 AutoExposurePass，未启用时为 1
+	float exposure;
+};
+
+Texture2D<float4> scene : register(t0);
+Texture3D<float4> lut : register(t1);
+SamplerState linearSampler : register(s0);
+
+float4 main(float4 position : SV_POSITION) : SV_Target {
+	const float4 color = scene.Load(int3(position.xy, 0));
+
+	// 非负值映射到 [zero, 1]，负值映射到 [0, zero)
+	const float3 c = mul(FROM_SCRGB, color.rgb * exposure);
+	const float zero = ZERO_INDEX / (LUT_SIZE - 1);
+	const float3 pq = LinearToPQ(abs(c) * PQ_SCALE);
+	const float3 coord = lerp(zero * (1 - pq), zero + (1 - zero) * pq, c >= 0);
+
+	// 格点位于纹素中心
+	const float3 uvw = coord * ((LUT_SIZE - 1) / LUT_SIZE) + 0.5 / LUT_SIZE;
+	return float4(lut.SampleLevel(linearSampler, uvw, 0).rgb, color.a);
+}
@@ -0,0 +1,39 @@
+// 像素着色器的输出。着色计算都使用 scRGB，定义 HDR10 时转换到 BT.2020 并编码为 PQ，用于
+// R10G10B10A2_UNORM 的交换链。和 ColorKernels 的 TransformGamut 和 LinearToPQ 一致，
+// 后者是 CPU 上的参考实现。ColorLut_PS.hlsl 也使用 PQ 编码计算 LUT 的坐标。
+
+// 即 ColorKernels::BT709_TO_BT2020
+static const float3x3 BT709_TO_BT2020 = {
+	0.627403896, 0.329283038, 0.0433130657,
+	0.0690972894, 0.919540395, 0.0113623156,
+	0.0163914389, 0.0880133079, 0.895595253
+};
+
+// SMPTE ST 2084
+static const float PQ_M1 = 2610.0 / 16384;
+static const float PQ_M2 = 2523.0 / 4096 * 128;
+static const float PQ_C1 = 3424.0 / 4096;
+static const float PQ_C2 = 2413.0 / 4096 * 32;
+static const float PQ_C3 = 2392.0 / 4096 * 32;
+
+// scRGB 的 1.0 为 80nit，PQ 的 1.0 为 10000nit
+static const float SCRGB_TO_PQ_SCALE = 80.0 / 10000;
+
+float3 LinearToPQ(float3 c) {
+	const float3 p = pow(saturate(c), PQ_M1);
+	return pow((PQ_C1 + PQ_C2 * p) / (1 + PQ_C3 * p), PQ_M2);
+}
+
+#ifdef HDR10
+
+float4 OutputColor(float3 c, float alpha) {
+	return float4(LinearToPQ(mul(BT709_TO_BT2020, c) * SCRGB_TO_PQ_SCALE), alpha);
+}
+
+#else
+
+float4 OutputColor(float3 c, float alpha) {
+	return float4(c, alpha);
+}
+
+#endif
@@ -0,0 +1,5 @@
+// 覆盖整个渲染目标的三角形，不需要顶点缓冲和输入布局，用于后处理
+float4 main(uint vertexId : SV_VertexID) : SV_POSITION {
+	const float2 uv = float2((vertexId << 1) & 2, vertexId & 2);
+	return float4(uv * float2(2, -2) + float2(-1, 1), 0, 1);
+}
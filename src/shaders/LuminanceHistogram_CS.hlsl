@@ -0,0 +1,59 @@
+// 场景亮度的直方图，分桶和 LuminanceHistogram::GetBin 一致，后者是 CPU 上的参考实现。每个
+// 线程组先在共享内存中统计，再合并到全局的直方图。
+
+// 即 LuminanceHistogram 的 BIN_COUNT、BINS_PER_OCTAVE 和 MIN_LOG2_LUMINANCE
+static const uint BIN_COUNT = 256;
+static const uint MANTISSA_SHIFT = 23 - 4;
+static const int FIRST_BIN_BITS = (127 - 8) * 16;
+
+// 每个线程负责清零和合并一个桶
+#define THREAD_GROUP_SIZE 16
+
+cbuffer RootConstants : register(b0) {
+	uint width;
+	uint height;
+};
+
+Texture2D<float4> scene : register(t0);
+RWByteAddressBuffer histogram : register(u0);
+
+groupshared uint localBins[BIN_COUNT];
+
+uint GetBin(float luminance) {
+	// 也排除了 NaN
+	if (!(luminance > 0)) {
+		return 0;
+	}
+	return (uint)clamp((int)(asuint(luminance) >> MANTISSA_SHIFT) - FIRST_BIN_BITS, 0, (int)BIN_COUNT - 1);
+}
+
+[numthreads(THREAD_GROUP_SIZE, THREAD_GROUP_SIZE, 1)]
+void main(uint3 tid : SV_DispatchThreadID, uint groupIndex : SV_GroupIndex) {
+	localBins[groupIndex] = 0;
+	GroupMemoryBarrierWithGroupSync();
+
+	if (tid.x < width && tid.y < height) {
+		// BT.709 原色的亮度
+		const float luminance = dot(scene.Load(int3(tid.xy, 0)).rgb, float3(0.212639, 0.715169, 0.0721923));
+		const uint bin = GetBin(luminance);
+
+		// 相邻像素的亮度通常相同，wave 内同一个桶只执行一次原子操作。每次迭代处理第一个活动
+		// lane 所在的桶，处理过的 lane 退出循环。
+		for (;;) {
+			if (bin == WaveReadLaneFirst(bin)) {
+				const uint count = WaveActiveCountBits(true);
+				if (WaveIsFirstLane()) {
+					InterlockedAdd(localBins[bin], count);
+				}
+				break;
+			}
+		}
+	}
+
+	GroupMemoryBarrierWithGroupSync();
+
+	const uint count = localBins[groupIndex];
+	if (count > 0) {
+		histogram.InterlockedAdd(groupIndex * 4, count);
+	}
+}
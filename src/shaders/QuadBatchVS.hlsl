@@ -0,0 +1,16 @@
+struct PSInput {
+    noperspective float2 uv : TEXCOORD;
+    nointerpolation float4 color : COLOR;
+    nointerpolation uint texture : TEXINDEX;
+    noperspective float4 position : SV_POSITION;
+};
+
+// rect 为左上角和尺寸，单位为 NDC
+PSInput main(float2 position : POSITION, float2 uv : TEXCOORD, float4 rect : RECT, float4 color : COLOR, uint texture : TEXINDEX) {
+    PSInput result;
+    result.position = float4(rect.xy + position * rect.zw, 0, 1);
+    result.uv = uv;
+    result.color = color;
+    result.texture = texture;
+    return result;
+}
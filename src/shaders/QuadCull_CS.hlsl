@@ -0,0 +1,50 @@
+// 和 QuadCulling.h 中的 QuadInstance 一致
+struct QuadInstance {
+	float4 rect;
+	uint color;
+	uint texture;
+};
+
+cbuffer RootConstants : register(b0) {
+	uint startInstance;
+	uint instanceCount;
+	// 这种材质的 D3D12_DRAW_ARGUMENTS 在 drawArgs 中的偏移
+	uint drawArgsOffset;
+};
+
+StructuredBuffer<QuadInstance> instances : register(t0);
+RWStructuredBuffer<QuadInstance> visibleInstances : register(u0);
+RWByteAddressBuffer drawArgs : register(u1);
+
+// 和 QuadCulling::IsInstanceVisible 保持一致
+bool IsVisible(float4 rect) {
+	return rect.z > 0 && rect.w < 0 &&
+		rect.x < 1 && rect.x + rect.z > -1 && rect.y > -1 && rect.y + rect.w < 1;
+}
+
+[numthreads(64, 1, 1)]
+void main(uint3 tid : SV_DispatchThreadID) {
+	QuadInstance instance = (QuadInstance)0;
+	bool isVisible = false;
+	if (tid.x < instanceCount) {
+		instance = instances[startInstance + tid.x];
+		isVisible = IsVisible(instance.rect);
+	}
+
+	// 每个 wave 只执行一次原子操作
+	const uint visibleCount = WaveActiveCountBits(isVisible);
+	if (visibleCount == 0) {
+		return;
+	}
+
+	uint base = 0;
+	if (WaveIsFirstLane()) {
+		// InstanceCount 是 D3D12_DRAW_ARGUMENTS 的第二个成员
+		drawArgs.InterlockedAdd(drawArgsOffset + 4, visibleCount, base);
+	}
+	base = WaveReadLaneFirst(base);
+
+	if (isVisible) {
+		visibleInstances[startInstance + base + WavePrefixCountBits(isVisible)] = instance;
+	}
+}
@@ -0,0 +1,11 @@
+#include "ColorOutput.hlsli"
+
+cbuffer RootConstants : register(b0) {
+	float boost;
+};
+
+float4 main(noperspective float2 uv : TEXCOORD, nointerpolation float4 color : COLOR) : SV_Target {
+	float3 c1 = lerp(float3(0, 0, 1), float3(0.5, 0, 0.5), uv.x);
+	float3 c2 = lerp(float3(0, 1, 0), float3(1, 0, 0), uv.x);
+	return OutputColor(lerp(c1, c2, uv.y) * color.rgb * boost, color.a);
+}
@@ -0,0 +1,9 @@
+#include "ColorOutput.hlsli"
+
+cbuffer RootConstants : register(b0) {
+	float boost;
+};
+
+float4 main(noperspective float2 uv : TEXCOORD, nointerpolation float4 color : COLOR) : SV_Target {
+	return OutputColor(color.rgb * boost, color.a);
+}
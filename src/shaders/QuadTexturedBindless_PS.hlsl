@@ -0,0 +1,21 @@
+// 支持 SM 6.6 时使用，直接索引 ResourceDescriptorHeap，根签名见 D3D12Context::GetBindlessRootSignature
+#include "ColorOutput.hlsli"
+
+cbuffer RootConstants : register(b0) {
+	float boost;
+	// 第一个纹理的 SRV 在描述符堆中的索引
+	uint textureBase;
+};
+
+SamplerState linearSampler : register(s0);
+
+float4 main(
+	noperspective float2 uv : TEXCOORD,
+	nointerpolation float4 color : COLOR,
+	nointerpolation uint texture : TEXINDEX
+) : SV_Target {
+	// 同一次绘制中不同实例的纹理不同
+	Texture2D<float4> tex = ResourceDescriptorHeap[NonUniformResourceIndex(textureBase + texture)];
+	const float4 c = tex.Sample(linearSampler, uv) * color;
+	return OutputColor(c.rgb * boost, c.a);
+}
@@ -0,0 +1,20 @@
+// 不支持 bindless 时使用，纹理通过描述符表绑定
+#include "ColorOutput.hlsli"
+
+cbuffer RootConstants : register(b0) {
+	float boost;
+};
+
+// 和 QuadBatcher::TEXTURE_COUNT 一致
+Texture2D<float4> textures[8] : register(t0);
+SamplerState linearSampler : register(s0);
+
+float4 main(
+	noperspective float2 uv : TEXCOORD,
+	nointerpolation float4 color : COLOR,
+	nointerpolation uint texture : TEXINDEX
+) : SV_Target {
+	// 同一次绘制中不同实例的纹理不同
+	const float4 c = textures[NonUniformResourceIndex(texture)].Sample(linearSampler, uv) * color;
+	return OutputColor(c.rgb * boost, c.a);
+}
@@ -0,0 +1,28 @@
+// 和 SceneGeometry::GetSquareVertex 保持一致
+cbuffer RootConstants : register(b0) {
+	// 由像素着色器使用
+	float boost;
+	float dpiScale;
+	float2 viewportSize;
+};
+
+struct PSInput {
+    noperspective float2 uv : TEXCOORD;
+    noperspective float4 position : SV_POSITION;
+};
+
+PSInput main(uint vertexId : SV_VertexID, uint instanceId : SV_InstanceID) {
+    const float2 squareSize = 200.0f * dpiScale / viewportSize * 2.0f;
+    const float2 corner = float2(vertexId & 1, vertexId >> 1);
+    const float2 mirror = float2(instanceId & 1, instanceId >> 1);
+
+    PSInput result;
+    result.position = float4(
+        -1.0f + mirror.x * (2.0f - squareSize.x) + corner.x * squareSize.x,
+        1.0f - mirror.y * (2.0f - squareSize.y) - corner.y * squareSize.y,
+        0,
+        1
+    );
+    result.uv = abs(corner - mirror);
+    return result;
+}
@@ -0,0 +1,17 @@
+#include "pch.h"
+#include "Test.h"
+#include "AutoExposurePass.h"
+
+// 在默认显卡上运行，没有显卡时使用 WARP，需要 exe 所在目录的 Shaders.bin
+
+TEST(AutoExposurePass, HistogramMatchesReference) {
+	AutoExposurePass::ValidationResult result;
+	REQUIRE(SUCCEEDED(AutoExposurePass::Validate({ 1920, 1080 }, result)));
+
+	// 亮度的舍入可能不同，落在桶边界附近的像素允许分到相邻的桶
+	CHECK(result.pixelCount == 1920 * 1080);
+	CHECK(result.gpuPixelCount == result.pixelCount);
+	CHECK(result.mismatchCount * 10000 <= result.pixelCount);
+	std::printf("    %llu/%llu 个像素，%llu 个分到不同的桶\n", (unsigned long long)result.gpuPixelCount,
+		(unsigned long long)result.pixelCount, (unsigned long long)result.mismatchCount);
+}
@@ -0,0 +1,158 @@
+#include "Test.h"
+#include "Benchmark.h"
+#include <string>
+
+namespace {
+
+// 1 到 count 的打乱顺序
+std::vector<double> MakeSamples(uint32_t count) {
+	std::vector<double> samples;
+	for (uint32_t i = 0; i < count; ++i) {
+		samples.push_back((i * 7919 % count) + 1.0);
+	}
+	return samples;
+}
+
+std::string GenerateReport(const Benchmark::Environment& environment, const Benchmark::RendererStats& rendererStats = {}) {
+	Benchmark benchmark({});
+	return benchmark.GenerateReport(environment, rendererStats);
+}
+
+}
+
+TEST(Benchmark, SummarizeEmpty) {
+	std::vector<double> samples;
+	const Benchmark::Summary summary = Benchmark::Summarize(samples);
+	CHECK(summary.count == 0);
+	CHECK(summary.min == 0 && summary.max == 0 && summary.mean == 0);
+	CHECK(summary.p50 == 0 && summary.p999 == 0);
+}
+
+TEST(Benchmark, SummarizeSingleSample) {
+	std::vector<double> samples = { 4.5 };
+	const Benchmark::Summary summary = Benchmark::Summarize(samples);
+	CHECK(summary.count == 1);
+	CHECK(summary.min == 4.5 && summary.max == 4.5 && summary.mean == 4.5);
+	CHECK(summary.p50 == 4.5 && summary.p95 == 4.5 && summary.p99 == 4.5 && summary.p999 == 4.5);
+}
+
+TEST(Benchmark, PercentilesUseNearestRank) {
+	// 第 p 百分位数是排序后的第 ceil(p * n) 个，总是样本中的值，不插值
+	std::vector<double> samples = { 3.0, 1.0 };
+	Benchmark::Summary summary = Benchmark::Summarize(samples);
+	CHECK(summary.p50 == 1.0);
+	CHECK(summary.p95 == 3.0);
+	CHECK(summary.mean == 2.0);
+
+	samples = { 1.0, 2.0, 3.0, 4.0 };
+	summary = Benchmark::Summarize(samples);
+	CHECK(summary.p50 == 2.0);
+	CHECK(summary.p95 == 4.0);
+
+	samples = MakeSamples(100);
+	summary = Benchmark::Summarize(samples);
+	CHECK(summary.min == 1 && summary.max == 100);
+	CHECK(summary.p50 == 50);
+	CHECK(summary.p95 == 95);
+	CHECK(summary.p99 == 99);
+	// 样本少于 1000 个时 p99.9 是最大值
+	CHECK(summary.p999 == 100);
+
+	samples = MakeSamples(1000);
+	summary = Benchmark::Summarize(samples);
+	CHECK(summary.p999 == 999);
+
+	// p * n 恰好为整数时不能因舍入误差取到下一个
+	for (uint32_t count : { 20u, 40u, 200u, 2000u, 10000u }) {
+		samples = MakeSamples(count);
+		summary = Benchmark::Summarize(samples);
+		CHECK(summary.p50 == count / 2);
+		CHECK(summary.p95 == count / 20 * 19);
+	}
+	samples = MakeSamples(100000);
+	summary = Benchmark::Summarize(samples);
+	CHECK(summary.p99 == 99000);
+	CHECK(summary.p999 == 99900);
+
+	// 刚超过整数时取下一个
+	samples = MakeSamples(101);
+	summary = Benchmark::Summarize(samples);
+	CHECK(summary.p50 == 51);
+	CHECK(summary.p99 == 100);
+}
+
+TEST(Benchmark, SummarizeDuplicates) {
+	std::vector<double> samples(999, 1.0);
+	samples.push_back(100.0);
+	const Benchmark::Summary summary = Benchmark::Summarize(samples);
+	CHECK(summary.p99 == 1.0);
+	CHECK(summary.p999 == 1.0);
+	CHECK(summary.max == 100.0);
+}
+
+TEST(Benchmark, ReportEscapesStrings) {
+	const std::string report = GenerateReport({
+		.adapterName = "GPU \"A\" \\ B",
+		.colorMode = "SDR\n\t\x01\x1f",
+		.commandLine = "-benchmark-output=C:\\\xe6\xb5\x8b\xe8\xaf\x95.json \x7f"
+	});
+
+	CHECK(report.find("\"name\": \"GPU \\\"A\\\" \\\\ B\"") != std::string::npos);
+	// 控制字符使用 \u 转义，报告中除了格式的换行和缩进没有其他控制字符
+	CHECK(report.find("\"colorMode\": \"SDR\\u000a\\u0009\\u0001\\u001f\"") != std::string::npos);
+	// UTF-8 和 DEL 原样输出
+	CHECK(report.find("\"commandLine\": \"-benchmark-output=C:\\\\\xe6\xb5\x8b\xe8\xaf\x95.json \x7f\"") !=
+		std::string::npos);
+
+	for (char c : report) {
+		CHECK((unsigned char)c >= 0x20 || c == '\n' || c == '\t');
+	}
+}
+
+TEST(Benchmark, ReportEscapesEmptyAndPlainStrings) {
+	const std::string report = GenerateReport({ .adapterName = "", .colorMode = "HDR10" });
+	CHECK(report.find("\"name\": \"\",") != std::string::npos);
+	CHECK(report.find("\"colorMode\": \"HDR10\",") != std::string::npos);
+	CHECK(report.find("\"commandLine\": \"\",") != std::string::npos);
+	CHECK(report.starts_with("{\n") && report.ends_with("}\n"));
+}
+
+TEST(Benchmark, ReportIncludesRendererStats) {
+	const std::string report = GenerateReport({}, {
+		.uploadLastFrameBytes = 65536,
+		.uploadMaxFrameBytes = 5'000'000'000,
+		.uploadWrapCount = 3,
+		.uploadStallCount = 1,
+		.commandAllocatorCount = 6,
+		.commandAllocatorInUseCount = 2,
+		.maxCommandAllocatorCount = 9,
+		.maxCommandAllocatorInUseCount = 4,
+		.heapCount = 2,
+		.heapSize = 128 << 20,
+		.heapUsedSize = 96 << 20,
+		.heapRequestedSize = 80 << 20,
+		.largestFreeBlockSize = 16 << 20,
+		.freeBlockCount = 5,
+		.placedResourceCount = 40,
+		.committedResourceCount = 3,
+		.sdrPipelineCompileTime = 120.5,
+		.hdr10PipelineCompileTime = 80.25,
+		.pipelineWaitTime = 0.125,
+		.deferredColorModeSwitchCount = 1
+	});
+
+	// 64 位的计数
+	CHECK(report.find("\"uploadRing\": {\n\t\t\"lastFrameBytes\": 65536,\n\t\t\"maxFrameBytes\": 5000000000,\n"
+		"\t\t\"wrapCount\": 3,\n\t\t\"stallCount\": 1\n\t},") != std::string::npos);
+	CHECK(report.find("\"commandAllocatorPool\": {\n\t\t\"count\": 6,\n\t\t\"inUseCount\": 2,\n"
+		"\t\t\"maxCount\": 9,\n\t\t\"maxInUseCount\": 4\n\t},") != std::string::npos);
+	CHECK(report.find("\"heapAllocator\": {\n\t\t\"heapCount\": 2,\n\t\t\"heapSize\": 134217728,\n"
+		"\t\t\"usedSize\": 100663296,\n\t\t\"requestedSize\": 83886080,\n"
+		"\t\t\"largestFreeBlockSize\": 16777216,\n\t\t\"freeBlockCount\": 5,\n"
+		"\t\t\"placedResourceCount\": 40,\n\t\t\"committedResourceCount\": 3\n\t},") != std::string::npos);
+	// 未编译的颜色模式为 0
+	CHECK(report.find("\"pipelineCompilation\": {\n\t\t\"sdrCompileTime\": 120.5000,\n"
+		"\t\t\"advancedColorCompileTime\": 0.0000,\n\t\t\"hdr10CompileTime\": 80.2500,\n"
+		"\t\t\"waitTime\": 0.1250,\n\t\t\"deferredColorModeSwitchCount\": 1\n\t}\n}\n") != std::string::npos);
+	CHECK(report.find("\"version\": 2,") != std::string::npos);
+}
@@ -0,0 +1,165 @@
+#include "Test.h"
+#include "BuddyAllocator.h"
+#include <chrono>
+#include <map>
+#include <random>
+
+TEST(BuddyAllocator, SplitsAndCoalesces) {
+	// 容量 16，最小块 1
+	BuddyAllocator allocator(1, 4);
+	CHECK(allocator.GetCapacity() == 16);
+	CHECK(allocator.IsEmpty());
+
+	BuddyAllocator::Allocation a, b, c;
+	REQUIRE(allocator.Allocate(3, 1, a));
+	REQUIRE(allocator.Allocate(1, 1, b));
+	REQUIRE(allocator.Allocate(8, 1, c));
+
+	// 3 向上取整为 4，偏移最小的块优先
+	CHECK(a.offset == 0 && a.order == 2);
+	CHECK(b.offset == 4 && b.order == 0);
+	CHECK(c.offset == 8 && c.order == 3);
+
+	BuddyAllocator::Stats stats = allocator.GetStats();
+	CHECK(stats.usedSize == 13);
+	CHECK(stats.requestedSize == 12);
+	CHECK(stats.allocationCount == 3);
+	// 剩余 [5, 6) 和 [6, 8)
+	CHECK(stats.freeBlockCount == 2);
+	CHECK(stats.largestFreeBlockSize == 2);
+
+	allocator.Free(c);
+	allocator.Free(a);
+	allocator.Free(b);
+
+	// 全部合并回一个块
+	stats = allocator.GetStats();
+	CHECK(allocator.IsEmpty());
+	CHECK(stats.usedSize == 0 && stats.requestedSize == 0);
+	CHECK(stats.freeBlockCount == 1);
+	CHECK(stats.largestFreeBlockSize == 16);
+}
+
+TEST(BuddyAllocator, HonorsAlignment) {
+	BuddyAllocator allocator(1, 6);
+
+	BuddyAllocator::Allocation small, aligned;
+	REQUIRE(allocator.Allocate(1, 1, small));
+	REQUIRE(allocator.Allocate(4, 16, aligned));
+
+	CHECK(aligned.offset % 16 == 0);
+	CHECK(aligned.offset != small.offset);
+	// 对齐使块变大，计入内部碎片
+	CHECK(aligned.order == 4);
+	CHECK(allocator.GetStats().requestedSize == 5);
+}
+
+TEST(BuddyAllocator, RejectsRequestsThatDoNotFit) {
+	BuddyAllocator allocator(4, 2);
+
+	BuddyAllocator::Allocation allocation;
+	CHECK(!allocator.Allocate(0, 1, allocation));
+	CHECK(!allocator.Allocate(17, 1, allocation));
+	CHECK(!allocator.Allocate(1, 32, allocation));
+
+	BuddyAllocator::Allocation blocks[4];
+	for (BuddyAllocator::Allocation& block : blocks) {
+		CHECK(allocator.Allocate(4, 4, block));
+	}
+	CHECK(!allocator.Allocate(1, 1, allocation));
+
+	// 释放不相邻的两块后仍无法分配 8
+	allocator.Free(blocks[1]);
+	allocator.Free(blocks[2]);
+	CHECK(!allocator.Allocate(8, 1, allocation));
+	CHECK(allocator.GetStats().freeBlockCount == 2);
+
+	allocator.Free(blocks[0]);
+	CHECK(allocator.Allocate(8, 1, allocation));
+	CHECK(allocation.offset == 0);
+}
+
+// 随机分配和释放，检查块不重叠、满足对齐，统计和参考模型一致。同时作为分配频繁变化时的基准。
+TEST(BuddyAllocator, RandomChurn) {
+	// 和 HeapAllocator 相同：64KB 的最小块，64MB 的堆
+	constexpr uint64_t MIN_BLOCK_SIZE = 64 * 1024;
+	constexpr uint32_t MAX_ORDER = 10;
+	BuddyAllocator allocator(MIN_BLOCK_SIZE, MAX_ORDER);
+
+	std::mt19937 rng(12345);
+	std::vector<BuddyAllocator::Allocation> live;
+	// 偏移 -> 块的末尾，用于检查重叠
+	std::map<uint64_t, uint64_t> ranges;
+	uint64_t requestedSize = 0;
+	uint32_t operationCount = 0;
+	uint32_t failedCount = 0;
+	uint32_t errorCount = 0;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < 200000; ++i) {
+		++operationCount;
+
+		if (live.empty() || rng() % 100 < 55) {
+			// 大小偏向小资源，偶尔有接近整个堆的
+			const uint32_t shift = rng() % 100 < 90 ? rng() % 5 : 5 + rng() % 5;
+			const uint64_t size = (MIN_BLOCK_SIZE << shift) - rng() % MIN_BLOCK_SIZE;
+			const uint64_t alignment = rng() % 4 == 0 ? 4 * 1024 * 1024 : 64 * 1024;
+
+			BuddyAllocator::Allocation allocation;
+			if (!allocator.Allocate(size, alignment, allocation)) {
+				++failedCount;
+				continue;
+			}
+
+			const uint64_t end = allocation.offset + (MIN_BLOCK_SIZE << allocation.order);
+			if (allocation.offset % alignment != 0 || allocation.size != size ||
+				end > allocator.GetCapacity() || end - allocation.offset < size) {
+				++errorCount;
+			}
+
+			auto next = ranges.lower_bound(allocation.offset);
+			if (next != ranges.end() && next->first < end) {
+				++errorCount;
+			}
+			if (next != ranges.begin() && std::prev(next)->second > allocation.offset) {
+				++errorCount;
+			}
+
+			ranges.emplace(allocation.offset, end);
+			live.push_back(allocation);
+			requestedSize += size;
+		} else {
+			const size_t index = rng() % live.size();
+			const BuddyAllocator::Allocation allocation = live[index];
+			live[index] = live.back();
+			live.pop_back();
+
+			allocator.Free(allocation);
+			ranges.erase(allocation.offset);
+			requestedSize -= allocation.size;
+		}
+
+		if (i % 1000 == 0) {
+			const BuddyAllocator::Stats stats = allocator.GetStats();
+			if (stats.allocationCount != live.size() || stats.requestedSize != requestedSize) {
+				++errorCount;
+			}
+		}
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const BuddyAllocator::Stats stats = allocator.GetStats();
+	std::printf("    %.0f 次操作/秒，%u 次分配失败，结束时 %u 个分配，最大空闲块 %llu KB\n",
+		operationCount / seconds, failedCount, stats.allocationCount,
+		(unsigned long long)stats.largestFreeBlockSize / 1024);
+
+	CHECK(errorCount == 0);
+
+	for (const BuddyAllocator::Allocation& allocation : live) {
+		allocator.Free(allocation);
+	}
+	CHECK(allocator.IsEmpty());
+	CHECK(allocator.GetStats().largestFreeBlockSize == allocator.GetCapacity());
+	CHECK(allocator.GetStats().freeBlockCount == 1);
+}
@@ -0,0 +1,77 @@
+#include "Test.h"
+#include "BufferCapacity.h"
+#include <bit>
+
+namespace {
+
+// 和 QuadBatcher 一致
+constexpr uint32_t QUAD_INSTANCE_SIZE = 24;
+constexpr uint32_t MIN_INSTANCE_UPLOAD_CAPACITY = 4096;
+// D3D12Context::Initialize 的默认上传环大小，QuadBatcher 以前从这里分配实例数据
+constexpr uint64_t DEFAULT_UPLOAD_RING_SIZE = 4 * 1024 * 1024;
+
+}
+
+TEST(BufferCapacity, KeepsSufficientCapacity) {
+	CHECK(BufferCapacity::Grow(0, 0, 1024) == 0);
+	CHECK(BufferCapacity::Grow(4096, 1, 1024) == 4096);
+	CHECK(BufferCapacity::Grow(4096, 4096, 1024) == 4096);
+	// 不收缩，也不要求已有的容量是 2 的幂
+	CHECK(BufferCapacity::Grow(5000, 10, 1024) == 5000);
+}
+
+TEST(BufferCapacity, GrowsToPowerOfTwo) {
+	CHECK(BufferCapacity::Grow(0, 1, 1024) == 1024);
+	CHECK(BufferCapacity::Grow(0, 1025, 1024) == 2048);
+	CHECK(BufferCapacity::Grow(1024, 1025, 1024) == 2048);
+	CHECK(BufferCapacity::Grow(3000, 3001, 1024) == 6000);
+
+	for (uint32_t count = 1; count < (1u << 24); count = count * 3 + 1) {
+		const uint32_t capacity = BufferCapacity::Grow(0, count, 1);
+		CHECK(capacity >= count);
+		CHECK(std::has_single_bit(capacity));
+		CHECK(capacity / 2 < count);
+	}
+}
+
+TEST(BufferCapacity, ClampsAtUint32Max) {
+	CHECK(BufferCapacity::Grow(0, 1u << 31, 1024) == 1u << 31);
+	CHECK(BufferCapacity::Grow(0, (1u << 31) + 1, 1024) == (1u << 31) + 1);
+	CHECK(BufferCapacity::Grow(1u << 31, UINT32_MAX, 1024) == UINT32_MAX);
+}
+
+// 模拟 QuadBatcher 每个在途帧的实例上传缓冲，四边形数增长到一百万以上
+TEST(BufferCapacity, MillionQuadsPerFrame) {
+	constexpr uint32_t FRAME_COUNT = 3;
+	constexpr uint32_t QUAD_COUNTS[] = { 1000, 100'000, 174'763, 1'000'000, 1'500'000, 2'000'000, 300'000 };
+
+	// 17.5 万个四边形就超出了上传环
+	CHECK((uint64_t)174'763 * QUAD_INSTANCE_SIZE > DEFAULT_UPLOAD_RING_SIZE);
+
+	uint32_t capacities[FRAME_COUNT]{};
+	uint32_t createCounts[FRAME_COUNT]{};
+	uint64_t frameNumber = 0;
+	for (uint32_t quadCount : QUAD_COUNTS) {
+		// 每个数量持续若干帧，每个帧索引都使用到
+		for (uint32_t i = 0; i < FRAME_COUNT * 4; ++i, ++frameNumber) {
+			const uint32_t frameIndex = uint32_t(frameNumber % FRAME_COUNT);
+			const uint32_t capacity = BufferCapacity::Grow(
+				capacities[frameIndex], quadCount, MIN_INSTANCE_UPLOAD_CAPACITY);
+			if (capacity != capacities[frameIndex]) {
+				capacities[frameIndex] = capacity;
+				++createCounts[frameIndex];
+			}
+
+			REQUIRE(capacities[frameIndex] >= quadCount);
+			// 不超出顶点缓冲视图的 32 位大小
+			REQUIRE((uint64_t)capacities[frameIndex] * QUAD_INSTANCE_SIZE <= UINT32_MAX);
+		}
+	}
+
+	for (uint32_t frameIndex = 0; frameIndex < FRAME_COUNT; ++frameIndex) {
+		// 2M 个四边形需要 2^21 个实例，约 48MB
+		CHECK(capacities[frameIndex] == 1u << 21);
+		// 4096 -> 2^17 -> 2^18 -> 2^20 -> 2^21，降回 30 万时不重新创建
+		CHECK(createCounts[frameIndex] == 5);
+	}
+}
@@ -0,0 +1,459 @@
+#include "Test.h"
+#include "ColorKernels.h"
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <random>
+
+using ColorKernels::InstructionSet;
+
+namespace {
+
+constexpr InstructionSet INSTRUCTION_SETS[] = {
+	InstructionSet::Scalar, InstructionSet::SSE4, InstructionSet::AVX2, InstructionSet::NEON
+};
+
+// 以 float 在 expected 处的间距为单位的误差，非规格化数的间距为 2^-149
+double GetUlpError(float actual, double expected) noexcept {
+	if (std::isinf(actual) || std::isinf((float)expected)) {
+		return actual == (float)expected ? 0.0 : std::numeric_limits<double>::infinity();
+	}
+
+	const int exponent = expected == 0.0 ? -126 : std::max(std::ilogb(expected), -126);
+	return std::abs(actual - expected) / std::ldexp(1.0, exponent - 23);
+}
+
+// 所有非负的有限 float 按表示等距取样，每个二进制数量级约 8000 个，包括 0 和最大值
+std::vector<float> GetNonNegativeFloats() noexcept {
+	constexpr uint32_t MAX_BITS = 0x7F7FFFFF;
+	constexpr uint32_t STEP = 1021;
+
+	std::vector<float> values;
+	values.reserve(MAX_BITS / STEP + 2);
+	for (uint32_t bits = 0; bits < MAX_BITS; bits += STEP) {
+		values.push_back(std::bit_cast<float>(bits));
+	}
+	values.push_back(std::bit_cast<float>(MAX_BITS));
+	return values;
+}
+
+// 所有有限 float 的取样，另外加上 [0, 1] 内分段点两侧的所有值
+std::vector<float> GetTestInputs(std::initializer_list<double> breakpoints) noexcept {
+	std::vector<float> values = GetNonNegativeFloats();
+
+	for (double breakpoint : breakpoints) {
+		const uint32_t bits = std::bit_cast<uint32_t>((float)breakpoint);
+		for (uint32_t i = bits - 4096; i <= bits + 4096; ++i) {
+			values.push_back(std::bit_cast<float>(i));
+		}
+	}
+
+	const size_t count = values.size();
+	for (size_t i = 0; i < count; ++i) {
+		values.push_back(-values[i]);
+	}
+	return values;
+}
+
+double SRGBToLinearReference(double x) noexcept {
+	const double a = std::abs(x);
+	return std::copysign(a <= 0.04045 ? a / 12.92 : std::pow((a + 0.055) / 1.055, 2.4), x);
+}
+
+double LinearToSRGBReference(double x) noexcept {
+	const double a = std::abs(x);
+	return std::copysign(a <= 0.0031308 ? a * 12.92 : 1.055 * std::pow(a, 1 / 2.4) - 0.055, x);
+}
+
+constexpr double PQ_M1 = 2610.0 / 16384;
+constexpr double PQ_M2 = 2523.0 / 4096 * 128;
+constexpr double PQ_C1 = 3424.0 / 4096;
+constexpr double PQ_C2 = 2413.0 / 4096 * 32;
+constexpr double PQ_C3 = 2392.0 / 4096 * 32;
+
+double Saturate(double x) noexcept {
+	return std::isnan(x) ? 0.0 : std::clamp(x, 0.0, 1.0);
+}
+
+double LinearToPQReference(double x, double scale) noexcept {
+	const double y = std::pow(Saturate(x * scale), PQ_M1);
+	return std::pow((PQ_C1 + PQ_C2 * y) / (1 + PQ_C3 * y), PQ_M2);
+}
+
+double PQToLinearReference(double x, double scale) noexcept {
+	const double e = std::pow(Saturate(x), 1 / PQ_M2);
+	return std::pow(std::max(e - PQ_C1, 0.0) / (PQ_C2 - PQ_C3 * e), 1 / PQ_M1) / scale;
+}
+
+// 对每种支持的指令集检查 kernel 的每个输出和 expected 相差不超过 1 ULP。kernel 把 inputs 对应
+// 的结果写入 dst。
+template <typename F>
+void CheckKernel(const char* name, const float* inputs, const std::vector<double>& expected, const F& kernel) noexcept {
+	const InstructionSet originalInstructionSet = ColorKernels::GetInstructionSet();
+
+	std::vector<float> outputs(expected.size());
+	for (InstructionSet instructionSet : INSTRUCTION_SETS) {
+		if (!ColorKernels::SetInstructionSet(instructionSet)) {
+			continue;
+		}
+
+		kernel(outputs.data());
+
+		double maxError = 0;
+		size_t failedCount = 0;
+		for (size_t i = 0; i < expected.size(); ++i) {
+			const double error = GetUlpError(outputs[i], expected[i]);
+			if (error <= 1.0) {
+				maxError = std::max(maxError, error);
+				continue;
+			}
+
+			// 只打印前几个
+			if (failedCount++ < 3) {
+				std::printf("    %s %s(%.9g) = %.9g，应为 %.17g\n", ColorKernels::GetInstructionSetName(instructionSet),
+					name, inputs[i], outputs[i], expected[i]);
+			}
+		}
+
+		CHECK(failedCount == 0);
+		std::printf("    %s %s：%zu 个输入，最大误差 %.3f ULP\n",
+			ColorKernels::GetInstructionSetName(instructionSet), name, expected.size(), maxError);
+	}
+
+	ColorKernels::SetInstructionSet(originalInstructionSet);
+}
+
+}
+
+TEST(ColorKernels, SRGBToLinearAccuracy) {
+	const std::vector<float> inputs = GetTestInputs({ 0.04045 });
+	std::vector<double> expected(inputs.size());
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		expected[i] = SRGBToLinearReference(inputs[i]);
+	}
+
+	CheckKernel("SRGBToLinear", inputs.data(), expected, [&](float* dst) {
+		ColorKernels::SRGBToLinear(inputs.data(), dst, inputs.size());
+	});
+}
+
+TEST(ColorKernels, LinearToSRGBAccuracy) {
+	const std::vector<float> inputs = GetTestInputs({ 0.0031308 });
+	std::vector<double> expected(inputs.size());
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		expected[i] = LinearToSRGBReference(inputs[i]);
+	}
+
+	CheckKernel("LinearToSRGB", inputs.data(), expected, [&](float* dst) {
+		ColorKernels::LinearToSRGB(inputs.data(), dst, inputs.size());
+	});
+}
+
+TEST(ColorKernels, LinearToPQAccuracy) {
+	// 截断前的范围是 [0, 1 / scale]
+	const float scale = ColorKernels::SCRGB_WHITE_NITS / ColorKernels::PQ_MAX_NITS;
+	std::vector<float> inputs = GetTestInputs({ 1.0, 1 / scale });
+	inputs.push_back(std::numeric_limits<float>::quiet_NaN());
+
+	std::vector<double> expected(inputs.size());
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		expected[i] = LinearToPQReference(inputs[i], scale);
+	}
+
+	CheckKernel("LinearToPQ", inputs.data(), expected, [&](float* dst) {
+		ColorKernels::LinearToPQ(inputs.data(), dst, inputs.size(), scale);
+	});
+}
+
+TEST(ColorKernels, PQToLinearAccuracy) {
+	const float scale = ColorKernels::SCRGB_WHITE_NITS / ColorKernels::PQ_MAX_NITS;
+	// 0.5 附近是 100 尼特
+	std::vector<float> inputs = GetTestInputs({ 0.5, 1.0 });
+	inputs.push_back(std::numeric_limits<float>::quiet_NaN());
+
+	std::vector<double> expected(inputs.size());
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		expected[i] = PQToLinearReference(inputs[i], scale);
+	}
+
+	CheckKernel("PQToLinear", inputs.data(), expected, [&](float* dst) {
+		ColorKernels::PQToLinear(inputs.data(), dst, inputs.size(), scale);
+	});
+}
+
+TEST(ColorKernels, ScaleAccuracy) {
+	const std::vector<float> inputs = GetTestInputs({});
+	std::vector<double> expected(inputs.size());
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		expected[i] = (double)inputs[i] * 2.5;
+	}
+
+	CheckKernel("Scale", inputs.data(), expected, [&](float* dst) {
+		ColorKernels::Scale(inputs.data(), dst, inputs.size(), 2.5f);
+	});
+}
+
+// 三个通道一起转换，分别和双精度的矩阵乘法比较
+TEST(ColorKernels, TransformGamutAccuracy) {
+	constexpr size_t COUNT = 100003;
+
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> distribution(-2.0f, 10.0f);
+	std::vector<float> inputs(COUNT * 3);
+	for (float& value : inputs) {
+		value = distribution(random);
+	}
+	const float* const src[3] = { inputs.data(), inputs.data() + COUNT, inputs.data() + COUNT * 2 };
+
+	const ColorKernels::Matrix3x3& matrix = ColorKernels::P3_TO_BT2020;
+	std::vector<float> outputs(COUNT * 3);
+	float* const dst[3] = { outputs.data(), outputs.data() + COUNT, outputs.data() + COUNT * 2 };
+
+	for (uint32_t c = 0; c < 3; ++c) {
+		std::vector<double> expected(COUNT);
+		for (size_t i = 0; i < COUNT; ++i) {
+			expected[i] = (double)matrix.m[c][0] * src[0][i] +
+				(double)matrix.m[c][1] * src[1][i] + (double)matrix.m[c][2] * src[2][i];
+		}
+
+		const char* const NAMES[] = { "TransformGamut.R", "TransformGamut.G", "TransformGamut.B" };
+		CheckKernel(NAMES[c], src[c], expected, [&](float* channel) {
+			ColorKernels::TransformGamut(src, dst, COUNT, matrix);
+			std::copy_n(dst[c], COUNT, channel);
+		});
+	}
+}
+
+// 半精度的转换是精确的，所有指令集的结果必须逐位相同
+TEST(ColorKernels, HalfRoundTrip) {
+	// 所有半精度值，包括非规格化数、无穷大和 NaN
+	constexpr size_t COUNT = 65536;
+	std::vector<uint16_t> halves(COUNT * 4);
+	for (uint32_t i = 0; i < COUNT; ++i) {
+		halves[i * 4] = (uint16_t)i;
+		halves[i * 4 + 1] = (uint16_t)(i ^ 0x8000);
+		halves[i * 4 + 2] = (uint16_t)(COUNT - 1 - i);
+		halves[i * 4 + 3] = 0x3C00;
+	}
+
+	// 所有有限 float 的取样，覆盖舍入、溢出和非规格化的结果
+	std::vector<float> floats = GetTestInputs({ 65504.0, 6.103515625e-05 });
+	floats.resize(floats.size() / 3 * 3);
+	const size_t floatCount = floats.size() / 3;
+	const float* const floatSrc[3] = { floats.data(), floats.data() + floatCount, floats.data() + floatCount * 2 };
+
+	const InstructionSet originalInstructionSet = ColorKernels::GetInstructionSet();
+
+	std::vector<float> scalarUnpacked;
+	std::vector<uint16_t> scalarPacked;
+	for (InstructionSet instructionSet : INSTRUCTION_SETS) {
+		if (!ColorKernels::SetInstructionSet(instructionSet)) {
+			continue;
+		}
+
+		std::vector<float> unpacked(COUNT * 3);
+		float* const dst[3] = { unpacked.data(), unpacked.data() + COUNT, unpacked.data() + COUNT * 2 };
+		ColorKernels::UnpackHalf(halves.data(), dst, COUNT);
+
+		// 每个有限的半精度值往返后不变
+		std::vector<uint16_t> repacked(COUNT * 4);
+		ColorKernels::PackHalf(dst, repacked.data(), COUNT);
+		for (size_t i = 0; i < COUNT * 4; ++i) {
+			const bool isNaN = (halves[i] & 0x7C00) == 0x7C00 && (halves[i] & 0x3FF) != 0;
+			if (!isNaN) {
+				REQUIRE(repacked[i] == halves[i]);
+			}
+		}
+
+		std::vector<uint16_t> packed(floatCount * 4);
+		ColorKernels::PackHalf(floatSrc, packed.data(), floatCount);
+
+		if (instructionSet == InstructionSet::Scalar) {
+			scalarUnpacked = std::move(unpacked);
+			scalarPacked = std::move(packed);
+			continue;
+		}
+
+		// NaN 的位模式可能不同，逐位比较前统一
+		for (size_t i = 0; i < unpacked.size(); ++i) {
+			CHECK(std::bit_cast<uint32_t>(unpacked[i]) == std::bit_cast<uint32_t>(scalarUnpacked[i]) ||
+				(std::isnan(unpacked[i]) && std::isnan(scalarUnpacked[i])));
+		}
+		CHECK(packed == scalarPacked);
+	}
+
+	ColorKernels::SetInstructionSet(originalInstructionSet);
+}
+
+// SMPTE ST 2084 的编码值，HDR10 的 10 位编码为全范围
+TEST(ColorKernels, PQReferenceValues) {
+	struct Sample {
+		float nits;
+		double pq;
+		uint32_t code;
+	};
+	static constexpr Sample SAMPLES[] = {
+		{ 0.0f, 7.309559025783966e-07, 0 },
+		{ 80.0f, 0.4858567653886785, 497 },
+		{ 100.0f, 0.508078421517399, 520 },
+		{ 203.0f, 0.5806888810416109, 594 },
+		{ 1000.0f, 0.751827096247041, 769 },
+		{ 10000.0f, 1.0, 1023 }
+	};
+	constexpr size_t COUNT = std::size(SAMPLES);
+
+	// scRGB 中 1.0 为 80 尼特
+	const float scale = ColorKernels::SCRGB_WHITE_NITS / ColorKernels::PQ_MAX_NITS;
+	float linear[COUNT];
+	for (size_t i = 0; i < COUNT; ++i) {
+		linear[i] = SAMPLES[i].nits / ColorKernels::SCRGB_WHITE_NITS;
+	}
+
+	const InstructionSet originalInstructionSet = ColorKernels::GetInstructionSet();
+
+	for (InstructionSet instructionSet : INSTRUCTION_SETS) {
+		if (!ColorKernels::SetInstructionSet(instructionSet)) {
+			continue;
+		}
+
+		float pq[COUNT];
+		ColorKernels::LinearToPQ(linear, pq, COUNT, scale);
+
+		uint32_t packed[COUNT];
+		const float* const channels[3] = { pq, pq, pq };
+		ColorKernels::PackUNorm10(channels, packed, COUNT);
+
+		float roundTrip[COUNT];
+		ColorKernels::PQToLinear(pq, roundTrip, COUNT, scale);
+
+		for (size_t i = 0; i < COUNT; ++i) {
+			CHECK(std::abs(pq[i] - SAMPLES[i].pq) < 1e-6);
+			CHECK(packed[i] == (SAMPLES[i].code | (SAMPLES[i].code << 10) | (SAMPLES[i].code << 20) | 0xC0000000u));
+			// 0 尼特编码后不为 0，解码回到 0
+			CHECK(std::abs(roundTrip[i] - linear[i]) <= linear[i] * 1e-6f);
+		}
+	}
+
+	ColorKernels::SetInstructionSet(originalInstructionSet);
+}
+
+namespace {
+
+using Matrix = std::array<std::array<double, 3>, 3>;
+
+Matrix Multiply(const Matrix& a, const Matrix& b) noexcept {
+	Matrix result{};
+	for (uint32_t i = 0; i < 3; ++i) {
+		for (uint32_t j = 0; j < 3; ++j) {
+			for (uint32_t k = 0; k < 3; ++k) {
+				result[i][j] += a[i][k] * b[k][j];
+			}
+		}
+	}
+	return result;
+}
+
+Matrix Invert(const Matrix& m) noexcept {
+	const double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+		m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+		m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+
+	Matrix result;
+	for (uint32_t i = 0; i < 3; ++i) {
+		for (uint32_t j = 0; j < 3; ++j) {
+			// 伴随矩阵的转置
+			const uint32_t r0 = (j + 1) % 3, r1 = (j + 2) % 3;
+			const uint32_t c0 = (i + 1) % 3, c1 = (i + 2) % 3;
+			result[i][j] = (m[r0][c0] * m[r1][c1] - m[r0][c1] * m[r1][c0]) / det;
+		}
+	}
+	return result;
+}
+
+// 由三原色和 D65 白点的色度坐标计算线性 RGB 到 XYZ 的矩阵
+Matrix GetRgbToXyz(const double (&primaries)[3][2]) noexcept {
+	constexpr double WHITE[2] = { 0.3127, 0.3290 };
+
+	Matrix m;
+	for (uint32_t c = 0; c < 3; ++c) {
+		const double x = primaries[c][0];
+		const double y = primaries[c][1];
+		m[0][c] = x / y;
+		m[1][c] = 1.0;
+		m[2][c] = (1 - x - y) / y;
+	}
+
+	// 每个原色的亮度使 RGB 为 1 时得到白点
+	const Matrix inverse = Invert(m);
+	const double white[3] = { WHITE[0] / WHITE[1], 1.0, (1 - WHITE[0] - WHITE[1]) / WHITE[1] };
+	for (uint32_t c = 0; c < 3; ++c) {
+		const double luminance = inverse[c][0] * white[0] + inverse[c][1] * white[1] + inverse[c][2] * white[2];
+		for (uint32_t r = 0; r < 3; ++r) {
+			m[r][c] *= luminance;
+		}
+	}
+	return m;
+}
+
+}
+
+// ColorKernels.h 中的色域转换矩阵和由色度坐标计算的结果一致
+TEST(ColorKernels, GamutMatrices) {
+	static constexpr double BT709[3][2] = { { 0.640, 0.330 }, { 0.300, 0.600 }, { 0.150, 0.060 } };
+	static constexpr double P3[3][2] = { { 0.680, 0.320 }, { 0.265, 0.690 }, { 0.150, 0.060 } };
+	static constexpr double BT2020[3][2] = { { 0.708, 0.292 }, { 0.170, 0.797 }, { 0.131, 0.046 } };
+
+	struct Conversion {
+		const char* name;
+		const ColorKernels::Matrix3x3& matrix;
+		const double (&from)[3][2];
+		const double (&to)[3][2];
+	};
+	const Conversion conversions[] = {
+		{ "BT709_TO_P3", ColorKernels::BT709_TO_P3, BT709, P3 },
+		{ "P3_TO_BT709", ColorKernels::P3_TO_BT709, P3, BT709 },
+		{ "BT709_TO_BT2020", ColorKernels::BT709_TO_BT2020, BT709, BT2020 },
+		{ "BT2020_TO_BT709", ColorKernels::BT2020_TO_BT709, BT2020, BT709 },
+		{ "P3_TO_BT2020", ColorKernels::P3_TO_BT2020, P3, BT2020 },
+		{ "BT2020_TO_P3", ColorKernels::BT2020_TO_P3, BT2020, P3 }
+	};
+
+	for (const Conversion& conversion : conversions) {
+		const Matrix expected = Multiply(Invert(GetRgbToXyz(conversion.to)), GetRgbToXyz(conversion.from));
+
+		double maxError = 0;
+		for (uint32_t i = 0; i < 3; ++i) {
+			// 白点不变
+			double rowSum = 0;
+			for (uint32_t j = 0; j < 3; ++j) {
+				maxError = std::max(maxError, std::abs(conversion.matrix.m[i][j] - expected[i][j]));
+				rowSum += conversion.matrix.m[i][j];
+			}
+			CHECK(std::abs(rowSum - 1.0) < 1e-6);
+		}
+
+		if (!(maxError < 1e-6)) {
+			std::printf("    %s 最大误差 %g\n", conversion.name, maxError);
+		}
+		CHECK(maxError < 1e-6);
+	}
+
+	// HDR10 的编码路径：BT.709 的原色转换到 BT.2020 后在色域内，转换回来不变
+	const float primaries[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+	float channels[3][3];
+	float* const rgb[3] = { channels[0], channels[1], channels[2] };
+	const float* const src[3] = { primaries[0], primaries[1], primaries[2] };
+	ColorKernels::TransformGamut(src, rgb, 3, ColorKernels::BT709_TO_BT2020);
+	for (uint32_t c = 0; c < 3; ++c) {
+		for (uint32_t i = 0; i < 3; ++i) {
+			CHECK(channels[c][i] > 0.0f && channels[c][i] < 1.0f);
+		}
+	}
+
+	ColorKernels::TransformGamut(rgb, rgb, 3, ColorKernels::BT2020_TO_BT709);
+	for (uint32_t c = 0; c < 3; ++c) {
+		for (uint32_t i = 0; i < 3; ++i) {
+			CHECK(std::abs(channels[c][i] - primaries[c][i]) < 1e-6f);
+		}
+	}
+}
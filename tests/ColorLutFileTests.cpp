@@ -0,0 +1,100 @@
+#include "Test.h"
+#include "ColorLutFile.h"
+#include <cstddef>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t KEY = 0x0123456789ABCDEF;
+
+// 模拟 ColorLutPass::Update 写入的文件
+std::vector<uint8_t> MakeFile(uint64_t key) {
+	std::vector<uint8_t> data(ColorLutFile::FILE_SIZE);
+	uint16_t* lut = ColorLutFile::GetLut(data);
+	for (size_t i = 0; i < ColorLut::DATA_SIZE; ++i) {
+		lut[i] = uint16_t(i * 31 + 7);
+	}
+	ColorLutFile::WriteHeader(key, data);
+	return data;
+}
+
+}
+
+TEST(ColorLutFile, RoundTrip) {
+	const std::vector<uint8_t> data = MakeFile(KEY);
+
+	std::vector<uint16_t> lut(ColorLut::DATA_SIZE);
+	REQUIRE(ColorLutFile::Read(data, KEY, lut.data()));
+	for (size_t i = 0; i < lut.size(); ++i) {
+		CHECK(lut[i] == uint16_t(i * 31 + 7));
+	}
+}
+
+TEST(ColorLutFile, HeaderLayout) {
+	const std::vector<uint8_t> data = MakeFile(KEY);
+
+	// 文件格式固定为小端，开头是 "CLT0" 和版本号
+	CHECK(std::memcmp(data.data(), "CLT0", 4) == 0);
+	uint32_t version;
+	std::memcpy(&version, data.data() + 4, sizeof(version));
+	CHECK(version == ColorLutFile::VERSION);
+
+	uint64_t key;
+	std::memcpy(&key, data.data() + offsetof(ColorLutFile::Header, key), sizeof(key));
+	CHECK(key == KEY);
+}
+
+TEST(ColorLutFile, RejectsDifferentKey) {
+	const std::vector<uint8_t> data = MakeFile(KEY);
+
+	// 同一显示器的亮度或配置文件改变后覆盖同一个文件，旧的内容因键不匹配而失效
+	std::vector<uint16_t> lut(ColorLut::DATA_SIZE, 0xFFFF);
+	CHECK(!ColorLutFile::Read(data, KEY + 1, lut.data()));
+	CHECK(!ColorLutFile::Read(data, 0, lut.data()));
+	// 失败时不写入
+	CHECK(std::ranges::all_of(lut, [](uint16_t value) { return value == 0xFFFF; }));
+}
+
+TEST(ColorLutFile, RejectsCorruption) {
+	const std::vector<uint8_t> original = MakeFile(KEY);
+	std::vector<uint16_t> lut(ColorLut::DATA_SIZE);
+	REQUIRE(ColorLutFile::Read(original, KEY, lut.data()));
+
+	// 文件头的任何一个字节改变都被发现。数据有约 280KB，逐字节检查太慢，间隔取样。
+	std::vector<uint8_t> data = original;
+	for (size_t i = 0; i < data.size(); i += i < ColorLutFile::HEADER_SIZE ? 1 : 997) {
+		data[i] ^= 0x40;
+		CHECK(!ColorLutFile::Read(data, KEY, lut.data()));
+		data[i] ^= 0x40;
+	}
+
+	// 最后一个字节
+	data.back() ^= 0x01;
+	CHECK(!ColorLutFile::Read(data, KEY, lut.data()));
+}
+
+TEST(ColorLutFile, RejectsWrongSize) {
+	std::vector<uint8_t> data = MakeFile(KEY);
+	std::vector<uint16_t> lut(ColorLut::DATA_SIZE);
+
+	CHECK(!ColorLutFile::Read({}, KEY, lut.data()));
+	CHECK(!ColorLutFile::Read(std::span(data).first(ColorLutFile::HEADER_SIZE), KEY, lut.data()));
+	// 截断
+	CHECK(!ColorLutFile::Read(std::span(data).first(data.size() - 1), KEY, lut.data()));
+	// 末尾有多余的数据
+	data.push_back(0);
+	CHECK(!ColorLutFile::Read(data, KEY, lut.data()));
+}
+
+TEST(ColorLutFile, UnalignedData) {
+	const std::vector<uint8_t> file = MakeFile(KEY);
+
+	// 文件数据不一定对齐
+	std::vector<uint8_t> buffer(1);
+	buffer.insert(buffer.end(), file.begin(), file.end());
+	const std::span<const uint8_t> data = std::span(buffer).subspan(1);
+
+	std::vector<uint16_t> lut(ColorLut::DATA_SIZE);
+	REQUIRE(ColorLutFile::Read(data, KEY, lut.data()));
+	CHECK(std::memcmp(lut.data(), file.data() + ColorLutFile::HEADER_SIZE, ColorLutFile::DATA_BYTES) == 0);
+}
@@ -0,0 +1,94 @@
+#include "Test.h"
+#include "ColorLut.h"
+#include "JobSystem.h"
+#include <cmath>
+
+namespace {
+
+double SRGBToLinear(double value) {
+	return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+}
+
+double LinearToSRGB(double value) {
+	return value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1 / 2.4) - 0.055;
+}
+
+// 8 位 sRGB 编码值的所有组合，每个通道间隔 step
+void GetSRGBCodes(uint32_t step, std::vector<float> (&codes)[3]) {
+	for (uint32_t b = 0; b <= 255; b += step) {
+		for (uint32_t g = 0; g <= 255; g += step) {
+			for (uint32_t r = 0; r <= 255; r += step) {
+				codes[0].push_back((float)r);
+				codes[1].push_back((float)g);
+				codes[2].push_back((float)b);
+			}
+		}
+	}
+}
+
+}
+
+TEST(ColorLut, SDRIdentity) {
+	JobSystem jobSystem;
+	REQUIRE(jobSystem.Initialize());
+
+	// 没有校准且 SDR 内容亮度为 1 时 LUT 是恒等变换
+	std::vector<uint16_t> lut(ColorLut::DATA_SIZE);
+	ColorLut::Build(jobSystem, { .output = ColorLut::Output::SDR }, lut.data());
+
+	std::vector<float> codes[3];
+	GetSRGBCodes(3, codes);
+	const size_t count = codes[0].size();
+
+	std::vector<float> channels[3];
+	for (uint32_t c = 0; c < 3; ++c) {
+		channels[c].resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			channels[c][i] = (float)SRGBToLinear(codes[c][i] / 255.0);
+		}
+	}
+
+	const float* const src[3] = { channels[0].data(), channels[1].data(), channels[2].data() };
+	float* const dst[3] = { channels[0].data(), channels[1].data(), channels[2].data() };
+	ColorLut::Apply(ColorLut::Output::SDR, lut.data(), src, dst, count);
+
+	// 渲染目标为 R8G8B8A8_UNORM_SRGB，以编码值衡量误差。LUT 存储线性值，而格点在 PQ 空间均匀
+	// 分布，格子内的三线性插值偏离恒等变换，半精度的误差可以忽略。1.0 约在 PQ 的 0.9，不在格点上，
+	// 白色附近误差最大。
+	double maxError = 0;
+	double errorSum = 0;
+	for (uint32_t c = 0; c < 3; ++c) {
+		for (size_t i = 0; i < count; ++i) {
+			const double error = std::abs(LinearToSRGB(std::max(dst[c][i], 0.0f)) * 255 - codes[c][i]);
+			maxError = std::max(maxError, error);
+			errorSum += error;
+		}
+	}
+	const double meanError = errorSum / (count * 3);
+
+	CHECK(maxError < 2.5);
+	CHECK(meanError < 1.0);
+	std::printf("    %zu 个颜色，最大误差 %.3f 个编码值，平均 %.3f\n", count, maxError, meanError);
+}
+
+TEST(ColorLut, SDRBlackAndWhite) {
+	JobSystem jobSystem;
+	REQUIRE(jobSystem.Initialize());
+
+	std::vector<uint16_t> lut(ColorLut::DATA_SIZE);
+	ColorLut::Build(jobSystem, { .output = ColorLut::Output::SDR }, lut.data());
+
+	// 0 是格点，PQ 编码的 0 不是精确的 0，黑色只和下一个格点有极小的插值。超出 SDR 的值由渲染目标
+	// 截断，不能小于白色。
+	float r[] = { 0.0f, 1.0f, 2.0f };
+	float g[] = { 0.0f, 1.0f, 2.0f };
+	float b[] = { 0.0f, 1.0f, 2.0f };
+	float* const rgb[3] = { r, g, b };
+	ColorLut::Apply(ColorLut::Output::SDR, lut.data(), rgb, rgb, 3);
+
+	for (uint32_t c = 0; c < 3; ++c) {
+		CHECK(std::abs(rgb[c][0]) < 1e-5f);
+		CHECK(rgb[c][1] >= 1.0f);
+		CHECK(rgb[c][2] >= 1.0f);
+	}
+}
@@ -0,0 +1,147 @@
+#include "Test.h"
+#include "DeferredReleaseQueue.h"
+#include <memory>
+#include <utility>
+
+namespace {
+
+// 模拟 ID3D12Fence：GPU 完成一帧时 Complete 推进完成值
+struct FakeFence {
+	uint64_t nextValue = 1;
+	uint64_t completedValue = 0;
+
+	uint64_t Signal() noexcept {
+		return nextValue++;
+	}
+
+	void Complete(uint64_t value) noexcept {
+		assert(value < nextValue);
+		completedValue = std::max(completedValue, value);
+	}
+};
+
+// 析构时记录自己的 id，用来检查释放的时机和顺序
+struct Tracked {
+	std::vector<int>* releasedIds;
+	int id;
+
+	Tracked(std::vector<int>* releasedIds_, int id_) noexcept : releasedIds(releasedIds_), id(id_) {}
+	Tracked(Tracked&& other) noexcept : releasedIds(std::exchange(other.releasedIds, nullptr)), id(other.id) {}
+	Tracked& operator=(Tracked&& other) noexcept {
+		releasedIds = std::exchange(other.releasedIds, nullptr);
+		id = other.id;
+		return *this;
+	}
+
+	~Tracked() {
+		if (releasedIds) {
+			releasedIds->push_back(id);
+		}
+	}
+};
+
+}
+
+TEST(DeferredReleaseQueue, ReleasesOnlyCompletedFenceValues) {
+	FakeFence fence;
+	std::vector<int> releasedIds;
+	DeferredReleaseQueue<Tracked> queue;
+
+	const uint64_t frame1 = fence.Signal();
+	queue.Push(frame1, Tracked(&releasedIds, 1));
+	queue.Push(frame1, Tracked(&releasedIds, 2));
+	const uint64_t frame2 = fence.Signal();
+	queue.Push(frame2, Tracked(&releasedIds, 3));
+
+	// GPU 还没有完成任何一帧
+	CHECK(queue.ReleaseCompleted(fence.completedValue) == 0);
+	CHECK(releasedIds.empty());
+	CHECK(queue.Size() == 3);
+
+	fence.Complete(frame1);
+	CHECK(queue.ReleaseCompleted(fence.completedValue) == 2);
+	CHECK((releasedIds == std::vector<int>{ 1, 2 }));
+	CHECK(queue.Size() == 1);
+
+	// 重复调用不会释放更多
+	CHECK(queue.ReleaseCompleted(fence.completedValue) == 0);
+
+	fence.Complete(frame2);
+	CHECK(queue.ReleaseCompleted(fence.completedValue) == 1);
+	CHECK((releasedIds == std::vector<int>{ 1, 2, 3 }));
+	CHECK(queue.Empty());
+}
+
+TEST(DeferredReleaseQueue, SkippedFenceValuesReleaseEverythingBefore) {
+	FakeFence fence;
+	std::vector<int> releasedIds;
+	DeferredReleaseQueue<Tracked> queue;
+
+	for (int i = 0; i < 5; ++i) {
+		queue.Push(fence.Signal(), Tracked(&releasedIds, i));
+	}
+
+	// 完成值可以一次跳过多帧
+	fence.Complete(4);
+	CHECK(queue.ReleaseCompleted(fence.completedValue) == 4);
+	CHECK((releasedIds == std::vector<int>{ 0, 1, 2, 3 }));
+	CHECK(queue.Size() == 1);
+}
+
+TEST(DeferredReleaseQueue, CallbackSeesEachObjectBeforeRelease) {
+	FakeFence fence;
+	DeferredReleaseQueue<std::unique_ptr<int>> queue;
+
+	queue.Push(fence.Signal(), std::make_unique<int>(10));
+	queue.Push(fence.Signal(), std::make_unique<int>(20));
+	queue.Push(fence.Signal(), std::make_unique<int>(30));
+
+	fence.Complete(2);
+	std::vector<int> values;
+	const uint32_t count = queue.ReleaseCompleted(fence.completedValue, [&](std::unique_ptr<int>& obj) {
+		values.push_back(*obj);
+	});
+	CHECK(count == 2);
+	CHECK((values == std::vector<int>{ 10, 20 }));
+	CHECK(queue.Size() == 1);
+}
+
+TEST(DeferredReleaseQueue, ClearReleasesEverything) {
+	FakeFence fence;
+	std::vector<int> releasedIds;
+	DeferredReleaseQueue<Tracked> queue;
+
+	queue.Push(fence.Signal(), Tracked(&releasedIds, 1));
+	queue.Push(fence.Signal(), Tracked(&releasedIds, 2));
+
+	// 设备移除或关闭时 GPU 已经空闲
+	queue.Clear();
+	CHECK((releasedIds == std::vector<int>{ 1, 2 }));
+	CHECK(queue.Empty());
+}
+
+TEST(DeferredReleaseQueue, FramesInFlight) {
+	// 模拟 D3D12Context 的帧循环：每帧替换一个对象，GPU 落后 CPU 两帧
+	constexpr uint64_t MAX_IN_FLIGHT = 2;
+	FakeFence fence;
+	std::vector<int> releasedIds;
+	DeferredReleaseQueue<Tracked> queue;
+
+	for (int frame = 0; frame < 10; ++frame) {
+		const uint64_t fenceValue = fence.Signal();
+		queue.Push(fenceValue, Tracked(&releasedIds, frame));
+
+		if (fenceValue > MAX_IN_FLIGHT) {
+			fence.Complete(fenceValue - MAX_IN_FLIGHT);
+		}
+		queue.ReleaseCompleted(fence.completedValue);
+
+		// GPU 可能仍在使用的对象不能被释放
+		CHECK(queue.Size() == std::min<uint64_t>(fenceValue, MAX_IN_FLIGHT));
+		CHECK(releasedIds.size() == fenceValue - queue.Size());
+	}
+
+	for (size_t i = 0; i < releasedIds.size(); ++i) {
+		CHECK(releasedIds[i] == (int)i);
+	}
+}
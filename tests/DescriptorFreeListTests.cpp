@@ -0,0 +1,191 @@
+#include "Test.h"
+#include "DescriptorFreeList.h"
+#include <random>
+
+namespace {
+
+// 用数组模拟描述符堆，记录每个描述符属于哪个分配，检查分配不重叠，并据此计算空闲区间
+class FakeDescriptorHeap {
+public:
+	static constexpr uint32_t FREE = UINT32_MAX;
+
+	explicit FakeDescriptorHeap(uint32_t capacity) : _owners(capacity, FREE) {}
+
+	bool Write(uint32_t offset, uint32_t count, uint32_t owner) noexcept {
+		for (uint32_t i = offset; i < offset + count; ++i) {
+			if (i >= _owners.size() || _owners[i] != FREE) {
+				return false;
+			}
+			_owners[i] = owner;
+		}
+		return true;
+	}
+
+	bool Clear(uint32_t offset, uint32_t count, uint32_t owner) noexcept {
+		for (uint32_t i = offset; i < offset + count; ++i) {
+			if (_owners[i] != owner) {
+				return false;
+			}
+			_owners[i] = FREE;
+		}
+		return true;
+	}
+
+	// 完全合并时空闲区间数等于连续空闲描述符的段数
+	DescriptorFreeList::Stats GetExpectedStats() const noexcept {
+		DescriptorFreeList::Stats stats{ .capacity = (uint32_t)_owners.size() };
+
+		uint32_t runLength = 0;
+		for (uint32_t owner : _owners) {
+			if (owner == FREE) {
+				++runLength;
+				continue;
+			}
+
+			++stats.usedCount;
+			if (runLength > 0) {
+				++stats.freeRangeCount;
+				stats.largestFreeRange = std::max(stats.largestFreeRange, runLength);
+				runLength = 0;
+			}
+		}
+
+		if (runLength > 0) {
+			++stats.freeRangeCount;
+			stats.largestFreeRange = std::max(stats.largestFreeRange, runLength);
+		}
+
+		return stats;
+	}
+
+private:
+	std::vector<uint32_t> _owners;
+};
+
+bool IsSameStats(const DescriptorFreeList::Stats& actual, const DescriptorFreeList::Stats& expected) noexcept {
+	return actual.capacity == expected.capacity && actual.usedCount == expected.usedCount &&
+		actual.freeRangeCount == expected.freeRangeCount && actual.largestFreeRange == expected.largestFreeRange;
+}
+
+}
+
+TEST(DescriptorFreeList, FirstFit) {
+	DescriptorFreeList freeList(16);
+	CHECK(freeList.Allocate(4) == 0);
+	CHECK(freeList.Allocate(4) == 4);
+	CHECK(freeList.Allocate(4) == 8);
+
+	// [4, 8) 空出后，3 个描述符放在这里而不是末尾
+	freeList.Free(4, 4);
+	CHECK(freeList.Allocate(3) == 4);
+	CHECK(freeList.Allocate(2) == 12);
+	CHECK(freeList.Allocate(3) == DescriptorFreeList::INVALID_OFFSET);
+	CHECK(freeList.Allocate(1) == 7);
+	CHECK(freeList.Allocate(0) == DescriptorFreeList::INVALID_OFFSET);
+
+	const DescriptorFreeList::Stats stats = freeList.GetStats();
+	CHECK(stats.usedCount == 14);
+	CHECK(stats.maxUsedCount == 14);
+	CHECK(stats.freeRangeCount == 1);
+	CHECK(stats.largestFreeRange == 2);
+}
+
+TEST(DescriptorFreeList, CoalescesWithBothNeighbours) {
+	DescriptorFreeList freeList(12);
+	const uint32_t a = freeList.Allocate(4);
+	const uint32_t b = freeList.Allocate(4);
+	const uint32_t c = freeList.Allocate(4);
+	CHECK(freeList.GetStats().freeRangeCount == 0);
+
+	// 不相邻的区间不合并
+	freeList.Free(a, 4);
+	freeList.Free(c, 4);
+	CHECK(freeList.GetStats().freeRangeCount == 2);
+	CHECK(freeList.GetStats().largestFreeRange == 4);
+
+	// 同时和前后合并
+	freeList.Free(b, 4);
+	CHECK(freeList.IsEmpty());
+	CHECK(freeList.GetStats().freeRangeCount == 1);
+	CHECK(freeList.GetStats().largestFreeRange == 12);
+	CHECK(freeList.Allocate(12) == 0);
+}
+
+TEST(DescriptorFreeList, CoalescesWithOneNeighbour) {
+	DescriptorFreeList freeList(12);
+	const uint32_t a = freeList.Allocate(4);
+	const uint32_t b = freeList.Allocate(4);
+	freeList.Allocate(4);
+
+	// 只和后一个合并
+	freeList.Free(b, 4);
+	freeList.Free(a, 4);
+	CHECK(freeList.GetStats().freeRangeCount == 1);
+	CHECK(freeList.GetStats().largestFreeRange == 8);
+
+	// 只和前一个合并
+	DescriptorFreeList freeList2(12);
+	const uint32_t d = freeList2.Allocate(4);
+	const uint32_t e = freeList2.Allocate(4);
+	freeList2.Allocate(4);
+	freeList2.Free(d, 4);
+	freeList2.Free(e, 4);
+	CHECK(freeList2.GetStats().freeRangeCount == 1);
+	CHECK(freeList2.GetStats().largestFreeRange == 8);
+}
+
+TEST(DescriptorFreeList, RandomChurnOnFakeHeap) {
+	constexpr uint32_t CAPACITY = 1024;
+
+	struct Allocation {
+		uint32_t offset;
+		uint32_t count;
+		uint32_t id;
+	};
+
+	DescriptorFreeList freeList(CAPACITY);
+	FakeDescriptorHeap heap(CAPACITY);
+	std::vector<Allocation> allocations;
+
+	std::mt19937 rng(7);
+	std::uniform_int_distribution<uint32_t> countDist(1, 32);
+	uint32_t nextId = 0;
+	uint32_t failedCount = 0;
+
+	for (uint32_t step = 0; step < 20000; ++step) {
+		// 大约一半的时间满载，覆盖空间不足的路径
+		const bool shouldAllocate = allocations.empty() || rng() % 100 < (step % 2000 < 1000 ? 60u : 40u);
+
+		if (shouldAllocate) {
+			const uint32_t count = countDist(rng);
+			const uint32_t offset = freeList.Allocate(count);
+			if (offset == DescriptorFreeList::INVALID_OFFSET) {
+				// 首次适配失败说明没有足够大的空闲区间
+				REQUIRE(heap.GetExpectedStats().largestFreeRange < count);
+				++failedCount;
+			} else {
+				REQUIRE(heap.Write(offset, count, nextId));
+				allocations.push_back({ offset, count, nextId++ });
+			}
+		} else {
+			const size_t index = rng() % allocations.size();
+			const Allocation allocation = allocations[index];
+			allocations[index] = allocations.back();
+			allocations.pop_back();
+
+			REQUIRE(heap.Clear(allocation.offset, allocation.count, allocation.id));
+			freeList.Free(allocation.offset, allocation.count);
+		}
+
+		REQUIRE(IsSameStats(freeList.GetStats(), heap.GetExpectedStats()));
+	}
+
+	CHECK(failedCount > 0);
+
+	for (const Allocation& allocation : allocations) {
+		freeList.Free(allocation.offset, allocation.count);
+	}
+	CHECK(freeList.IsEmpty());
+	CHECK(freeList.GetStats().freeRangeCount == 1);
+	CHECK(freeList.GetStats().largestFreeRange == CAPACITY);
+}
@@ -0,0 +1,291 @@
+#include "pch.h"
+#include "Test.h"
+#include "GpuProfiler.h"
+#include <thread>
+
+// 不传入设备和命令列表，用合成的时间戳测试 ReadFrame 的范围树，不需要 GPU
+
+namespace {
+
+// 1 个时间戳单位为 1 微秒
+constexpr GpuProfiler::Calibration CALIBRATION = {
+	.gpuTimestamp = 50,
+	.cpuTimestamp = 5000,
+	.gpuFrequency = 1'000'000,
+	.cpuFrequency = 10'000'000
+};
+
+bool IsNear(double value, double expected) {
+	return std::abs(value - expected) < 1e-9;
+}
+
+bool CheckScope(
+	const GpuProfiler::Scope& scope,
+	std::string_view name,
+	uint32_t parent,
+	uint32_t depth,
+	double beginTime,
+	double endTime
+) {
+	return scope.name == name && scope.parent == parent && scope.depth == depth &&
+		IsNear(scope.beginTime, beginTime) && IsNear(scope.endTime, endTime);
+}
+
+}
+
+TEST(GpuProfiler, Nesting) {
+	GpuProfiler profiler;
+	REQUIRE(SUCCEEDED(profiler.Initialize(nullptr, 2)));
+
+	profiler.BeginFrame(0, 7);
+	CHECK(!profiler.HasScopes());
+	const uint32_t frame = profiler.BeginScope(nullptr, "Frame");
+	const uint32_t shadow = profiler.BeginScope(nullptr, "Shadow", frame);
+	const uint32_t cascade = profiler.BeginScope(nullptr, "Cascade", shadow);
+	profiler.EndScope(nullptr, cascade);
+	profiler.EndScope(nullptr, shadow);
+	const uint32_t mainPass = profiler.BeginScope(nullptr, "Main", frame);
+	profiler.EndScope(nullptr, mainPass);
+	profiler.EndScope(nullptr, frame);
+	CHECK(profiler.HasScopes());
+	profiler.Resolve(nullptr, CALIBRATION);
+
+	const uint64_t timestamps[] = { 100, 1100, 200, 500, 250, 300, 600, 1000 };
+	profiler.ReadFrame(0, timestamps);
+
+	// 先序排列，时间相对于最早的时间戳
+	const GpuProfiler::Frame& result = profiler.GetCompletedFrame();
+	CHECK(result.frameNumber == 7);
+	REQUIRE(result.scopes.size() == 4);
+	CHECK(CheckScope(result.scopes[0], "Frame", GpuProfiler::NO_SCOPE, 0, 0.0, 1.0));
+	CHECK(CheckScope(result.scopes[1], "Shadow", 0, 1, 0.1, 0.4));
+	CHECK(CheckScope(result.scopes[2], "Cascade", 1, 2, 0.15, 0.2));
+	CHECK(CheckScope(result.scopes[3], "Main", 0, 1, 0.5, 0.9));
+
+	// 最早的时间戳比校准点晚 50 微秒，即 500 个 CPU 时钟单位
+	CHECK(result.cpuBeginTime == 5500);
+}
+
+TEST(GpuProfiler, SiblingsSortedByBeginTime) {
+	GpuProfiler profiler;
+	REQUIRE(SUCCEEDED(profiler.Initialize(nullptr, 1)));
+
+	// 范围的录制顺序和 GPU 的执行顺序不同，如不同命令列表中的范围
+	profiler.BeginFrame(0, 0);
+	const uint32_t frame = profiler.BeginScope(nullptr, "Frame");
+	for (const char* name : { "C", "A", "B", "A2" }) {
+		profiler.EndScope(nullptr, profiler.BeginScope(nullptr, name, frame));
+	}
+	profiler.EndScope(nullptr, frame);
+	profiler.Resolve(nullptr, CALIBRATION);
+
+	// A 和 A2 开始时间相同，保持录制顺序
+	const uint64_t timestamps[] = { 0, 100, 70, 80, 10, 20, 40, 60, 10, 30 };
+	profiler.ReadFrame(0, timestamps);
+
+	const GpuProfiler::Frame& result = profiler.GetCompletedFrame();
+	REQUIRE(result.scopes.size() == 5);
+	CHECK(CheckScope(result.scopes[1], "A", 0, 1, 0.01, 0.02));
+	CHECK(CheckScope(result.scopes[2], "A2", 0, 1, 0.01, 0.03));
+	CHECK(CheckScope(result.scopes[3], "B", 0, 1, 0.04, 0.06));
+	CHECK(CheckScope(result.scopes[4], "C", 0, 1, 0.07, 0.08));
+}
+
+TEST(GpuProfiler, ScopesAcrossCommandLists) {
+	GpuProfiler profiler;
+	REQUIRE(SUCCEEDED(profiler.Initialize(nullptr, 1)));
+
+	// 整帧的范围在主命令列表开始，在最后提交的命令列表结束。其他线程同时在各自的命令列表中录制
+	// 子范围，它们的结束可能晚于整帧的 EndScope 调用。
+	profiler.BeginFrame(0, 3);
+	const uint32_t frame = profiler.BeginScope(nullptr, "Frame");
+
+	static constexpr uint32_t THREAD_COUNT = 4;
+	static constexpr uint32_t SCOPES_PER_THREAD = 20;
+	std::vector<std::pair<uint32_t, uint32_t>> passes[THREAD_COUNT];
+	{
+		std::vector<std::thread> threads;
+		for (uint32_t t = 0; t < THREAD_COUNT; ++t) {
+			threads.emplace_back([&, t]() {
+				for (uint32_t i = 0; i < SCOPES_PER_THREAD; ++i) {
+					const uint32_t pass = profiler.BeginScope(nullptr, "Pass", frame);
+					const uint32_t draw = profiler.BeginScope(nullptr, "Draw", pass);
+					passes[t].push_back({ pass, draw });
+				}
+			});
+		}
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+	}
+	profiler.EndScope(nullptr, frame);
+	for (const auto& scopes : passes) {
+		for (auto [pass, draw] : scopes) {
+			profiler.EndScope(nullptr, draw);
+			profiler.EndScope(nullptr, pass);
+		}
+	}
+	profiler.Resolve(nullptr, CALIBRATION);
+
+	// 每个 Pass 占据不重叠的区间，Draw 在其中
+	const uint32_t scopeCount = 1 + THREAD_COUNT * SCOPES_PER_THREAD * 2;
+	std::vector<uint64_t> timestamps(scopeCount * 2);
+	timestamps[0] = 0;
+	timestamps[1] = 100000;
+	for (const auto& scopes : passes) {
+		for (auto [pass, draw] : scopes) {
+			timestamps[pass * 2] = pass * 100;
+			timestamps[pass * 2 + 1] = pass * 100 + 90;
+			timestamps[draw * 2] = pass * 100 + 10;
+			timestamps[draw * 2 + 1] = pass * 100 + 80;
+		}
+	}
+	profiler.ReadFrame(0, timestamps);
+
+	const GpuProfiler::Frame& result = profiler.GetCompletedFrame();
+	CHECK(result.frameNumber == 3);
+	REQUIRE(result.scopes.size() == scopeCount);
+	CHECK(CheckScope(result.scopes[0], "Frame", GpuProfiler::NO_SCOPE, 0, 0.0, 100.0));
+	for (uint32_t i = 1; i < scopeCount; i += 2) {
+		const GpuProfiler::Scope& pass = result.scopes[i];
+		const GpuProfiler::Scope& draw = result.scopes[i + 1];
+		CHECK(pass.parent == 0 && pass.depth == 1);
+		CHECK(draw.parent == i && draw.depth == 2);
+		CHECK(draw.beginTime > pass.beginTime && draw.endTime < pass.endTime);
+		if (i > 1) {
+			CHECK(pass.beginTime > result.scopes[i - 2].endTime);
+		}
+	}
+}
+
+TEST(GpuProfiler, DropsUnendedScopes) {
+	GpuProfiler profiler;
+	REQUIRE(SUCCEEDED(profiler.Initialize(nullptr, 1)));
+
+	// 没有结束的范围和它的子范围被丢弃，同级的范围不受影响
+	profiler.BeginFrame(0, 0);
+	const uint32_t frame = profiler.BeginScope(nullptr, "Frame");
+	const uint32_t unended = profiler.BeginScope(nullptr, "Unended", frame);
+	profiler.EndScope(nullptr, profiler.BeginScope(nullptr, "Child", unended));
+	profiler.EndScope(nullptr, profiler.BeginScope(nullptr, "Sibling", frame));
+	profiler.EndScope(nullptr, frame);
+	profiler.Resolve(nullptr, CALIBRATION);
+
+	// 被丢弃的范围不影响最早的时间戳
+	const uint64_t timestamps[] = { 10, 100, 0, 200, 20, 30, 40, 50 };
+	profiler.ReadFrame(0, timestamps);
+
+	const GpuProfiler::Frame& result = profiler.GetCompletedFrame();
+	REQUIRE(result.scopes.size() == 2);
+	CHECK(CheckScope(result.scopes[0], "Frame", GpuProfiler::NO_SCOPE, 0, 0.0, 0.09));
+	CHECK(CheckScope(result.scopes[1], "Sibling", 0, 1, 0.03, 0.04));
+
+	// 整帧没有结束时没有任何结果
+	profiler.BeginFrame(0, 1);
+	profiler.BeginScope(nullptr, "Frame");
+	profiler.Resolve(nullptr, CALIBRATION);
+	profiler.ReadFrame(0, std::span(timestamps).first(2));
+	CHECK(profiler.GetCompletedFrame().frameNumber == UINT64_MAX);
+	CHECK(profiler.GetCompletedFrame().scopes.empty());
+}
+
+TEST(GpuProfiler, DropsBackwardsTimestamps) {
+	GpuProfiler profiler;
+	REQUIRE(SUCCEEDED(profiler.Initialize(nullptr, 1)));
+
+	profiler.BeginFrame(0, 0);
+	const uint32_t frame = profiler.BeginScope(nullptr, "Frame");
+	const uint32_t backwards = profiler.BeginScope(nullptr, "Backwards", frame);
+	profiler.EndScope(nullptr, profiler.BeginScope(nullptr, "Child", backwards));
+	profiler.EndScope(nullptr, backwards);
+	profiler.EndScope(nullptr, profiler.BeginScope(nullptr, "Sibling", frame));
+	profiler.EndScope(nullptr, frame);
+	profiler.Resolve(nullptr, CALIBRATION);
+
+	// GPU 切换电源状态时时间戳可能倒退。被丢弃的范围不影响最早的时间戳。
+	const uint64_t timestamps[] = { 100, 1000, 500, 5, 1, 2, 600, 700 };
+	profiler.ReadFrame(0, timestamps);
+
+	const GpuProfiler::Frame& result = profiler.GetCompletedFrame();
+	REQUIRE(result.scopes.size() == 2);
+	CHECK(CheckScope(result.scopes[0], "Frame", GpuProfiler::NO_SCOPE, 0, 0.0, 0.9));
+	CHECK(CheckScope(result.scopes[1], "Sibling", 0, 1, 0.5, 0.6));
+
+	// 开始和结束相同的范围有效
+	const uint64_t zeroLength[] = { 100, 100, 100, 100, 100, 100, 100, 100 };
+	profiler.ReadFrame(0, zeroLength);
+	CHECK(profiler.GetCompletedFrame().scopes.size() == 4);
+}
+
+TEST(GpuProfiler, ScopeOverflow) {
+	GpuProfiler profiler;
+	REQUIRE(SUCCEEDED(profiler.Initialize(nullptr, 1)));
+
+	// 超出 MAX_SCOPE_COUNT 的范围不计时，EndScope 忽略 NO_SCOPE
+	profiler.BeginFrame(0, 0);
+	const uint32_t frame = profiler.BeginScope(nullptr, "Frame");
+	uint32_t overflowCount = 0;
+	for (uint32_t i = 0; i < GpuProfiler::MAX_SCOPE_COUNT + 50; ++i) {
+		const uint32_t scope = profiler.BeginScope(nullptr, "Pass", frame);
+		if (scope == GpuProfiler::NO_SCOPE) {
+			++overflowCount;
+		} else {
+			CHECK(scope == i + 1);
+		}
+		profiler.EndScope(nullptr, scope);
+	}
+	profiler.EndScope(nullptr, frame);
+	CHECK(overflowCount == 51);
+	profiler.Resolve(nullptr, CALIBRATION);
+
+	// 只解析前 MAX_SCOPE_COUNT 个范围的时间戳
+	std::vector<uint64_t> timestamps(GpuProfiler::MAX_SCOPE_COUNT * 2);
+	timestamps[1] = GpuProfiler::MAX_SCOPE_COUNT * 10;
+	for (uint32_t i = 1; i < GpuProfiler::MAX_SCOPE_COUNT; ++i) {
+		timestamps[i * 2] = i * 10;
+		timestamps[i * 2 + 1] = i * 10 + 5;
+	}
+	profiler.ReadFrame(0, timestamps);
+
+	const GpuProfiler::Frame& result = profiler.GetCompletedFrame();
+	REQUIRE(result.scopes.size() == GpuProfiler::MAX_SCOPE_COUNT);
+	for (uint32_t i = 1; i < GpuProfiler::MAX_SCOPE_COUNT; ++i) {
+		CHECK(result.scopes[i].parent == 0);
+	}
+
+	// 下一帧重新计数
+	profiler.BeginFrame(0, 1);
+	CHECK(profiler.BeginScope(nullptr, "Frame") == 0);
+}
+
+TEST(GpuProfiler, FrameRing) {
+	GpuProfiler profiler;
+	REQUIRE(SUCCEEDED(profiler.Initialize(nullptr, 2)));
+
+	// 每个帧索引独占记录，读取帧 0 的结果不受之后帧 1 的影响
+	profiler.BeginFrame(0, 10);
+	profiler.EndScope(nullptr, profiler.BeginScope(nullptr, "Frame0"));
+	profiler.Resolve(nullptr, CALIBRATION);
+
+	profiler.BeginFrame(1, 11);
+	profiler.EndScope(nullptr, profiler.BeginScope(nullptr, "Frame1"));
+	profiler.EndScope(nullptr, profiler.BeginScope(nullptr, "Extra"));
+	profiler.Resolve(nullptr, CALIBRATION);
+
+	const uint64_t timestamps[] = { 0, 10, 20, 30 };
+	profiler.ReadFrame(0, std::span(timestamps).first(2));
+	CHECK(profiler.GetCompletedFrame().frameNumber == 10);
+	REQUIRE(profiler.GetCompletedFrame().scopes.size() == 1);
+	CHECK(CheckScope(profiler.GetCompletedFrame().scopes[0], "Frame0", GpuProfiler::NO_SCOPE, 0, 0.0, 0.01));
+
+	profiler.ReadFrame(1, timestamps);
+	CHECK(profiler.GetCompletedFrame().frameNumber == 11);
+	CHECK(profiler.GetCompletedFrame().scopes.size() == 2);
+
+	// 没有时间戳频率时这一帧没有结果
+	profiler.BeginFrame(0, 12);
+	profiler.EndScope(nullptr, profiler.BeginScope(nullptr, "Frame"));
+	profiler.Resolve(nullptr, {});
+	profiler.ReadFrame(0, std::span(timestamps).first(2));
+	CHECK(profiler.GetCompletedFrame().frameNumber == UINT64_MAX);
+}
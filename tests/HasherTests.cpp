@@ -0,0 +1,62 @@
+#include "Test.h"
+#include "Hasher.h"
+#include <cstring>
+
+TEST(Hasher, KnownValues) {
+	// FNV-1a 的参考值，结果持久化到缓存文件中，不能改变
+	CHECK(Hasher().GetHash() == 0xCBF29CE484222325);
+	CHECK(Hasher::Hash("a", 1) == 0xAF63DC4C8601EC8C);
+	CHECK(Hasher::Hash("foobar", 6) == 0x85944171F73967E8);
+}
+
+TEST(Hasher, IncrementalMatchesOneShot) {
+	const char data[] = "D3D12Playground pipeline cache";
+	const size_t size = std::strlen(data);
+
+	for (size_t split = 0; split <= size; ++split) {
+		Hasher hasher;
+		hasher.AddBytes(data, split);
+		hasher.AddBytes(data + split, size - split);
+		CHECK(hasher.GetHash() == Hasher::Hash(data, size));
+	}
+}
+
+TEST(Hasher, AddUsesObjectBytes) {
+	const uint32_t value = 0x04030201;
+	Hasher hasher;
+	hasher.Add(value);
+
+	uint8_t bytes[sizeof(value)];
+	std::memcpy(bytes, &value, sizeof(value));
+	CHECK(hasher.GetHash() == Hasher::Hash(bytes, sizeof(bytes)));
+}
+
+TEST(Hasher, StringsIncludeLength) {
+	Hasher ab_c;
+	ab_c.AddString("ab");
+	ab_c.AddString("c");
+
+	Hasher a_bc;
+	a_bc.AddString("a");
+	a_bc.AddString("bc");
+
+	CHECK(ab_c.GetHash() != a_bc.GetHash());
+
+	// 空字符串也改变哈希
+	Hasher empty;
+	empty.AddString("");
+	CHECK(empty.GetHash() != Hasher().GetHash());
+}
+
+TEST(Hasher, SensitiveToEveryByte) {
+	uint8_t data[64]{};
+	const uint64_t baseHash = Hasher::Hash(data, sizeof(data));
+
+	for (size_t i = 0; i < sizeof(data); ++i) {
+		for (uint32_t bit = 0; bit < 8; ++bit) {
+			data[i] ^= uint8_t(1 << bit);
+			CHECK(Hasher::Hash(data, sizeof(data)) != baseHash);
+			data[i] ^= uint8_t(1 << bit);
+		}
+	}
+}
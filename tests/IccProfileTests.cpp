@@ -0,0 +1,256 @@
+#include "Test.h"
+#include "IccProfile.h"
+#include <cmath>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+namespace {
+
+// ICC 的数值都是大端序
+void AppendU16(std::vector<uint8_t>& data, uint32_t value) {
+	data.push_back(uint8_t(value >> 8));
+	data.push_back(uint8_t(value));
+}
+
+void AppendU32(std::vector<uint8_t>& data, uint32_t value) {
+	AppendU16(data, value >> 16);
+	AppendU16(data, value & 0xFFFF);
+}
+
+void AppendSignature(std::vector<uint8_t>& data, std::string_view signature) {
+	data.insert(data.end(), signature.begin(), signature.end());
+}
+
+void AppendS15Fixed16(std::vector<uint8_t>& data, double value) {
+	AppendU32(data, (uint32_t)(int32_t)std::lround(value * 65536));
+}
+
+// 类型签名和 4 个保留字节
+std::vector<uint8_t> MakeTag(std::string_view type) {
+	std::vector<uint8_t> tag(8);
+	std::memcpy(tag.data(), type.data(), 4);
+	return tag;
+}
+
+void WriteU32(std::vector<uint8_t>& data, size_t offset, uint32_t value) {
+	for (uint32_t i = 0; i < 4; ++i) {
+		data[offset + i] = uint8_t(value >> (24 - 8 * i));
+	}
+}
+
+std::vector<uint8_t> MakeXYZ(double x, double y, double z) {
+	std::vector<uint8_t> tag = MakeTag("XYZ ");
+	AppendS15Fixed16(tag, x);
+	AppendS15Fixed16(tag, y);
+	AppendS15Fixed16(tag, z);
+	return tag;
+}
+
+std::vector<uint8_t> MakeCurv(std::span<const uint16_t> values) {
+	std::vector<uint8_t> tag = MakeTag("curv");
+	AppendU32(tag, (uint32_t)values.size());
+	for (uint16_t value : values) {
+		AppendU16(tag, value);
+	}
+	return tag;
+}
+
+std::vector<uint8_t> MakePara(uint32_t functionType, std::span<const double> params) {
+	std::vector<uint8_t> tag = MakeTag("para");
+	AppendU16(tag, functionType);
+	AppendU16(tag, 0);
+	for (double param : params) {
+		AppendS15Fixed16(tag, param);
+	}
+	return tag;
+}
+
+struct Tag {
+	std::string_view signature;
+	std::vector<uint8_t> data;
+};
+
+// 标签数据按顺序紧跟在标签表之后，最后一个标签延伸到文件末尾
+std::vector<uint8_t> MakeProfile(const std::vector<Tag>& tags) {
+	std::vector<uint8_t> data(128);
+	std::memcpy(data.data() + 12, "mntr", 4);
+	std::memcpy(data.data() + 16, "RGB ", 4);
+	std::memcpy(data.data() + 20, "XYZ ", 4);
+	std::memcpy(data.data() + 36, "acsp", 4);
+
+	AppendU32(data, (uint32_t)tags.size());
+	size_t offset = data.size() + 12 * tags.size();
+	for (const Tag& tag : tags) {
+		AppendSignature(data, tag.signature);
+		AppendU32(data, (uint32_t)offset);
+		AppendU32(data, (uint32_t)tag.data.size());
+		// 标签按 4 字节对齐
+		offset += (tag.data.size() + 3) & ~3;
+	}
+	for (const Tag& tag : tags) {
+		data.resize((data.size() + 3) & ~3);
+		data.insert(data.end(), tag.data.begin(), tag.data.end());
+	}
+
+	WriteU32(data, 0, (uint32_t)data.size());
+	return data;
+}
+
+constexpr double SRGB_PARAMS[] = { 2.4, 1 / 1.055, 0.055 / 1.055, 1 / 12.92, 0.04045 };
+constexpr uint16_t TABLE[] = { 0, 0x4000, 0xFFFF };
+constexpr uint16_t GAMMA[] = { 0x0233 };
+
+// sRGB 的原色适应到 D50，三条曲线分别为 para、一个值的 curv 和表形式的 curv
+std::vector<Tag> GetValidTags() {
+	return {
+		{ "rXYZ", MakeXYZ(0.4361, 0.2225, 0.0139) },
+		{ "gXYZ", MakeXYZ(0.3851, 0.7169, 0.0971) },
+		{ "bXYZ", MakeXYZ(0.1431, 0.0606, 0.7141) },
+		{ "rTRC", MakePara(3, SRGB_PARAMS) },
+		{ "gTRC", MakeCurv(GAMMA) },
+		{ "bTRC", MakeCurv(TABLE) }
+	};
+}
+
+bool Parse(const std::vector<uint8_t>& data) {
+	IccProfile profile;
+	return IccProfile::Parse(data, profile);
+}
+
+}
+
+TEST(IccProfile, ParsesMatrixTrc) {
+	IccProfile profile;
+	REQUIRE(IccProfile::Parse(MakeProfile(GetValidTags()), profile));
+
+	// 每列是一个原色
+	CHECK(std::abs(profile.rgbToXYZ.m[0][0] - 0.4361f) < 1e-4f);
+	CHECK(std::abs(profile.rgbToXYZ.m[1][1] - 0.7169f) < 1e-4f);
+	CHECK(std::abs(profile.rgbToXYZ.m[2][2] - 0.7141f) < 1e-4f);
+	CHECK(std::abs(profile.rgbToXYZ.m[1][0] - 0.2225f) < 1e-4f);
+
+	CHECK(profile.curves[0].functionType == 3);
+	CHECK(std::abs(profile.curves[0].Evaluate(0.5f) - 0.21404f) < 1e-4f);
+	CHECK(std::abs(profile.curves[0].Evaluate(0.02f) - 0.02f / 12.92f) < 1e-5f);
+
+	// u8Fixed8Number，0x0233 约为 2.2
+	CHECK(profile.curves[1].table.empty());
+	CHECK(std::abs(profile.curves[1].Evaluate(0.5f) - std::pow(0.5f, 0x233 / 256.0f)) < 1e-5f);
+
+	REQUIRE(profile.curves[2].table.size() == 3);
+	CHECK(std::abs(profile.curves[2].Evaluate(0.25f) - 0x2000 / 65535.0f) < 1e-5f);
+	CHECK(profile.curves[2].Evaluate(1.5f) == 1.0f);
+	CHECK(profile.curves[2].Evaluate(-1.0f) == 0.0f);
+}
+
+TEST(IccProfile, RejectsTruncation) {
+	const std::vector<uint8_t> data = MakeProfile(GetValidTags());
+	REQUIRE(Parse(data));
+
+	// 任何截断都使某个标签越界
+	for (size_t size = 0; size < data.size(); ++size) {
+		CHECK(!Parse(std::vector<uint8_t>(data.begin(), data.begin() + size)));
+	}
+}
+
+TEST(IccProfile, RejectsMalformedHeader) {
+	const std::vector<uint8_t> original = MakeProfile(GetValidTags());
+
+	std::vector<uint8_t> data = original;
+	data[36] = 'b';
+	CHECK(!Parse(data));
+
+	// 不是 RGB 或者 PCS 不是 XYZ
+	data = original;
+	std::memcpy(data.data() + 16, "CMYK", 4);
+	CHECK(!Parse(data));
+
+	data = original;
+	std::memcpy(data.data() + 20, "Lab ", 4);
+	CHECK(!Parse(data));
+
+	// 标签数超出文件
+	data = original;
+	WriteU32(data, 128, 0xFFFFFFFF);
+	CHECK(!Parse(data));
+
+	data = original;
+	WriteU32(data, 128, 0x15555556);
+	CHECK(!Parse(data));
+}
+
+TEST(IccProfile, RejectsMalformedTags) {
+	const std::vector<uint8_t> original = MakeProfile(GetValidTags());
+
+	// 第一个标签 rXYZ 的偏移和大小。偏移加大小溢出 32 位时不能绕回。
+	std::vector<uint8_t> data = original;
+	WriteU32(data, 136, 0xFFFFFFF0);
+	WriteU32(data, 140, 0x20);
+	CHECK(!Parse(data));
+
+	data = original;
+	WriteU32(data, 140, 0xFFFFFFFF);
+	CHECK(!Parse(data));
+
+	// 缺少标签
+	std::vector<Tag> tags = GetValidTags();
+	tags.pop_back();
+	CHECK(!Parse(MakeProfile(tags)));
+
+	// 类型错误
+	tags = GetValidTags();
+	tags[0].data = MakeCurv(GAMMA);
+	CHECK(!Parse(MakeProfile(tags)));
+
+	tags = GetValidTags();
+	tags[3].data = MakeXYZ(1, 1, 1);
+	CHECK(!Parse(MakeProfile(tags)));
+
+	// XYZ 太短
+	tags = GetValidTags();
+	tags[1].data.resize(16);
+	CHECK(!Parse(MakeProfile(tags)));
+
+	// para 的函数类型超出范围，参数不足
+	tags = GetValidTags();
+	tags[3].data = MakePara(5, SRGB_PARAMS);
+	CHECK(!Parse(MakeProfile(tags)));
+
+	tags = GetValidTags();
+	tags[3].data = MakePara(4, SRGB_PARAMS);
+	CHECK(!Parse(MakeProfile(tags)));
+
+	// curv 的项数超出标签
+	tags = GetValidTags();
+	WriteU32(tags[5].data, 8, 0x80000000);
+	CHECK(!Parse(MakeProfile(tags)));
+
+	tags = GetValidTags();
+	tags[5].data.pop_back();
+	CHECK(!Parse(MakeProfile(tags)));
+}
+
+TEST(IccProfile, RejectsUnsupportedTags) {
+	for (std::string_view signature : { "A2B0", "A2B1", "B2A0", "vcgt" }) {
+		std::vector<Tag> tags = GetValidTags();
+		tags.push_back({ signature, std::vector<uint8_t>(16) });
+		CHECK(!Parse(MakeProfile(tags)));
+	}
+
+	// 其他标签不影响
+	std::vector<Tag> tags = GetValidTags();
+	tags.push_back({ "wtpt", MakeXYZ(0.9642, 1.0, 0.8249) });
+	CHECK(Parse(MakeProfile(tags)));
+}
+
+TEST(IccProfile, CurveIgnoresNaN) {
+	// 参数不合理时 Evaluate 返回有限值
+	IccProfile::Curve curve;
+	curve.functionType = 1;
+	curve.params = { 2.2f, 0.0f, 0.0f };
+	for (float x : { 0.0f, 0.5f, 1.0f }) {
+		const float y = curve.Evaluate(x);
+		CHECK(std::isfinite(y) && y >= 0.0f && y <= 1.0f);
+	}
+}
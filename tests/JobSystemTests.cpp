@@ -0,0 +1,164 @@
+#include "Test.h"
+#include "JobSystem.h"
+#include <chrono>
+#include <numeric>
+
+TEST(JobSystem, DispatchAndWait) {
+	for (uint32_t workerCount : { 1u, 3u }) {
+		JobSystem jobSystem;
+		REQUIRE(jobSystem.Initialize(workerCount));
+		CHECK(jobSystem.GetWorkerCount() == workerCount);
+
+		constexpr uint32_t COUNT = 1000;
+		std::vector<uint32_t> results(COUNT, 0);
+
+		JobSystem::Counter counter;
+		for (uint32_t i = 0; i < COUNT; ++i) {
+			jobSystem.Dispatch(counter, [&results, i]() {
+				results[i] = i * 2 + 1;
+			});
+		}
+		jobSystem.Wait(counter);
+
+		CHECK(counter.IsDone());
+		uint32_t errorCount = 0;
+		for (uint32_t i = 0; i < COUNT; ++i) {
+			errorCount += results[i] != i * 2 + 1;
+		}
+		CHECK(errorCount == 0);
+		CHECK(jobSystem.GetStats().executedJobCount == COUNT);
+	}
+}
+
+TEST(JobSystem, ParallelForVisitsEachIndexOnce) {
+	JobSystem jobSystem;
+	REQUIRE(jobSystem.Initialize(3));
+
+	for (uint32_t count : { 0u, 1u, 2u, 15u, 16u, 17u, 1000u, 12345u }) {
+		std::vector<std::atomic<uint32_t>> visits(count);
+		jobSystem.ParallelFor(count, [&](uint32_t i) {
+			visits[i].fetch_add(1, std::memory_order_relaxed);
+		});
+
+		uint32_t errorCount = 0;
+		for (const std::atomic<uint32_t>& visit : visits) {
+			errorCount += visit.load(std::memory_order_relaxed) != 1;
+		}
+		CHECK(errorCount == 0);
+	}
+}
+
+TEST(JobSystem, NestedJobs) {
+	// 任务在工作线程中提交子任务并等待，子任务进入工作线程自己的队列，其他线程可以窃取
+	JobSystem jobSystem;
+	REQUIRE(jobSystem.Initialize(3));
+
+	constexpr uint32_t OUTER_COUNT = 16;
+	constexpr uint32_t INNER_COUNT = 64;
+	std::atomic<uint32_t> innerDone = 0;
+
+	JobSystem::Counter counter;
+	for (uint32_t i = 0; i < OUTER_COUNT; ++i) {
+		jobSystem.Dispatch(counter, [&]() {
+			JobSystem::Counter innerCounter;
+			for (uint32_t j = 0; j < INNER_COUNT; ++j) {
+				jobSystem.Dispatch(innerCounter, [&]() {
+					innerDone.fetch_add(1, std::memory_order_relaxed);
+				});
+			}
+			jobSystem.Wait(innerCounter);
+		});
+	}
+	jobSystem.Wait(counter);
+
+	CHECK(innerDone.load() == OUTER_COUNT * INNER_COUNT);
+	CHECK(jobSystem.GetStats().executedJobCount == OUTER_COUNT * (INNER_COUNT + 1));
+}
+
+TEST(JobSystem, StressConcurrentSubmitters) {
+	// 多个不属于线程池的线程同时使用共享队列提交和等待，Counter 在每轮结束后立即销毁
+	JobSystem jobSystem;
+	REQUIRE(jobSystem.Initialize(3));
+
+	constexpr uint32_t THREAD_COUNT = 4;
+	constexpr uint32_t ROUND_COUNT = 200;
+	constexpr uint32_t JOBS_PER_ROUND = 32;
+
+	std::atomic<uint32_t> errorCount = 0;
+	std::vector<std::thread> threads;
+	for (uint32_t t = 0; t < THREAD_COUNT; ++t) {
+		threads.emplace_back([&, t]() {
+			for (uint32_t round = 0; round < ROUND_COUNT; ++round) {
+				std::vector<uint32_t> values(JOBS_PER_ROUND, 0);
+				JobSystem::Counter counter;
+				for (uint32_t i = 0; i < JOBS_PER_ROUND; ++i) {
+					jobSystem.Dispatch(counter, [&values, i, t]() {
+						values[i] = i + t;
+					});
+				}
+				jobSystem.Wait(counter);
+
+				for (uint32_t i = 0; i < JOBS_PER_ROUND; ++i) {
+					if (values[i] != i + t) {
+						errorCount.fetch_add(1, std::memory_order_relaxed);
+					}
+				}
+			}
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	CHECK(errorCount.load() == 0);
+	CHECK(jobSystem.GetStats().executedJobCount == THREAD_COUNT * ROUND_COUNT * JOBS_PER_ROUND);
+}
+
+TEST(JobSystem, IdleWorkersDoNotLoseJobs) {
+	// 每次只提交一个任务，工作线程在两次提交之间进入睡眠，检查唤醒不会丢失
+	JobSystem jobSystem;
+	REQUIRE(jobSystem.Initialize(2));
+
+	for (uint32_t i = 0; i < 2000; ++i) {
+		std::atomic<bool> done = false;
+		JobSystem::Counter counter;
+		jobSystem.Dispatch(counter, [&]() {
+			done.store(true, std::memory_order_relaxed);
+		});
+		jobSystem.Wait(counter);
+		CHECK(done.load(std::memory_order_relaxed));
+	}
+}
+
+TEST(JobSystem, Throughput) {
+	// 吞吐量基准，只输出结果，不检查。在多核机器上比较不同的工作线程数可以看出扩展性。
+	constexpr uint32_t JOB_COUNT = 20000;
+	const uint32_t maxWorkerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+	for (uint32_t workerCount = 1; workerCount <= maxWorkerCount; workerCount *= 2) {
+		JobSystem jobSystem;
+		REQUIRE(jobSystem.Initialize(workerCount));
+
+		std::vector<uint64_t> sums(JOB_COUNT);
+		const auto start = std::chrono::steady_clock::now();
+
+		JobSystem::Counter counter;
+		for (uint32_t i = 0; i < JOB_COUNT; ++i) {
+			jobSystem.Dispatch(counter, [&sums, i]() {
+				// 少量计算模拟录制命令的开销
+				uint64_t sum = i;
+				for (uint32_t j = 0; j < 1000; ++j) {
+					sum = sum * 6364136223846793005ull + 1442695040888963407ull;
+				}
+				sums[i] = sum;
+			});
+		}
+		jobSystem.Wait(counter);
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::printf("    %u 个工作线程：%.0f 任务/秒，窃取 %llu 次\n", workerCount, JOB_COUNT / seconds,
+			(unsigned long long)jobSystem.GetStats().stolenJobCount);
+
+		CHECK(jobSystem.GetStats().executedJobCount == JOB_COUNT);
+	}
+}
@@ -0,0 +1,175 @@
+#include "Test.h"
+#include "LinearRingAllocator.h"
+#include <deque>
+#include <random>
+
+TEST(LinearRingAllocator, AllocatesSequentially) {
+	LinearRingAllocator ring(256);
+	CHECK(ring.Allocate(10, 1) == 0);
+	CHECK(ring.Allocate(10, 16) == 16);
+	CHECK(ring.Allocate(4, 4) == 28);
+	// 对齐的空隙计入使用量
+	CHECK(ring.GetUsedSize() == 32);
+
+	CHECK(ring.Allocate(0, 1) == LinearRingAllocator::INVALID_OFFSET);
+	CHECK(ring.Allocate(257, 1) == LinearRingAllocator::INVALID_OFFSET);
+
+	ring.FinishFrame(1);
+	CHECK(ring.GetStats().lastFrameBytes == 32);
+	CHECK(ring.GetOldestFenceValue() == 1);
+
+	ring.ReleaseCompleted(1);
+	CHECK(ring.GetUsedSize() == 0);
+	CHECK(ring.GetOldestFenceValue() == 0);
+
+	// 环为空时从头开始
+	CHECK(ring.Allocate(8, 8) == 0);
+}
+
+TEST(LinearRingAllocator, WrapsAround) {
+	LinearRingAllocator ring(100);
+
+	CHECK(ring.Allocate(60, 1) == 0);
+	ring.FinishFrame(1);
+	CHECK(ring.Allocate(30, 1) == 60);
+	ring.FinishFrame(2);
+
+	// 帧 1 完成前没有空间
+	CHECK(ring.Allocate(50, 1) == LinearRingAllocator::INVALID_OFFSET);
+	CHECK(ring.GetOldestFenceValue() == 1);
+
+	ring.ReleaseCompleted(1);
+	CHECK(ring.GetUsedSize() == 30);
+
+	// 末尾只剩 10 字节，回绕到开头并浪费它们
+	CHECK(ring.Allocate(50, 1) == 0);
+	CHECK(ring.GetStats().wrapCount == 1);
+	CHECK(ring.GetUsedSize() == 90);
+	// [50, 60) 仍然可用，[60, 90) 属于帧 2
+	CHECK(ring.Allocate(10, 1) == 50);
+	CHECK(ring.Allocate(1, 1) == LinearRingAllocator::INVALID_OFFSET);
+	ring.FinishFrame(3);
+	CHECK(ring.GetStats().lastFrameBytes == 70);
+
+	ring.ReleaseCompleted(2);
+	CHECK(ring.GetUsedSize() == 70);
+	ring.ReleaseCompleted(3);
+	CHECK(ring.GetUsedSize() == 0);
+}
+
+TEST(LinearRingAllocator, FillsToCapacity) {
+	LinearRingAllocator ring(64);
+	CHECK(ring.Allocate(32, 1) == 0);
+	CHECK(ring.Allocate(32, 1) == 32);
+	CHECK(ring.GetUsedSize() == 64);
+	CHECK(ring.Allocate(1, 1) == LinearRingAllocator::INVALID_OFFSET);
+	ring.FinishFrame(1);
+
+	ring.ReleaseCompleted(1);
+	CHECK(ring.Allocate(64, 1) == 0);
+}
+
+TEST(LinearRingAllocator, AlignmentAfterWrap) {
+	LinearRingAllocator ring(256);
+	CHECK(ring.Allocate(100, 1) == 0);
+	ring.FinishFrame(1);
+	CHECK(ring.Allocate(100, 1) == 100);
+	ring.FinishFrame(2);
+	ring.ReleaseCompleted(1);
+
+	// 对齐到 256 超出容量，回绕到 0
+	CHECK(ring.Allocate(64, 64) == 0);
+	CHECK(ring.Allocate(30, 32) == 64);
+	// 下一个对齐位置 96 加 4 不超过帧 2 的起点 100
+	CHECK(ring.Allocate(4, 32) == 96);
+	CHECK(ring.Allocate(1, 1) == LinearRingAllocator::INVALID_OFFSET);
+}
+
+// 用字节数组模拟上传堆，每个分配写入所属帧的标记。GPU 落后 CPU 若干帧，帧完成时检查它的数据
+// 没有被之后的分配覆盖。
+TEST(LinearRingAllocator, FakeGpuLatency) {
+	constexpr uint64_t CAPACITY = 4096;
+	constexpr uint64_t IN_FLIGHT_FRAME_COUNT = 3;
+
+	struct Allocation {
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	struct Frame {
+		uint64_t fenceValue;
+		std::vector<Allocation> allocations;
+	};
+
+	LinearRingAllocator ring(CAPACITY);
+	std::vector<uint8_t> heap(CAPACITY);
+	std::deque<Frame> inFlightFrames;
+
+	std::mt19937 rng(3);
+	std::uniform_int_distribution<uint64_t> sizeDist(1, 700);
+	std::uniform_int_distribution<uint32_t> alignmentLog2Dist(0, 8);
+	std::uniform_int_distribution<uint32_t> allocationCountDist(0, 6);
+
+	// 帧完成前检查它的数据完好，然后回收
+	auto completeOldestFrame = [&]() {
+		const Frame& completed = inFlightFrames.front();
+		for (const Allocation& allocation : completed.allocations) {
+			for (uint64_t j = 0; j < allocation.size; ++j) {
+				REQUIRE(heap[allocation.offset + j] == uint8_t(completed.fenceValue));
+			}
+		}
+		ring.ReleaseCompleted(completed.fenceValue);
+		inFlightFrames.pop_front();
+	};
+
+	uint64_t stallCount = 0;
+	for (uint64_t fenceValue = 1; fenceValue <= 5000; ++fenceValue) {
+		const uint8_t tag = uint8_t(fenceValue);
+		Frame frame = { fenceValue };
+
+		const uint32_t allocationCount = allocationCountDist(rng);
+		for (uint32_t i = 0; i < allocationCount; ++i) {
+			const uint64_t size = sizeDist(rng);
+			const uint64_t alignment = 1ull << alignmentLog2Dist(rng);
+
+			uint64_t offset = ring.Allocate(size, alignment);
+			while (offset == LinearRingAllocator::INVALID_OFFSET && ring.GetOldestFenceValue() != 0) {
+				// 和 D3D12Context::AllocateUpload 一样等待最早的帧完成。没有分配的帧不在环中。
+				ring.OnStall();
+				++stallCount;
+
+				const uint64_t oldestFenceValue = ring.GetOldestFenceValue();
+				while (!inFlightFrames.empty() && inFlightFrames.front().fenceValue <= oldestFenceValue) {
+					completeOldestFrame();
+				}
+
+				offset = ring.Allocate(size, alignment);
+			}
+
+			// 这一帧的数据已经占满了环
+			if (offset == LinearRingAllocator::INVALID_OFFSET) {
+				continue;
+			}
+
+			REQUIRE(offset % alignment == 0);
+			REQUIRE(offset + size <= CAPACITY);
+			std::fill_n(heap.begin() + offset, size, tag);
+			frame.allocations.push_back({ offset, size });
+		}
+
+		ring.FinishFrame(fenceValue);
+		REQUIRE(ring.GetUsedSize() <= CAPACITY);
+		inFlightFrames.push_back(std::move(frame));
+
+		// GPU 完成 IN_FLIGHT_FRAME_COUNT 帧之前的帧
+		while (inFlightFrames.size() > IN_FLIGHT_FRAME_COUNT) {
+			completeOldestFrame();
+		}
+	}
+
+	CHECK(ring.GetStats().wrapCount > 0);
+	CHECK(ring.GetStats().stallCount == stallCount);
+	CHECK(ring.GetStats().maxFrameBytes <= CAPACITY);
+	std::printf("    回绕 %llu 次，等待 GPU %llu 次\n",
+		(unsigned long long)ring.GetStats().wrapCount, (unsigned long long)stallCount);
+}
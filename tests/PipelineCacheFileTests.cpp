@@ -0,0 +1,116 @@
+#include "Test.h"
+#include "PipelineCacheFile.h"
+#include <cstddef>
+#include <vector>
+
+namespace {
+
+constexpr PipelineCacheFile::AdapterIdentity ADAPTER = {
+	.vendorId = 0x10DE,
+	.deviceId = 0x2684,
+	.subSysId = 0x16F41043,
+	.revision = 0xA1,
+	.driverVersion = 0x001F000F0D5A1234
+};
+
+// 模拟 PipelineCache::Save 写入的文件
+std::vector<uint8_t> MakeFile(const PipelineCacheFile::AdapterIdentity& adapter, size_t librarySize) {
+	std::vector<uint8_t> data(PipelineCacheFile::GetFileSize(librarySize));
+	const std::span<uint8_t> library = PipelineCacheFile::GetLibrary(data);
+	for (size_t i = 0; i < library.size(); ++i) {
+		library[i] = uint8_t(i * 31 + 7);
+	}
+	PipelineCacheFile::WriteHeader(adapter, data);
+	return data;
+}
+
+}
+
+TEST(PipelineCacheFile, RoundTrip) {
+	const std::vector<uint8_t> data = MakeFile(ADAPTER, 1000);
+	CHECK(data.size() == PipelineCacheFile::HEADER_SIZE + 1000);
+
+	const std::span<const uint8_t> library = PipelineCacheFile::Read(data, ADAPTER);
+	REQUIRE(library.size() == 1000);
+	CHECK(library.data() == data.data() + PipelineCacheFile::HEADER_SIZE);
+	for (size_t i = 0; i < library.size(); ++i) {
+		CHECK(library[i] == uint8_t(i * 31 + 7));
+	}
+}
+
+TEST(PipelineCacheFile, HeaderLayout) {
+	const std::vector<uint8_t> data = MakeFile(ADAPTER, 16);
+
+	// 文件格式固定为小端，开头是 "PLC0" 和版本号
+	CHECK(std::memcmp(data.data(), "PLC0", 4) == 0);
+	uint32_t version;
+	std::memcpy(&version, data.data() + 4, sizeof(version));
+	CHECK(version == PipelineCacheFile::VERSION);
+
+	uint64_t librarySize;
+	std::memcpy(&librarySize, data.data() + offsetof(PipelineCacheFile::Header, librarySize), sizeof(librarySize));
+	CHECK(librarySize == 16);
+}
+
+TEST(PipelineCacheFile, RejectsDifferentAdapter) {
+	const std::vector<uint8_t> data = MakeFile(ADAPTER, 100);
+
+	PipelineCacheFile::AdapterIdentity adapter = ADAPTER;
+	adapter.vendorId = 0x1002;
+	CHECK(PipelineCacheFile::Read(data, adapter).empty());
+
+	adapter = ADAPTER;
+	adapter.deviceId += 1;
+	CHECK(PipelineCacheFile::Read(data, adapter).empty());
+
+	adapter = ADAPTER;
+	adapter.subSysId += 1;
+	CHECK(PipelineCacheFile::Read(data, adapter).empty());
+
+	adapter = ADAPTER;
+	adapter.revision += 1;
+	CHECK(PipelineCacheFile::Read(data, adapter).empty());
+
+	// 更新驱动后缓存失效
+	adapter = ADAPTER;
+	adapter.driverVersion += 1;
+	CHECK(PipelineCacheFile::Read(data, adapter).empty());
+}
+
+TEST(PipelineCacheFile, RejectsCorruption) {
+	const std::vector<uint8_t> original = MakeFile(ADAPTER, 256);
+	REQUIRE(!PipelineCacheFile::Read(original, ADAPTER).empty());
+
+	// 任何一个字节改变都被发现
+	std::vector<uint8_t> data = original;
+	for (size_t i = 0; i < data.size(); ++i) {
+		data[i] ^= 0x40;
+		CHECK(PipelineCacheFile::Read(data, ADAPTER).empty());
+		data[i] ^= 0x40;
+	}
+}
+
+TEST(PipelineCacheFile, RejectsWrongSize) {
+	std::vector<uint8_t> data = MakeFile(ADAPTER, 64);
+
+	CHECK(PipelineCacheFile::Read({}, ADAPTER).empty());
+	CHECK(PipelineCacheFile::Read(std::span(data).first(PipelineCacheFile::HEADER_SIZE - 1), ADAPTER).empty());
+	// 截断
+	CHECK(PipelineCacheFile::Read(std::span(data).first(data.size() - 1), ADAPTER).empty());
+	// 末尾有多余的数据
+	data.push_back(0);
+	CHECK(PipelineCacheFile::Read(data, ADAPTER).empty());
+}
+
+TEST(PipelineCacheFile, UnalignedData) {
+	const std::vector<uint8_t> file = MakeFile(ADAPTER, 333);
+
+	// 文件数据不一定对齐
+	std::vector<uint8_t> buffer(1);
+	buffer.insert(buffer.end(), file.begin(), file.end());
+	const std::span<const uint8_t> data = std::span(buffer).subspan(1);
+
+	const std::span<const uint8_t> library = PipelineCacheFile::Read(data, ADAPTER);
+	REQUIRE(library.size() == 333);
+	CHECK(std::memcmp(library.data(), file.data() + PipelineCacheFile::HEADER_SIZE, 333) == 0);
+}
@@ -0,0 +1,258 @@
+#include "Test.h"
+#include "QuadCulling.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// 视口的尺寸为 2 的幂，像素坐标转换到 NDC 没有舍入误差，可以精确构造和边缘相接的四边形
+constexpr float VIEWPORT_WIDTH = 1024;
+constexpr float VIEWPORT_HEIGHT = 512;
+
+constexpr uint32_t VERTEX_COUNT_PER_INSTANCE = 4;
+
+// 和 QuadBatcher::PackInstances 相同的转换，texture 用于标识实例
+QuadInstance MakeInstance(float left, float top, float width, float height, uint32_t id) {
+	return {
+		.rect = {
+			left * 2 / VIEWPORT_WIDTH - 1,
+			1 - top * 2 / VIEWPORT_HEIGHT,
+			width * 2 / VIEWPORT_WIDTH,
+			-height * 2 / VIEWPORT_HEIGHT
+		},
+		.texture = id
+	};
+}
+
+bool IsVisible(float left, float top, float width, float height) {
+	return QuadCulling::IsInstanceVisible(MakeInstance(left, top, width, height, 0));
+}
+
+// 每种材质的实例连续存放，和 QuadBatcher::Prepare 一致
+struct Scene {
+	std::vector<QuadInstance> instances;
+	std::vector<QuadCulling::Batch> batches;
+
+	void AddBatch(const std::vector<QuadInstance>& batchInstances) {
+		if (batchInstances.empty()) {
+			batches.push_back({});
+			return;
+		}
+
+		batches.push_back({ (uint32_t)instances.size(), (uint32_t)batchInstances.size() });
+		instances.insert(instances.end(), batchInstances.begin(), batchInstances.end());
+	}
+};
+
+// 按 shaders/QuadCull_CS.hlsl 的方式执行剔除：每个 wave 原子地累加 InstanceCount 得到基址，
+// wave 内按前缀计数写入。reverse 为 true 时 wave 以相反的顺序执行，模拟 GPU 上不确定的顺序。
+void SimulateCullShader(
+	const Scene& scene,
+	uint32_t waveSize,
+	bool reverse,
+	QuadInstance* visibleInstances,
+	QuadCulling::DrawArguments* drawArgs
+) {
+	for (size_t i = 0; i < scene.batches.size(); ++i) {
+		const QuadCulling::Batch& batch = scene.batches[i];
+		// QuadBatcher::_PrepareGpuCulling 上传的初值
+		drawArgs[i] = {
+			.vertexCountPerInstance = VERTEX_COUNT_PER_INSTANCE,
+			.instanceCount = 0,
+			.startVertexLocation = 0,
+			.startInstanceLocation = batch.startInstance
+		};
+
+		const uint32_t waveCount = (batch.instanceCount + waveSize - 1) / waveSize;
+		for (uint32_t w = 0; w < waveCount; ++w) {
+			const uint32_t wave = reverse ? waveCount - 1 - w : w;
+			const uint32_t first = wave * waveSize;
+			const uint32_t last = std::min(first + waveSize, batch.instanceCount);
+
+			const uint32_t base = drawArgs[i].instanceCount;
+			uint32_t prefix = 0;
+			for (uint32_t t = first; t < last; ++t) {
+				const QuadInstance& instance = scene.instances[batch.startInstance + t];
+				if (QuadCulling::IsInstanceVisible(instance)) {
+					visibleInstances[batch.startInstance + base + prefix++] = instance;
+				}
+			}
+			drawArgs[i].instanceCount += prefix;
+		}
+	}
+}
+
+std::vector<uint32_t> GetIds(const QuadInstance* instances, uint32_t count) {
+	std::vector<uint32_t> ids;
+	for (uint32_t i = 0; i < count; ++i) {
+		ids.push_back(instances[i].texture);
+	}
+	return ids;
+}
+
+bool IsSameDrawArguments(const QuadCulling::DrawArguments& a, const QuadCulling::DrawArguments& b) {
+	return a.vertexCountPerInstance == b.vertexCountPerInstance && a.instanceCount == b.instanceCount &&
+		a.startVertexLocation == b.startVertexLocation && a.startInstanceLocation == b.startInstanceLocation;
+}
+
+// 视口内外交替的一行四边形，id 从 firstId 开始，可见的 id 写入 visibleIds
+std::vector<QuadInstance> MakeRow(uint32_t count, uint32_t firstId, float top, std::vector<uint32_t>& visibleIds) {
+	std::vector<QuadInstance> instances;
+	for (uint32_t i = 0; i < count; ++i) {
+		const uint32_t id = firstId + i;
+		// 每 3 个中有 1 个在视口右侧之外
+		const bool isVisible = i % 3 != 2;
+		const float left = isVisible ? float(i % 64) * 16 : VIEWPORT_WIDTH + float(i);
+		instances.push_back(MakeInstance(left, top, 12, 12, id));
+		if (isVisible) {
+			visibleIds.push_back(id);
+		}
+	}
+	return instances;
+}
+
+}
+
+TEST(QuadCulling, VisibleCountPerMaterial) {
+	// 三种材质，第二种没有四边形，第三种跨越多个线程组
+	std::vector<uint32_t> visibleIds[3];
+	Scene scene;
+	scene.AddBatch(MakeRow(10, 0, 0, visibleIds[0]));
+	scene.AddBatch({});
+	scene.AddBatch(MakeRow(300, 100, 100, visibleIds[2]));
+
+	std::vector<QuadInstance> visibleInstances(scene.instances.size());
+	QuadCulling::DrawArguments drawArgs[3];
+	QuadCulling::CullBatches(scene.batches, scene.instances.data(),
+		VERTEX_COUNT_PER_INSTANCE, visibleInstances.data(), drawArgs);
+
+	const uint32_t startInstances[] = { 0, 0, 10 };
+	for (uint32_t i = 0; i < 3; ++i) {
+		CHECK(drawArgs[i].vertexCountPerInstance == VERTEX_COUNT_PER_INSTANCE);
+		CHECK(drawArgs[i].instanceCount == visibleIds[i].size());
+		CHECK(drawArgs[i].startVertexLocation == 0);
+		// 剔除后的实例从剔除前的起始位置开始
+		CHECK(drawArgs[i].startInstanceLocation == startInstances[i]);
+
+		// 可见的实例保持原顺序
+		CHECK(GetIds(visibleInstances.data() + drawArgs[i].startInstanceLocation,
+			drawArgs[i].instanceCount) == visibleIds[i]);
+	}
+	CHECK(drawArgs[0].instanceCount == 7);
+	CHECK(drawArgs[2].instanceCount == 200);
+}
+
+TEST(QuadCulling, MatchesCullShader) {
+	std::vector<uint32_t> visibleIds[3];
+	Scene scene;
+	scene.AddBatch(MakeRow(70, 0, 0, visibleIds[0]));
+	scene.AddBatch(MakeRow(1, 1000, 50, visibleIds[1]));
+	scene.AddBatch(MakeRow(257, 2000, 100, visibleIds[2]));
+
+	std::vector<QuadInstance> expectedInstances(scene.instances.size());
+	QuadCulling::DrawArguments expectedDrawArgs[3];
+	QuadCulling::CullBatches(scene.batches, scene.instances.data(),
+		VERTEX_COUNT_PER_INSTANCE, expectedInstances.data(), expectedDrawArgs);
+
+	// 常见的 wave 大小，以及 WARP 的 4
+	for (uint32_t waveSize : { 4u, 32u, 64u }) {
+		for (bool reverse : { false, true }) {
+			std::vector<QuadInstance> visibleInstances(scene.instances.size());
+			QuadCulling::DrawArguments drawArgs[3];
+			SimulateCullShader(scene, waveSize, reverse, visibleInstances.data(), drawArgs);
+
+			for (uint32_t i = 0; i < 3; ++i) {
+				CHECK(IsSameDrawArguments(drawArgs[i], expectedDrawArgs[i]));
+
+				// wave 之间的顺序不确定，排序后比较
+				const uint32_t start = drawArgs[i].startInstanceLocation;
+				std::vector<uint32_t> ids = GetIds(visibleInstances.data() + start, drawArgs[i].instanceCount);
+				std::ranges::sort(ids);
+				CHECK(ids == GetIds(expectedInstances.data() + start, expectedDrawArgs[i].instanceCount));
+			}
+		}
+	}
+}
+
+TEST(QuadCulling, CompactsInOrder) {
+	// CPU 剔除时可见的实例按原顺序紧密排列
+	std::vector<QuadInstance> instances;
+	std::vector<uint32_t> visibleIds;
+	for (uint32_t i = 0; i < 100; ++i) {
+		const bool isVisible = i % 7 == 0 || i % 5 == 1;
+		instances.push_back(MakeInstance(isVisible ? 100 : -100, 100, 50, 50, i));
+		if (isVisible) {
+			visibleIds.push_back(i);
+		}
+	}
+
+	std::vector<QuadInstance> visibleInstances(instances.size());
+	const uint32_t visibleCount = QuadCulling::CullInstances(instances.data(), (uint32_t)instances.size(),
+		visibleInstances.data());
+	CHECK(visibleCount == visibleIds.size());
+	CHECK(GetIds(visibleInstances.data(), visibleCount) == visibleIds);
+
+	// 原样复制
+	for (uint32_t i = 0; i < visibleCount; ++i) {
+		const QuadInstance& instance = instances[visibleIds[i]];
+		CHECK(visibleInstances[i].rect.x == instance.rect.x && visibleInstances[i].rect.w == instance.rect.w);
+	}
+}
+
+TEST(QuadCulling, AllCulled) {
+	// 视口四周之外
+	Scene scene;
+	scene.AddBatch({
+		MakeInstance(-20, 100, 10, 10, 0),
+		MakeInstance(VIEWPORT_WIDTH + 10, 100, 10, 10, 1),
+		MakeInstance(100, -20, 10, 10, 2),
+		MakeInstance(100, VIEWPORT_HEIGHT + 10, 10, 10, 3)
+	});
+	scene.AddBatch({ MakeInstance(-5000, -5000, 100, 100, 4) });
+
+	// 不写入任何实例
+	const QuadInstance sentinel = MakeInstance(0, 0, 1, 1, 0xFFFFFFFF);
+	std::vector<QuadInstance> visibleInstances(scene.instances.size(), sentinel);
+	QuadCulling::DrawArguments drawArgs[2];
+	QuadCulling::CullBatches(scene.batches, scene.instances.data(),
+		VERTEX_COUNT_PER_INSTANCE, visibleInstances.data(), drawArgs);
+
+	CHECK(drawArgs[0].instanceCount == 0 && drawArgs[0].startInstanceLocation == 0);
+	CHECK(drawArgs[1].instanceCount == 0 && drawArgs[1].startInstanceLocation == 4);
+	CHECK(std::ranges::all_of(visibleInstances, [](const QuadInstance& instance) {
+		return instance.texture == 0xFFFFFFFF;
+	}));
+
+	for (uint32_t waveSize : { 4u, 64u }) {
+		QuadCulling::DrawArguments shaderDrawArgs[2];
+		SimulateCullShader(scene, waveSize, false, visibleInstances.data(), shaderDrawArgs);
+		CHECK(IsSameDrawArguments(shaderDrawArgs[0], drawArgs[0]));
+		CHECK(IsSameDrawArguments(shaderDrawArgs[1], drawArgs[1]));
+	}
+}
+
+TEST(QuadCulling, ViewportEdge) {
+	// 只和视口边缘相接的四边形不覆盖任何像素，被剔除
+	CHECK(!IsVisible(-10, 100, 10, 10));
+	CHECK(!IsVisible(VIEWPORT_WIDTH, 100, 10, 10));
+	CHECK(!IsVisible(100, -10, 10, 10));
+	CHECK(!IsVisible(100, VIEWPORT_HEIGHT, 10, 10));
+
+	// 向内一个像素就可见
+	CHECK(IsVisible(-9, 100, 10, 10));
+	CHECK(IsVisible(VIEWPORT_WIDTH - 1, 100, 10, 10));
+	CHECK(IsVisible(100, -9, 10, 10));
+	CHECK(IsVisible(100, VIEWPORT_HEIGHT - 1, 10, 10));
+
+	// 恰好覆盖视口和超出视口
+	CHECK(IsVisible(0, 0, VIEWPORT_WIDTH, VIEWPORT_HEIGHT));
+	CHECK(IsVisible(-100, -100, VIEWPORT_WIDTH + 200, VIEWPORT_HEIGHT + 200));
+	// 视口四角之外只相接一个点
+	CHECK(!IsVisible(-10, -10, 10, 10));
+	CHECK(!IsVisible(VIEWPORT_WIDTH, VIEWPORT_HEIGHT, 10, 10));
+
+	// 面积为 0 或尺寸为负
+	CHECK(!IsVisible(100, 100, 0, 10));
+	CHECK(!IsVisible(100, 100, 10, 0));
+	CHECK(!IsVisible(100, 100, -10, 10));
+}
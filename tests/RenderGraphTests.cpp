@@ -0,0 +1,353 @@
+#include "pch.h"
+#include "Test.h"
+#include "RenderGraph.h"
+
+// Compile 不调用 D3D12，这里用固定的图检查屏障序列
+
+namespace {
+
+using Barrier = RenderGraph::Barrier;
+
+constexpr D3D12_RESOURCE_STATES PRESENT = D3D12_RESOURCE_STATE_PRESENT;
+constexpr D3D12_RESOURCE_STATES RT = D3D12_RESOURCE_STATE_RENDER_TARGET;
+constexpr D3D12_RESOURCE_STATES SRV = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+constexpr D3D12_RESOURCE_STATES NPSRV = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+constexpr D3D12_RESOURCE_STATES UAV = D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+constexpr D3D12_RESOURCE_STATES COPY_SOURCE = D3D12_RESOURCE_STATE_COPY_SOURCE;
+
+constexpr D3D12_RESOURCE_BARRIER_FLAGS BEGIN = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+constexpr D3D12_RESOURCE_BARRIER_FLAGS END = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+
+Barrier Transition(
+	uint32_t resource,
+	D3D12_RESOURCE_STATES stateBefore,
+	D3D12_RESOURCE_STATES stateAfter,
+	D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE
+) noexcept {
+	return {
+		.resource = resource,
+		.type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION,
+		.stateBefore = stateBefore,
+		.stateAfter = stateAfter,
+		.flags = flags
+	};
+}
+
+Barrier UavBarrier(uint32_t resource) noexcept {
+	return {
+		.resource = resource,
+		.type = D3D12_RESOURCE_BARRIER_TYPE_UAV,
+		.flags = D3D12_RESOURCE_BARRIER_FLAG_NONE
+	};
+}
+
+bool IsBarriers(std::span<const Barrier> actual, std::initializer_list<Barrier> expected) noexcept {
+	return std::equal(actual.begin(), actual.end(), expected.begin(), expected.end());
+}
+
+D3D12_RESOURCE_DESC TextureDesc(uint32_t width = 1920) noexcept {
+	return CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R16G16B16A16_FLOAT,
+		width, 1080, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+}
+
+D3D12_RESOURCE_DESC BufferDesc() noexcept {
+	return CD3DX12_RESOURCE_DESC::Buffer(65536, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+}
+
+}
+
+TEST(RenderGraph, LinearChain) {
+	RenderGraph graph;
+	const RenderGraphResource backBuffer = graph.ImportResource(nullptr, PRESENT, PRESENT);
+	const RenderGraphResource scene = graph.CreateTransientResource(TextureDesc());
+
+	const uint32_t draw = graph.AddPass("Draw", 0, {});
+	graph.WriteResource(draw, scene, RT);
+	const uint32_t composite = graph.AddPass("Composite", 0, {});
+	graph.ReadResource(composite, scene, SRV);
+	graph.WriteResource(composite, backBuffer, RT);
+
+	graph.Compile();
+
+	// 外部资源在前，物理索引 0 是后备缓冲，1 是场景
+	REQUIRE(graph.GetPhysicalResourceCount() == 2);
+	REQUIRE(graph.GetTransientResources().size() == 1);
+	CHECK(graph.GetTransientResources()[0].physicalIndex == 1);
+	CHECK(graph.GetTransientResources()[0].initialState == RT);
+
+	// 后备缓冲的转换在同一个命令列表中拆分
+	CHECK(IsBarriers(graph.GetPassBarriers(draw), { Transition(0, PRESENT, RT, BEGIN) }));
+	CHECK(IsBarriers(graph.GetPassBarriers(composite), {
+		Transition(0, PRESENT, RT, END),
+		Transition(1, RT, SRV)
+	}));
+	// 瞬态资源转换回创建时的状态
+	CHECK(IsBarriers(graph.GetFinalBarriers(), {
+		Transition(0, RT, PRESENT),
+		Transition(1, SRV, RT)
+	}));
+}
+
+TEST(RenderGraph, CullsUnusedPasses) {
+	RenderGraph graph;
+	const RenderGraphResource backBuffer = graph.ImportResource(nullptr, RT, RT);
+	const RenderGraphResource unused = graph.CreateTransientResource(TextureDesc());
+	const RenderGraphResource log = graph.CreateTransientResource(BufferDesc());
+
+	const uint32_t dead = graph.AddPass("Dead", 0, {});
+	graph.WriteResource(dead, unused, RT);
+	const uint32_t sideEffect = graph.AddPass("SideEffect", 0, {}, true);
+	graph.WriteResource(sideEffect, log, UAV);
+	const uint32_t draw = graph.AddPass("Draw", 0, {});
+	graph.WriteResource(draw, backBuffer, RT);
+
+	graph.Compile();
+
+	CHECK(graph.IsPassCulled(dead));
+	CHECK(!graph.IsPassCulled(sideEffect));
+	CHECK(!graph.IsPassCulled(draw));
+
+	// 只有被存活 pass 使用的瞬态资源才分配物理资源
+	REQUIRE(graph.GetTransientResources().size() == 1);
+	CHECK(graph.GetTransientResources()[0].initialState == UAV);
+	CHECK(graph.GetTransientResources()[0].firstPosition == 0);
+	CHECK(graph.GetPassBarriers(dead).empty());
+	CHECK(graph.GetPassBarriers(draw).empty());
+	CHECK(graph.GetFinalBarriers().empty());
+}
+
+TEST(RenderGraph, ReusesNonOverlappingTransients) {
+	RenderGraph graph;
+	const RenderGraphResource backBuffer = graph.ImportResource(nullptr, RT, RT);
+	const RenderGraphResource a = graph.CreateTransientResource(TextureDesc());
+	const RenderGraphResource b = graph.CreateTransientResource(TextureDesc());
+	const RenderGraphResource c = graph.CreateTransientResource(TextureDesc());
+	// 描述不同，不能复用
+	const RenderGraphResource d = graph.CreateTransientResource(TextureDesc(1280));
+
+	const uint32_t pass0 = graph.AddPass("0", 0, {});
+	graph.WriteResource(pass0, a, RT);
+	const uint32_t pass1 = graph.AddPass("1", 0, {});
+	graph.ReadResource(pass1, a, SRV);
+	graph.WriteResource(pass1, b, RT);
+	// a 的生命周期已结束，c 复用 a
+	const uint32_t pass2 = graph.AddPass("2", 0, {});
+	graph.ReadResource(pass2, b, SRV);
+	graph.WriteResource(pass2, c, RT);
+	const uint32_t pass3 = graph.AddPass("3", 0, {});
+	graph.ReadResource(pass3, c, SRV);
+	graph.WriteResource(pass3, d, RT);
+	const uint32_t pass4 = graph.AddPass("4", 0, {});
+	graph.ReadResource(pass4, d, SRV);
+	graph.WriteResource(pass4, backBuffer, RT);
+
+	graph.Compile();
+
+	REQUIRE(graph.GetTransientResources().size() == 3);
+	CHECK(graph.GetPhysicalResourceCount() == 4);
+
+	const std::vector<RenderGraph::TransientResourceInfo>& transients = graph.GetTransientResources();
+	// a 和 c 共用物理资源 1，生命周期合并
+	CHECK(transients[0].physicalIndex == 1);
+	CHECK(transients[0].firstPosition == 0);
+	CHECK(transients[0].lastPosition == 3);
+	CHECK(transients[1].physicalIndex == 2);
+	CHECK(transients[1].firstPosition == 1);
+	CHECK(transients[1].lastPosition == 2);
+	CHECK(transients[2].physicalIndex == 3);
+	CHECK(transients[2].desc.Width == 1280);
+
+	// a 读取后立即转换回 RT，c 写入时无需屏障
+	CHECK(IsBarriers(graph.GetPassBarriers(pass1), { Transition(1, RT, SRV) }));
+	CHECK(IsBarriers(graph.GetPassBarriers(pass2), {
+		Transition(1, SRV, RT),
+		Transition(2, RT, SRV)
+	}));
+	CHECK(IsBarriers(graph.GetPassBarriers(pass3), {
+		Transition(1, RT, SRV),
+		Transition(2, SRV, RT)
+	}));
+	CHECK(IsBarriers(graph.GetPassBarriers(pass4), {
+		Transition(1, SRV, RT),
+		Transition(3, RT, SRV)
+	}));
+	CHECK(IsBarriers(graph.GetFinalBarriers(), { Transition(3, SRV, RT) }));
+
+	graph.AddAliasingBarrier(2);
+	const Barrier aliasing = {
+		.resource = 2,
+		.type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING,
+		.stateAfter = RT,
+		.flags = D3D12_RESOURCE_BARRIER_FLAG_NONE
+	};
+	CHECK(graph.GetPassBarriers(pass1).back() == aliasing);
+}
+
+TEST(RenderGraph, MergesConsecutiveReads) {
+	RenderGraph graph;
+	const RenderGraphResource backBuffer = graph.ImportResource(nullptr, RT, RT);
+	const RenderGraphResource scene = graph.CreateTransientResource(TextureDesc());
+
+	const uint32_t draw = graph.AddPass("Draw", 0, {});
+	graph.WriteResource(draw, scene, RT);
+	const uint32_t read0 = graph.AddPass("Read0", 0, {});
+	graph.ReadResource(read0, scene, SRV);
+	graph.WriteResource(read0, backBuffer, RT);
+	const uint32_t read1 = graph.AddPass("Read1", 0, {});
+	graph.ReadResource(read1, scene, NPSRV);
+	graph.ReadResource(read1, scene, SRV);
+	graph.WriteResource(read1, backBuffer, RT);
+
+	graph.Compile();
+
+	// 两个 pass 的读取合并为一次转换
+	CHECK(IsBarriers(graph.GetPassBarriers(read0), { Transition(1, RT, SRV | NPSRV) }));
+	CHECK(graph.GetPassBarriers(read1).empty());
+	CHECK(IsBarriers(graph.GetFinalBarriers(), { Transition(1, SRV | NPSRV, RT) }));
+}
+
+TEST(RenderGraph, DoesNotMergeWritableReadStates) {
+	RenderGraph graph;
+	const RenderGraphResource buffer = graph.ImportBuffer(nullptr);
+	const RenderGraphResource output = graph.ImportBuffer(nullptr);
+
+	const uint32_t read = graph.AddPass("Read", 0, {});
+	graph.ReadResource(read, buffer, COPY_SOURCE);
+	graph.WriteResource(read, output, UAV);
+	// 以 UNORDERED_ACCESS 读取，不能和之前的 COPY_SOURCE 合并成无效的组合
+	const uint32_t uavRead = graph.AddPass("UavRead", 0, {});
+	graph.ReadResource(uavRead, buffer, UAV);
+	graph.WriteResource(uavRead, output, UAV);
+
+	graph.Compile();
+
+	// 缓冲区第一次访问隐式提升
+	CHECK(graph.GetPassBarriers(read).empty());
+	CHECK(IsBarriers(graph.GetPassBarriers(uavRead), {
+		Transition(0, COPY_SOURCE, UAV),
+		UavBarrier(1)
+	}));
+	CHECK(graph.GetFinalBarriers().empty());
+}
+
+TEST(RenderGraph, ReadWriteInOnePass) {
+	RenderGraph graph;
+	const RenderGraphResource buffer = graph.ImportBuffer(nullptr);
+	const RenderGraphResource texture = graph.ImportResource(nullptr, SRV, SRV);
+
+	const uint32_t clear = graph.AddPass("Clear", 0, {});
+	graph.WriteResource(clear, buffer, UAV);
+	// 同一个 pass 以相同的状态读写
+	const uint32_t accumulate = graph.AddPass("Accumulate", 0, {});
+	graph.ReadResource(accumulate, buffer, UAV);
+	graph.WriteResource(accumulate, buffer, UAV);
+	graph.ReadResource(accumulate, texture, SRV);
+	const uint32_t copy = graph.AddPass("Copy", 0, {});
+	graph.ReadResource(copy, buffer, COPY_SOURCE);
+	graph.WriteResource(copy, texture, D3D12_RESOURCE_STATE_COPY_DEST);
+
+	graph.Compile();
+
+	CHECK(graph.GetPassBarriers(clear).empty());
+	CHECK(IsBarriers(graph.GetPassBarriers(accumulate), { UavBarrier(0) }));
+	CHECK(IsBarriers(graph.GetPassBarriers(copy), {
+		Transition(0, UAV, COPY_SOURCE),
+		Transition(1, SRV, D3D12_RESOURCE_STATE_COPY_DEST)
+	}));
+	CHECK(IsBarriers(graph.GetFinalBarriers(), { Transition(1, D3D12_RESOURCE_STATE_COPY_DEST, SRV) }));
+}
+
+TEST(RenderGraph, SplitBarriersStayInCommandList) {
+	RenderGraph graph;
+	const RenderGraphResource backBuffer = graph.ImportResource(nullptr, PRESENT, PRESENT);
+	const RenderGraphResource scene = graph.CreateTransientResource(TextureDesc());
+	const RenderGraphResource other = graph.CreateTransientResource(TextureDesc(1280));
+
+	const uint32_t draw = graph.AddPass("Draw", 0, {});
+	graph.WriteResource(draw, scene, RT);
+	const uint32_t unrelated = graph.AddPass("Unrelated", 0, {});
+	graph.WriteResource(unrelated, other, RT);
+	// 在另一个命令列表中读取，scene 的转换不能拆分
+	const uint32_t composite = graph.AddPass("Composite", 1, {});
+	graph.ReadResource(composite, scene, SRV);
+	graph.ReadResource(composite, other, SRV);
+	graph.WriteResource(composite, backBuffer, RT);
+
+	graph.Compile();
+
+	CHECK(graph.GetPassBarriers(draw).empty());
+	CHECK(graph.GetPassBarriers(unrelated).empty());
+	CHECK(IsBarriers(graph.GetPassBarriers(composite), {
+		Transition(0, PRESENT, RT),
+		Transition(1, RT, SRV),
+		Transition(2, RT, SRV)
+	}));
+	CHECK(IsBarriers(graph.GetFinalBarriers(), {
+		Transition(0, RT, PRESENT),
+		Transition(1, SRV, RT),
+		Transition(2, SRV, RT)
+	}));
+}
+
+TEST(RenderGraph, SplitBarrierAcrossPasses) {
+	RenderGraph graph;
+	const RenderGraphResource backBuffer = graph.ImportResource(nullptr, PRESENT, PRESENT);
+	const RenderGraphResource scene = graph.CreateTransientResource(TextureDesc());
+	const RenderGraphResource other = graph.CreateTransientResource(TextureDesc(1280));
+
+	const uint32_t draw = graph.AddPass("Draw", 0, {});
+	graph.WriteResource(draw, scene, RT);
+	const uint32_t unrelated = graph.AddPass("Unrelated", 0, {});
+	graph.WriteResource(unrelated, other, RT);
+	const uint32_t composite = graph.AddPass("Composite", 0, {});
+	graph.ReadResource(composite, scene, SRV);
+	graph.ReadResource(composite, other, SRV);
+	graph.WriteResource(composite, backBuffer, RT);
+
+	graph.Compile();
+
+	// scene 最后一次写入和读取之间有其他 pass，转换在 Unrelated 之前开始
+	CHECK(IsBarriers(graph.GetPassBarriers(draw), { Transition(0, PRESENT, RT, BEGIN) }));
+	CHECK(IsBarriers(graph.GetPassBarriers(unrelated), { Transition(1, RT, SRV, BEGIN) }));
+	CHECK(IsBarriers(graph.GetPassBarriers(composite), {
+		Transition(0, PRESENT, RT, END),
+		Transition(1, RT, SRV, END),
+		Transition(2, RT, SRV)
+	}));
+}
+
+TEST(RenderGraph, CompileIsDeterministic) {
+	RenderGraph graph;
+	std::vector<std::vector<Barrier>> expected;
+
+	for (uint32_t iteration = 0; iteration < 2; ++iteration) {
+		graph.Reset();
+		const RenderGraphResource backBuffer = graph.ImportResource(nullptr, PRESENT, PRESENT);
+		RenderGraphResource prev = graph.CreateTransientResource(TextureDesc());
+		graph.WriteResource(graph.AddPass("First", 0, {}), prev, RT);
+
+		std::vector<uint32_t> passes;
+		for (uint32_t i = 0; i < 16; ++i) {
+			const uint32_t pass = graph.AddPass("Pass", i / 8, {});
+			graph.ReadResource(pass, prev, SRV);
+			const RenderGraphResource next = i == 15 ? backBuffer : graph.CreateTransientResource(TextureDesc());
+			graph.WriteResource(pass, next, RT);
+			prev = next;
+			passes.push_back(pass);
+		}
+
+		graph.Compile();
+
+		// 交替使用两个物理资源
+		CHECK(graph.GetTransientResources().size() == 2);
+
+		for (size_t i = 0; i < passes.size(); ++i) {
+			const std::span<const Barrier> barriers = graph.GetPassBarriers(passes[i]);
+			if (iteration == 0) {
+				expected.emplace_back(barriers.begin(), barriers.end());
+			} else {
+				CHECK(std::ranges::equal(barriers, expected[i]));
+			}
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#include "pch.h"
+#include "Test.h"
+#include "JobSystem.h"
+#include "Renderer.h"
+
+// 和 D3D12Playground 一样使用随程序部署的 D3D12 运行时，WARP 也来自其中
+extern "C" { __declspec(dllexport) extern const UINT D3D12SDKVersion = 619; }
+extern "C" { __declspec(dllexport) extern const char* D3D12SDKPath = ".\\D3D12\\"; }
+
+// 以下测试在 WARP 上运行，不需要显卡，需要 exe 所在目录的 Shaders.bin
+
+TEST(Renderer, SoftwareRenderingMatchesWarp) {
+	JobSystem jobSystem;
+	REQUIRE(jobSystem.Initialize());
+
+	// 高度不是 SoftwareRenderer::TILE_HEIGHT 的倍数，覆盖最后一块不完整的情况
+	Renderer::SoftwareRenderingComparison result;
+	REQUIRE(SUCCEEDED(Renderer::CompareSoftwareRendering(jobSystem, { 1920, 1080 }, result)));
+
+	// 8 位的 sRGB 编码和纹理过滤的精度不同，允许相差 1。正方形和四边形的边缘都遵循左上规则，
+	// 覆盖的像素应当一致。
+	CHECK(result.pixelCount == 1920 * 1080);
+	CHECK(result.mismatchCount * 1000 <= result.pixelCount);
+	std::printf("    %u/%u 个像素相差超过 1，最大相差 %u\n",
+		result.mismatchCount, result.pixelCount, result.maxDifference);
+}
+
+TEST(Renderer, BenchmarkSoftwareRendering) {
+	JobSystem jobSystem;
+	REQUIRE(jobSystem.Initialize());
+
+	const Renderer::SoftwareRenderingBenchmark result =
+		Renderer::BenchmarkSoftwareRendering(jobSystem, { 1920, 1080 }, 60);
+	CHECK(result.softwarePixelsPerSecond > 0);
+	CHECK(result.warpPixelsPerSecond > 0);
+	std::printf("    1920x1080：SoftwareRenderer %.1f M 像素/秒，WARP %.1f M 像素/秒\n",
+		result.softwarePixelsPerSecond / 1e6, result.warpPixelsPerSecond / 1e6);
+}
@@ -0,0 +1,173 @@
+#include "Test.h"
+#include "SceneGeometry.h"
+#include <cmath>
+
+namespace {
+
+struct Viewport {
+	float width;
+	float height;
+	float dpiScale;
+};
+
+constexpr Viewport VIEWPORTS[] = {
+	{ 800, 600, 1.0f },
+	{ 1920, 1080, 1.5f },
+	{ 401, 401, 2.0f },
+	{ 3840, 2160, 1.25f },
+	{ 7680, 4320, 3.5f }
+};
+
+// 视口宽 8K 时一个像素约 2.4e-4 NDC，这个误差远小于光栅化的精度
+constexpr float EPSILON = 1e-6f;
+
+bool IsNear(float a, float b) noexcept {
+	return std::abs(a - b) <= EPSILON;
+}
+
+bool IsNear(const VertexPositionTexture& a, const VertexPositionTexture& b) noexcept {
+	return IsNear(a.position.x, b.position.x) && IsNear(a.position.y, b.position.y) &&
+		a.texCoord.x == b.texCoord.x && a.texCoord.y == b.texCoord.y;
+}
+
+// 引入顶点拉取之前 Renderer 中手写的顶点，作为独立的参考。squareIndex 的两位分别表示右侧和下方。
+void GetReferenceSquare(const Viewport& viewport, uint32_t squareIndex, VertexPositionTexture (&square)[4]) noexcept {
+	const float w = 200.0f * viewport.dpiScale / viewport.width * 2.0f;
+	const float h = 200.0f * viewport.dpiScale / viewport.height * 2.0f;
+
+	switch (squareIndex) {
+	case 0:
+		// 左上
+		square[0] = { { -1.0f, 1.0f }, { 0.0f, 0.0f } };
+		square[1] = { { -1.0f + w, 1.0f }, { 1.0f, 0.0f } };
+		square[2] = { { -1.0f, 1.0f - h }, { 0.0f, 1.0f } };
+		square[3] = { { -1.0f + w, 1.0f - h }, { 1.0f, 1.0f } };
+		break;
+	case 1:
+		// 右上
+		square[0] = { { 1.0f - w, 1.0f }, { 1.0f, 0.0f } };
+		square[1] = { { 1.0f, 1.0f }, { 0.0f, 0.0f } };
+		square[2] = { { 1.0f - w, 1.0f - h }, { 1.0f, 1.0f } };
+		square[3] = { { 1.0f, 1.0f - h }, { 0.0f, 1.0f } };
+		break;
+	case 2:
+		// 左下
+		square[0] = { { -1.0f, -1.0f + h }, { 0.0f, 1.0f } };
+		square[1] = { { -1.0f + w, -1.0f + h }, { 1.0f, 1.0f } };
+		square[2] = { { -1.0f, -1.0f }, { 0.0f, 0.0f } };
+		square[3] = { { -1.0f + w, -1.0f }, { 1.0f, 0.0f } };
+		break;
+	default:
+		// 右下
+		square[0] = { { 1.0f - w, -1.0f + h }, { 1.0f, 1.0f } };
+		square[1] = { { 1.0f, -1.0f + h }, { 0.0f, 1.0f } };
+		square[2] = { { 1.0f - w, -1.0f }, { 1.0f, 0.0f } };
+		square[3] = { { 1.0f, -1.0f }, { 0.0f, 0.0f } };
+		break;
+	}
+}
+
+float TriangleArea(const VertexPositionTexture& a, const VertexPositionTexture& b, const VertexPositionTexture& c) noexcept {
+	return 0.5f * std::abs((b.position.x - a.position.x) * (c.position.y - a.position.y) -
+		(c.position.x - a.position.x) * (b.position.y - a.position.y));
+}
+
+}
+
+// GetSquareVertex 和 shaders/QuadVS.hlsl 的计算相同，这里检查它和原先的顶点一致
+TEST(SceneGeometry, SquareVerticesMatchReference) {
+	for (const Viewport& viewport : VIEWPORTS) {
+		for (uint32_t square = 0; square < SceneGeometry::SQUARE_COUNT; ++square) {
+			VertexPositionTexture reference[4];
+			GetReferenceSquare(viewport, square, reference);
+
+			for (uint32_t vertex = 0; vertex < SceneGeometry::SQUARE_VERTEX_COUNT; ++vertex) {
+				const VertexPositionTexture v = SceneGeometry::GetSquareVertex(
+					vertex, square, viewport.dpiScale, viewport.width, viewport.height);
+				CHECK(IsNear(v, reference[vertex]));
+			}
+		}
+	}
+}
+
+TEST(SceneGeometry, SquaresCoverWindowCornersInPixels) {
+	for (const Viewport& viewport : VIEWPORTS) {
+		const float squareSize = SceneGeometry::SQUARE_SIZE * viewport.dpiScale;
+
+		for (uint32_t square = 0; square < SceneGeometry::SQUARE_COUNT; ++square) {
+			float left = INFINITY, right = -INFINITY, top = INFINITY, bottom = -INFINITY;
+			for (uint32_t vertex = 0; vertex < SceneGeometry::SQUARE_VERTEX_COUNT; ++vertex) {
+				const VertexPositionTexture v = SceneGeometry::GetSquareVertex(
+					vertex, square, viewport.dpiScale, viewport.width, viewport.height);
+
+				// NDC 转换为像素坐标，y 轴向下
+				const float x = (v.position.x + 1.0f) * 0.5f * viewport.width;
+				const float y = (1.0f - v.position.y) * 0.5f * viewport.height;
+				left = std::min(left, x);
+				right = std::max(right, x);
+				top = std::min(top, y);
+				bottom = std::max(bottom, y);
+
+				// 窗口的角对应纹理坐标 (0, 0)
+				const bool isWindowCorner =
+					(x < 1e-3f || x > viewport.width - 1e-3f) && (y < 1e-3f || y > viewport.height - 1e-3f);
+				if (isWindowCorner) {
+					CHECK(v.texCoord.x == 0.0f && v.texCoord.y == 0.0f);
+				}
+			}
+
+			const float expectedLeft = (square & 1) ? viewport.width - squareSize : 0.0f;
+			const float expectedTop = (square >> 1) ? viewport.height - squareSize : 0.0f;
+			CHECK(std::abs(left - expectedLeft) < 1e-3f);
+			CHECK(std::abs(top - expectedTop) < 1e-3f);
+			CHECK(std::abs(right - left - squareSize) < 1e-3f);
+			CHECK(std::abs(bottom - top - squareSize) < 1e-3f);
+		}
+	}
+}
+
+// 顶点缓冲中的三角形带和顶点拉取绘制的四个实例覆盖相同的区域
+TEST(SceneGeometry, StripMatchesInstancedSquares) {
+	for (const Viewport& viewport : VIEWPORTS) {
+		VertexPositionTexture strip[SceneGeometry::STRIP_VERTEX_COUNT];
+		SceneGeometry::GetStripVertices(viewport.dpiScale, viewport.width, viewport.height, strip);
+
+		const float squareArea = (SceneGeometry::SQUARE_SIZE * viewport.dpiScale / viewport.width * 2.0f) *
+			(SceneGeometry::SQUARE_SIZE * viewport.dpiScale / viewport.height * 2.0f);
+
+		uint32_t triangleCount = 0;
+		float totalArea = 0.0f;
+		for (uint32_t i = 0; i + 2 < SceneGeometry::STRIP_VERTEX_COUNT; ++i) {
+			const float area = TriangleArea(strip[i], strip[i + 1], strip[i + 2]);
+			if (area < squareArea * 1e-4f) {
+				// 退化三角形不产生像素
+				CHECK(area == 0.0f);
+				continue;
+			}
+
+			// 有面积的三角形的三个顶点属于同一个正方形，并且和实例化绘制的顶点相同
+			++triangleCount;
+			totalArea += area;
+
+			bool found = false;
+			for (uint32_t square = 0; square < SceneGeometry::SQUARE_COUNT && !found; ++square) {
+				uint32_t matchCount = 0;
+				for (uint32_t j = 0; j < 3; ++j) {
+					for (uint32_t vertex = 0; vertex < SceneGeometry::SQUARE_VERTEX_COUNT; ++vertex) {
+						if (IsNear(strip[i + j], SceneGeometry::GetSquareVertex(
+							vertex, square, viewport.dpiScale, viewport.width, viewport.height))) {
+							++matchCount;
+							break;
+						}
+					}
+				}
+				found = matchCount == 3;
+			}
+			CHECK(found);
+		}
+
+		// 每个正方形两个三角形
+		CHECK(triangleCount == SceneGeometry::SQUARE_COUNT * 2);
+		CHECK(std::abs(totalArea - squareArea * SceneGeometry::SQUARE_COUNT) < squareArea * 1e-4f);
+	}
+}
@@ -0,0 +1,203 @@
+#include "Test.h"
+#include "ShaderArchiveFile.h"
+#include <random>
+#include <string>
+
+namespace {
+
+std::vector<uint8_t> MakeByteCode(uint32_t size, uint32_t seed) {
+	std::vector<uint8_t> byteCode(size);
+	std::mt19937 rng(seed);
+	for (uint8_t& b : byteCode) {
+		b = uint8_t(rng());
+	}
+	return byteCode;
+}
+
+bool IsSameBytes(std::span<const uint8_t> a, std::span<const uint8_t> b) noexcept {
+	return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size()) == 0);
+}
+
+// 和 D3D12Playground 一样读取：先检查文件头和名字，再按需读取变体
+bool IsSameArchive(std::span<const uint8_t> data, std::span<const ShaderArchiveFile::Shader> shaders) noexcept {
+	if (ShaderArchiveFile::ReadHeader(data) != shaders.size()) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < (uint32_t)shaders.size(); ++i) {
+		const ShaderArchiveFile::Entry entry = ShaderArchiveFile::ReadEntry(data, i);
+		if (entry.nameHash != ShaderArchiveFile::HashName(shaders[i].name)) {
+			return false;
+		}
+
+		for (uint32_t j = 0; j < ShaderArchiveFile::VARIANT_COUNT; ++j) {
+			const ShaderArchiveFile::Variant& variant = entry.variants[j];
+			if (variant.offset % ShaderArchiveFile::ALIGNMENT != 0) {
+				return false;
+			}
+			if (!IsSameBytes(ShaderArchiveFile::ReadVariant(data, variant), shaders[i].variants[j])) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+}
+
+TEST(ShaderArchiveFile, RoundTrip) {
+	const std::vector<uint8_t> quadVS = MakeByteCode(1234, 1);
+	const std::vector<uint8_t> quadVS_SM5 = MakeByteCode(1000, 2);
+	const std::vector<uint8_t> quadCull = MakeByteCode(3, 3);
+	const std::vector<uint8_t> colorLut = MakeByteCode(4096, 4);
+	const std::vector<uint8_t> colorLut_SM5 = MakeByteCode(17, 5);
+
+	// 和 GenerateShaderList 一样，SkipSM5 的着色器没有第二个变体
+	const ShaderArchiveFile::Shader shaders[] = {
+		{ "QuadVS", { quadVS, quadVS_SM5 } },
+		{ "QuadCull_CS", { quadCull, {} } },
+		{ "ColorLut_PS", { colorLut, colorLut_SM5 } }
+	};
+
+	const std::vector<uint8_t> data = ShaderArchiveFile::Write(shaders);
+	REQUIRE(!data.empty());
+	CHECK(IsSameArchive(data, shaders));
+
+	const ShaderArchiveFile::Entry entry = ShaderArchiveFile::ReadEntry(data, 1);
+	CHECK(entry.variants[1].size == 0);
+	CHECK(ShaderArchiveFile::ReadVariant(data, entry.variants[1]).empty());
+
+	// 文件在最后一个字节码处结束
+	CHECK(data.size() == ShaderArchiveFile::ReadEntry(data, 2).variants[1].offset + colorLut_SM5.size());
+}
+
+TEST(ShaderArchiveFile, Layout) {
+	const uint8_t a[] = { 1, 2, 3 };
+	const uint8_t b[] = { 4, 5 };
+	const ShaderArchiveFile::Shader shaders[] = {
+		{ "A", { a, b } }
+	};
+
+	const std::vector<uint8_t> data = ShaderArchiveFile::Write(shaders);
+
+	// 文件头 16 字节，一个索引 40 字节，字节码从 64 开始，第二个对齐到 80
+	REQUIRE(data.size() == 82);
+	CHECK(std::memcmp(data.data(), "SHA0", 4) == 0);
+
+	uint32_t header[4];
+	std::memcpy(header, data.data(), sizeof(header));
+	CHECK(header[1] == ShaderArchiveFile::VERSION);
+	CHECK(header[2] == 1);
+	CHECK(header[3] == 0);
+
+	const ShaderArchiveFile::Entry entry = ShaderArchiveFile::ReadEntry(data, 0);
+	CHECK(entry.nameHash == Hasher::Hash("A", 1));
+	CHECK(entry.variants[0].offset == 64);
+	CHECK(entry.variants[0].size == 3);
+	CHECK(entry.variants[0].hash == Hasher::Hash(a, sizeof(a)));
+	CHECK(entry.variants[1].offset == 80);
+	CHECK(entry.variants[1].size == 2);
+
+	CHECK(std::memcmp(data.data() + 64, a, sizeof(a)) == 0);
+	CHECK(std::memcmp(data.data() + 80, b, sizeof(b)) == 0);
+	// 对齐的空隙为 0
+	for (size_t i = 67; i < 80; ++i) {
+		CHECK(data[i] == 0);
+	}
+}
+
+TEST(ShaderArchiveFile, Empty) {
+	const std::vector<uint8_t> data = ShaderArchiveFile::Write({});
+	CHECK(data.size() == ShaderArchiveFile::HEADER_SIZE);
+	// 没有着色器和无效的文件都返回 0
+	CHECK(ShaderArchiveFile::ReadHeader(data) == 0);
+}
+
+TEST(ShaderArchiveFile, RandomRoundTrip) {
+	std::mt19937 rng(11);
+	std::uniform_int_distribution<uint32_t> sizeDist(0, 300);
+
+	for (uint32_t iteration = 0; iteration < 50; ++iteration) {
+		const uint32_t shaderCount = 1 + iteration % 20;
+
+		std::vector<std::string> names(shaderCount);
+		std::vector<std::vector<uint8_t>> byteCodes(shaderCount * ShaderArchiveFile::VARIANT_COUNT);
+		std::vector<ShaderArchiveFile::Shader> shaders(shaderCount);
+		for (uint32_t i = 0; i < shaderCount; ++i) {
+			names[i] = "Shader" + std::to_string(i);
+			shaders[i].name = names[i];
+
+			for (uint32_t j = 0; j < ShaderArchiveFile::VARIANT_COUNT; ++j) {
+				// 第一个变体总是存在
+				std::vector<uint8_t>& byteCode = byteCodes[i * ShaderArchiveFile::VARIANT_COUNT + j];
+				byteCode = MakeByteCode(j == 0 ? 1 + sizeDist(rng) : sizeDist(rng), rng());
+				shaders[i].variants[j] = byteCode;
+			}
+		}
+
+		const std::vector<uint8_t> data = ShaderArchiveFile::Write(shaders);
+		REQUIRE(IsSameArchive(data, shaders));
+
+		// 相同的输入产生相同的文件，构建是确定的
+		CHECK(ShaderArchiveFile::Write(shaders) == data);
+	}
+}
+
+TEST(ShaderArchiveFile, RejectsInvalidHeader) {
+	const std::vector<uint8_t> byteCode = MakeByteCode(100, 6);
+	const ShaderArchiveFile::Shader shaders[] = {
+		{ "A", { byteCode, {} } },
+		{ "B", { byteCode, byteCode } }
+	};
+	const std::vector<uint8_t> original = ShaderArchiveFile::Write(shaders);
+	REQUIRE(ShaderArchiveFile::ReadHeader(original) == 2);
+
+	CHECK(ShaderArchiveFile::ReadHeader({}) == 0);
+	CHECK(ShaderArchiveFile::ReadHeader(std::span(original).first(ShaderArchiveFile::HEADER_SIZE - 1)) == 0);
+	// 索引不完整
+	CHECK(ShaderArchiveFile::ReadHeader(
+		std::span(original).first(ShaderArchiveFile::HEADER_SIZE + sizeof(ShaderArchiveFile::Entry) * 2 - 1)) == 0);
+
+	std::vector<uint8_t> data = original;
+	data[0] ^= 1;
+	CHECK(ShaderArchiveFile::ReadHeader(data) == 0);
+
+	data = original;
+	data[4] += 1;
+	CHECK(ShaderArchiveFile::ReadHeader(data) == 0);
+
+	// 着色器数量超出文件
+	data = original;
+	data[8] = 0xFF;
+	CHECK(ShaderArchiveFile::ReadHeader(data) == 0);
+}
+
+TEST(ShaderArchiveFile, RejectsCorruptByteCode) {
+	const std::vector<uint8_t> vs = MakeByteCode(200, 7);
+	const std::vector<uint8_t> ps = MakeByteCode(300, 8);
+	const ShaderArchiveFile::Shader shaders[] = {
+		{ "VS", { vs, {} } },
+		{ "PS", { ps, {} } }
+	};
+	std::vector<uint8_t> data = ShaderArchiveFile::Write(shaders);
+
+	const ShaderArchiveFile::Entry vsEntry = ShaderArchiveFile::ReadEntry(data, 0);
+	const ShaderArchiveFile::Entry psEntry = ShaderArchiveFile::ReadEntry(data, 1);
+
+	// 只影响损坏的变体
+	data[vsEntry.variants[0].offset + 10] ^= 0x80;
+	CHECK(ShaderArchiveFile::ReadVariant(data, vsEntry.variants[0]).empty());
+	CHECK(IsSameBytes(ShaderArchiveFile::ReadVariant(data, psEntry.variants[0]), ps));
+
+	// 截断的文件中越界的变体
+	const std::span<const uint8_t> truncated = std::span(data).first(data.size() - 1);
+	CHECK(ShaderArchiveFile::ReadVariant(truncated, psEntry.variants[0]).empty());
+
+	ShaderArchiveFile::Variant variant = psEntry.variants[0];
+	variant.offset = UINT32_MAX;
+	CHECK(ShaderArchiveFile::ReadVariant(data, variant).empty());
+	variant = psEntry.variants[0];
+	variant.size = UINT32_MAX;
+	CHECK(ShaderArchiveFile::ReadVariant(data, variant).empty());
+}
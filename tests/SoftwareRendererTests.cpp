@@ -0,0 +1,345 @@
+#include "Test.h"
+#include "SoftwareRenderer.h"
+#include "ColorKernels.h"
+#include "JobSystem.h"
+#include "QuadTextures.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+using Color = std::array<double, 3>;
+using Format = SoftwareRenderer::Format;
+using Material = SoftwareRenderer::Material;
+
+// 高度不是 TILE_HEIGHT 的倍数，最后一块只有 10 行，下方的两个正方形都在其中
+constexpr uint32_t WIDTH = 160;
+constexpr uint32_t HEIGHT = 90;
+static_assert(HEIGHT % SoftwareRenderer::TILE_HEIGHT != 0);
+
+constexpr float SQUARE_SIZE = 32;
+constexpr std::array<float, 3> CLEAR_COLOR = { 0.05f, 0.1f, 0.2f };
+
+constexpr uint32_t TEXTURE = 2;
+
+// shaders/sRGB_PS.hlsl，QuadGradient_PS.hlsl 在所有颜色模式下也使用
+constexpr Color SRGB_CORNERS[4] = { { 0, 0, 1 }, { 0.5, 0, 0.5 }, { 0, 1, 0 }, { 1, 0, 0 } };
+
+Color GetP3Primary(uint32_t index) {
+	const ColorKernels::Matrix3x3& matrix = ColorKernels::P3_TO_BT709;
+	return { matrix.m[0][index], matrix.m[1][index], matrix.m[2][index] };
+}
+
+// 双线性渐变，四个角依次为 uv 为 (0, 0)、(1, 0)、(0, 1)、(1, 1) 处的颜色
+Color EvaluateGradient(const Color (&corners)[4], double u, double v) {
+	Color result;
+	for (uint32_t c = 0; c < 3; ++c) {
+		const double left = corners[0][c] + (corners[2][c] - corners[0][c]) * v;
+		const double right = corners[1][c] + (corners[3][c] - corners[1][c]) * v;
+		result[c] = left + (right - left) * u;
+	}
+	return result;
+}
+
+// shaders/AdvancedColor_PS.hlsl
+Color EvaluateSceneGradient(Format format, double u, double v) {
+	if (format == Format::R8G8B8A8_UNORM_SRGB) {
+		return EvaluateGradient(SRGB_CORNERS, u, v);
+	}
+
+	const Color blue = GetP3Primary(2);
+	const Color red = GetP3Primary(0);
+	const Color corners[4] = {
+		blue,
+		{ (red[0] + blue[0]) / 2, (red[1] + blue[1]) / 2, (red[2] + blue[2]) / 2 },
+		GetP3Primary(1),
+		red
+	};
+	return EvaluateGradient(corners, u, v);
+}
+
+Color Multiply(const Color& color, double scale) {
+	return { color[0] * scale, color[1] * scale, color[2] * scale };
+}
+
+// 和 QuadBatcher 一样量化为 8 位
+double Quantize(float value) {
+	return std::round(value * 255.0) / 255.0;
+}
+
+Color GetTextureColor(uint32_t texture) {
+	const uint32_t color = QuadTextures::COLORS[texture];
+	Color result;
+	for (uint32_t c = 0; c < 3; ++c) {
+		const double value = ((color >> (8 * c)) & 0xFF) / 255.0;
+		result[c] = value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+	}
+	return result;
+}
+
+// 内置场景的简化版：每种材质都有，同一材质内后提交的覆盖先提交的，Gradient 虽然先提交但覆盖
+// Solid，Textured 的四边形超出帧的底部。
+void AddQuads(SoftwareRenderer& renderer) {
+	renderer.AddQuad(Material::Gradient, { 70, 25, 40, 40, { 1.0f, 1.0f, 1.0f } });
+	renderer.AddQuad(Material::Solid, { 40, 10, 30, 20, { 1.0f, 0.5f, 0.25f } });
+	renderer.AddQuad(Material::Solid, { 60, 20, 20, 20, { 0.0f, 1.0f, 0.0f } });
+	// 像素中心在 [35.5, 37.5) 和 [60.5, 62.5) 内，覆盖 2x2 个像素
+	renderer.AddQuad(Material::Solid, { 35.5f, 60.5f, 2, 2, { 0.0f, 0.0f, 1.0f } });
+	// 每个像素中心恰好是一个纹素的中心
+	renderer.AddQuad(Material::Textured, { 64, 50, 64, 64, { 1.0f, 0.5f, 1.0f }, TEXTURE });
+}
+
+SoftwareRenderer::Frame MakeFrame(Format format, float boost) {
+	return {
+		.width = WIDTH,
+		.height = HEIGHT,
+		.format = format,
+		.squareSize = SQUARE_SIZE,
+		.clearColor = CLEAR_COLOR,
+		.boost = boost
+	};
+}
+
+struct Spot {
+	uint32_t x;
+	uint32_t y;
+	// 线性颜色，已乘以 boost
+	Color color;
+};
+
+// 各个图元中抽取的像素，以及它们的期望值
+std::vector<Spot> GetSpots(Format format, double boost) {
+	const Color clearColor = { CLEAR_COLOR[0], CLEAR_COLOR[1], CLEAR_COLOR[2] };
+	const auto square = [&](double u, double v) {
+		return Multiply(EvaluateSceneGradient(format, u, v), boost);
+	};
+	const auto solid = [&](float r, float g, float b) {
+		return Multiply({ Quantize(r), Quantize(g), Quantize(b) }, boost);
+	};
+
+	const Color textureColor = GetTextureColor(TEXTURE);
+	const Color tint = { 1.0, Quantize(0.5f), 1.0 };
+
+	return {
+		// 清屏颜色不乘以 boost
+		{ 150, 45, clearColor },
+		{ 35, 5, clearColor },
+		// 四个角的正方形，右侧和下方的镜像，窗口的角都是 uv 为 (0, 0)
+		{ 0, 0, square(0.5 / 32, 0.5 / 32) },
+		{ 159, 0, square(0.5 / 32, 0.5 / 32) },
+		{ 0, 89, square(0.5 / 32, 0.5 / 32) },
+		{ 159, 89, square(0.5 / 32, 0.5 / 32) },
+		{ 10, 70, square(10.5 / 32, 1 - 12.5 / 32) },
+		{ 140, 20, square(1 - 12.5 / 32, 20.5 / 32) },
+		{ 31, 31, square(31.5 / 32, 31.5 / 32) },
+		{ 32, 31, clearColor },
+		// Solid，同一材质后提交的在上面
+		{ 45, 15, solid(1.0f, 0.5f, 0.25f) },
+		{ 65, 25, solid(0.0f, 1.0f, 0.0f) },
+		{ 79, 22, solid(0.0f, 1.0f, 0.0f) },
+		{ 80, 22, clearColor },
+		// 不在像素边界上的四边形
+		{ 35, 60, solid(0.0f, 0.0f, 1.0f) },
+		{ 36, 61, solid(0.0f, 0.0f, 1.0f) },
+		{ 34, 60, clearColor },
+		{ 37, 60, clearColor },
+		{ 35, 62, clearColor },
+		// Gradient 覆盖 Solid，在所有颜色模式下都是 sRGB 的渐变
+		{ 75, 30, Multiply(EvaluateGradient(SRGB_CORNERS, 5.5 / 40, 5.5 / 40), boost) },
+		{ 109, 49, Multiply(EvaluateGradient(SRGB_CORNERS, 39.5 / 40, 24.5 / 40), boost) },
+		// Textured，纹素 (3, 3) 是彩色，(11, 3) 是白色。覆盖 Gradient 且被帧的底部截断。
+		{ 67, 53, Multiply({ textureColor[0] * tint[0], textureColor[1] * tint[1], textureColor[2] * tint[2] }, boost) },
+		{ 75, 53, Multiply(tint, boost) },
+		{ 108, 89, Multiply(tint, boost) },
+		{ 64, 89, Multiply({ textureColor[0] * tint[0], textureColor[1] * tint[1], textureColor[2] * tint[2] }, boost) }
+	};
+}
+
+double LinearToSRGB(double value) {
+	value = std::clamp(value, 0.0, 1.0);
+	return value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1 / 2.4) - 0.055;
+}
+
+double LinearToPQ(double value) {
+	constexpr double m1 = 2610.0 / 16384;
+	constexpr double m2 = 2523.0 / 4096 * 128;
+	constexpr double c1 = 3424.0 / 4096;
+	constexpr double c2 = 2413.0 / 4096 * 32;
+	constexpr double c3 = 2392.0 / 4096 * 32;
+
+	const double y = std::pow(std::clamp(value, 0.0, 1.0), m1);
+	return std::pow((c1 + c2 * y) / (1 + c3 * y), m2);
+}
+
+// HDR10 的编码值：转换到 BT.2020 再以 PQ 编码
+Color EncodeHDR10(const Color& color) {
+	const ColorKernels::Matrix3x3& matrix = ColorKernels::BT709_TO_BT2020;
+	Color result;
+	for (uint32_t c = 0; c < 3; ++c) {
+		const double value = matrix.m[c][0] * color[0] + matrix.m[c][1] * color[1] + matrix.m[c][2] * color[2];
+		result[c] = LinearToPQ(value * ColorKernels::SCRGB_WHITE_NITS / ColorKernels::PQ_MAX_NITS);
+	}
+	return result;
+}
+
+struct Image {
+	std::vector<uint8_t> data;
+	size_t rowPitch;
+};
+
+// 每行末尾有填充，检查不越界写入
+constexpr size_t ROW_PADDING = 16;
+constexpr uint8_t PADDING_VALUE = 0xCD;
+
+Image Render(JobSystem& jobSystem, Format format, float boost) {
+	const SoftwareRenderer::Frame frame = MakeFrame(format, boost);
+	Image image;
+	image.rowPitch = (size_t)WIDTH * SoftwareRenderer::GetBytesPerPixel(format) + ROW_PADDING;
+	image.data.assign(image.rowPitch * HEIGHT, PADDING_VALUE);
+
+	SoftwareRenderer renderer;
+	AddQuads(renderer);
+	renderer.Render(jobSystem, frame, image.data.data(), image.rowPitch);
+	return image;
+}
+
+// 逐行检查填充未被改动，再和串行渲染每一块的结果逐字节比较，没有写入的行两者不同
+void CheckTiles(const Image& image, Format format, float boost) {
+	const size_t rowBytes = image.rowPitch - ROW_PADDING;
+	for (uint32_t y = 0; y < HEIGHT; ++y) {
+		const uint8_t* padding = image.data.data() + image.rowPitch * y + rowBytes;
+		CHECK(std::all_of(padding, padding + ROW_PADDING, [](uint8_t value) { return value == PADDING_VALUE; }));
+	}
+
+	const SoftwareRenderer::Frame frame = MakeFrame(format, boost);
+	CHECK(SoftwareRenderer::GetTileCount(frame) == HEIGHT / SoftwareRenderer::TILE_HEIGHT + 1);
+
+	std::vector<uint8_t> serial(image.data.size(), 0);
+	SoftwareRenderer renderer;
+	AddQuads(renderer);
+	for (uint32_t i = 0; i < SoftwareRenderer::GetTileCount(frame); ++i) {
+		renderer.RenderTile(frame, i, serial.data(), image.rowPitch);
+	}
+
+	for (uint32_t y = 0; y < HEIGHT; ++y) {
+		CHECK(std::memcmp(serial.data() + image.rowPitch * y, image.data.data() + image.rowPitch * y, rowBytes) == 0);
+	}
+}
+
+template <typename T>
+T ReadPixel(const Image& image, uint32_t x, uint32_t y) {
+	T pixel;
+	std::memcpy(&pixel, image.data.data() + image.rowPitch * y + sizeof(T) * x, sizeof(T));
+	return pixel;
+}
+
+}
+
+TEST(SoftwareRenderer, SDRGoldenImage) {
+	JobSystem jobSystem;
+	REQUIRE(jobSystem.Initialize());
+
+	const Image image = Render(jobSystem, Format::R8G8B8A8_UNORM_SRGB, 1.0f);
+	CheckTiles(image, Format::R8G8B8A8_UNORM_SRGB, 1.0f);
+
+	// 8 位 sRGB 编码，允许相差 1
+	uint32_t maxError = 0;
+	for (const Spot& spot : GetSpots(Format::R8G8B8A8_UNORM_SRGB, 1.0)) {
+		const uint32_t pixel = ReadPixel<uint32_t>(image, spot.x, spot.y);
+		CHECK(pixel >> 24 == 0xFF);
+		for (uint32_t c = 0; c < 3; ++c) {
+			const int32_t expected = (int32_t)std::lround(LinearToSRGB(spot.color[c]) * 255);
+			const uint32_t error = (uint32_t)std::abs((int32_t)((pixel >> (8 * c)) & 0xFF) - expected);
+			CHECK(error <= 1);
+			maxError = std::max(maxError, error);
+		}
+	}
+	std::printf("    最大相差 %u 个编码值\n", maxError);
+}
+
+TEST(SoftwareRenderer, ScRGBGoldenImage) {
+	JobSystem jobSystem;
+	REQUIRE(jobSystem.Initialize());
+
+	// HDR 下正方形和四边形乘以 boost，P3 的渐变超出 sRGB 色域，有负值
+	constexpr float BOOST = 2.5f;
+	const Image image = Render(jobSystem, Format::R16G16B16A16_FLOAT, BOOST);
+	CheckTiles(image, Format::R16G16B16A16_FLOAT, BOOST);
+
+	const std::vector<Spot> spots = GetSpots(Format::R16G16B16A16_FLOAT, BOOST);
+	double maxError = 0;
+	for (const Spot& spot : spots) {
+		const auto pixel = ReadPixel<std::array<uint16_t, 4>>(image, spot.x, spot.y);
+		float channels[4][1];
+		float* const dst[3] = { channels[0], channels[1], channels[2] };
+		ColorKernels::UnpackHalf(pixel.data(), dst, 1);
+
+		// 半精度有 11 位有效数字
+		for (uint32_t c = 0; c < 3; ++c) {
+			const double error = std::abs(channels[c][0] - spot.color[c]);
+			CHECK(error <= std::abs(spot.color[c]) * 1e-3 + 1e-5);
+			maxError = std::max(maxError, error);
+		}
+		// alpha 为 1
+		CHECK(pixel[3] == 0x3C00);
+	}
+	std::printf("    最大误差 %.2e\n", maxError);
+
+	// 左上角正方形的内角接近 P3 的红色，绿色在 scRGB 中为负
+	const auto corner = ReadPixel<std::array<uint16_t, 4>>(image, 31, 31);
+	CHECK((corner[1] & 0x8000) != 0);
+}
+
+TEST(SoftwareRenderer, HDR10GoldenImage) {
+	JobSystem jobSystem;
+	REQUIRE(jobSystem.Initialize());
+
+	constexpr float BOOST = 2.5f;
+	const Image image = Render(jobSystem, Format::R10G10B10A2_UNORM, BOOST);
+	CheckTiles(image, Format::R10G10B10A2_UNORM, BOOST);
+
+	// 10 位 PQ 编码，允许相差 1
+	uint32_t maxError = 0;
+	for (const Spot& spot : GetSpots(Format::R10G10B10A2_UNORM, BOOST)) {
+		const uint32_t pixel = ReadPixel<uint32_t>(image, spot.x, spot.y);
+		CHECK(pixel >> 30 == 3);
+
+		const Color expected = EncodeHDR10(spot.color);
+		for (uint32_t c = 0; c < 3; ++c) {
+			const int32_t code = (int32_t)((pixel >> (10 * c)) & 0x3FF);
+			const uint32_t error = (uint32_t)std::abs(code - (int32_t)std::lround(expected[c] * 1023));
+			CHECK(error <= 1);
+			maxError = std::max(maxError, error);
+		}
+	}
+	std::printf("    最大相差 %u 个编码值\n", maxError);
+}
+
+TEST(SoftwareRenderer, RenderClearsQuads) {
+	JobSystem jobSystem;
+	REQUIRE(jobSystem.Initialize());
+
+	const SoftwareRenderer::Frame frame = MakeFrame(Format::R8G8B8A8_UNORM_SRGB, 1.0f);
+	const size_t rowPitch = (size_t)WIDTH * 4;
+	std::vector<uint8_t> first(rowPitch * HEIGHT);
+	std::vector<uint8_t> second(rowPitch * HEIGHT);
+
+	SoftwareRenderer renderer;
+	AddQuads(renderer);
+	renderer.Render(jobSystem, frame, first.data(), rowPitch);
+	// 第二帧没有提交四边形，只有清屏颜色和正方形
+	renderer.Render(jobSystem, frame, second.data(), rowPitch);
+
+	const auto readPixel = [&](const std::vector<uint8_t>& data, uint32_t x, uint32_t y) {
+		uint32_t pixel;
+		std::memcpy(&pixel, data.data() + rowPitch * y + 4 * x, 4);
+		return pixel;
+	};
+	CHECK(readPixel(first, 45, 15) != readPixel(second, 45, 15));
+	CHECK(readPixel(second, 45, 15) == readPixel(second, 150, 45));
+	CHECK(readPixel(first, 67, 53) != readPixel(second, 67, 53));
+
+	// 正方形不变
+	CHECK(std::memcmp(first.data(), second.data(), 4 * 32) == 0);
+}
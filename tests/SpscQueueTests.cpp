@@ -0,0 +1,93 @@
+#include "Test.h"
+#include "SpscQueue.h"
+#include <thread>
+
+TEST(SpscQueue, FifoAndCapacity) {
+	SpscQueue<int, 4> queue;
+
+	int value;
+	CHECK(!queue.TryPop(value));
+
+	for (int i = 0; i < 4; ++i) {
+		CHECK(queue.TryPush(i));
+	}
+	// 已满
+	CHECK(!queue.TryPush(4));
+
+	CHECK(queue.TryPop(value) && value == 0);
+	CHECK(queue.TryPush(4));
+	CHECK(!queue.TryPush(5));
+
+	for (int i = 1; i <= 4; ++i) {
+		CHECK(queue.TryPop(value) && value == i);
+	}
+	CHECK(!queue.TryPop(value));
+}
+
+TEST(SpscQueue, WrapsAroundManyTimes) {
+	SpscQueue<uint32_t, 8> queue;
+
+	// 每轮推入的数量和容量互质，位置在数组中不断错开
+	uint32_t next = 0;
+	uint32_t expected = 0;
+	for (int round = 0; round < 1000; ++round) {
+		for (int i = 0; i < 5; ++i) {
+			CHECK(queue.TryPush(next++));
+		}
+
+		uint32_t value;
+		while (queue.TryPop(value)) {
+			CHECK(value == expected++);
+		}
+	}
+	CHECK(expected == next);
+}
+
+namespace {
+
+// 多个字段，检查消费者看到的是生产者完整写入的值
+struct Payload {
+	uint32_t sequence;
+	uint32_t checksum;
+	float values[4];
+};
+
+}
+
+// 在 ThreadSanitizer 下运行时也检查数据竞争
+TEST(SpscQueue, ProducerConsumerThreads) {
+	constexpr uint32_t COUNT = 200000;
+	SpscQueue<Payload, 64> queue;
+
+	std::thread producer([&] {
+		for (uint32_t i = 0; i < COUNT; ++i) {
+			const Payload payload = {
+				.sequence = i,
+				.checksum = i * 2654435761u,
+				.values = { (float)i, (float)i + 1, (float)i + 2, (float)i + 3 }
+			};
+			while (!queue.TryPush(payload)) {
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	uint32_t errorCount = 0;
+	for (uint32_t i = 0; i < COUNT; ++i) {
+		Payload payload;
+		while (!queue.TryPop(payload)) {
+			std::this_thread::yield();
+		}
+
+		if (payload.sequence != i || payload.checksum != i * 2654435761u ||
+			payload.values[0] != (float)i || payload.values[3] != (float)i + 3) {
+			++errorCount;
+		}
+	}
+
+	producer.join();
+
+	CHECK(errorCount == 0);
+	Payload payload;
+	CHECK(!queue.TryPop(payload));
+}
@@ -0,0 +1,150 @@
+#include "Test.h"
+#include "SpscQueue.h"
+#include "SyncHandshake.h"
+#include <thread>
+
+TEST(SyncHandshake, RequestsMergeIntoLatest) {
+	SyncHandshake handshake;
+
+	const uint64_t first = handshake.Begin();
+	const uint64_t second = handshake.Begin();
+	CHECK(second > first);
+	CHECK(!handshake.IsPending());
+	CHECK(!handshake.IsCompleted(first));
+
+	// 渲染线程一次处理了两个事件，只渲染一帧
+	handshake.Request(second);
+	handshake.Request(first);
+	CHECK(handshake.IsPending());
+	CHECK(!handshake.IsCompleted(first));
+
+	handshake.Complete();
+	CHECK(!handshake.IsPending());
+	CHECK(handshake.IsCompleted(first));
+	CHECK(handshake.IsCompleted(second));
+
+	const uint64_t third = handshake.Begin();
+	CHECK(!handshake.IsCompleted(third));
+}
+
+TEST(SyncHandshake, AbandonCompletesEverything) {
+	SyncHandshake handshake;
+
+	const uint64_t syncId = handshake.Begin();
+	handshake.Request(syncId);
+	handshake.Abandon();
+
+	CHECK(!handshake.IsPending());
+	CHECK(handshake.IsCompleted(syncId));
+	CHECK(handshake.IsCompleted(handshake.Begin()));
+}
+
+namespace {
+
+enum class EventType {
+	Resized,
+	DpiChanged,
+	Exit
+};
+
+struct Event {
+	EventType type;
+	uint32_t width;
+	uint64_t syncId;
+};
+
+}
+
+// 模拟 RenderThread：UI 线程通过队列发送事件，调整尺寸时等待渲染线程用新尺寸渲染一帧。
+// 渲染线程在同步点写入的 syncedWidth 不是原子的，由握手保证可见性，ThreadSanitizer 下检查
+// 数据竞争。
+TEST(SyncHandshake, ResizeWaitsForNewFrame) {
+	constexpr uint32_t RESIZE_COUNT = 5000;
+
+	SpscQueue<Event, 8> eventQueue;
+	SyncHandshake handshake;
+	uint32_t syncedWidth = 0;
+	uint32_t frameCount = 0;
+
+	// 第一个同步点是初始化完成，在启动线程前请求
+	const uint64_t initSyncId = handshake.Begin();
+	handshake.Request(initSyncId);
+
+	std::thread renderThread([&] {
+		uint32_t width = 100;
+
+		// 初始化
+		syncedWidth = width;
+		handshake.Complete();
+
+		while (true) {
+			Event event;
+			bool exit = false;
+			while (eventQueue.TryPop(event)) {
+				if (event.type == EventType::Resized) {
+					width = event.width;
+					handshake.Request(event.syncId);
+				} else if (event.type == EventType::Exit) {
+					exit = true;
+					break;
+				}
+			}
+
+			if (exit) {
+				break;
+			}
+
+			// 渲染一帧
+			const uint32_t renderedWidth = width;
+			++frameCount;
+
+			if (handshake.IsPending()) {
+				// UI 线程读取之后才会发送下一个调整尺寸的事件，因此这里不会和它竞争
+				syncedWidth = renderedWidth;
+				handshake.Complete();
+			} else {
+				std::this_thread::yield();
+			}
+		}
+
+		handshake.Abandon();
+	});
+
+	auto postEvent = [&](const Event& event) {
+		while (!eventQueue.TryPush(event)) {
+			std::this_thread::yield();
+		}
+	};
+
+	while (!handshake.IsCompleted(initSyncId)) {
+		std::this_thread::yield();
+	}
+	CHECK(syncedWidth == 100);
+
+	uint32_t errorCount = 0;
+	for (uint32_t i = 0; i < RESIZE_COUNT; ++i) {
+		// 不需要同步的事件穿插其中
+		postEvent({ .type = EventType::DpiChanged });
+
+		const uint32_t width = 200 + i;
+		const uint64_t syncId = handshake.Begin();
+		postEvent({ .type = EventType::Resized, .width = width, .syncId = syncId });
+
+		while (!handshake.IsCompleted(syncId)) {
+			std::this_thread::yield();
+		}
+
+		// 同步点完成时已经用新尺寸渲染过
+		if (syncedWidth != width) {
+			++errorCount;
+		}
+	}
+
+	postEvent({ .type = EventType::Exit });
+	renderThread.join();
+
+	CHECK(errorCount == 0);
+	CHECK(frameCount >= RESIZE_COUNT);
+	// 渲染线程退出后不会再阻塞 UI 线程
+	CHECK(handshake.IsCompleted(handshake.Begin()));
+}
@@ -0,0 +1,46 @@
+#pragma once
+// 测试不使用预编译头，这里包含被测头文件依赖的标准库
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+#include <vector>
+
+// 极简的测试框架。TEST 定义的测试在静态初始化时注册，main 按名称前缀筛选后依次运行。
+namespace Test {
+
+struct TestCase {
+	const char* suite;
+	const char* name;
+	void (*func)();
+};
+
+std::vector<TestCase>& GetTestCases() noexcept;
+
+// 记录当前测试失败，测试继续运行
+void ReportFailure(const char* file, int line, const char* expr) noexcept;
+
+struct Registrar {
+	Registrar(const char* suite, const char* name, void (*func)()) noexcept {
+		GetTestCases().push_back({ suite, name, func });
+	}
+};
+
+}
+
+#define TEST(suite, name) \
+	static void suite##_##name##_Test(); \
+	static const Test::Registrar suite##_##name##_Registrar(#suite, #name, suite##_##name##_Test); \
+	static void suite##_##name##_Test()
+
+#define CHECK(expr) ((expr) ? (void)0 : Test::ReportFailure(__FILE__, __LINE__, #expr))
+
+// 失败时结束当前测试，用于后续检查依赖这个条件的场合
+#define REQUIRE(expr) \
+	do { \
+		if (!(expr)) { \
+			Test::ReportFailure(__FILE__, __LINE__, #expr); \
+			return; \
+		} \
+	} while (false)
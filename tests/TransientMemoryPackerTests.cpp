@@ -0,0 +1,236 @@
+#include "Test.h"
+#include "TransientMemoryPacker.h"
+#include <random>
+
+namespace {
+
+using Item = TransientMemoryPacker::Item;
+
+// D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT
+constexpr uint64_t PLACEMENT_ALIGNMENT = 65536;
+
+bool IsLifetimeOverlapping(const Item& a, const Item& b) noexcept {
+	return a.firstPosition <= b.lastPosition && b.firstPosition <= a.lastPosition;
+}
+
+// 检查偏移对齐、不超出 peakSize，生命周期重叠的资源内存不重叠，别名标记和实际一致
+bool IsValidPacking(const TransientMemoryPacker& packer, std::span<const Item> items) noexcept {
+	const uint32_t count = (uint32_t)items.size();
+	std::vector<bool> isAliased(count);
+
+	for (uint32_t i = 0; i < count; ++i) {
+		const uint64_t offset = packer.GetOffset(i);
+		if (offset % items[i].alignment != 0 || offset + items[i].size > packer.GetStats().peakSize) {
+			return false;
+		}
+
+		for (uint32_t j = i + 1; j < count; ++j) {
+			const uint64_t otherOffset = packer.GetOffset(j);
+			if (offset < otherOffset + items[j].size && otherOffset < offset + items[i].size) {
+				if (IsLifetimeOverlapping(items[i], items[j])) {
+					return false;
+				}
+				isAliased[i] = true;
+				isAliased[j] = true;
+			}
+		}
+	}
+
+	uint32_t aliasedCount = 0;
+	for (uint32_t i = 0; i < count; ++i) {
+		if (packer.IsAliased(i) != isAliased[i]) {
+			return false;
+		}
+		aliasedCount += isAliased[i];
+	}
+
+	return aliasedCount == packer.GetStats().aliasedCount;
+}
+
+void PrintStats(const char* name, const TransientMemoryPacker::Stats& stats) noexcept {
+	std::printf("    %s：%llu KB -> %llu KB（%.0f%%），%u 个资源共享内存\n", name,
+		(unsigned long long)stats.naiveSize / 1024, (unsigned long long)stats.peakSize / 1024,
+		stats.peakSize * 100.0 / stats.naiveSize, stats.aliasedCount);
+}
+
+}
+
+TEST(TransientMemoryPacker, Empty) {
+	TransientMemoryPacker packer;
+	CHECK(packer.Pack({}) == 0);
+	CHECK(packer.GetStats().peakSize == 0);
+	CHECK(packer.GetStats().naiveSize == 0);
+	CHECK(packer.GetStats().aliasedCount == 0);
+}
+
+TEST(TransientMemoryPacker, DisjointLifetimesShareMemory) {
+	const Item items[] = {
+		{ 100, 4, 0, 1 },
+		{ 300, 4, 2, 3 },
+		{ 200, 4, 4, 4 }
+	};
+
+	TransientMemoryPacker packer;
+	CHECK(packer.Pack(items) == 300);
+	CHECK(packer.GetStats().naiveSize == 600);
+	CHECK(packer.GetStats().aliasedCount == 3);
+
+	for (uint32_t i = 0; i < 3; ++i) {
+		CHECK(packer.GetOffset(i) == 0);
+		CHECK(packer.IsAliased(i));
+	}
+	CHECK(IsValidPacking(packer, items));
+}
+
+TEST(TransientMemoryPacker, OverlappingLifetimesDoNotShare) {
+	// 首尾都包含在内，位置 2 上三个资源同时存活
+	const Item items[] = {
+		{ 100, 4, 0, 2 },
+		{ 100, 4, 2, 3 },
+		{ 100, 4, 1, 2 }
+	};
+
+	TransientMemoryPacker packer;
+	CHECK(packer.Pack(items) == 300);
+	CHECK(packer.GetStats().naiveSize == 300);
+	CHECK(packer.GetStats().aliasedCount == 0);
+	CHECK(IsValidPacking(packer, items));
+}
+
+TEST(TransientMemoryPacker, SmallItemsFillGaps) {
+	// 1 和 0 重叠，放在 0 之后。2 和 3 在 0 结束后存活，填进 0 留下的空隙。
+	const Item items[] = {
+		{ 400, 4, 0, 1 },
+		{ 300, 4, 0, 3 },
+		{ 200, 4, 2, 3 },
+		{ 100, 4, 2, 3 }
+	};
+
+	TransientMemoryPacker packer;
+	CHECK(packer.Pack(items) == 700);
+	CHECK(packer.GetStats().naiveSize == 1000);
+	CHECK(packer.GetOffset(0) == 0);
+	CHECK(packer.GetOffset(1) == 400);
+	CHECK(packer.GetOffset(2) == 0);
+	CHECK(packer.GetOffset(3) == 200);
+	CHECK(packer.GetStats().aliasedCount == 3);
+	CHECK(!packer.IsAliased(1));
+	CHECK(IsValidPacking(packer, items));
+}
+
+TEST(TransientMemoryPacker, RespectsAlignment) {
+	const Item items[] = {
+		{ 10, 1, 0, 0 },
+		{ 10, 64, 0, 0 },
+		{ 10, 16, 0, 0 },
+		{ 1000, 256, 0, 0 }
+	};
+
+	TransientMemoryPacker packer;
+	packer.Pack(items);
+	CHECK(IsValidPacking(packer, items));
+	CHECK(packer.GetStats().aliasedCount == 0);
+	// 先放最大的，其余依次排列在对齐后的位置
+	CHECK(packer.GetOffset(3) == 0);
+	CHECK(packer.GetOffset(0) == 1000);
+	CHECK(packer.GetOffset(1) == 1024);
+	CHECK(packer.GetOffset(2) == 1040);
+	CHECK(packer.GetStats().peakSize == 1050);
+	CHECK(packer.GetStats().naiveSize == 1050);
+}
+
+TEST(TransientMemoryPacker, NeverWorseThanNaive) {
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<uint32_t> positionDist(0, 31);
+	std::uniform_int_distribution<uint32_t> sizeDist(1, 1 << 20);
+	std::uniform_int_distribution<uint32_t> alignmentLog2Dist(0, 16);
+
+	TransientMemoryPacker packer;
+	std::vector<Item> items;
+
+	for (uint32_t iteration = 0; iteration < 200; ++iteration) {
+		items.resize(1 + iteration % 40);
+		for (Item& item : items) {
+			const uint32_t a = positionDist(rng);
+			const uint32_t b = positionDist(rng);
+			item = {
+				.size = sizeDist(rng),
+				.alignment = 1ull << alignmentLog2Dist(rng),
+				.firstPosition = std::min(a, b),
+				.lastPosition = std::max(a, b)
+			};
+		}
+
+		const uint64_t peakSize = packer.Pack(items);
+		REQUIRE(IsValidPacking(packer, items));
+		CHECK(peakSize <= packer.GetStats().naiveSize);
+
+		// 相同的输入产生相同的结果
+		std::vector<uint64_t> offsets(items.size());
+		for (uint32_t i = 0; i < (uint32_t)items.size(); ++i) {
+			offsets[i] = packer.GetOffset(i);
+		}
+		CHECK(packer.Pack(items) == peakSize);
+		for (uint32_t i = 0; i < (uint32_t)items.size(); ++i) {
+			CHECK(packer.GetOffset(i) == offsets[i]);
+		}
+	}
+}
+
+// 和 TransientResourceAllocator::EstimateSavings 相同的后处理链：场景一直存活到最后合成，
+// 每个 pass 读取上一个 pass 的输出。任意时刻最多存活场景和两个中间纹理。
+TEST(TransientMemoryPacker, PostProcessChain) {
+	constexpr uint32_t PASS_COUNT = 8;
+	constexpr uint64_t TEXTURE_SIZE = 3840ull * 2160 * 8;
+
+	std::vector<Item> items;
+	items.push_back({ TEXTURE_SIZE, PLACEMENT_ALIGNMENT, 0, PASS_COUNT + 1 });
+	for (uint32_t i = 0; i < PASS_COUNT; ++i) {
+		items.push_back({ TEXTURE_SIZE, PLACEMENT_ALIGNMENT, i + 1, i + 2 });
+	}
+
+	TransientMemoryPacker packer;
+	packer.Pack(items);
+	REQUIRE(IsValidPacking(packer, items));
+
+	const TransientMemoryPacker::Stats& stats = packer.GetStats();
+	const uint64_t alignedSize = (TEXTURE_SIZE + PLACEMENT_ALIGNMENT - 1) & ~(PLACEMENT_ALIGNMENT - 1);
+	CHECK(stats.peakSize == alignedSize * 2 + TEXTURE_SIZE);
+	CHECK(stats.naiveSize == alignedSize * PASS_COUNT + TEXTURE_SIZE);
+	// 场景不和其他纹理共享
+	CHECK(!packer.IsAliased(0));
+	CHECK(stats.aliasedCount == PASS_COUNT);
+	PrintStats("4K 后处理链", stats);
+}
+
+// 多种尺寸的纹理，生命周期长短不一，模拟更接近实际的帧
+TEST(TransientMemoryPacker, MixedFrame) {
+	constexpr uint64_t MB = 1024 * 1024;
+	const Item items[] = {
+		// GBuffer
+		{ 64 * MB, PLACEMENT_ALIGNMENT, 0, 3 },
+		{ 32 * MB, PLACEMENT_ALIGNMENT, 0, 3 },
+		{ 32 * MB, PLACEMENT_ALIGNMENT, 0, 3 },
+		// 阴影
+		{ 16 * MB, PLACEMENT_ALIGNMENT, 1, 2 },
+		// 光照结果
+		{ 64 * MB, PLACEMENT_ALIGNMENT, 3, 6 },
+		// 泛光的降采样链
+		{ 16 * MB, PLACEMENT_ALIGNMENT, 4, 5 },
+		{ 4 * MB, PLACEMENT_ALIGNMENT, 5, 6 },
+		{ 1 * MB, PLACEMENT_ALIGNMENT, 6, 7 },
+		// 色调映射
+		{ 32 * MB, PLACEMENT_ALIGNMENT, 7, 8 }
+	};
+
+	TransientMemoryPacker packer;
+	packer.Pack(items);
+	REQUIRE(IsValidPacking(packer, items));
+
+	const TransientMemoryPacker::Stats& stats = packer.GetStats();
+	CHECK(stats.naiveSize == 261 * MB);
+	// 位置 3 上 GBuffer 和光照结果同时存活，至少需要 192MB
+	CHECK(stats.peakSize >= 192 * MB);
+	CHECK(stats.peakSize < stats.naiveSize);
+	PrintStats("混合帧", stats);
+}
@@ -0,0 +1,107 @@
+#include "pch.h"
+#include "Test.h"
+#include "WaitMultiplexer.h"
+
+namespace {
+
+// 模拟的 MsgWaitForMultipleObjectsEx，返回预设的结果并记录参数
+struct FakeWait {
+	DWORD result = WAIT_TIMEOUT;
+	std::vector<HANDLE> handles;
+	DWORD timeout = 0;
+	uint32_t callCount = 0;
+};
+
+FakeWait fakeWait;
+
+DWORD FakeWaitFunc(DWORD count, const HANDLE* handles, DWORD timeout) {
+	fakeWait.handles.assign(handles, handles + count);
+	fakeWait.timeout = timeout;
+	++fakeWait.callCount;
+	return fakeWait.result;
+}
+
+HANDLE MakeHandle(uintptr_t value) {
+	return (HANDLE)value;
+}
+
+// 和渲染线程相同的布局：唤醒事件没有回调，之后是帧延迟句柄和 GPU 的帧句柄
+struct RenderWait {
+	WaitMultiplexer waitMultiplexer{ FakeWaitFunc };
+	uint32_t frameLatencyCount = 0;
+
+	RenderWait() {
+		fakeWait = {};
+		waitMultiplexer.Add(MakeHandle(1));
+		waitMultiplexer.Add(MakeHandle(2), [this]() { ++frameLatencyCount; });
+		waitMultiplexer.Add(MakeHandle(3));
+	}
+};
+
+}
+
+TEST(WaitMultiplexer, FrameLatencyHandleRunsCallback) {
+	RenderWait renderWait;
+
+	fakeWait.result = WAIT_OBJECT_0 + 1;
+	CHECK(renderWait.waitMultiplexer.WaitForFrame(1000) == WaitMultiplexer::WaitResult::Signaled);
+	CHECK(renderWait.frameLatencyCount == 1);
+
+	// 按添加的顺序传入所有句柄
+	CHECK(fakeWait.callCount == 1);
+	CHECK(fakeWait.timeout == 1000);
+	const std::vector<HANDLE> handles = { MakeHandle(1), MakeHandle(2), MakeHandle(3) };
+	CHECK(fakeWait.handles == handles);
+
+	// 其他句柄被触发时不调用它的回调
+	fakeWait.result = WAIT_OBJECT_0;
+	CHECK(renderWait.waitMultiplexer.WaitForFrame(1000) == WaitMultiplexer::WaitResult::Signaled);
+	fakeWait.result = WAIT_OBJECT_0 + 2;
+	CHECK(renderWait.waitMultiplexer.WaitForFrame(1000) == WaitMultiplexer::WaitResult::Signaled);
+	CHECK(renderWait.frameLatencyCount == 1);
+}
+
+TEST(WaitMultiplexer, TimeoutSignalsAll) {
+	RenderWait renderWait;
+
+	// 超时后强制渲染下一帧，SwapChain 不应再等待帧延迟句柄
+	fakeWait.result = WAIT_TIMEOUT;
+	CHECK(renderWait.waitMultiplexer.WaitForFrame(1000) == WaitMultiplexer::WaitResult::Timeout);
+	CHECK(renderWait.frameLatencyCount == 1);
+
+	// 等待失败时同样
+	fakeWait.result = WAIT_FAILED;
+	CHECK(renderWait.waitMultiplexer.WaitForFrame(1000) == WaitMultiplexer::WaitResult::Failed);
+	CHECK(renderWait.frameLatencyCount == 2);
+
+	// Wait 只报告结果
+	fakeWait.result = WAIT_TIMEOUT;
+	CHECK(renderWait.waitMultiplexer.Wait(0) == WaitMultiplexer::WaitResult::Timeout);
+	CHECK(renderWait.frameLatencyCount == 2);
+}
+
+TEST(WaitMultiplexer, MessageReturnsToPump) {
+	RenderWait renderWait;
+
+	// 返回 WAIT_OBJECT_0 + count 表示有新消息，不调用任何回调
+	fakeWait.result = WAIT_OBJECT_0 + 3;
+	CHECK(renderWait.waitMultiplexer.WaitForFrame(1000) == WaitMultiplexer::WaitResult::MessageAvailable);
+	CHECK(renderWait.frameLatencyCount == 0);
+
+	// 没有句柄时只等待消息，如最小化时
+	renderWait.waitMultiplexer.Clear();
+	CHECK(renderWait.waitMultiplexer.Count() == 0);
+	fakeWait.result = WAIT_OBJECT_0;
+	CHECK(renderWait.waitMultiplexer.WaitForFrame(INFINITE) == WaitMultiplexer::WaitResult::MessageAvailable);
+	CHECK(fakeWait.handles.empty());
+	CHECK(fakeWait.timeout == INFINITE);
+}
+
+TEST(WaitMultiplexer, HandleLimit) {
+	WaitMultiplexer waitMultiplexer(FakeWaitFunc);
+	for (uint32_t i = 0; i < WaitMultiplexer::MAX_HANDLE_COUNT; ++i) {
+		REQUIRE(waitMultiplexer.Add(MakeHandle(i + 1)));
+	}
+	CHECK(!waitMultiplexer.Add(MakeHandle(WaitMultiplexer::MAX_HANDLE_COUNT + 1)));
+	CHECK(waitMultiplexer.Count() == WaitMultiplexer::MAX_HANDLE_COUNT);
+}
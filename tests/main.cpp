@@ -0,0 +1,52 @@
+#include "Test.h"
+
+namespace Test {
+
+static uint32_t failureCount = 0;
+
+std::vector<TestCase>& GetTestCases() noexcept {
+	// 函数内的静态变量保证注册时已经初始化
+	static std::vector<TestCase> testCases;
+	return testCases;
+}
+
+void ReportFailure(const char* file, int line, const char* expr) noexcept {
+	std::fprintf(stderr, "%s(%d): CHECK(%s) 失败\n", file, line, expr);
+	++failureCount;
+}
+
+}
+
+// 可选的参数为名称前缀，如 "SpscQueue." 只运行这一组测试
+int main(int argc, char* argv[]) {
+	const std::string_view filter = argc > 1 ? argv[1] : "";
+
+	uint32_t testCount = 0;
+	uint32_t failedTestCount = 0;
+	for (const Test::TestCase& testCase : Test::GetTestCases()) {
+		char fullName[256];
+		std::snprintf(fullName, sizeof(fullName), "%s.%s", testCase.suite, testCase.name);
+		if (!std::string_view(fullName).starts_with(filter)) {
+			continue;
+		}
+
+		std::printf("[ RUN    ] %s\n", fullName);
+		std::fflush(stdout);
+
+		const uint32_t oldFailureCount = Test::failureCount;
+		testCase.func();
+		++testCount;
+
+		if (Test::failureCount == oldFailureCount) {
+			std::printf("[     OK ] %s\n", fullName);
+		} else {
+			std::printf("[ FAILED ] %s\n", fullName);
+			++failedTestCount;
+		}
+		std::fflush(stdout);
+	}
+
+	std::printf("%u 个测试，%u 个失败\n", testCount, failedTestCount);
+	// 筛选不到测试视为失败，防止名称写错时测试被静默跳过
+	return testCount == 0 || failedTestCount != 0 ? 1 : 0;
+}
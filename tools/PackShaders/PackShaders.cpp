@@ -0,0 +1,117 @@
+// 编译时将所有着色器的字节码打包到 Shaders.bin，格式见 ShaderArchiveFile.h。由
+// D3D12Playground.vcxproj 中的 PackShaders 调用。
+//
+// 用法：PackShaders <列表文件> <输出文件>
+// 列表文件为 UTF-8 编码，每行一个着色器，顺序和 ShaderId 相同，形如
+// "名字|字节码路径|SM5.1 字节码路径"，没有 SM5.1 版本时最后一项为空。
+#include "ShaderArchiveFile.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+static bool ReadFile(const std::filesystem::path& path, std::vector<uint8_t>& data) noexcept {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return !file.bad();
+}
+
+static std::filesystem::path Utf8ToPath(std::string_view str) noexcept {
+	return std::filesystem::path(std::u8string(str.begin(), str.end()));
+}
+
+// 输出格式和 MSBuild 的错误一致，会显示在错误列表中。控制台不一定能输出中文，因此使用英文。
+static int ReportError(const wchar_t* message, const std::filesystem::path& path) noexcept {
+	std::fwprintf(stderr, L"PackShaders : error : %ls: %ls\n", message, path.c_str());
+	return 1;
+}
+
+int wmain(int argc, wchar_t* argv[]) {
+	if (argc != 3) {
+		std::fwprintf(stderr, L"Usage: PackShaders <list file> <output file>\n");
+		return 1;
+	}
+
+	const std::filesystem::path listPath = argv[1];
+	const std::filesystem::path outputPath = argv[2];
+
+	std::ifstream listFile(listPath);
+	if (!listFile) {
+		return ReportError(L"Cannot open the list file", listPath);
+	}
+
+	struct ShaderFile {
+		std::string name;
+		std::vector<uint8_t> variants[ShaderArchiveFile::VARIANT_COUNT];
+	};
+	std::vector<ShaderFile> shaderFiles;
+
+	std::string line;
+	while (std::getline(listFile, line)) {
+		// 去掉 BOM 和行尾的 \r
+		if (shaderFiles.empty() && line.starts_with("\xEF\xBB\xBF")) {
+			line.erase(0, 3);
+		}
+		if (!line.empty() && line.back() == '\r') {
+			line.pop_back();
+		}
+		if (line.empty()) {
+			continue;
+		}
+
+		// | 不能出现在路径中
+		const size_t firstSeparator = line.find('|');
+		const size_t secondSeparator = line.find('|', firstSeparator + 1);
+		if (firstSeparator == std::string::npos || secondSeparator == std::string::npos) {
+			return ReportError(L"Invalid line in the list file", listPath);
+		}
+
+		ShaderFile& shaderFile = shaderFiles.emplace_back();
+		shaderFile.name = line.substr(0, firstSeparator);
+
+		const std::string_view paths[] = {
+			std::string_view(line).substr(firstSeparator + 1, secondSeparator - firstSeparator - 1),
+			std::string_view(line).substr(secondSeparator + 1)
+		};
+		for (uint32_t i = 0; i < ShaderArchiveFile::VARIANT_COUNT; ++i) {
+			if (paths[i].empty()) {
+				continue;
+			}
+
+			const std::filesystem::path path = Utf8ToPath(paths[i]);
+			if (!ReadFile(path, shaderFile.variants[i]) || shaderFile.variants[i].empty()) {
+				return ReportError(L"Cannot read the byte code", path);
+			}
+		}
+	}
+
+	std::vector<ShaderArchiveFile::Shader> shaders(shaderFiles.size());
+	for (size_t i = 0; i < shaderFiles.size(); ++i) {
+		shaders[i].name = shaderFiles[i].name;
+		for (uint32_t j = 0; j < ShaderArchiveFile::VARIANT_COUNT; ++j) {
+			shaders[i].variants[j] = shaderFiles[i].variants[j];
+		}
+	}
+
+	const std::vector<uint8_t> data = ShaderArchiveFile::Write(shaders);
+	if (data.empty()) {
+		return ReportError(L"Byte code exceeds 4GB", outputPath);
+	}
+
+	std::ofstream outputFile(outputPath, std::ios::binary | std::ios::trunc);
+	if (!outputFile) {
+		return ReportError(L"Cannot create the output file", outputPath);
+	}
+	outputFile.write((const char*)data.data(), (std::streamsize)data.size());
+	outputFile.close();
+	if (!outputFile) {
+		return ReportError(L"Cannot write the output file", outputPath);
+	}
+
+	return 0;
+}